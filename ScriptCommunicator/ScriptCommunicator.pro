@@ -42,11 +42,20 @@ SOURCES += \
     scriptClasses/plotwindow.cpp \
     scriptClasses/scriptThread.cpp \
     mainInterfaceThread.cpp \
+    cyclicSendEngine.cpp \
     addmessagedialog.cpp \
     cheetahSpi/cheetah.c \
     cheetahSpi/cheetahspi.cpp \
     pcan/PCANBasicClass.cpp \
     canTab.cpp \
+    canTableModel.cpp \
+    socketCan.cpp \
+    canDatabase.cpp \
+    canTransmitScheduler.cpp \
+    canBusStatistics.cpp \
+    triggerCapture.cpp \
+    canFilter.cpp \
+    isoTp.cpp \
     scriptClasses/scriptSlots.cpp \
     scriptClasses/customConsoleLogObject.cpp \
     searchconsole.cpp \
@@ -54,6 +63,7 @@ SOURCES += \
     scriptClasses/sequencetableview.cpp \
     scriptClasses/scriptsqldatabase.cpp \
     mainwindowHandleData.cpp \
+    sendHistory.cpp \
     crc.cpp \
     scriptClasses/scriptUiClasses/scriptStandardDialogs.cpp \
     scriptClasses/scriptFile.cpp \
@@ -76,6 +86,13 @@ SOURCES += \
     colorWidgets/color_selector.cpp \
     colorWidgets/swatch.cpp \
     scriptClasses/scriptXml.cpp \
+    scriptClasses/scriptProtocolFramer.cpp \
+    scriptClasses/scriptStructCodec.cpp \
+    scriptClasses/scriptTimerWheel.cpp \
+    scriptClasses/scriptSequencePlaylist.cpp \
+    scriptClasses/scriptTransactionEngine.cpp \
+    scriptClasses/scriptFileTransfer.cpp \
+    scriptClasses/scriptProfiler.cpp \
     scriptClasses/canvas2D/context2d.cpp \
     scriptClasses/canvas2D/qcontext2dcanvas.cpp \
     createSceFile.cpp \
@@ -121,6 +138,7 @@ HEADERS += \
     scriptClasses/scriptUdpSocket.h \
     scriptClasses/scriptThread.h \
     mainInterfaceThread.h \
+    cyclicSendEngine.h \
     scriptClasses/scriptPlotWindow.h \
     scriptClasses/scriptUiClasses/scriptButton.h \
     scriptClasses/scriptUiClasses/scriptCheckBox.h \
@@ -152,6 +170,15 @@ HEADERS += \
     pcan/PCANBasicClass.h \
     scriptClasses/scriptPcan.h \
     canTab.h \
+    canTableModel.h \
+    canFrame.h \
+    socketCan.h \
+    canDatabase.h \
+    canTransmitScheduler.h \
+    canBusStatistics.h \
+    triggerCapture.h \
+    canFilter.h \
+    isoTp.h \
     scriptClasses/scriptUiClasses/scriptSplitter.h \
     scriptClasses/scriptSlots.h \
     scriptClasses/scriptUiClasses/scriptDoubleSpinBox.h \
@@ -167,6 +194,7 @@ HEADERS += \
     scriptClasses/scriptsqldatabase.h \
     scriptClasses/scriptHelper.h \
     mainwindowHandleData.h \
+    sendHistory.h \
     crc.h \
     scriptClasses/scriptUiClasses/scriptStandardDialogs.h \
     scriptClasses/scriptFile.h \
@@ -190,6 +218,13 @@ HEADERS += \
     colorWidgets/color_selector.hpp \
     colorWidgets/swatch.hpp \
     scriptClasses/scriptXml.h \
+    scriptClasses/scriptProtocolFramer.h \
+    scriptClasses/scriptStructCodec.h \
+    scriptClasses/scriptTimerWheel.h \
+    scriptClasses/scriptSequencePlaylist.h \
+    scriptClasses/scriptTransactionEngine.h \
+    scriptClasses/scriptFileTransfer.h \
+    scriptClasses/scriptProfiler.h \
     scriptClasses/canvas2D/context2d.h \
     scriptClasses/canvas2D/qcontext2dcanvas.h \
     createSceFile.h \
@@ -0,0 +1,264 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "canBusStatistics.h"
+#include <algorithm>
+
+/**
+ * Constructor.
+ */
+CanBusStatistics::CanBusStatistics() : m_bitrate(0), m_receivedFrames(0), m_sentFrames(0), m_receivedBits(0), m_sentBits(0),
+    m_errorFrames(0), m_lastReceivedFrames(0), m_lastSentFrames(0), m_lastReceivedBits(0), m_lastSentBits(0), m_lastErrorFrames(0),
+    m_maxBusLoad(0), m_ids()
+{
+}
+
+/**
+ * Removes all counters (the bit rate is not changed).
+ */
+void CanBusStatistics::reset(void)
+{
+    m_receivedFrames = 0;
+    m_sentFrames = 0;
+    m_receivedBits = 0;
+    m_sentBits = 0;
+    m_errorFrames = 0;
+    m_lastReceivedFrames = 0;
+    m_lastSentFrames = 0;
+    m_lastReceivedBits = 0;
+    m_lastSentBits = 0;
+    m_lastErrorFrames = 0;
+    m_maxBusLoad = 0;
+    m_ids.clear();
+}
+
+/**
+ * Counts received or sent frames.
+ * @param frames
+ *      The frames.
+ * @param received
+ *      True for received frames, false for sent frames.
+ */
+void CanBusStatistics::addFrames(const QVector<CanFrame>& frames, bool received)
+{
+    quint64 bits = 0;
+    for(const auto& el : frames)
+    {
+        bits += frameBitCount(el);
+
+        IdCounter& counter = m_ids[createKey(el.id, canFrameType(el))];
+        if(received)
+        {
+            counter.receivedFrames++;
+        }
+        else
+        {
+            counter.sentFrames++;
+        }
+    }
+
+    if(received)
+    {
+        m_receivedFrames += frames.size();
+        m_receivedBits += bits;
+    }
+    else
+    {
+        m_sentFrames += frames.size();
+        m_sentBits += bits;
+    }
+}
+
+/**
+ * Calculates the rates since the last call and returns the current statistics.
+ * @param elapsedNs
+ *      The time since the last call (ns).
+ * @return
+ *      The statistics.
+ */
+CanBusStatisticsSnapshot CanBusStatistics::update(qint64 elapsedNs)
+{
+    CanBusStatisticsSnapshot snapshot;
+    double seconds = (elapsedNs > 0) ? ((double)elapsedNs / 1000000000.0) : 1.0;
+
+    snapshot.bitrate = m_bitrate;
+    snapshot.receivedFrames = m_receivedFrames;
+    snapshot.sentFrames = m_sentFrames;
+    snapshot.errorFrames = m_errorFrames;
+    snapshot.receivedFramesPerSecond = (double)(m_receivedFrames - m_lastReceivedFrames) / seconds;
+    snapshot.sentFramesPerSecond = (double)(m_sentFrames - m_lastSentFrames) / seconds;
+    snapshot.receivedBitsPerSecond = (double)(m_receivedBits - m_lastReceivedBits) / seconds;
+    snapshot.sentBitsPerSecond = (double)(m_sentBits - m_lastSentBits) / seconds;
+    snapshot.errorFramesPerSecond = (m_errorFrames >= m_lastErrorFrames) ? ((double)(m_errorFrames - m_lastErrorFrames) / seconds) : 0.0;
+
+    if(m_bitrate > 0)
+    {
+        snapshot.busLoad = ((snapshot.receivedBitsPerSecond + snapshot.sentBitsPerSecond) * 100.0) / (double)m_bitrate;
+        m_maxBusLoad = qMax(m_maxBusLoad, snapshot.busLoad);
+        snapshot.maxBusLoad = m_maxBusLoad;
+    }
+    else
+    {
+        snapshot.busLoad = -1;
+        snapshot.maxBusLoad = -1;
+    }
+
+    QList<quint64> keys = m_ids.keys();
+    std::sort(keys.begin(), keys.end());
+    snapshot.ids.reserve(keys.size());
+    for(auto key : keys)
+    {
+        IdCounter& counter = m_ids[key];
+        CanIdStatistics statistics;
+        statistics.type = (quint8)(key & 0xff);
+        statistics.id = (quint32)(key >> 8);
+        statistics.receivedFrames = counter.receivedFrames;
+        statistics.sentFrames = counter.sentFrames;
+        statistics.receivedFramesPerSecond = (double)(counter.receivedFrames - counter.lastReceivedFrames) / seconds;
+        statistics.sentFramesPerSecond = (double)(counter.sentFrames - counter.lastSentFrames) / seconds;
+        snapshot.ids.append(statistics);
+
+        counter.lastReceivedFrames = counter.receivedFrames;
+        counter.lastSentFrames = counter.sentFrames;
+    }
+
+    m_lastReceivedFrames = m_receivedFrames;
+    m_lastSentFrames = m_sentFrames;
+    m_lastReceivedBits = m_receivedBits;
+    m_lastSentBits = m_sentBits;
+    m_lastErrorFrames = m_errorFrames;
+
+    return snapshot;
+}
+
+/**
+ * Appends the lowest count bits of value (msb first) to bits.
+ * @param bits
+ *      The bit array (one bit per byte).
+ * @param bitCount
+ *      The number of bits in bits (is incremented).
+ * @param value
+ *      The value.
+ * @param count
+ *      The number of bits.
+ */
+void CanBusStatistics::appendBits(quint8* bits, int* bitCount, quint32 value, int count)
+{
+    for(int i = count - 1; i >= 0; i--)
+    {
+        bits[(*bitCount)++] = (value >> i) & 1;
+    }
+}
+
+/**
+ * Returns the number of bits of a frame on the wire (including the stuff bits and the interframe space).
+ * The stuff bits of classic frames are counted exactly (the bit sequence and the CRC are built).
+ * The stuff bits of CAN FD frames are estimated (1 per 5 bits) and all bits are counted with
+ * the nominal bit rate.
+ * @param frame
+ *      The frame.
+ * @return
+ *      The number of bits.
+ */
+quint32 CanBusStatistics::frameBitCount(const CanFrame& frame)
+{
+    //CRC delimiter (1), ACK slot and delimiter (2), end of frame (7) and interframe space (3).
+    const quint32 fixedBits = 13;
+    const bool isExtended = (frame.flags & CAN_FRAME_FLAG_EXTENDED) ? true : false;
+    const bool isRemote = (frame.flags & CAN_FRAME_FLAG_RTR) ? true : false;
+    const int dataLength = isRemote ? 0 : qMin((int)frame.length, 8);
+
+    if(frame.flags & CAN_FRAME_FLAG_FD)
+    {
+        //Arbitration and control field, data and the CRC field (stuff count, CRC and fixed stuff bits).
+        quint32 bits = (isExtended ? 41 : 22) + (8 * frame.length);
+        quint32 crcBits = (frame.length > 16) ? 33 : 28;
+        return bits + (bits / 5) + crcBits + fixedBits;
+    }
+
+    //Start of frame, arbitration field, control field, data and CRC (max. 39 + 64 + 15 bits).
+    quint8 bits[128];
+    int bitCount = 0;
+
+    appendBits(bits, &bitCount, 0, 1);
+    if(isExtended)
+    {
+        appendBits(bits, &bitCount, frame.id >> 18, 11);
+        appendBits(bits, &bitCount, 3, 2); //SRR and IDE
+        appendBits(bits, &bitCount, frame.id, 18);
+        appendBits(bits, &bitCount, isRemote ? 1 : 0, 1);
+        appendBits(bits, &bitCount, 0, 2); //r1 and r0
+    }
+    else
+    {
+        appendBits(bits, &bitCount, frame.id, 11);
+        appendBits(bits, &bitCount, isRemote ? 1 : 0, 1);
+        appendBits(bits, &bitCount, 0, 2); //IDE and r0
+    }
+    appendBits(bits, &bitCount, isRemote ? 0 : dataLength, 4);
+    for(int i = 0; i < dataLength; i++)
+    {
+        appendBits(bits, &bitCount, frame.data[i], 8);
+    }
+
+    //CRC-15 (polynomial 0x4599).
+    quint32 crc = 0;
+    for(int i = 0; i < bitCount; i++)
+    {
+        quint32 crcNext = bits[i] ^ ((crc >> 14) & 1);
+        crc = (crc << 1) & 0x7fff;
+        if(crcNext)
+        {
+            crc ^= 0x4599;
+        }
+    }
+    appendBits(bits, &bitCount, crc, 15);
+
+    //A stuff bit (the complement) is inserted after 5 equal bits, it is part of the next sequence.
+    quint32 stuffBits = 0;
+    quint8 lastBit = bits[0];
+    int equalBits = 1;
+    for(int i = 1; i < bitCount; i++)
+    {
+        if(bits[i] == lastBit)
+        {
+            equalBits++;
+        }
+        else
+        {
+            lastBit = bits[i];
+            equalBits = 1;
+        }
+
+        if(equalBits == 5)
+        {
+            stuffBits++;
+            lastBit ^= 1;
+            equalBits = 1;
+        }
+    }
+
+    return bitCount + stuffBits + fixedBits;
+}
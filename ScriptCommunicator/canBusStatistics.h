@@ -0,0 +1,175 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef CANBUSSTATISTICS_H
+#define CANBUSSTATISTICS_H
+
+#include <QHash>
+#include <QVector>
+#include <QMetaType>
+#include "canFrame.h"
+
+///The statistics of one can id/type.
+typedef struct
+{
+    ///The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+    quint8 type;
+
+    ///The can id.
+    quint32 id;
+
+    ///The number of received frames.
+    quint64 receivedFrames;
+
+    ///The number of sent frames.
+    quint64 sentFrames;
+
+    ///The received frames per second (last interval).
+    double receivedFramesPerSecond;
+
+    ///The sent frames per second (last interval).
+    double sentFramesPerSecond;
+}CanIdStatistics;
+
+///The can bus statistics (rates of the last interval, counters since the interface has been connected).
+typedef struct
+{
+    ///The bit rate (bit/s, 0 if unknown).
+    quint32 bitrate;
+
+    ///The number of received frames.
+    quint64 receivedFrames;
+
+    ///The number of sent frames.
+    quint64 sentFrames;
+
+    ///The number of error frames (PCAN: status messages).
+    quint64 errorFrames;
+
+    ///The received frames per second.
+    double receivedFramesPerSecond;
+
+    ///The sent frames per second.
+    double sentFramesPerSecond;
+
+    ///The received bits on the wire per second (including the stuff bits).
+    double receivedBitsPerSecond;
+
+    ///The sent bits on the wire per second (including the stuff bits).
+    double sentBitsPerSecond;
+
+    ///The error frames per second.
+    double errorFramesPerSecond;
+
+    ///The bus load (%, -1 if the bit rate is unknown).
+    double busLoad;
+
+    ///The max. bus load (%, -1 if the bit rate is unknown).
+    double maxBusLoad;
+
+    ///The statistics of all ids (sorted by id and type).
+    QVector<CanIdStatistics> ids;
+}CanBusStatisticsSnapshot;
+
+Q_DECLARE_METATYPE(CanBusStatisticsSnapshot)
+
+///Computes the can bus statistics incrementally (every frame is counted when it is received/sent,
+///the rates are calculated once per interval in update). Must be used by one thread only.
+class CanBusStatistics
+{
+public:
+    CanBusStatistics();
+
+    ///Removes all counters (the bit rate is not changed).
+    void reset(void);
+
+    ///Sets the bit rate (bit/s, 0 if unknown).
+    void setBitrate(quint32 bitrate){m_bitrate = bitrate;}
+
+    ///Counts received or sent frames.
+    void addFrames(const QVector<CanFrame>& frames, bool received);
+
+    ///Sets the number of error frames since the interface has been connected.
+    void setErrorFrames(quint64 errorFrames){m_errorFrames = errorFrames;}
+
+    ///Calculates the rates since the last call (elapsedNs is the time since the last call)
+    ///and returns the current statistics.
+    CanBusStatisticsSnapshot update(qint64 elapsedNs);
+
+    ///Returns the number of bits of a frame on the wire (including the stuff bits and the interframe space).
+    ///Classic frames are stuffed exactly, the stuff bits of CAN FD frames are estimated and
+    ///all bits are counted with the nominal bit rate.
+    static quint32 frameBitCount(const CanFrame& frame);
+
+private:
+
+    ///The counters of one id/type.
+    typedef struct
+    {
+        quint64 receivedFrames;
+        quint64 sentFrames;
+        quint64 lastReceivedFrames;
+        quint64 lastSentFrames;
+    }IdCounter;
+
+    ///Appends the lowest count bits of value (msb first) to bits.
+    static void appendBits(quint8* bits, int* bitCount, quint32 value, int count);
+
+    ///Creates the hash key (the order of the keys is the order of CanBusStatisticsSnapshot::ids).
+    static quint64 createKey(quint32 canId, quint8 type){return ((quint64)canId << 8) | type;}
+
+    ///The bit rate (bit/s, 0 if unknown).
+    quint32 m_bitrate;
+
+    ///The number of received frames.
+    quint64 m_receivedFrames;
+
+    ///The number of sent frames.
+    quint64 m_sentFrames;
+
+    ///The number of received bits.
+    quint64 m_receivedBits;
+
+    ///The number of sent bits.
+    quint64 m_sentBits;
+
+    ///The number of error frames.
+    quint64 m_errorFrames;
+
+    ///The counters at the last update.
+    quint64 m_lastReceivedFrames;
+    quint64 m_lastSentFrames;
+    quint64 m_lastReceivedBits;
+    quint64 m_lastSentBits;
+    quint64 m_lastErrorFrames;
+
+    ///The max. bus load (%).
+    double m_maxBusLoad;
+
+    ///The counters of all ids.
+    QHash<quint64, IdCounter> m_ids;
+};
+
+#endif // CANBUSSTATISTICS_H
@@ -0,0 +1,515 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "canDatabase.h"
+#include <QFile>
+#include <QRegularExpression>
+
+/**
+ * Constructor.
+ */
+CanDatabase::CanDatabase() : m_messages(), m_signals(), m_messageIndexes(), m_signalIndexes(), m_fileName()
+{
+}
+
+/**
+ * Removes all messages.
+ */
+void CanDatabase::clear(void)
+{
+    m_messages.clear();
+    m_signals.clear();
+    m_messageIndexes.clear();
+    m_signalIndexes.clear();
+    m_fileName.clear();
+}
+
+/**
+ * Loads a DBC file (the current content is replaced).
+ * @param fileName
+ *      The file name.
+ * @param errorString
+ *      The error description.
+ * @return
+ *      True on success.
+ */
+bool CanDatabase::loadFile(QString fileName, QString* errorString)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *errorString = file.errorString();
+        return false;
+    }
+
+    //DBC files are not UTF-8 encoded (usually Windows-1252).
+    if(!parse(QString::fromLatin1(file.readAll()), errorString))
+    {
+        return false;
+    }
+    m_fileName = fileName;
+    return true;
+}
+
+/**
+ * Parses the content of a DBC file (the current content is replaced).
+ * Supported are messages (BO_), signals (SG_, incl. simple multiplexing) and the
+ * signal value types (SIG_VALTYPE_). All other sections are ignored.
+ * @param content
+ *      The file content.
+ * @param errorString
+ *      The error description.
+ * @return
+ *      True on success.
+ */
+bool CanDatabase::parse(const QString& content, QString* errorString)
+{
+    static const QRegularExpression messageExpression("^BO_\\s+(\\d+)\\s+(\\w+)\\s*:\\s*(\\d+)");
+    static const QRegularExpression valueTypeExpression("^SIG_VALTYPE_\\s+(\\d+)\\s+(\\w+)\\s*:?\\s*([0-3])");
+
+    clear();
+
+    QStringList lines = content.split('\n');
+    qint32 currentMessage = -1;
+
+    for(qint32 lineIndex = 0; lineIndex < lines.size(); lineIndex++)
+    {
+        QString line = lines[lineIndex].trimmed();
+
+        if(line.startsWith("BO_ "))
+        {
+            QRegularExpressionMatch match = messageExpression.match(line);
+            bool idIsOk = false;
+            quint32 rawId = match.hasMatch() ? match.captured(1).toUInt(&idIsOk) : 0;
+            if(!idIsOk)
+            {
+                *errorString = QString("line %1: invalid message definition").arg(lineIndex + 1);
+                clear();
+                return false;
+            }
+
+            currentMessage = -1;
+            if(match.captured(2) == "VECTOR__INDEPENDENT_SIG_MSG")
+            {//Pseudo message for signals which are not assigned to a message.
+                continue;
+            }
+
+            CanMessageDefinition message;
+            message.isExtended = (rawId & 0x80000000) ? true : false;
+            message.id = rawId & 0x1fffffff;
+            message.name = match.captured(2);
+            message.length = (quint8)qMin(match.captured(3).toUInt(), (uint)CAN_FRAME_MAX_DATA);
+            message.firstSignal = m_signals.size();
+            message.signalCount = 0;
+            message.multiplexer = -1;
+
+            m_messages.append(message);
+            currentMessage = m_messages.size() - 1;
+            m_messageIndexes.insert(createKey(message.id, message.isExtended), currentMessage);
+        }
+        else if(line.startsWith("SG_ "))
+        {
+            if(currentMessage < 0)
+            {
+                continue;
+            }
+
+            CanSignal signal;
+            if(!parseSignal(line, &signal))
+            {
+                *errorString = QString("line %1: invalid signal definition").arg(lineIndex + 1);
+                clear();
+                return false;
+            }
+
+            CanMessageDefinition& message = m_messages[currentMessage];
+            signal.fullName = message.name + "." + signal.name;
+            if(signal.multiplexing == CAN_SIGNAL_MULTIPLEXER)
+            {
+                message.multiplexer = m_signals.size();
+            }
+            m_signals.append(signal);
+            message.signalCount++;
+        }
+        else
+        {
+            //The signals of a message directly follow the message definition.
+            currentMessage = -1;
+
+            if(line.startsWith("SIG_VALTYPE_ "))
+            {
+                QRegularExpressionMatch match = valueTypeExpression.match(line);
+                if(match.hasMatch())
+                {
+                    quint32 rawId = match.captured(1).toUInt();
+                    const CanMessageDefinition* message = findMessage(rawId & 0x1fffffff, (rawId & 0x80000000) ? true : false);
+                    for(qint32 i = 0; (message != 0) && (i < message->signalCount); i++)
+                    {
+                        CanSignal& signal = m_signals[message->firstSignal + i];
+                        if(signal.name == match.captured(2))
+                        {
+                            quint32 type = match.captured(3).toUInt();
+                            signal.valueType = (type == 1) ? CAN_SIGNAL_VALUE_FLOAT : ((type == 2) ? CAN_SIGNAL_VALUE_DOUBLE : CAN_SIGNAL_VALUE_INTEGER);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    for(qint32 i = 0; i < m_signals.size(); i++)
+    {
+        if(!compileSignal(&m_signals[i]))
+        {
+            *errorString = QString("signal %1: invalid bit position, length or value type").arg(m_signals[i].fullName);
+            clear();
+            return false;
+        }
+
+        m_signalIndexes.insert(m_signals[i].fullName, i);
+        if(!m_signalIndexes.contains(m_signals[i].name))
+        {
+            m_signalIndexes.insert(m_signals[i].name, i);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Parses a signal line (SG_ name [M|m<n>] : start|length@byteOrder sign (factor,offset) [min|max] "unit" receivers).
+ * @param line
+ *      The line.
+ * @param signal
+ *      The parsed signal.
+ * @return
+ *      True on success.
+ */
+bool CanDatabase::parseSignal(const QString& line, CanSignal* signal)
+{
+    static const QRegularExpression signalExpression("^SG_\\s+(\\w+)\\s*(M|m\\d+M?)?\\s*:\\s*(\\d+)\\s*\\|\\s*(\\d+)\\s*@\\s*([01])\\s*([+-])"
+                                                     "\\s*\\(\\s*([^,\\s]+)\\s*,\\s*([^)\\s]+)\\s*\\)"
+                                                     "\\s*\\[\\s*([^|\\s]*)\\s*\\|\\s*([^\\]\\s]*)\\s*\\]\\s*\"([^\"]*)\"");
+
+    QRegularExpressionMatch match = signalExpression.match(line);
+    if(!match.hasMatch())
+    {
+        return false;
+    }
+
+    bool factorIsOk = false;
+    bool offsetIsOk = false;
+    quint32 length = match.captured(4).toUInt();
+    if((length == 0) || (length > 64))
+    {
+        return false;
+    }
+
+    signal->name = match.captured(1);
+    signal->unit = match.captured(11);
+    signal->startBit = (quint16)match.captured(3).toUInt();
+    signal->length = (quint8)length;
+    signal->isLittleEndian = (match.captured(5) == "1");
+    signal->isSigned = (match.captured(6) == "-");
+    signal->valueType = CAN_SIGNAL_VALUE_INTEGER;
+    signal->factor = match.captured(7).toDouble(&factorIsOk);
+    signal->offset = match.captured(8).toDouble(&offsetIsOk);
+    signal->minimum = match.captured(9).toDouble();
+    signal->maximum = match.captured(10).toDouble();
+    signal->multiplexValue = 0;
+
+    QString multiplexing = match.captured(2);
+    if(multiplexing == "M")
+    {
+        signal->multiplexing = CAN_SIGNAL_MULTIPLEXER;
+    }
+    else if(multiplexing.startsWith("m"))
+    {//Extended multiplexing (m<n>M) is decoded like simple multiplexing.
+        signal->multiplexing = CAN_SIGNAL_MULTIPLEXED;
+        signal->multiplexValue = multiplexing.mid(1).remove("M").toUInt();
+    }
+    else
+    {
+        signal->multiplexing = CAN_SIGNAL_PLAIN;
+    }
+
+    return factorIsOk && offsetIsOk;
+}
+
+/**
+ * Creates the decode plan of a signal.
+ * @param signal
+ *      The signal.
+ * @return
+ *      False if the signal does not fit into a can frame.
+ */
+bool CanDatabase::compileSignal(CanSignal* signal)
+{
+    qint32 firstByte;
+    qint32 lastByte;
+
+    if(((signal->valueType == CAN_SIGNAL_VALUE_FLOAT) && (signal->length != 32)) ||
+       ((signal->valueType == CAN_SIGNAL_VALUE_DOUBLE) && (signal->length != 64)))
+    {
+        return false;
+    }
+
+    if(signal->isLittleEndian)
+    {//The start bit is the lsb.
+        qint32 msb = signal->startBit + signal->length - 1;
+        firstByte = signal->startBit / 8;
+        lastByte = msb / 8;
+        signal->shift = signal->startBit % 8;
+    }
+    else
+    {//The start bit is the msb, the following bits are in the next (more significant) bit positions
+     //of the following bytes (bit 0 of byte n is followed by bit 7 of byte n+1).
+        qint32 msbPosition = ((signal->startBit / 8) * 8) + (7 - (signal->startBit % 8));
+        qint32 lsbPosition = msbPosition + signal->length - 1;
+        firstByte = msbPosition / 8;
+        lastByte = lsbPosition / 8;
+        signal->shift = 7 - (lsbPosition % 8);
+    }
+
+    if(lastByte >= CAN_FRAME_MAX_DATA)
+    {
+        return false;
+    }
+
+    signal->firstByte = (quint8)firstByte;
+    signal->byteCount = (quint8)(lastByte - firstByte + 1);
+    signal->mask = (signal->length == 64) ? ~(quint64)0 : (((quint64)1 << signal->length) - 1);
+    return true;
+}
+
+/**
+ * Extracts the raw value of a signal (the frame must contain all bytes of the signal).
+ * @param signal
+ *      The signal.
+ * @param data
+ *      The frame data.
+ * @return
+ *      The raw value.
+ */
+quint64 CanDatabase::extractRawValue(const CanSignal& signal, const quint8* data)
+{
+    const quint8* bytes = data + signal.firstByte;
+    qint32 count = (signal.byteCount > 8) ? 8 : signal.byteCount;
+    quint64 rawValue = 0;
+
+    if(signal.isLittleEndian)
+    {
+        for(qint32 i = count - 1; i >= 0; i--)
+        {
+            rawValue = (rawValue << 8) | bytes[i];
+        }
+        rawValue >>= signal.shift;
+
+        if(signal.byteCount > 8)
+        {//Unaligned signal with more than 56 bits (shift is not 0).
+            rawValue |= (quint64)bytes[8] << (64 - signal.shift);
+        }
+    }
+    else
+    {
+        for(qint32 i = 0; i < count; i++)
+        {
+            rawValue = (rawValue << 8) | bytes[i];
+        }
+
+        if(signal.byteCount > 8)
+        {
+            rawValue = (rawValue << (8 - signal.shift)) | (bytes[8] >> signal.shift);
+        }
+        else
+        {
+            rawValue >>= signal.shift;
+        }
+    }
+
+    return rawValue & signal.mask;
+}
+
+/**
+ * Converts a raw value into the physical value.
+ * @param signal
+ *      The signal.
+ * @param rawValue
+ *      The raw value.
+ * @return
+ *      The physical value.
+ */
+double CanDatabase::toPhysicalValue(const CanSignal& signal, quint64 rawValue)
+{
+    double value;
+
+    if(signal.valueType == CAN_SIGNAL_VALUE_FLOAT)
+    {
+        quint32 bits = (quint32)rawValue;
+        float floatValue;
+        memcpy(&floatValue, &bits, sizeof(floatValue));
+        value = floatValue;
+    }
+    else if(signal.valueType == CAN_SIGNAL_VALUE_DOUBLE)
+    {
+        memcpy(&value, &rawValue, sizeof(value));
+    }
+    else if(signal.isSigned && ((rawValue >> (signal.length - 1)) & 1))
+    {//Negative value: sign extension.
+        value = (double)(qint64)(rawValue | ~signal.mask);
+    }
+    else
+    {
+        value = (double)rawValue;
+    }
+
+    return (value * signal.factor) + signal.offset;
+}
+
+/**
+ * Returns the message definition of a can id.
+ * @param id
+ *      The can id.
+ * @param isExtended
+ *      True if the id is an extended id.
+ * @return
+ *      The message definition (0 if the id is not in the database).
+ */
+const CanMessageDefinition* CanDatabase::findMessage(quint32 id, bool isExtended) const
+{
+    QHash<quint32, qint32>::const_iterator iter = m_messageIndexes.constFind(createKey(id, isExtended));
+    return (iter == m_messageIndexes.constEnd()) ? 0 : &m_messages.constData()[iter.value()];
+}
+
+/**
+ * Decodes all signals of a frame. Signals which are not (completely) contained in the frame
+ * and multiplexed signals of other multiplexer values are skipped.
+ * @param frame
+ *      The frame.
+ * @param values
+ *      The values are appended to this vector.
+ * @return
+ *      False if the frame is not in the database.
+ */
+bool CanDatabase::decodeFrame(const CanFrame& frame, QVector<CanSignalValue>* values) const
+{
+    const CanMessageDefinition* message = findMessage(frame.id, (frame.flags & CAN_FRAME_FLAG_EXTENDED) ? true : false);
+    if((message == 0) || (frame.flags & CAN_FRAME_FLAG_RTR))
+    {
+        return false;
+    }
+
+    const CanSignal* signalList = m_signals.constData();
+    bool hasMultiplexValue = false;
+    quint64 multiplexValue = 0;
+
+    if(message->multiplexer >= 0)
+    {
+        const CanSignal& multiplexer = signalList[message->multiplexer];
+        if(frame.length >= (multiplexer.firstByte + multiplexer.byteCount))
+        {
+            multiplexValue = extractRawValue(multiplexer, frame.data);
+            hasMultiplexValue = true;
+        }
+    }
+
+    for(qint32 i = message->firstSignal; i < (message->firstSignal + message->signalCount); i++)
+    {
+        const CanSignal& signal = signalList[i];
+        if(frame.length < (signal.firstByte + signal.byteCount))
+        {
+            continue;
+        }
+        if((signal.multiplexing == CAN_SIGNAL_MULTIPLEXED) && (!hasMultiplexValue || (multiplexValue != signal.multiplexValue)))
+        {
+            continue;
+        }
+
+        CanSignalValue value;
+        value.signalIndex = i;
+        value.value = toPhysicalValue(signal, extractRawValue(signal, frame.data));
+        values->append(value);
+    }
+    return true;
+}
+
+/**
+ * Decodes all signals of a frame and returns them as string.
+ * @param frame
+ *      The frame.
+ * @return
+ *      The signals (name=value unit, ...). Empty if the frame is not in the database.
+ */
+QString CanDatabase::decodeFrameToString(const CanFrame& frame) const
+{
+    QVector<CanSignalValue> values;
+    QString result;
+
+    if(decodeFrame(frame, &values))
+    {
+        for(const auto& el : values)
+        {
+            const CanSignal& signal = m_signals[el.signalIndex];
+            if(!result.isEmpty())
+            {
+                result += ", ";
+            }
+            result += signal.name + "=" + QString::number(el.value, 'g', 10);
+            if(!signal.unit.isEmpty())
+            {
+                result += " " + signal.unit;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the index of a signal.
+ * @param name
+ *      The full name (message name.signal name) or the signal name (the first signal
+ *      with this name is returned).
+ * @return
+ *      The signal index (-1 if not found).
+ */
+qint32 CanDatabase::findSignal(QString name) const
+{
+    return m_signalIndexes.value(name, -1);
+}
+
+/**
+ * Returns the full names (message name.signal name) of all signals.
+ * @return
+ *      The names.
+ */
+QStringList CanDatabase::signalNames(void) const
+{
+    QStringList names;
+    for(const auto& el : m_signals)
+    {
+        names << el.fullName;
+    }
+    return names;
+}
@@ -0,0 +1,227 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef CANDATABASE_H
+#define CANDATABASE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include "canFrame.h"
+
+///Multiplexing type of a can signal.
+typedef enum
+{
+    ///The signal is always present.
+    CAN_SIGNAL_PLAIN = 0,
+
+    ///The signal is the multiplexer of its message (DBC: M).
+    CAN_SIGNAL_MULTIPLEXER,
+
+    ///The signal is only present if the multiplexer has the value multiplexValue (DBC: m<n>).
+    CAN_SIGNAL_MULTIPLEXED
+}CanSignalMultiplexing;
+
+///Value type of a can signal.
+typedef enum
+{
+    CAN_SIGNAL_VALUE_INTEGER = 0,
+    CAN_SIGNAL_VALUE_FLOAT,
+    CAN_SIGNAL_VALUE_DOUBLE
+}CanSignalValueType;
+
+///A signal of a can message definition (DBC: SG_) and its precompiled decode plan.
+typedef struct
+{
+    ///The signal name.
+    QString name;
+
+    ///The full name (message name.signal name).
+    QString fullName;
+
+    ///The unit.
+    QString unit;
+
+    ///The start bit (DBC numbering).
+    quint16 startBit;
+
+    ///The number of bits.
+    quint8 length;
+
+    ///True for little endian (Intel, DBC: @1), false for big endian (Motorola, DBC: @0).
+    bool isLittleEndian;
+
+    ///True if the raw value is signed.
+    bool isSigned;
+
+    ///The value type.
+    CanSignalValueType valueType;
+
+    ///The scaling factor.
+    double factor;
+
+    ///The offset.
+    double offset;
+
+    ///The min. physical value.
+    double minimum;
+
+    ///The max. physical value.
+    double maximum;
+
+    ///The multiplexing type.
+    CanSignalMultiplexing multiplexing;
+
+    ///The multiplexer value (CAN_SIGNAL_MULTIPLEXED).
+    quint32 multiplexValue;
+
+    ///Decode plan: the first data byte of the signal (little endian: lowest byte, big endian: byte of the msb).
+    quint8 firstByte;
+
+    ///Decode plan: the number of data bytes which contain the signal (1-9).
+    quint8 byteCount;
+
+    ///Decode plan: the number of bits the read bytes must be shifted to the right.
+    quint8 shift;
+
+    ///Decode plan: the mask of the raw value.
+    quint64 mask;
+}CanSignal;
+
+///A can message definition (DBC: BO_).
+typedef struct
+{
+    ///The can id.
+    quint32 id;
+
+    ///True if the id is an extended (29 bit) id.
+    bool isExtended;
+
+    ///The message name.
+    QString name;
+
+    ///The number of data bytes.
+    quint8 length;
+
+    ///The index of the first signal of this message (CanDatabase::signalAt).
+    qint32 firstSignal;
+
+    ///The number of signals of this message.
+    qint32 signalCount;
+
+    ///The index of the multiplexer signal (-1 if the message is not multiplexed).
+    qint32 multiplexer;
+}CanMessageDefinition;
+
+///A decoded signal value.
+typedef struct
+{
+    ///The signal index (CanDatabase::signalAt).
+    qint32 signalIndex;
+
+    ///The physical value.
+    double value;
+}CanSignalValue;
+
+///Can database which is loaded from a DBC file. For every message a decode plan is created
+///while loading (byte range, shift and mask of every signal), so that decodeFrame only
+///executes a few integer operations per signal.
+class CanDatabase
+{
+public:
+    CanDatabase();
+
+    ///Loads a DBC file (the current content is replaced).
+    bool loadFile(QString fileName, QString* errorString);
+
+    ///Parses the content of a DBC file (the current content is replaced).
+    bool parse(const QString& content, QString* errorString);
+
+    ///Removes all messages.
+    void clear(void);
+
+    ///Returns true if the database contains no messages.
+    bool isEmpty(void) const {return m_messages.isEmpty();}
+
+    ///Returns the name of the loaded file.
+    QString fileName(void) const {return m_fileName;}
+
+    ///Returns the message definition of a can id (0 if the id is not in the database).
+    const CanMessageDefinition* findMessage(quint32 id, bool isExtended) const;
+
+    ///Decodes all signals of a frame. The values are appended to values.
+    ///Returns false if the frame is not in the database.
+    bool decodeFrame(const CanFrame& frame, QVector<CanSignalValue>* values) const;
+
+    ///Decodes all signals of a frame and returns them as string (name=value unit, ...).
+    QString decodeFrameToString(const CanFrame& frame) const;
+
+    ///Returns the index of a signal (message name.signal name or signal name, -1 if not found).
+    qint32 findSignal(QString name) const;
+
+    ///Returns the number of signals.
+    qint32 signalCount(void) const {return m_signals.size();}
+
+    ///Returns a signal.
+    const CanSignal& signalAt(qint32 index) const {return m_signals[index];}
+
+    ///Returns the full names (message name.signal name) of all signals.
+    QStringList signalNames(void) const;
+
+private:
+
+    ///Parses a signal line (SG_).
+    bool parseSignal(const QString& line, CanSignal* signal);
+
+    ///Creates the decode plan of a signal.
+    static bool compileSignal(CanSignal* signal);
+
+    ///Extracts the raw value of a signal.
+    static quint64 extractRawValue(const CanSignal& signal, const quint8* data);
+
+    ///Converts a raw value into the physical value.
+    static double toPhysicalValue(const CanSignal& signal, quint64 rawValue);
+
+    ///Creates the key of m_messageIndexes.
+    static quint32 createKey(quint32 id, bool isExtended){return isExtended ? (id | 0x80000000) : id;}
+
+    ///The message definitions.
+    QVector<CanMessageDefinition> m_messages;
+
+    ///The signals of all messages (the signals of one message are contiguous).
+    QVector<CanSignal> m_signals;
+
+    ///The message indexes (key: id, bit 31 is set for extended ids).
+    QHash<quint32, qint32> m_messageIndexes;
+
+    ///The signal indexes (key: full name and signal name).
+    QHash<QString, qint32> m_signalIndexes;
+
+    ///The name of the loaded file.
+    QString m_fileName;
+};
+
+#endif // CANDATABASE_H
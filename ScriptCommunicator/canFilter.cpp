@@ -0,0 +1,349 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "canFilter.h"
+#include <QStringList>
+#include <QMutexLocker>
+#include <algorithm>
+
+/**
+ * Constructor (creates a filter which accepts all frames).
+ */
+CanFilter::CanFilter() : m_text(), m_isEmpty(true), m_hasIncludeRules(false), m_extendedIncludes(), m_extendedExcludes()
+{
+    memset(m_standardTable, 0xff, sizeof(m_standardTable));
+}
+
+/**
+ * Compiles a filter. The filter is not changed if the compilation fails.
+ * @param filter
+ *      Comma separated list of rules (hex): id, first-last or id:mask. A rule with a leading '!'
+ *      is an exclude rule. An id with 8 hex digits is an extended id. An empty string creates a
+ *      filter which accepts all frames.
+ * @param errorString
+ *      The error description.
+ * @return
+ *      True on success.
+ */
+bool CanFilter::compile(QString filter, QString* errorString)
+{
+    CanFilterRuleSet standardIncludes;
+    CanFilterRuleSet standardExcludes;
+    CanFilterRuleSet extendedIncludes;
+    CanFilterRuleSet extendedExcludes;
+    bool hasRules = false;
+    bool hasIncludeRules = false;
+
+    for(auto el : filter.split(",", QString::SkipEmptyParts))
+    {
+        QString rule = el.trimmed();
+        if(rule.isEmpty())
+        {
+            continue;
+        }
+
+        bool isExclude = rule.startsWith('!');
+        if(isExclude)
+        {
+            rule = rule.mid(1).trimmed();
+        }
+
+        bool isMaskRule = rule.contains(':');
+        QStringList parts = rule.split(isMaskRule ? ':' : '-');
+        bool isExtended = (parts[0].trimmed().length() == 8);
+        quint32 maxId = isExtended ? 0x1fffffff : 0x7ff;
+        bool firstIsOk = false;
+        bool secondIsOk = (parts.size() == 1);
+        quint32 first = parts[0].trimmed().toUInt(&firstIsOk, 16);
+        quint32 second = first;
+
+        if(parts.size() == 2)
+        {
+            second = parts[1].trimmed().toUInt(&secondIsOk, 16);
+            if(!isMaskRule && ((parts[1].trimmed().length() == 8) != isExtended))
+            {//Ranges must not mix standard and extended ids.
+                secondIsOk = false;
+            }
+        }
+
+        if(!firstIsOk || !secondIsOk || (parts.size() > 2) || (first > maxId) || (!isMaskRule && ((second > maxId) || (second < first))))
+        {
+            *errorString = QString("invalid can filter rule: %1").arg(el.trimmed());
+            return false;
+        }
+
+        CanFilterRuleSet* rules = isExtended ? (isExclude ? &extendedExcludes : &extendedIncludes) :
+                                               (isExclude ? &standardExcludes : &standardIncludes);
+        if(isMaskRule)
+        {
+            second &= maxId;
+            if(second == maxId)
+            {//A mask rule with a full mask is a single id.
+                addRule(rules, first, first, 0, false);
+            }
+            else
+            {
+                addRule(rules, first, first, second, true);
+            }
+        }
+        else
+        {
+            addRule(rules, first, second, 0, false);
+        }
+
+        hasRules = true;
+        hasIncludeRules = hasIncludeRules || !isExclude;
+    }
+
+    mergeRanges(&standardIncludes);
+    mergeRanges(&standardExcludes);
+    mergeRanges(&extendedIncludes);
+    mergeRanges(&extendedExcludes);
+
+    //All standard ids are evaluated now (the table is used for every received standard frame).
+    memset(m_standardTable, 0, sizeof(m_standardTable));
+    for(quint32 id = 0; id <= 0x7ff; id++)
+    {
+        if((!hasIncludeRules || matches(standardIncludes, id)) && !matches(standardExcludes, id))
+        {
+            m_standardTable[id >> 3] |= (quint8)(1 << (id & 7));
+        }
+    }
+
+    m_extendedIncludes = extendedIncludes;
+    m_extendedExcludes = extendedExcludes;
+    m_hasIncludeRules = hasIncludeRules;
+    m_isEmpty = !hasRules;
+    m_text = filter.trimmed();
+    return true;
+}
+
+/**
+ * Returns the frames which pass the filter.
+ * @param frames
+ *      The frames.
+ * @return
+ *      The frames which have passed (the order is not changed).
+ */
+QVector<CanFrame> CanFilter::apply(const QVector<CanFrame>& frames) const
+{
+    if(m_isEmpty)
+    {
+        return frames;
+    }
+
+    QVector<CanFrame> result;
+    result.reserve(frames.size());
+    for(const auto& el : frames)
+    {
+        if(accepts(el))
+        {
+            result.append(el);
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns true if an extended id passes the filter.
+ * @param id
+ *      The id.
+ * @return
+ *      True if the id passes.
+ */
+bool CanFilter::acceptsExtendedId(quint32 id) const
+{
+    if(m_hasIncludeRules && !matches(m_extendedIncludes, id))
+    {
+        return false;
+    }
+    return !matches(m_extendedExcludes, id);
+}
+
+/**
+ * Returns true if id matches a rule of a rule set.
+ * @param rules
+ *      The rule set.
+ * @param id
+ *      The id.
+ * @return
+ *      True if a rule matches.
+ */
+bool CanFilter::matches(const CanFilterRuleSet& rules, quint32 id)
+{
+    if(rules.ids.contains(id))
+    {
+        return true;
+    }
+
+    if(!rules.ranges.isEmpty())
+    {
+        //Find the last range which starts at or before id.
+        auto it = std::upper_bound(rules.ranges.constBegin(), rules.ranges.constEnd(), id,
+                                   [](quint32 value, const QPair<quint32, quint32>& range){return value < range.first;});
+        if((it != rules.ranges.constBegin()) && (id <= (it - 1)->second))
+        {
+            return true;
+        }
+    }
+
+    for(const auto& el : rules.maskGroups)
+    {
+        if(el.second.contains(id & el.first))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Adds a rule to a rule set.
+ * @param rules
+ *      The rule set.
+ * @param first
+ *      The first id (the id of a mask rule).
+ * @param last
+ *      The last id (not used for mask rules).
+ * @param mask
+ *      The mask (only used for mask rules).
+ * @param isMaskRule
+ *      True for a mask rule.
+ */
+void CanFilter::addRule(CanFilterRuleSet* rules, quint32 first, quint32 last, quint32 mask, bool isMaskRule)
+{
+    if(isMaskRule)
+    {
+        for(auto& el : rules->maskGroups)
+        {
+            if(el.first == mask)
+            {
+                el.second.insert(first & mask);
+                return;
+            }
+        }
+        QSet<quint32> values;
+        values.insert(first & mask);
+        rules->maskGroups.append(qMakePair(mask, values));
+    }
+    else if(first == last)
+    {
+        rules->ids.insert(first);
+    }
+    else
+    {
+        rules->ranges.append(qMakePair(first, last));
+    }
+}
+
+/**
+ * Sorts and merges (overlapping and adjacent) the ranges of a rule set.
+ * @param rules
+ *      The rule set.
+ */
+void CanFilter::mergeRanges(CanFilterRuleSet* rules)
+{
+    if(rules->ranges.isEmpty())
+    {
+        return;
+    }
+
+    std::sort(rules->ranges.begin(), rules->ranges.end());
+
+    QVector<QPair<quint32, quint32> > merged;
+    merged.append(rules->ranges[0]);
+    for(int i = 1; i < rules->ranges.size(); i++)
+    {
+        QPair<quint32, quint32>& last = merged.last();
+        if(rules->ranges[i].first <= (last.second + 1))
+        {
+            last.second = qMax(last.second, rules->ranges[i].second);
+        }
+        else
+        {
+            merged.append(rules->ranges[i]);
+        }
+    }
+    rules->ranges = merged;
+}
+
+/**
+ * Constructor (the relay accepts all frames).
+ * @param parent
+ *      The parent.
+ */
+CanFilterRelay::CanFilterRelay(QObject *parent) : QObject(parent), m_mutex(), m_filter(new CanFilter())
+{
+}
+
+/**
+ * Sets the filter.
+ * @param filter
+ *      The filter.
+ */
+void CanFilterRelay::setFilter(const CanFilter& filter)
+{
+    QSharedPointer<const CanFilter> newFilter(new CanFilter(filter));
+    QMutexLocker locker(&m_mutex);
+    m_filter = newFilter;
+}
+
+/**
+ * Returns the filter.
+ * @return
+ *      The filter.
+ */
+CanFilter CanFilterRelay::filter(void)
+{
+    QMutexLocker locker(&m_mutex);
+    return *m_filter;
+}
+
+/**
+ * Filters received frames and emits framesAcceptedSignal with the frames which have passed.
+ * This slot must be connected with a direct connection to MainInterfaceThread::canMessagesReceivedSignal.
+ * @param frames
+ *      The received frames.
+ */
+void CanFilterRelay::framesReceivedSlot(QVector<CanFrame> frames)
+{
+    QSharedPointer<const CanFilter> filter;
+    {
+        QMutexLocker locker(&m_mutex);
+        filter = m_filter;
+    }
+
+    if(filter->isEmpty())
+    {
+        emit framesAcceptedSignal(frames);
+        return;
+    }
+
+    QVector<CanFrame> accepted = filter->apply(frames);
+    if(!accepted.isEmpty())
+    {
+        emit framesAcceptedSignal(accepted);
+    }
+}
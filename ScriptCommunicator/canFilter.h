@@ -0,0 +1,156 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef CANFILTER_H
+#define CANFILTER_H
+
+#include <QObject>
+#include <QVector>
+#include <QSet>
+#include <QPair>
+#include <QMutex>
+#include <QSharedPointer>
+#include "canFrame.h"
+
+///The rules of one kind (include or exclude rules) of a can filter.
+typedef struct
+{
+    ///The single ids.
+    QSet<quint32> ids;
+
+    ///The ranges (first id, last id), sorted, merged and disjoint.
+    QVector<QPair<quint32, quint32> > ranges;
+
+    ///The mask rules grouped by mask (mask, set of (id & mask)).
+    QVector<QPair<quint32, QSet<quint32> > > maskGroups;
+}CanFilterRuleSet;
+
+///A hardware independent can filter. The filter is compiled from a comma separated list of rules (hex):
+///id (single id), first-last (range) or id:mask (mask rule). A rule with a leading '!' is an exclude rule.
+///An id with 8 hex digits is an extended id (as in the SocketCAN kernel filters).
+///A frame passes the filter if it matches an include rule (or if the filter has no include rules)
+///and if it matches no exclude rule.
+///Standard frames are evaluated with a precomputed table (O(1)), extended frames with a hash set, binary
+///searched ranges and one hash lookup per distinct mask.
+class CanFilter
+{
+public:
+    CanFilter();
+
+    ///Compiles a filter (an empty string creates a filter which accepts all frames).
+    bool compile(QString filter, QString* errorString);
+
+    ///Returns the source of the filter.
+    QString text(void) const {return m_text;}
+
+    ///Returns true if the filter accepts all frames.
+    bool isEmpty(void) const {return m_isEmpty;}
+
+    ///Returns true if a frame passes the filter.
+    bool accepts(const CanFrame& frame) const
+    {
+        if(m_isEmpty)
+        {
+            return true;
+        }
+        if((frame.flags & CAN_FRAME_FLAG_EXTENDED) == 0)
+        {
+            quint32 id = frame.id & 0x7ff;
+            return (m_standardTable[id >> 3] & (1 << (id & 7))) != 0;
+        }
+        return acceptsExtendedId(frame.id & 0x1fffffff);
+    }
+
+    ///Returns the frames which pass the filter.
+    QVector<CanFrame> apply(const QVector<CanFrame>& frames) const;
+
+private:
+
+    ///Returns true if an extended id passes the filter.
+    bool acceptsExtendedId(quint32 id) const;
+
+    ///Returns true if id matches a rule of a rule set.
+    static bool matches(const CanFilterRuleSet& rules, quint32 id);
+
+    ///Adds a rule to a rule set.
+    static void addRule(CanFilterRuleSet* rules, quint32 first, quint32 last, quint32 mask, bool isMaskRule);
+
+    ///Sorts and merges the ranges of a rule set.
+    static void mergeRanges(CanFilterRuleSet* rules);
+
+    ///The source of the filter.
+    QString m_text;
+
+    ///True if the filter accepts all frames.
+    bool m_isEmpty;
+
+    ///True if the filter contains include rules.
+    bool m_hasIncludeRules;
+
+    ///The decision of every standard id (bit (id & 7) of byte (id >> 3) is set if the id passes).
+    quint8 m_standardTable[256];
+
+    ///The include rules for the extended ids.
+    CanFilterRuleSet m_extendedIncludes;
+
+    ///The exclude rules for the extended ids.
+    CanFilterRuleSet m_extendedExcludes;
+};
+
+///Filters the received can frames of one consumer (main window consoles/logs, can tab, script).
+///framesReceivedSlot must be connected with a direct connection to MainInterfaceThread::canMessagesReceivedSignal
+///(the filter is evaluated in the main interface thread), the consumer is connected to framesAcceptedSignal.
+///setFilter and filter are thread safe.
+class CanFilterRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    CanFilterRelay(QObject *parent = 0);
+
+    ///Sets the filter.
+    void setFilter(const CanFilter& filter);
+
+    ///Returns the filter.
+    CanFilter filter(void);
+
+signals:
+    ///Is emitted with the frames which have passed the filter (not emitted if no frame has passed).
+    void framesAcceptedSignal(QVector<CanFrame> frames);
+
+public slots:
+    ///Filters received frames (must be connected with a direct connection).
+    void framesReceivedSlot(QVector<CanFrame> frames);
+
+private:
+
+    ///Protects m_filter.
+    QMutex m_mutex;
+
+    ///The filter (is replaced and not modified, so that it can be evaluated without m_mutex).
+    QSharedPointer<const CanFilter> m_filter;
+};
+
+#endif // CANFILTER_H
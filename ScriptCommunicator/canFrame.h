@@ -0,0 +1,200 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef CANFRAME_H
+#define CANFRAME_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QVector>
+#include <QMetaType>
+#include <string.h>
+
+///The max. number of data bytes in a can frame (CAN FD).
+#define CAN_FRAME_MAX_DATA 64
+
+///The frame is a remote-transfer-request (same value as PCAN_MESSAGE_RTR).
+#define CAN_FRAME_FLAG_RTR 0x01
+
+///The frame has a 29-bit id (same value as PCAN_MESSAGE_EXTENDED).
+#define CAN_FRAME_FLAG_EXTENDED 0x02
+
+///The frame is a CAN FD frame.
+#define CAN_FRAME_FLAG_FD 0x04
+
+///The data of the CAN FD frame has been sent with the bit rate switch.
+#define CAN_FRAME_FLAG_BRS 0x08
+
+///The sender of the CAN FD frame was error passive.
+#define CAN_FRAME_FLAG_ESI 0x10
+
+///The mask for the can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+#define CAN_FRAME_TYPE_MASK (CAN_FRAME_FLAG_RTR | CAN_FRAME_FLAG_EXTENDED)
+
+///A can frame. The frames are passed by value in contiguous vectors (QVector<CanFrame>)
+///from the can drivers to the consumers (no heap allocation per frame).
+typedef struct
+{
+    ///The timestamp (us since the first received frame, 0 for transmitted frames).
+    quint64 timestamp;
+
+    ///The can id (11 or 29 bit).
+    quint32 id;
+
+    ///The flags (CAN_FRAME_FLAG_...).
+    quint8 flags;
+
+    ///The number of data bytes (0-64).
+    quint8 length;
+
+    ///Reserved (alignment).
+    quint8 reserved[2];
+
+    ///The data.
+    quint8 data[CAN_FRAME_MAX_DATA];
+}CanFrame;
+
+Q_DECLARE_METATYPE(CanFrame)
+
+/**
+ * Returns the can type of a frame (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+ * @param frame
+ *      The frame.
+ * @return
+ *      The type.
+ */
+static inline quint8 canFrameType(const CanFrame& frame)
+{
+    return frame.flags & CAN_FRAME_TYPE_MASK;
+}
+
+/**
+ * Initializes a can frame.
+ * @param frame
+ *      The frame.
+ * @param type
+ *      The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+ * @param id
+ *      The can id.
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of data bytes (is limited to CAN_FRAME_MAX_DATA).
+ * @param timestamp
+ *      The timestamp (us).
+ */
+static inline void initCanFrame(CanFrame* frame, quint8 type, quint32 id, const void* data, int length, quint64 timestamp)
+{
+    if(length > CAN_FRAME_MAX_DATA)
+    {
+        length = CAN_FRAME_MAX_DATA;
+    }
+    frame->timestamp = timestamp;
+    frame->id = id;
+    frame->flags = type & CAN_FRAME_TYPE_MASK;
+    frame->length = (length > 0) ? (quint8)length : 0;
+    frame->reserved[0] = 0;
+    frame->reserved[1] = 0;
+    if(frame->length > 0)
+    {
+        memcpy(frame->data, data, frame->length);
+    }
+}
+
+/**
+ * Converts a received can frame into the byte format of the console, the logs and the custom
+ * console/log scripts (byte 0=type, byte 1-4=id, byte 5-8=timestamp (ms), byte 9-n=data).
+ * @param frame
+ *      The frame.
+ * @return
+ *      The created array.
+ */
+static inline QByteArray canFrameToByteArray(const CanFrame& frame)
+{
+    quint32 timestamp = (quint32)(frame.timestamp / 1000);
+    char header[9] = {(char)canFrameType(frame),
+                      (char)(frame.id >> 24), (char)(frame.id >> 16), (char)(frame.id >> 8), (char)frame.id,
+                      (char)(timestamp >> 24), (char)(timestamp >> 16), (char)(timestamp >> 8), (char)timestamp};
+
+    QByteArray result;
+    result.reserve(sizeof(header) + frame.length);
+    result.append(header, sizeof(header));
+    result.append((const char*)frame.data, frame.length);
+    return result;
+}
+
+/**
+ * Converts a can frame into the format of sent data (byte 0=type, byte 1-4=id, byte 5-n=data).
+ * @param frame
+ *      The frame.
+ * @return
+ *      The created array.
+ */
+static inline QByteArray canFrameToSendData(const CanFrame& frame)
+{
+    char header[5] = {(char)canFrameType(frame),
+                      (char)(frame.id >> 24), (char)(frame.id >> 16), (char)(frame.id >> 8), (char)frame.id};
+
+    QByteArray result;
+    result.reserve(sizeof(header) + frame.length);
+    result.append(header, sizeof(header));
+    result.append((const char*)frame.data, frame.length);
+    return result;
+}
+
+/**
+ * Creates the can frames of sent data (byte 0=type, byte 1-4=id, byte 5-n=data, one frame
+ * for every maxBytesPerFrame data bytes).
+ * @param data
+ *      The sent data.
+ * @param maxBytesPerFrame
+ *      The max. number of data bytes in one frame.
+ * @param frames
+ *      The created frames are appended to this vector.
+ */
+static inline void canFramesFromSendData(const QByteArray& data, int maxBytesPerFrame, QVector<CanFrame>* frames)
+{
+    if(data.size() < 5)
+    {
+        return;
+    }
+
+    const quint8* bytes = (const quint8*)data.constData();
+    quint32 id = ((quint32)bytes[1] << 24) | ((quint32)bytes[2] << 16) | ((quint32)bytes[3] << 8) | bytes[4];
+    id &= (bytes[0] & CAN_FRAME_FLAG_EXTENDED) ? 0x1fffffff : 0x7ff;
+    CanFrame frame;
+
+    if(data.size() == 5)
+    {
+        initCanFrame(&frame, bytes[0], id, 0, 0, 0);
+        frames->append(frame);
+    }
+    for(int i = 5; i < data.size(); i += maxBytesPerFrame)
+    {
+        initCanFrame(&frame, bytes[0], id, bytes + i, qMin(maxBytesPerFrame, data.size() - i), 0);
+        frames->append(frame);
+    }
+}
+
+#endif // CANFRAME_H
@@ -25,52 +25,52 @@
 #include "canTab.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <algorithm>
 
 /**
  * Constructor.
  * @param mainWindow
  *      Main window pointer.
  */
-CanTab::CanTab(MainWindow *mainWindow) : QObject(mainWindow), m_mainWindow(mainWindow)
+CanTab::CanTab(MainWindow *mainWindow) : QObject(mainWindow), m_mainWindow(mainWindow),
+    m_receiveModel(new CanTableModel(this)), m_transmitModel(new CanTableModel(this)), m_database(), m_tableFilter(), m_consoleFilter()
 {
     m_creationTime = QDateTime::currentDateTime();
 
+    initTable(m_mainWindow->m_userInterface->canReceiveTableView, m_receiveModel);
+    initTable(m_mainWindow->m_userInterface->canTransmitTableView, m_transmitModel);
+
     connect(&m_updateTimer, SIGNAL(timeout()),this, SLOT(updateTableSlot()));
 
     connect(m_mainWindow->m_userInterface->pcanDeleteReceiveEntryButton, SIGNAL(clicked()),this, SLOT(deleteReceiveTableEntrySlot()));
     connect(m_mainWindow->m_userInterface->pcanDeleteTransmitEntryButton, SIGNAL(clicked()),this, SLOT(deleteTransmitTableEntrySlot()));
+    connect(m_mainWindow->m_userInterface->canLoadDatabaseButton, SIGNAL(clicked()),this, SLOT(loadDatabaseSlot()));
+    connect(m_mainWindow->m_userInterface->canRemoveDatabaseButton, SIGNAL(clicked()),this, SLOT(removeDatabaseSlot()));
+    m_mainWindow->m_userInterface->canRemoveDatabaseButton->setEnabled(false);
+    connect(m_mainWindow->m_userInterface->canTableFilterLineEdit, SIGNAL(editingFinished()),this, SLOT(filterEditingFinishedSlot()));
+    connect(m_mainWindow->m_userInterface->canConsoleFilterLineEdit, SIGNAL(editingFinished()),this, SLOT(filterEditingFinishedSlot()));
+    connect(&m_tableFilter, SIGNAL(framesAcceptedSignal(QVector<CanFrame>)),this, SLOT(canMessagesReceivedSlot(QVector<CanFrame>)), Qt::QueuedConnection);
 
 
     m_updateTimer.start(200);
 }
 
 /**
- * Finds an entry in a can table.
- * @param canId
- *      The can id which must be matched.
+ * Initializes a table.
  * @param table
- *      The can table.
- * @param type
- *      The can type which must be matched.
- * @return
- *      The row of the entry (-1 if not found).
+ *      The table.
+ * @param model
+ *      The model of the table.
  */
-int CanTab::findEntry(quint32 canId, QTableWidget* table, quint8 type)
+void CanTab::initTable(QTableView* table, CanTableModel* model)
 {
-    int row = -1;
-
-    for (int i = 0; i < table->rowCount(); i++)
-    {
-        quint8 storedType = (quint8)table->item(i, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_TYPE_IN_TABLE).toUInt();
-        quint32 storedCanId = table->item(i, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_ID_IN_TABLE).toUInt();
-        if((storedCanId == canId) && (storedType == type))
-        {
-            row = i;
-            break;
-        }
-    }
-
-    return row;
+    table->setModel(model);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->resizeColumnsToContents();
 }
 
 /**
@@ -78,86 +78,66 @@ int CanTab::findEntry(quint32 canId, QTableWidget* table, quint8 type)
  */
 void CanTab::clearTables()
 {
-    m_mainWindow->m_userInterface->canReceiveTableWidget->setRowCount(0);
-    m_mainWindow->m_userInterface->canTransmitTableWidget->setRowCount(0);
+    m_receiveModel->clear();
+    m_transmitModel->clear();
 }
 
 /**
- * Creates a new entry in the can receive table.
- * @param table
- *      The table.
+ * Loads a can database. The signals of the messages in the database are shown in the
+ * signals column of the tables and written into the logs.
+ * @param fileName
+ *      The dbc file (an empty file name removes the current database).
+ * @return
+ *      True on success.
  */
-void CanTab::createNewReceiveEntry(QTableWidget* table)
+bool CanTab::loadDatabase(QString fileName)
 {
-    table->setRowCount(table->rowCount() + 1);
-
-    QTableWidgetItem* item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_ID_COLUMN, item);
-
-    item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_TYPE_COLUMN, item);
-
-    item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_DLC_COLUMN, item);
+    bool success = true;
+    QString errorString;
 
-    item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_DATA_COLUMN, item);
+    m_receiveModel->setDatabase(0);
+    m_transmitModel->setDatabase(0);
 
-    item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_CYCLE_COLUMN, item);
-
-    item = new QTableWidgetItem();
-    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-    table->setItem(table->rowCount()- 1, RECEIVE_TABLE_COUNT_COLUMN, item);
+    if(fileName.isEmpty())
+    {
+        m_database.clear();
+    }
+    else if(!m_database.loadFile(fileName, &errorString))
+    {
+        m_database.clear();
+        QMessageBox::critical(m_mainWindow, "error", "could not load " + fileName + ": " + errorString);
+        success = false;
+    }
 
+    m_receiveModel->setDatabase(getDatabase());
+    m_transmitModel->setDatabase(getDatabase());
+    m_mainWindow->m_userInterface->canRemoveDatabaseButton->setEnabled(!m_database.isEmpty());
+    m_mainWindow->m_userInterface->canLoadDatabaseButton->setToolTip(m_database.fileName());
 
+    return success;
 }
 
 /**
- * Converts a can type to a type string.
- * @param type
- *      The can type.
- * @return
- *      The created string.
+ * Is called if the load dbc button has been pressed.
  */
-QString CanTab::typeToString(quint8 type)
+void CanTab::loadDatabaseSlot(void)
 {
-    QString result;
-    switch(type)
+    QString fileName = QFileDialog::getOpenFileName(m_mainWindow, tr("Open can database"), m_database.fileName(),
+                                                    tr("can databases (*.dbc);;Files (*)"));
+    if(!fileName.isEmpty())
     {
-        case PCAN_MESSAGE_STANDARD:
-        {
-            result = "std";
-            break;
-        }
-        case PCAN_MESSAGE_RTR:
-        {
-            result = "std rtr";
-            break;
-        }
-        case PCAN_MESSAGE_EXTENDED:
-        {
-            result = "ext";
-            break;
-        }
-        case (PCAN_MESSAGE_RTR + PCAN_MESSAGE_EXTENDED):
-        {
-            result = "ext rtr";
-            break;
-        }
-        default:
-        {
-            result = "unkown";
-            break;
-
-        }
+        loadDatabase(fileName);
+        m_mainWindow->configHasToBeSavedSlot();
     }
-    return result;
+}
+
+/**
+ * Is called if the remove dbc button has been pressed.
+ */
+void CanTab::removeDatabaseSlot(void)
+{
+    loadDatabase("");
+    m_mainWindow->configHasToBeSavedSlot();
 }
 
 /**
@@ -165,7 +145,7 @@ QString CanTab::typeToString(quint8 type)
  */
 void CanTab::deleteReceiveTableEntrySlot(void)
 {
-    deleteSelectedEntries(m_mainWindow->m_userInterface->canReceiveTableWidget);
+    deleteSelectedEntries(m_mainWindow->m_userInterface->canReceiveTableView, m_receiveModel);
 }
 
 /**
@@ -173,253 +153,191 @@ void CanTab::deleteReceiveTableEntrySlot(void)
  */
 void CanTab::deleteTransmitTableEntrySlot(void)
 {
-    deleteSelectedEntries(m_mainWindow->m_userInterface->canTransmitTableWidget);
+    deleteSelectedEntries(m_mainWindow->m_userInterface->canTransmitTableView, m_transmitModel);
 }
 
 /**
  * Deletes the selected table entries.
  * @param table
  *      The table.
+ * @param model
+ *      The model of the table.
  */
-void CanTab::deleteSelectedEntries(QTableWidget* table)
+void CanTab::deleteSelectedEntries(QTableView* table, CanTableModel* model)
 {
     QList<int> selectedRows;
-    for(int i = 0; i < table->rowCount(); i++)
+    for(auto el : table->selectionModel()->selectedRows())
     {
-        if(table->item(i, 0)->isSelected())
-        {
-            selectedRows << i;
-        }
+        selectedRows << el.row();
     }
 
-    int alreadySelectedRows = 0;
-    for(auto el : selectedRows)
-    {
-        table->removeRow(el - alreadySelectedRows);
-        alreadySelectedRows++;
-    }
+    model->removeEntries(selectedRows);
 
-    table->selectRow(table->rowCount() - 1);
+    table->selectRow(model->rowCount() - 1);
 }
 
 /**
- * Sorts the can receive table entries.
- * @param table
- *      The table.
+ * Adds a message to a table model (the table is updated in updateTableSlot).
+ * @param model
+ *      The model.
+ * @param frame
+ *      The received or transmitted message.
+ * @param isReceived
+ *      True if the message has been received.
  */
-void CanTab::sortReceiveTable(QTableWidget* table)
+void CanTab::addMessage(CanTableModel* model, const CanFrame& frame, bool isReceived)
 {
-     bool elementsChanged = false;
-
-     do
-     {
-         for(int row = 0; row < (table->rowCount() - 1); row++)
-         {
-             elementsChanged = false;
-             QList<QTableWidgetItem*> rowItems1,rowItems2;
-             quint32 id1 = table->item(row, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_ID_IN_TABLE).toUInt();
-             quint32 id2 = table->item(row + 1, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_ID_IN_TABLE).toUInt();
-             quint32 type1 = table->item(row, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_TYPE_IN_TABLE).toUInt();
-             quint32 type2 = table->item(row + 1, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_TYPE_IN_TABLE).toUInt();
-
-             if((id1 > id2) || ((id1 == id2) && (type1 > type2)))
-             {
-                 elementsChanged = true;
-
-                 //remove all cells from the two rows which position have to be swapped
-                 for (int col = 0; col < table->columnCount(); col++)
-                 {
-                     rowItems1 << table->takeItem(row, col);
-                     rowItems2 << table->takeItem(row + 1, col);
-
-                 }
-                 //insert all cells from the two rows which positions have to be swapped
-                 //at their new positions
-                 for (int cola = 0; cola < table->columnCount(); cola++)
-                 {
-                     table->setItem(row + 1, cola, rowItems1.at(cola));
-                     table->setItem(row, cola, rowItems2.at(cola));
-
-                 }
-                 break;
-             }
-         }
-
-     }while(elementsChanged);
-
-}
-
-/**
- * Update a table entry.
- * @param table
- *      The table.
- * @param data
- *      The received or transmitted entry.
- */
-void CanTab::updateTableEntry(QTableWidget* table, const QByteArray &data, bool isReceived)
-{
-    bool newItemInserted = false;
-
-    quint8 type = data[0];
-    quint32 canId = ((quint8)data[1] << 24) + ((quint8)data[2] << 16) + ((quint8)data[3] << 8) + ((quint8)data[4] & 0xff);
-
     quint32 timestamp = 0;
-    table->blockSignals(true);
 
     if(isReceived)
     {
-        timestamp = ((quint8)data[5] << 24) + ((quint8)data[6] << 16) + ((quint8)data[7] << 8) + ((quint8)data[8] &0xff);
+        timestamp = (quint32)(frame.timestamp / 1000);
     }
     else
     {
         timestamp = (quint32)m_creationTime.msecsTo(QDateTime::currentDateTime());
     }
 
+    model->addFrame(frame, timestamp);
+}
 
-    int row = findEntry(canId, table, type);
-
-    if(row == -1)
+/**
+ * Adds received can messages to the receive table.
+ * This slot is connected to the CanFilterRelay::framesAcceptedSignal signal of m_tableFilter.
+ * @param messages
+ *      The received messages (which have passed the table filter).
+ */
+void CanTab::canMessagesReceivedSlot(QVector<CanFrame> messages)
+{
+    if(m_mainWindow->m_userInterface->pcanUpdateReceiveTableCheckBox->isChecked())
     {
-        newItemInserted= true;
-        createNewReceiveEntry(table);
-        row = table->rowCount()- 1;
-
-        QString idString = QString::number(canId, 16);
-        QString leadingZeros;
-        int numberOfLeadingZeros = 8;
-
-        if((type == PCAN_MESSAGE_STANDARD) || (type == PCAN_MESSAGE_RTR))
-        {
-            numberOfLeadingZeros = 3;
-        }
-        for(int i = 0; i < (numberOfLeadingZeros - idString.size()); i++)
+        for(const auto& el : messages)
         {
-            leadingZeros += "0";
+            addMessage(m_receiveModel, el, true);
         }
-        idString = leadingZeros + idString+ "h";
-
-
-        table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_ID_IN_TABLE, canId);
-        table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_TYPE_IN_TABLE, (quint32)type);
-        table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_TIMESTAMP_IN_TABLE, timestamp);
-
-        table->item(row, RECEIVE_TABLE_ID_COLUMN)->setText(idString);
-        table->item(row, RECEIVE_TABLE_TYPE_COLUMN)->setText(typeToString(type));
-
-        table->resizeColumnsToContents();
-        updateTableSlot();
-
     }
+}
 
-    table->item(row, RECEIVE_TABLE_DLC_COLUMN)->setText(QString("%1").arg(data.length() -
-                                          (isReceived ? PCANBasicClass::BYTES_METADATA_RECEIVE : PCANBasicClass::BYTES_METADATA_SEND)));
-    QString dataString = MainWindow::byteArrayToNumberString(data.mid(isReceived ? PCANBasicClass::BYTES_METADATA_RECEIVE : PCANBasicClass::BYTES_METADATA_SEND),
-                                                             false,  true, false, true, true);
-    table->item(row, RECEIVE_TABLE_DATA_COLUMN)->setText(dataString + " ");
-
-    quint32 storedTimeStamp = table->item(row, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_TIMESTAMP_IN_TABLE).toUInt();
-    quint32 lastCycle = table->item(row, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_LAST_CYCLE_IN_TABLE).toUInt();
-    quint32 secondToLastCycle = table->item(row, RECEIVE_TABLE_ID_COLUMN)->data(USER_ROLE_CAN_SECOND_TO_LAST_CYCLE_IN_TABLE).toUInt();
-    quint32 newCycle = lastCycle;
+/**
+ * Sets the can filters of the receive table and of the consoles/logs.
+ * @param tableFilter
+ *      The filter of the receive table (see CanFilter::compile).
+ * @param consoleFilter
+ *      The filter of the consoles and the logs.
+ */
+void CanTab::setFilters(QString tableFilter, QString consoleFilter)
+{
+    m_mainWindow->m_userInterface->canTableFilterLineEdit->setText(tableFilter);
+    m_mainWindow->m_userInterface->canConsoleFilterLineEdit->setText(consoleFilter);
+    applyFilter(m_mainWindow->m_userInterface->canTableFilterLineEdit, &m_tableFilter);
+    applyFilter(m_mainWindow->m_userInterface->canConsoleFilterLineEdit, &m_consoleFilter);
+}
 
-    if(storedTimeStamp <= timestamp)
+/**
+ * Is called if the editing of a filter line edit has been finished.
+ */
+void CanTab::filterEditingFinishedSlot(void)
+{
+    if(sender() == m_mainWindow->m_userInterface->canTableFilterLineEdit)
     {
-        newCycle = timestamp - storedTimeStamp;
-        quint32 shownCycle = (newCycle + secondToLastCycle + lastCycle) / 3;
-
-        quint32 tmp = shownCycle % 5;
-
-        if(tmp == 4)
-        {//Round up
-            shownCycle++;
-
-        }
-        else if(tmp == 3)
-        {//Round up
-            shownCycle += 2;
-
-        }
-        else if(tmp == 2)
-        {//Round up
-            shownCycle += 3;
-
-        }
-        else
-        {
-            shownCycle = shownCycle - tmp;
-        }
-
-
-
-        table->item(row, RECEIVE_TABLE_CYCLE_COLUMN)->setText(QString("%1").arg(shownCycle));
+        applyFilter(m_mainWindow->m_userInterface->canTableFilterLineEdit, &m_tableFilter);
     }
-
-    table->item(row, RECEIVE_TABLE_COUNT_COLUMN)->setText(QString("%1").arg(table->item(row, RECEIVE_TABLE_COUNT_COLUMN)->text().toUInt() + 1));
-    table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_TIMESTAMP_IN_TABLE, timestamp);
-    table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_SECOND_TO_LAST_CYCLE_IN_TABLE, lastCycle);
-    table->item(row, RECEIVE_TABLE_ID_COLUMN)->setData(USER_ROLE_CAN_LAST_CYCLE_IN_TABLE, newCycle);
-
-    if(newItemInserted)
+    else
     {
-        sortReceiveTable(table);
+        applyFilter(m_mainWindow->m_userInterface->canConsoleFilterLineEdit, &m_consoleFilter);
     }
-
-    table->blockSignals(false);
 }
 
 /**
- * Must be called if a can message has been received.
- * @param data
- *      The received can message.
+ * Compiles the filter of a line edit and sets it in relay. Invalid filters are shown in red
+ * (with the error in the tool tip) and are not set.
+ * @param lineEdit
+ *      The line edit.
+ * @param relay
+ *      The filter relay.
  */
-void CanTab::canMessageReceived(const QByteArray &data)
+void CanTab::applyFilter(QLineEdit* lineEdit, CanFilterRelay* relay)
 {
-    if(m_mainWindow->m_userInterface->pcanUpdateReceiveTableCheckBox->isChecked())
+    CanFilter filter;
+    QString errorString;
+    bool isValid = filter.compile(lineEdit->text(), &errorString);
+
+    if(isValid)
+    {
+        relay->setFilter(filter);
+    }
+
+    if(isValid)
+    {//Restore the default palette (e.g. dark styles).
+        lineEdit->setPalette(QPalette());
+    }
+    else
     {
-        updateTableEntry( m_mainWindow->m_userInterface->canReceiveTableWidget, data, true);
+        QPalette palette = lineEdit->palette();
+        palette.setColor(QPalette::Text, Qt::red);
+        lineEdit->setPalette(palette);
     }
+    lineEdit->setToolTip(errorString);
 }
 
 /**
  * Must be called if a can message has been transmitted.
- * @param data
- *      The received can message.
+ * @param frame
+ *      The transmitted can message.
  */
-void CanTab::canMessageTransmitted(const QByteArray &data)
+void CanTab::canMessageTransmitted(const CanFrame& frame)
 {
     if(m_mainWindow->m_userInterface->pcanUpdateTransmitTableCheckBox->isChecked())
     {
-        updateTableEntry( m_mainWindow->m_userInterface->canTransmitTableWidget, data, false);
+        addMessage(m_transmitModel, frame, false);
     }
 }
 
 /**
- * Resizes a table.
- * @param table
- *      The table.
+ * Cyclic slot function which updates the can receive and the transmit table
+ * (all messages since the last call are shown at once).
  */
-void CanTab::resizeTable(QTableWidget* table)
+void CanTab::updateTableSlot(void)
 {
-
-    table->setColumnWidth(RECEIVE_TABLE_COUNT_COLUMN, table->width() -
-                          (table->columnWidth(RECEIVE_TABLE_ID_COLUMN) + table->columnWidth(RECEIVE_TABLE_TYPE_COLUMN)
-                           + table->columnWidth(RECEIVE_TABLE_DLC_COLUMN) + table->columnWidth(RECEIVE_TABLE_DATA_COLUMN)
-                           + table->columnWidth(RECEIVE_TABLE_CYCLE_COLUMN)
-                           + 2 *table->frameWidth()));
-
+    if(m_receiveModel->update())
+    {
+        m_mainWindow->m_userInterface->canReceiveTableView->resizeColumnsToContents();
+    }
+    if(m_transmitModel->update())
+    {
+        m_mainWindow->m_userInterface->canTransmitTableView->resizeColumnsToContents();
+    }
 }
 
 /**
- * Cyclic slot function which updates the can receive and the transmit table.
+ * Shows the can bus statistics (is connected with MainInterfaceThread::canBusStatisticsSignal).
+ * The ids with the highest frame rates are shown in the tool tip.
+ * @param statistics
+ *      The statistics.
  */
-void CanTab::updateTableSlot(void)
+void CanTab::canBusStatisticsSlot(CanBusStatisticsSnapshot statistics)
 {
-    m_mainWindow->m_userInterface->canReceiveTableWidget->setUpdatesEnabled(true);
-    m_mainWindow->m_userInterface->canTransmitTableWidget->setUpdatesEnabled(true);
-
-    resizeTable(m_mainWindow->m_userInterface->canReceiveTableWidget);
-    resizeTable(m_mainWindow->m_userInterface->canTransmitTableWidget);
-    m_mainWindow->m_userInterface->canReceiveTableWidget->setUpdatesEnabled(false);
-    m_mainWindow->m_userInterface->canTransmitTableWidget->setUpdatesEnabled(false);
+    QString busLoad = (statistics.busLoad < 0) ? QString("- (unknown bit rate)") :
+                                                 QString("%1 % (max. %2 %)").arg(statistics.busLoad, 0, 'f', 1).arg(statistics.maxBusLoad, 0, 'f', 1);
+
+    m_mainWindow->m_userInterface->canBusStatisticsLabel->setText(
+                QString("bus load: %1   rx: %2 frames/s, %3 kbit/s   tx: %4 frames/s, %5 kbit/s   errors: %6 (%7/s)")
+                .arg(busLoad)
+                .arg(statistics.receivedFramesPerSecond, 0, 'f', 0).arg(statistics.receivedBitsPerSecond / 1000.0, 0, 'f', 1)
+                .arg(statistics.sentFramesPerSecond, 0, 'f', 0).arg(statistics.sentBitsPerSecond / 1000.0, 0, 'f', 1)
+                .arg(statistics.errorFrames).arg(statistics.errorFramesPerSecond, 0, 'f', 0));
+
+    QVector<CanIdStatistics> ids = statistics.ids;
+    std::sort(ids.begin(), ids.end(), [](const CanIdStatistics& a, const CanIdStatistics& b)
+    {
+        return (a.receivedFramesPerSecond + a.sentFramesPerSecond) > (b.receivedFramesPerSecond + b.sentFramesPerSecond);
+    });
 
+    QString toolTip = "frames/s (rx/tx):";
+    for(int i = 0; (i < ids.size()) && (i < MAX_IDS_IN_STATISTICS_TOOL_TIP); i++)
+    {
+        toolTip += QString("\n%1 %2: %3/%4").arg(ids[i].id, 0, 16).arg(CanTableModel::typeToString(ids[i].type))
+                .arg(ids[i].receivedFramesPerSecond, 0, 'f', 0).arg(ids[i].sentFramesPerSecond, 0, 'f', 0);
+    }
+    m_mainWindow->m_userInterface->canBusStatisticsLabel->setToolTip(toolTip);
 }
@@ -26,10 +26,14 @@
 #define CANTAB_H
 
 
-#include <QTableWidget>
+#include <QTableView>
+#include <QLineEdit>
 #include <QObject>
 #include <QTimer>
 #include <QTime>
+#include "canTableModel.h"
+#include "canBusStatistics.h"
+#include "canFilter.h"
 
 class MainWindow;
 
@@ -40,85 +44,92 @@ class CanTab : public QObject
 public:
     CanTab(MainWindow* mainWindow);
 
-    ///Must be called if a can message has been received.
-    void canMessageReceived(const QByteArray& data);
-
    ///Must be called if a can message has been transmitted.
-   void canMessageTransmitted(const QByteArray &data);
+   void canMessageTransmitted(const CanFrame& frame);
 
    ///Clears the tables.
    void clearTables();
 
-private slots:
-
-    ///Cyclic slot function which updates the can receive table.
-    void updateTableSlot(void);
-
-    ///Deletes the selected can receive table entries.
-    void deleteReceiveTableEntrySlot(void);
+   ///Loads a can database (dbc file, an empty file name removes the current database).
+   bool loadDatabase(QString fileName);
 
-    ///Deletes the selected can transmit table entries.
-    void deleteTransmitTableEntrySlot(void);
-private:
+   ///Returns the can database (0 if no database is loaded).
+   const CanDatabase* getDatabase(void){return m_database.isEmpty() ? 0 : &m_database;}
 
-    ///Resizes a table.
-    void resizeTable(QTableWidget* table);
+   ///Returns the file name of the loaded can database.
+   QString getDatabaseFileName(void){return m_database.fileName();}
 
-    ///Update a table entry.
-    void updateTableEntry(QTableWidget* table, const QByteArray &data, bool isReceived);
+   ///Returns the filter relay of the can receive table.
+   CanFilterRelay* getTableFilter(void){return &m_tableFilter;}
 
-    ///Sorts the can receive table entries.
-    void sortReceiveTable(QTableWidget *table);
+   ///Returns the filter relay of the consoles and the logs.
+   CanFilterRelay* getConsoleFilter(void){return &m_consoleFilter;}
 
-    ///Deletes the selected table entries.
-    void deleteSelectedEntries(QTableWidget* table);
+   ///Sets the can filters of the receive table and of the consoles/logs (see CanFilter::compile).
+   void setFilters(QString tableFilter, QString consoleFilter);
 
-    ///Converts a can type to a type string.
-    QString typeToString(quint8 type);
+   ///The number of ids which are shown in the tool tip of the bus statistics label.
+   static const int MAX_IDS_IN_STATISTICS_TOOL_TIP = 10;
 
-    ///Creates a new entry in the can receive table.
-    void createNewReceiveEntry(QTableWidget *table);
+public slots:
 
-    ///User role value for the can id in the table.
-    static const int  USER_ROLE_CAN_ID_IN_TABLE = Qt::UserRole + 1;
+    ///Shows the can bus statistics (is connected with MainInterfaceThread::canBusStatisticsSignal).
+    void canBusStatisticsSlot(CanBusStatisticsSnapshot statistics);
 
-    ///User role value for the can type in the table.
-    static const int  USER_ROLE_CAN_TYPE_IN_TABLE = Qt::UserRole + 2;
+    ///Adds received can messages to the receive table (is connected with CanFilterRelay::framesAcceptedSignal of m_tableFilter).
+    void canMessagesReceivedSlot(QVector<CanFrame> messages);
 
-    ///User role value for the can timestamp in the table.
-    static const int  USER_ROLE_CAN_TIMESTAMP_IN_TABLE = Qt::UserRole + 3;
+private slots:
 
-    ///User role value for the last cycle value in the table.
-    static const int  USER_ROLE_CAN_LAST_CYCLE_IN_TABLE = Qt::UserRole + 4;
+    ///Cyclic slot function which updates the can receive and transmit table.
+    void updateTableSlot(void);
 
-    ///User role value for the second to last cycle value in the table.
-    static const int  USER_ROLE_CAN_SECOND_TO_LAST_CYCLE_IN_TABLE = Qt::UserRole + 5;
+    ///Deletes the selected can receive table entries.
+    void deleteReceiveTableEntrySlot(void);
 
+    ///Deletes the selected can transmit table entries.
+    void deleteTransmitTableEntrySlot(void);
 
-    ///Id column in the receive table.
-    static const int  RECEIVE_TABLE_ID_COLUMN = 0;
+    ///Is called if the load dbc button has been pressed.
+    void loadDatabaseSlot(void);
 
-    ///Type column in the receive table.
-    static const int  RECEIVE_TABLE_TYPE_COLUMN = 1;
+    ///Is called if the remove dbc button has been pressed.
+    void removeDatabaseSlot(void);
 
-    ///DLC column in the receive table.
-    static const int  RECEIVE_TABLE_DLC_COLUMN = 2;
+    ///Is called if the editing of a filter line edit has been finished.
+    void filterEditingFinishedSlot(void);
+private:
 
-    ///Data column in the receive table.
-    static const int  RECEIVE_TABLE_DATA_COLUMN = 3;
+    ///Initializes a table.
+    void initTable(QTableView* table, CanTableModel* model);
 
-    ///Cycle column in the receive table.
-    static const int  RECEIVE_TABLE_CYCLE_COLUMN = 4;
+    ///Adds a message to a table model.
+    void addMessage(CanTableModel* model, const CanFrame& frame, bool isReceived);
 
-    ///Cycle column in the receive table.
-    static const int  RECEIVE_TABLE_COUNT_COLUMN = 5;
+    ///Deletes the selected table entries.
+    void deleteSelectedEntries(QTableView* table, CanTableModel* model);
 
-    ///Finds an entry in the can receive table.
-    int findEntry(quint32 canId, QTableWidget* table, quint8 type);
+    ///Compiles the filter of a line edit and sets it in relay (invalid filters are shown in red and not set).
+    void applyFilter(QLineEdit* lineEdit, CanFilterRelay* relay);
 
     ///Main window pointer.
     MainWindow* m_mainWindow;
 
+    ///The model of the can receive table.
+    CanTableModel* m_receiveModel;
+
+    ///The model of the can transmit table.
+    CanTableModel* m_transmitModel;
+
+    ///The can database.
+    CanDatabase m_database;
+
+    ///The filter relay of the can receive table.
+    CanFilterRelay m_tableFilter;
+
+    ///The filter relay of the consoles and the logs.
+    CanFilterRelay m_consoleFilter;
+
     ///Timer which calls updateTableSlot periodically.
     QTimer m_updateTimer;
 
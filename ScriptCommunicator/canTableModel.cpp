@@ -0,0 +1,350 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "canTableModel.h"
+#include "mainwindow.h"
+#include <algorithm>
+
+///The weight of a new cycle value in the moving average of the cycle time.
+static const double CYCLE_EMA_WEIGHT = 0.25;
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ */
+CanTableModel::CanTableModel(QObject* parent) : QAbstractTableModel(parent), m_entries(), m_orderedKeys(), m_newKeys(),
+    m_entriesChanged(false), m_database(0)
+{
+}
+
+/**
+ * Returns the number of rows.
+ * @param parent
+ *      The parent index.
+ * @return
+ *      The number of rows.
+ */
+int CanTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_orderedKeys.size();
+}
+
+/**
+ * Returns the number of columns.
+ * @param parent
+ *      The parent index.
+ * @return
+ *      The number of columns.
+ */
+int CanTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : (int)COLUMN_NUMBER;
+}
+
+/**
+ * Returns the data of a cell (the data is formatted on demand).
+ * @param index
+ *      The model index.
+ * @param role
+ *      The role.
+ * @return
+ *      The data.
+ */
+QVariant CanTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || (index.row() >= m_orderedKeys.size()) || (role != Qt::DisplayRole))
+    {
+        return QVariant();
+    }
+
+    QHash<quint64, CanTableEntry>::const_iterator iter = m_entries.constFind(m_orderedKeys[index.row()]);
+    if(iter == m_entries.constEnd())
+    {
+        return QVariant();
+    }
+    const CanTableEntry& entry = iter.value();
+    QVariant result;
+
+    switch(index.column())
+    {
+        case COLUMN_ID:
+        {
+            int numberOfDigits = (entry.lastFrame.flags & CAN_FRAME_FLAG_EXTENDED) ? 8 : 3;
+            result = QString("%1h").arg(entry.lastFrame.id, numberOfDigits, 16, QChar('0'));
+            break;
+        }
+        case COLUMN_TYPE:
+        {
+            result = typeToString(canFrameType(entry.lastFrame));
+            break;
+        }
+        case COLUMN_DLC:
+        {
+            result = QString::number(entry.lastFrame.length);
+            break;
+        }
+        case COLUMN_DATA:
+        {
+            QByteArray data = QByteArray::fromRawData((const char*)entry.lastFrame.data, entry.lastFrame.length);
+            result = MainWindow::byteArrayToNumberString(data, false,  true, false, true, true) + " ";
+            break;
+        }
+        case COLUMN_CYCLE:
+        {
+            result = (entry.cycleEma < 0) ? QString() : QString::number(qRound(entry.cycleEma));
+            break;
+        }
+        case COLUMN_MIN_CYCLE:
+        {
+            result = (entry.cycleEma < 0) ? QString() : QString::number(entry.minCycle);
+            break;
+        }
+        case COLUMN_MAX_CYCLE:
+        {
+            result = (entry.cycleEma < 0) ? QString() : QString::number(entry.maxCycle);
+            break;
+        }
+        case COLUMN_COUNT:
+        {
+            result = QString::number(entry.count);
+            break;
+        }
+        case COLUMN_SIGNALS:
+        {
+            result = (m_database != 0) ? m_database->decodeFrameToString(entry.lastFrame) : QString();
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+/**
+ * Returns the header data.
+ * @param section
+ *      The section (column or row).
+ * @param orientation
+ *      The orientation.
+ * @param role
+ *      The role.
+ * @return
+ *      The header data.
+ */
+QVariant CanTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if((orientation == Qt::Horizontal) && (role == Qt::DisplayRole))
+    {
+        static const char* names[COLUMN_NUMBER] = {"id", "type", "dlc", "data", "cycle", "min", "max", "count", "signals"};
+        if((section >= 0) && (section < COLUMN_NUMBER))
+        {
+            return QString(names[section]);
+        }
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+/**
+ * Sets the can database which is used to decode the signals column.
+ * @param database
+ *      The database (0=no database).
+ */
+void CanTableModel::setDatabase(const CanDatabase* database)
+{
+    m_database = database;
+    if(!m_orderedKeys.isEmpty())
+    {
+        emit dataChanged(index(0, COLUMN_SIGNALS), index(m_orderedKeys.size() - 1, COLUMN_SIGNALS));
+    }
+}
+
+/**
+ * Adds a can frame. The view is updated in update.
+ * @param frame
+ *      The frame.
+ * @param timestamp
+ *      The timestamp of the frame (ms).
+ */
+void CanTableModel::addFrame(const CanFrame& frame, quint32 timestamp)
+{
+    quint64 key = createKey(frame.id, canFrameType(frame));
+    QHash<quint64, CanTableEntry>::iterator iter = m_entries.find(key);
+
+    if(iter == m_entries.end())
+    {
+        CanTableEntry newEntry;
+        newEntry.lastFrame = frame;
+        newEntry.count = 0;
+        newEntry.lastTimestamp = timestamp;
+        newEntry.cycleEma = -1;
+        newEntry.minCycle = 0;
+        newEntry.maxCycle = 0;
+
+        iter = m_entries.insert(key, newEntry);
+        m_newKeys.append(key);
+    }
+
+    CanTableEntry& entry = iter.value();
+
+    if((entry.count > 0) && (entry.lastTimestamp <= timestamp))
+    {
+        quint32 cycle = timestamp - entry.lastTimestamp;
+
+        if(entry.cycleEma < 0)
+        {
+            entry.cycleEma = cycle;
+            entry.minCycle = cycle;
+            entry.maxCycle = cycle;
+        }
+        else
+        {
+            entry.cycleEma += CYCLE_EMA_WEIGHT * ((double)cycle - entry.cycleEma);
+            if(cycle < entry.minCycle)
+            {
+                entry.minCycle = cycle;
+            }
+            if(cycle > entry.maxCycle)
+            {
+                entry.maxCycle = cycle;
+            }
+        }
+    }
+
+    entry.lastTimestamp = timestamp;
+    entry.lastFrame = frame;
+    entry.count++;
+    m_entriesChanged = true;
+}
+
+/**
+ * Shows the messages which have been added since the last call. The rows for new ids are
+ * inserted at their sorted positions and the changed rows are updated with one dataChanged signal.
+ * @return
+ *      True if rows have been inserted.
+ */
+bool CanTableModel::update(void)
+{
+    bool rowsInserted = !m_newKeys.isEmpty();
+
+    std::sort(m_newKeys.begin(), m_newKeys.end());
+    for(auto key : m_newKeys)
+    {
+        int row = std::lower_bound(m_orderedKeys.begin(), m_orderedKeys.end(), key) - m_orderedKeys.begin();
+
+        beginInsertRows(QModelIndex(), row, row);
+        m_orderedKeys.insert(row, key);
+        endInsertRows();
+    }
+    m_newKeys.clear();
+
+    if(m_entriesChanged && !m_orderedKeys.isEmpty())
+    {
+        emit dataChanged(index(0, COLUMN_DLC), index(m_orderedKeys.size() - 1, COLUMN_NUMBER - 1));
+    }
+    m_entriesChanged = false;
+
+    return rowsInserted;
+}
+
+/**
+ * Removes rows (and their entries).
+ * @param rows
+ *      The rows.
+ */
+void CanTableModel::removeEntries(QList<int> rows)
+{
+    //Remove the rows from the bottom to the top (the indexes of the remaining rows stay valid).
+    std::sort(rows.begin(), rows.end());
+    for(int i = rows.size() - 1; i >= 0; i--)
+    {
+        int row = rows[i];
+        if((row < 0) || (row >= m_orderedKeys.size()) || ((i < (rows.size() - 1)) && (rows[i + 1] == row)))
+        {
+            continue;
+        }
+
+        beginRemoveRows(QModelIndex(), row, row);
+        m_entries.remove(m_orderedKeys[row]);
+        m_orderedKeys.remove(row);
+        endRemoveRows();
+    }
+}
+
+/**
+ * Removes all entries.
+ */
+void CanTableModel::clear(void)
+{
+    beginResetModel();
+    m_entries.clear();
+    m_orderedKeys.clear();
+    m_newKeys.clear();
+    m_entriesChanged = false;
+    endResetModel();
+}
+
+/**
+ * Converts a can type to a type string.
+ * @param type
+ *      The can type.
+ * @return
+ *      The created string.
+ */
+QString CanTableModel::typeToString(quint8 type)
+{
+    QString result;
+    switch(type)
+    {
+        case PCAN_MESSAGE_STANDARD:
+        {
+            result = "std";
+            break;
+        }
+        case PCAN_MESSAGE_RTR:
+        {
+            result = "std rtr";
+            break;
+        }
+        case PCAN_MESSAGE_EXTENDED:
+        {
+            result = "ext";
+            break;
+        }
+        case (PCAN_MESSAGE_RTR + PCAN_MESSAGE_EXTENDED):
+        {
+            result = "ext rtr";
+            break;
+        }
+        default:
+        {
+            result = "unkown";
+            break;
+
+        }
+    }
+    return result;
+}
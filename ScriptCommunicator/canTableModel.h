@@ -0,0 +1,134 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef CANTABLEMODEL_H
+#define CANTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include "canFrame.h"
+#include "canDatabase.h"
+
+///Statistics of one can id/type in the can tables.
+typedef struct
+{
+    ///The last frame.
+    CanFrame lastFrame;
+
+    ///The number of messages.
+    quint64 count;
+
+    ///The timestamp of the last message.
+    quint32 lastTimestamp;
+
+    ///The exponential moving average of the cycle time (ms, <0 if no cycle has been measured).
+    double cycleEma;
+
+    ///The min. cycle time (ms).
+    quint32 minCycle;
+
+    ///The max. cycle time (ms).
+    quint32 maxCycle;
+}CanTableEntry;
+
+///Model for the can receive and transmit table. The entries are stored in a hash (key: id and type)
+///and an ordered index (sorted by id and type) maps the rows to the entries.
+///Added messages are only shown after update has been called (once per UI tick).
+class CanTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    CanTableModel(QObject* parent);
+
+    ///The columns.
+    enum Column
+    {
+        COLUMN_ID = 0,
+        COLUMN_TYPE,
+        COLUMN_DLC,
+        COLUMN_DATA,
+        COLUMN_CYCLE,
+        COLUMN_MIN_CYCLE,
+        COLUMN_MAX_CYCLE,
+        COLUMN_COUNT,
+        COLUMN_SIGNALS,
+        COLUMN_NUMBER
+    };
+
+    ///Returns the number of rows.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    ///Returns the number of columns.
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+    ///Returns the data of a cell.
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    ///Returns the header data.
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    ///Adds a can frame (timestamp in ms). The view is updated in update.
+    void addFrame(const CanFrame& frame, quint32 timestamp);
+
+    ///Shows the messages which have been added since the last call (inserts the rows
+    ///for new ids and updates the changed rows). Returns true if rows have been inserted.
+    bool update(void);
+
+    ///Removes rows (and their entries).
+    void removeEntries(QList<int> rows);
+
+    ///Removes all entries.
+    void clear(void);
+
+    ///Sets the can database which is used to decode the signals column (0=no database).
+    void setDatabase(const CanDatabase* database);
+
+    ///Converts a can type to a type string.
+    static QString typeToString(quint8 type);
+
+private:
+
+    ///Creates the hash key (the order of the keys is the order of the rows).
+    static quint64 createKey(quint32 canId, quint8 type){return ((quint64)canId << 8) | type;}
+
+    ///All entries.
+    QHash<quint64, CanTableEntry> m_entries;
+
+    ///The ordered index (the keys of the shown entries sorted by id and type).
+    QVector<quint64> m_orderedKeys;
+
+    ///The keys of the entries which have been created since the last update.
+    QVector<quint64> m_newKeys;
+
+    ///True if a message has been added since the last update.
+    bool m_entriesChanged;
+
+    ///The can database (0 if the signals are not decoded).
+    const CanDatabase* m_database;
+};
+
+#endif // CANTABLEMODEL_H
@@ -0,0 +1,395 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "canTransmitScheduler.h"
+#include <QThread>
+#include <QMutexLocker>
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ */
+CanTransmitScheduler::CanTransmitScheduler(QObject *parent) : QObject(parent), m_mutex(), m_messages(), m_indexes(), m_clock(), m_timer(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(timerSlot()));
+
+    m_clock.start();
+}
+
+/**
+ * Adds a periodic message or replaces the message with the same type and id.
+ * The first frame is sent immediately.
+ * @param ownerId
+ *      The id of the owner (send id of the script thread).
+ * @param type
+ *      The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+ * @param id
+ *      The can id.
+ * @param data
+ *      The payload.
+ * @param cycleTime
+ *      The cycle time (ms).
+ * @param notifyOwner
+ *      True if periodicMessagesSentSignal shall be emitted after every transmission.
+ * @return
+ *      False if the cycle time is too small.
+ */
+bool CanTransmitScheduler::setMessage(quint32 ownerId, quint8 type, quint32 id, const QByteArray& data, double cycleTime, bool notifyOwner)
+{
+    qint64 cycleTimeNs = (qint64)(cycleTime * 1000000.0);
+    if(cycleTimeNs < MIN_CYCLE_TIME_NS)
+    {
+        return false;
+    }
+
+    id = maskId(type, id);
+
+    CanPeriodicMessage message;
+    initCanFrame(&message.frame, type, id, data.constData(), data.size(), 0);
+    message.ownerId = ownerId;
+    message.cycleTimeNs = cycleTimeNs;
+    message.nextDeadlineNs = m_clock.nsecsElapsed();
+    message.lastSendTimeNs = -1;
+    message.notifyOwner = notifyOwner;
+    message.sentFrames = 0;
+    message.missedCycles = 0;
+    message.cycleTimeSumNs = 0;
+    message.minCycleTimeNs = 0;
+    message.maxCycleTimeNs = 0;
+    message.delaySumNs = 0;
+    message.maxDelayNs = 0;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        quint32 key = createKey(type, id);
+        qint32 index = m_indexes.value(key, -1);
+        if(index >= 0)
+        {
+            m_messages[index] = message;
+        }
+        else
+        {
+            m_indexes[key] = m_messages.size();
+            m_messages.append(message);
+        }
+    }
+
+    triggerReschedule();
+    return true;
+}
+
+/**
+ * Updates the payload of a periodic message (is used for the next transmission).
+ * @param type
+ *      The can type.
+ * @param id
+ *      The can id.
+ * @param data
+ *      The new payload.
+ * @return
+ *      False if the message does not exist.
+ */
+bool CanTransmitScheduler::setPayload(quint8 type, quint32 id, const QByteArray& data)
+{
+    id = maskId(type, id);
+
+    QMutexLocker locker(&m_mutex);
+    qint32 index = m_indexes.value(createKey(type, id), -1);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    CanFrame& frame = m_messages[index].frame;
+    initCanFrame(&frame, type, frame.id, data.constData(), data.size(), 0);
+    return true;
+}
+
+/**
+ * Removes a periodic message.
+ * @param type
+ *      The can type.
+ * @param id
+ *      The can id.
+ */
+void CanTransmitScheduler::removeMessage(quint8 type, quint32 id)
+{
+    id = maskId(type, id);
+
+    QMutexLocker locker(&m_mutex);
+    qint32 index = m_indexes.value(createKey(type, id), -1);
+    if(index >= 0)
+    {
+        removeAt(index);
+    }
+}
+
+/**
+ * Removes all periodic messages of an owner.
+ * @param ownerId
+ *      The id of the owner.
+ */
+void CanTransmitScheduler::removeAllMessages(quint32 ownerId)
+{
+    QMutexLocker locker(&m_mutex);
+    for(qint32 index = m_messages.size() - 1; index >= 0; index--)
+    {
+        if(m_messages[index].ownerId == ownerId)
+        {
+            removeAt(index);
+        }
+    }
+}
+
+/**
+ * Removes the message at index (the last message is moved to index).
+ * m_mutex must be locked by the caller.
+ * @param index
+ *      The index.
+ */
+void CanTransmitScheduler::removeAt(qint32 index)
+{
+    m_indexes.remove(createKey(m_messages[index].frame.flags, m_messages[index].frame.id));
+
+    qint32 lastIndex = m_messages.size() - 1;
+    if(index != lastIndex)
+    {
+        m_messages[index] = m_messages[lastIndex];
+        m_indexes[createKey(m_messages[index].frame.flags, m_messages[index].frame.id)] = index;
+    }
+    m_messages.removeLast();
+}
+
+/**
+ * Returns the measured cycle accuracy of a periodic message.
+ * @param type
+ *      The can type.
+ * @param id
+ *      The can id.
+ * @param statistics
+ *      The statistics (all times in ms).
+ * @return
+ *      False if the message does not exist.
+ */
+bool CanTransmitScheduler::getStatistics(quint8 type, quint32 id, CanPeriodicMessageStatistics* statistics)
+{
+    id = maskId(type, id);
+
+    QMutexLocker locker(&m_mutex);
+    qint32 index = m_indexes.value(createKey(type, id), -1);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    const CanPeriodicMessage& message = m_messages[index];
+    quint64 measuredCycles = (message.sentFrames > 1) ? (message.sentFrames - 1) : 0;
+
+    statistics->cycleTime = (double)message.cycleTimeNs / 1000000.0;
+    statistics->sentFrames = message.sentFrames;
+    statistics->missedCycles = message.missedCycles;
+    statistics->meanCycleTime = (measuredCycles > 0) ? ((double)message.cycleTimeSumNs / (double)measuredCycles) / 1000000.0 : 0.0;
+    statistics->minCycleTime = (double)message.minCycleTimeNs / 1000000.0;
+    statistics->maxCycleTime = (double)message.maxCycleTimeNs / 1000000.0;
+    statistics->meanDelay = (message.sentFrames > 0) ? ((double)message.delaySumNs / (double)message.sentFrames) / 1000000.0 : 0.0;
+    statistics->maxDelay = (double)message.maxDelayNs / 1000000.0;
+    return true;
+}
+
+/**
+ * Stops the scheduler (must be called in the thread of the scheduler).
+ */
+void CanTransmitScheduler::stopSlot(void)
+{
+    m_timer->stop();
+}
+
+/**
+ * Triggers rescheduleSlot in the thread of the scheduler.
+ */
+void CanTransmitScheduler::triggerReschedule(void)
+{
+    QMetaObject::invokeMethod(this, "rescheduleSlot", Qt::QueuedConnection);
+}
+
+/**
+ * Returns the earliest deadline of all messages.
+ * @return
+ *      The deadline (ns since the start of the scheduler, -1 if no message exists).
+ */
+qint64 CanTransmitScheduler::nextDeadline(void)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 deadline = -1;
+    for(const auto& el : m_messages)
+    {
+        if((deadline < 0) || (el.nextDeadlineNs < deadline))
+        {
+            deadline = el.nextDeadlineNs;
+        }
+    }
+    return deadline;
+}
+
+/**
+ * Starts the timer for the next deadline (must be called in the thread of the scheduler).
+ */
+void CanTransmitScheduler::rescheduleSlot(void)
+{
+    qint64 deadline = nextDeadline();
+    if(deadline < 0)
+    {
+        m_timer->stop();
+        return;
+    }
+
+    qint64 remainingNs = deadline - m_clock.nsecsElapsed() - SEND_TOLERANCE_NS;
+    if(remainingNs <= MAX_ACTIVE_WAIT_NS)
+    {
+        m_timer->start(0);
+    }
+    else
+    {
+        //The timer has a resolution of 1 ms (rounded, min. 1 ms so that the thread does not poll the deadline).
+        m_timer->start(qMax((int)((remainingNs + 500000) / 1000000), 1));
+    }
+}
+
+/**
+ * Sends all due messages and starts the timer for the next deadline.
+ */
+void CanTransmitScheduler::timerSlot(void)
+{
+    qint64 deadline = nextDeadline();
+    if(deadline < 0)
+    {
+        return;
+    }
+
+    qint64 remainingNs = deadline - m_clock.nsecsElapsed();
+    if(remainingNs > SEND_TOLERANCE_NS)
+    {
+        if(remainingNs > (SEND_TOLERANCE_NS + MAX_ACTIVE_WAIT_NS))
+        {//The timer has fired early or has been started for an earlier (removed or replaced) message.
+            rescheduleSlot();
+            return;
+        }
+
+        //Spin for the rest of the time (max. MAX_ACTIVE_WAIT_NS, QThread::usleep sleeps at least
+        //one scheduler tick on Windows).
+        while((deadline - m_clock.nsecsElapsed()) > SEND_TOLERANCE_NS)
+        {
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    sendDueMessages();
+    rescheduleSlot();
+}
+
+/**
+ * Sends all messages which are due (within SEND_TOLERANCE_NS) with one framesDueSignal and
+ * updates the deadlines and the cycle statistics.
+ */
+void CanTransmitScheduler::sendDueMessages(void)
+{
+    QVector<CanFrame> frames;
+    QVector<quint32> keys;
+    QVector<CanFrame> notifiedFrames;
+    qint64 now = m_clock.nsecsElapsed();
+
+    {
+        QMutexLocker locker(&m_mutex);
+        for(const auto& el : m_messages)
+        {
+            if((el.nextDeadlineNs - SEND_TOLERANCE_NS) <= now)
+            {
+                frames.append(el.frame);
+                keys.append(createKey(el.frame.flags, el.frame.id));
+            }
+        }
+    }
+
+    if(frames.isEmpty())
+    {
+        return;
+    }
+
+    //The mutex is not locked during the sending (setPayload must not wait for the driver).
+    bool success = false;
+    emit framesDueSignal(frames, &success);
+
+    {
+        QMutexLocker locker(&m_mutex);
+        for(auto key : keys)
+        {
+            qint32 index = m_indexes.value(key, -1);
+            if(index < 0)
+            {//The message has been removed during the sending.
+                continue;
+            }
+
+            CanPeriodicMessage& message = m_messages[index];
+            if(success)
+            {
+                qint64 delayNs = now - message.nextDeadlineNs;
+                message.delaySumNs += delayNs;
+                message.maxDelayNs = qMax(message.maxDelayNs, delayNs);
+
+                if(message.lastSendTimeNs >= 0)
+                {
+                    qint64 cycleTimeNs = now - message.lastSendTimeNs;
+                    message.cycleTimeSumNs += cycleTimeNs;
+                    message.minCycleTimeNs = (message.sentFrames > 1) ? qMin(message.minCycleTimeNs, cycleTimeNs) : cycleTimeNs;
+                    message.maxCycleTimeNs = qMax(message.maxCycleTimeNs, cycleTimeNs);
+                }
+                message.lastSendTimeNs = now;
+                message.sentFrames++;
+
+                if(message.notifyOwner)
+                {
+                    notifiedFrames.append(message.frame);
+                }
+            }
+
+            message.nextDeadlineNs += message.cycleTimeNs;
+            if(message.nextDeadlineNs <= now)
+            {//The deadline has been missed by more than one cycle (the missed cycles are not sent).
+                qint64 missedCycles = ((now - message.nextDeadlineNs) / message.cycleTimeNs) + 1;
+                message.missedCycles += missedCycles;
+                message.nextDeadlineNs += missedCycles * message.cycleTimeNs;
+            }
+        }
+    }
+
+    if(!notifiedFrames.isEmpty())
+    {
+        emit periodicMessagesSentSignal(notifiedFrames);
+    }
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef CANTRANSMITSCHEDULER_H
+#define CANTRANSMITSCHEDULER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
+#include "canFrame.h"
+
+///A periodic can message of the transmit scheduler.
+typedef struct
+{
+    ///The frame (the payload is updated with CanTransmitScheduler::setPayload).
+    CanFrame frame;
+
+    ///The id of the owner (send id of the script thread).
+    quint32 ownerId;
+
+    ///The cycle time (ns).
+    qint64 cycleTimeNs;
+
+    ///The next deadline (ns since the start of the scheduler).
+    qint64 nextDeadlineNs;
+
+    ///The time of the last transmission (ns since the start of the scheduler, -1 if not sent yet).
+    qint64 lastSendTimeNs;
+
+    ///True if the owner shall be notified after every transmission (periodicMessagesSentSignal).
+    bool notifyOwner;
+
+    ///The number of sent frames.
+    quint64 sentFrames;
+
+    ///The number of cycles which have been skipped because the deadline was missed by more than one cycle.
+    quint64 missedCycles;
+
+    ///The sum of all measured cycle times (ns).
+    qint64 cycleTimeSumNs;
+
+    ///The min. measured cycle time (ns).
+    qint64 minCycleTimeNs;
+
+    ///The max. measured cycle time (ns).
+    qint64 maxCycleTimeNs;
+
+    ///The sum of all delays (transmission time - deadline, ns).
+    qint64 delaySumNs;
+
+    ///The max. delay (ns).
+    qint64 maxDelayNs;
+}CanPeriodicMessage;
+
+///The measured cycle accuracy of a periodic can message (all times in ms).
+typedef struct
+{
+    ///The configured cycle time.
+    double cycleTime;
+
+    ///The number of sent frames.
+    quint64 sentFrames;
+
+    ///The number of skipped cycles.
+    quint64 missedCycles;
+
+    ///The mean measured cycle time.
+    double meanCycleTime;
+
+    ///The min. measured cycle time.
+    double minCycleTime;
+
+    ///The max. measured cycle time.
+    double maxCycleTime;
+
+    ///The mean delay (transmission time - deadline).
+    double meanDelay;
+
+    ///The max. delay.
+    double maxDelay;
+}CanPeriodicMessageStatistics;
+
+///Sends periodic can messages with individual cycle times. The scheduler lives in the main interface thread
+///and uses absolute deadlines (the send time does not add up). All messages which are due at the same
+///time are sent with one call (framesDueSignal). The public functions are thread safe.
+class CanTransmitScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    CanTransmitScheduler(QObject *parent = 0);
+
+    ///The min. cycle time (ns).
+    static const qint64 MIN_CYCLE_TIME_NS = 100000;
+
+    ///If the next deadline is less than SEND_TOLERANCE_NS + MAX_ACTIVE_WAIT_NS away, then the scheduler
+    ///spins on the clock instead of starting the timer. The spinning is kept short because the scheduler
+    ///runs in the main interface thread (which also receives the can frames).
+    static const qint64 MAX_ACTIVE_WAIT_NS = 100000;
+
+    ///Messages whose deadline is less than this time (ns) in the future are sent together with the due messages.
+    static const qint64 SEND_TOLERANCE_NS = 200000;
+
+    ///Adds a periodic message or replaces the message with the same type and id.
+    ///The first frame is sent immediately.
+    bool setMessage(quint32 ownerId, quint8 type, quint32 id, const QByteArray& data, double cycleTime, bool notifyOwner);
+
+    ///Updates the payload of a periodic message (is used for the next transmission).
+    bool setPayload(quint8 type, quint32 id, const QByteArray& data);
+
+    ///Removes a periodic message.
+    void removeMessage(quint8 type, quint32 id);
+
+    ///Removes all periodic messages of an owner.
+    void removeAllMessages(quint32 ownerId);
+
+    ///Returns the measured cycle accuracy of a periodic message (false if the message does not exist).
+    bool getStatistics(quint8 type, quint32 id, CanPeriodicMessageStatistics* statistics);
+
+    ///Returns the id masked to 11 bits (standard) or 29 bits (extended). All functions of the scheduler
+    ///store and look up the masked id.
+    static quint32 maskId(quint8 type, quint32 id){return id & ((type & CAN_FRAME_FLAG_EXTENDED) ? 0x1fffffff : 0x7ff);}
+
+    ///Returns the key of a periodic message (the id must be masked with maskId, the rtr bit is ignored).
+    static quint32 createKey(quint8 type, quint32 id){return (type & CAN_FRAME_FLAG_EXTENDED) ? (id | 0x80000000) : id;}
+
+signals:
+    ///Is emitted if periodic messages are due. The receiver sends the frames and sets success.
+    ///This signal must be connected with a direct connection.
+    void framesDueSignal(const QVector<CanFrame>& frames, bool* success);
+
+    ///Is emitted after the transmission of periodic messages whose owner shall be notified.
+    void periodicMessagesSentSignal(QVector<CanFrame> frames);
+
+public slots:
+    ///Stops the scheduler (must be called in the thread of the scheduler).
+    void stopSlot(void);
+
+private slots:
+    ///Sends all due messages and starts the timer for the next deadline.
+    void timerSlot(void);
+
+    ///Starts the timer for the next deadline (must be called in the thread of the scheduler).
+    void rescheduleSlot(void);
+
+private:
+
+    ///Returns the earliest deadline of all messages (-1 if no message exists).
+    qint64 nextDeadline(void);
+
+    ///Sends all messages which are due (within SEND_TOLERANCE_NS).
+    void sendDueMessages(void);
+
+    ///Triggers rescheduleSlot in the thread of the scheduler.
+    void triggerReschedule(void);
+
+    ///Removes the message at index (the last message is moved to index).
+    void removeAt(qint32 index);
+
+    ///Protects m_messages and m_indexes.
+    QMutex m_mutex;
+
+    ///All periodic messages.
+    QVector<CanPeriodicMessage> m_messages;
+
+    ///Maps the key of a message (createKey) to its index in m_messages.
+    QHash<quint32, qint32> m_indexes;
+
+    ///The time base of all deadlines.
+    QElapsedTimer m_clock;
+
+    ///The timer for the next deadline.
+    QTimer* m_timer;
+};
+
+#endif // CANTRANSMITSCHEDULER_H
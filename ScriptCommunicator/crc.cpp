@@ -40,6 +40,20 @@ CRC::CRC()
  *      The calculated crc.
  */
 quint8 CRC::calculateCrc8(const QVector<unsigned char> data)
+{
+    return calculateCrc8(data.constData(), data.size());
+}
+
+/**
+ * Calculates a crc8 (without copying the data into a vector).
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of bytes in data.
+ * @return
+ *      The calculated crc.
+ */
+quint8 CRC::calculateCrc8(const unsigned char* data, int length)
 {
     static const quint8 crc8Table[] = {
         0x00, 0x3e, 0x7c, 0x42, 0xf8, 0xc6, 0x84, 0xba, 0x95, 0xab, 0xe9, 0xd7,
@@ -66,8 +80,9 @@ quint8 CRC::calculateCrc8(const QVector<unsigned char> data)
         0x57, 0x69, 0x2b, 0x15};
 
     quint8 crc  = 0xff;
-    for (auto val : data)
+    for (int i = 0; i < length; i++)
     {
+        const unsigned char val = data[i];
         crc = crc8Table[(crc ^ val) & 0xff];
     }
     crc = ~crc;
@@ -83,6 +98,20 @@ quint8 CRC::calculateCrc8(const QVector<unsigned char> data)
  *      The calculated crc.
  */
 quint16 CRC::calculateCrc16(const QVector<unsigned char> data)
+{
+    return calculateCrc16(data.constData(), data.size());
+}
+
+/**
+ * Calculates a crc16 (without copying the data into a vector).
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of bytes in data.
+ * @return
+ *      The calculated crc.
+ */
+quint16 CRC::calculateCrc16(const unsigned char* data, int length)
 {
     static const quint16 crc16Table[256] =
     {
@@ -120,8 +149,9 @@ quint16 CRC::calculateCrc16(const QVector<unsigned char> data)
      0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040 };
 
     quint16 crc = 0xFFFF;
-    for (auto val : data)
+    for (int i = 0; i < length; i++)
     {
+        const unsigned char val = data[i];
         crc = (crc >> 8) ^ crc16Table[(crc ^ val) & 0xff];
     }
     crc = ~crc;
@@ -138,6 +168,20 @@ quint16 CRC::calculateCrc16(const QVector<unsigned char> data)
  *      The calculated crc.
  */
 quint32 CRC::calculateCrc32(const QVector<unsigned char> data)
+{
+    return calculateCrc32(data.constData(), data.size());
+}
+
+/**
+ * Calculates a crc32 (without copying the data into a vector).
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of bytes in data.
+ * @return
+ *      The calculated crc.
+ */
+quint32 CRC::calculateCrc32(const unsigned char* data, int length)
 {
     static bool crc32TableCreated = false;
     static quint32 crc32Table[256];
@@ -167,8 +211,9 @@ quint32 CRC::calculateCrc32(const QVector<unsigned char> data)
     }
 
     quint32 crc = 0xFFFFFFFF;
-    for (auto val : data)
+    for (int i = 0; i < length; i++)
     {
+        const unsigned char val = data[i];
         crc = crc32Table[(crc ^ val) & 0xFF] ^ (crc >> 8);
     }
     crc = ~crc;
@@ -184,6 +229,20 @@ quint32 CRC::calculateCrc32(const QVector<unsigned char> data)
  *      The calculated crc.
  */
 quint64 CRC::calculateCrc64(const QVector<unsigned char> data)
+{
+    return calculateCrc64(data.constData(), data.size());
+}
+
+/**
+ * Calculates a crc64 (without copying the data into a vector).
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of bytes in data.
+ * @return
+ *      The calculated crc.
+ */
+quint64 CRC::calculateCrc64(const unsigned char* data, int length)
 {
     static bool crc64TableCreated = false;
     static quint64 crc64Table[256];
@@ -214,8 +273,9 @@ quint64 CRC::calculateCrc64(const QVector<unsigned char> data)
     }
 
     quint64 crc = 0;
-    for (auto val : data)
+    for (int i = 0; i < length; i++)
     {
+        const unsigned char val = data[i];
         crc = crc64Table[(crc ^ val) & 0xFF] ^ (crc >> 8);
     }
     crc = ~crc;
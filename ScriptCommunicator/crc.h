@@ -36,14 +36,26 @@ public:
     ///Calculates a crc8.
     static quint8 calculateCrc8(const QVector<unsigned char> data);
 
+    ///Calculates a crc8 over length bytes starting at data.
+    static quint8 calculateCrc8(const unsigned char* data, int length);
+
     ///Calculates a crc16.
     static quint16 calculateCrc16(const QVector<unsigned char> data);
 
+    ///Calculates a crc16 over length bytes starting at data.
+    static quint16 calculateCrc16(const unsigned char* data, int length);
+
     ///Calculates a crc32.
     static quint32 calculateCrc32(const QVector<unsigned char> data);
 
+    ///Calculates a crc32 over length bytes starting at data.
+    static quint32 calculateCrc32(const unsigned char* data, int length);
+
     ///Calculates a crc64.
     static quint64 calculateCrc64(const QVector<unsigned char> data);
+
+    ///Calculates a crc64 over length bytes starting at data.
+    static quint64 calculateCrc64(const unsigned char* data, int length);
 };
 
 #endif // CRC_H
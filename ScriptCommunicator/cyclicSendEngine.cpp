@@ -0,0 +1,377 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "cyclicSendEngine.h"
+#include "mainInterfaceThread.h"
+
+const quint32 CyclicSendEngine::HISTOGRAM_LIMITS_US[CyclicSendEngine::HISTOGRAM_BIN_COUNT - 1] = {50, 100, 200, 500, 1000, 2000, 5000, 10000};
+
+/**
+ * Constructor.
+ */
+CyclicSendEngine::CyclicSendEngine() : QThread(0), m_mutex(), m_waitCondition(), m_payloads(),
+    m_isConstantPayload(false), m_noMorePayloads(false), m_payloadsRequested(false), m_numberOfSends(0), m_periodNs(0),
+    m_stop(false), m_sendIsPending(false), m_statistics(), m_periodSumNs(0), m_elapsedTimer()
+{
+    m_statistics.numberOfSends = 0;
+    m_statistics.nominalPeriodMs = 0.0;
+    m_statistics.minPeriodMs = 0.0;
+    m_statistics.maxPeriodMs = 0.0;
+    m_statistics.meanPeriodMs = 0.0;
+    m_statistics.maxJitterMs = 0.0;
+    m_statistics.missedPeriods = 0;
+    m_statistics.periodHistogram.fill(0, HISTOGRAM_BIN_COUNT);
+    m_statistics.jitterHistogram.fill(0, HISTOGRAM_BIN_COUNT);
+}
+
+/**
+ * Destructor.
+ */
+CyclicSendEngine::~CyclicSendEngine()
+{
+    stopSending();
+}
+
+/**
+ * Starts sending.
+ * @param payloads
+ *      The first payloads (are sent in order).
+ * @param numberOfSends
+ *      The number of payloads which shall be sent.
+ * @param periodMs
+ *      The period (ms). If 0 then the next payload is sent as soon as the previous one has been sent.
+ * @param isConstantPayload
+ *      True if payloads[0] shall be sent numberOfSends times. If false, then the payloads which follow
+ *      payloads are added with appendPayloads (see payloadsNeededSignal).
+ */
+void CyclicSendEngine::startSending(const QVector<QByteArray>& payloads, quint64 numberOfSends, quint32 periodMs, bool isConstantPayload)
+{
+    stopSending();
+
+    if(payloads.isEmpty())
+    {
+        return;
+    }
+
+    m_payloads.clear();
+    for(const auto& el : payloads)
+    {
+        m_payloads.enqueue(el);
+        if(isConstantPayload)
+        {
+            break;
+        }
+    }
+    m_isConstantPayload = isConstantPayload;
+    m_noMorePayloads = isConstantPayload || ((quint64)m_payloads.size() >= numberOfSends);
+    m_payloadsRequested = false;
+    m_numberOfSends = numberOfSends;
+    m_periodNs = (qint64)periodMs * 1000000;
+    m_stop = false;
+    m_sendIsPending = false;
+    m_periodSumNs = 0;
+
+    m_statistics.numberOfSends = 0;
+    m_statistics.nominalPeriodMs = periodMs;
+    m_statistics.minPeriodMs = 0.0;
+    m_statistics.maxPeriodMs = 0.0;
+    m_statistics.meanPeriodMs = 0.0;
+    m_statistics.maxJitterMs = 0.0;
+    m_statistics.missedPeriods = 0;
+    m_statistics.periodHistogram.fill(0, HISTOGRAM_BIN_COUNT);
+    m_statistics.jitterHistogram.fill(0, HISTOGRAM_BIN_COUNT);
+
+    start(QThread::TimeCriticalPriority);
+}
+
+/**
+ * Adds payloads to the current send process (the answer to payloadsNeededSignal).
+ * @param payloads
+ *      The payloads.
+ * @param noMorePayloads
+ *      True if no more payloads follow (the send process ends after the last payload).
+ */
+void CyclicSendEngine::appendPayloads(const QVector<QByteArray>& payloads, bool noMorePayloads)
+{
+    QMutexLocker locker(&m_mutex);
+    for(const auto& el : payloads)
+    {
+        m_payloads.enqueue(el);
+    }
+    m_noMorePayloads = m_noMorePayloads || noMorePayloads;
+    m_payloadsRequested = false;
+    m_waitCondition.wakeAll();
+}
+
+/**
+ * Stops sending and waits until the send thread has been finished.
+ */
+void CyclicSendEngine::stopSending(void)
+{
+    m_mutex.lock();
+    m_stop = true;
+    m_waitCondition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/**
+ * Returns the statistics of the current (or last) send process.
+ * @return
+ *      The statistics.
+ */
+CyclicSendStatistics CyclicSendEngine::getStatistics(void)
+{
+    QMutexLocker locker(&m_mutex);
+    CyclicSendStatistics statistics = m_statistics;
+
+    if(statistics.numberOfSends > 1)
+    {
+        statistics.meanPeriodMs = ((double)m_periodSumNs / (double)(statistics.numberOfSends - 1)) / 1000000.0;
+    }
+    return statistics;
+}
+
+/**
+ * Converts statistics into a text (for displaying).
+ * @param statistics
+ *      The statistics.
+ * @return
+ *      The text.
+ */
+QString CyclicSendEngine::statisticsToString(const CyclicSendStatistics& statistics)
+{
+    QString result = QString("sends: %1, period: %2 ms (nominal %3 ms, min %4 ms, max %5 ms), max. jitter: %6 ms, missed periods: %7")
+            .arg(statistics.numberOfSends).arg(statistics.meanPeriodMs, 0, 'f', 3).arg(statistics.nominalPeriodMs)
+            .arg(statistics.minPeriodMs, 0, 'f', 3).arg(statistics.maxPeriodMs, 0, 'f', 3)
+            .arg(statistics.maxJitterMs, 0, 'f', 3).arg(statistics.missedPeriods);
+
+    QString periodHistogram = "period deviation:";
+    QString jitterHistogram = "jitter:";
+    for(int i = 0; i < HISTOGRAM_BIN_COUNT; i++)
+    {
+        QString binName;
+        if(i < (HISTOGRAM_BIN_COUNT - 1))
+        {
+            binName = (HISTOGRAM_LIMITS_US[i] < 1000) ? QString("<=%1us").arg(HISTOGRAM_LIMITS_US[i]) :
+                                                         QString("<=%1ms").arg(HISTOGRAM_LIMITS_US[i] / 1000);
+        }
+        else
+        {
+            binName = QString(">%1ms").arg(HISTOGRAM_LIMITS_US[HISTOGRAM_BIN_COUNT - 2] / 1000);
+        }
+
+        if(i < statistics.periodHistogram.size())
+        {
+            periodHistogram += QString(" %1: %2").arg(binName).arg(statistics.periodHistogram[i]);
+        }
+        if(i < statistics.jitterHistogram.size())
+        {
+            jitterHistogram += QString(" %1: %2").arg(binName).arg(statistics.jitterHistogram[i]);
+        }
+    }
+
+    return result + "\n" + periodHistogram + "\n" + jitterHistogram;
+}
+
+/**
+ * Must be called (direct connection) if the main interface has sent data.
+ * @param success
+ *      True on success.
+ * @param id
+ *      The send id.
+ */
+void CyclicSendEngine::sendingFinishedSlot(bool success, uint id)
+{
+    if(id == MainInterfaceThread::SEND_ID_SEND_WINDOW_CYCLIC)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_sendIsPending = false;
+        if(!success)
+        {
+            m_stop = true;
+        }
+        m_waitCondition.wakeAll();
+    }
+}
+
+/**
+ * Adds a value to a histogram.
+ * @param histogram
+ *      The histogram.
+ * @param valueNs
+ *      The value (ns).
+ */
+void CyclicSendEngine::addToHistogram(QVector<quint64>& histogram, qint64 valueNs)
+{
+    qint64 valueUs = valueNs / 1000;
+    int bin = 0;
+
+    while((bin < (HISTOGRAM_BIN_COUNT - 1)) && (valueUs > HISTOGRAM_LIMITS_US[bin]))
+    {
+        bin++;
+    }
+    histogram[bin]++;
+}
+
+/**
+ * Waits until deadlineNs. The send thread waits for the wait condition until
+ * the remaining time is smaller than FINE_WAIT_THRESHOLD_NS and sleeps in small steps afterwards.
+ * @param deadlineNs
+ *      The deadline (relative to m_elapsedTimer).
+ * @return
+ *      False if the send process has been stopped.
+ */
+bool CyclicSendEngine::waitForDeadline(qint64 deadlineNs)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 remainingNs = deadlineNs - m_elapsedTimer.nsecsElapsed();
+
+    while(!m_stop && (remainingNs > FINE_WAIT_THRESHOLD_NS))
+    {
+        m_waitCondition.wait(&m_mutex, (unsigned long)((remainingNs - FINE_WAIT_THRESHOLD_NS) / 1000000) + 1);
+        remainingNs = deadlineNs - m_elapsedTimer.nsecsElapsed();
+    }
+
+    if(m_stop)
+    {
+        return false;
+    }
+    locker.unlock();
+
+    while(remainingNs > 0)
+    {
+        if(remainingNs > 200000)
+        {
+            QThread::usleep((unsigned long)(remainingNs / 2000));
+        }
+        else
+        {
+            QThread::yieldCurrentThread();
+        }
+        remainingNs = deadlineNs - m_elapsedTimer.nsecsElapsed();
+    }
+
+    return true;
+}
+
+/**
+ * Waits until a payload is available. payloadsNeededSignal is emitted if less than
+ * PAYLOAD_REFILL_THRESHOLD payloads are waiting.
+ * @return
+ *      False if the send process has been stopped or if no more payloads follow.
+ */
+bool CyclicSendEngine::waitForPayload(void)
+{
+    QMutexLocker locker(&m_mutex);
+    bool requestPayloads = !m_noMorePayloads && !m_payloadsRequested && (m_payloads.size() < PAYLOAD_REFILL_THRESHOLD);
+    if(requestPayloads)
+    {
+        m_payloadsRequested = true;
+        locker.unlock();
+        emit payloadsNeededSignal();
+        locker.relock();
+    }
+
+    while(m_payloads.isEmpty() && !m_noMorePayloads && !m_stop)
+    {//The payloads have not been created in time (the deadline is missed).
+        m_waitCondition.wait(&m_mutex);
+    }
+    return !m_stop && !m_payloads.isEmpty();
+}
+
+/**
+ * The send loop.
+ */
+void CyclicSendEngine::run()
+{
+    qint64 nextDeadlineNs = 0;
+    qint64 lastSendNs = 0;
+
+    m_elapsedTimer.start();
+
+    for(quint64 i = 0; i < m_numberOfSends; i++)
+    {
+        if(!waitForPayload() || !waitForDeadline(nextDeadlineNs))
+        {
+            break;
+        }
+
+        m_mutex.lock();
+        while(m_sendIsPending && !m_stop)
+        {//Wait until the main interface has sent the previous payload.
+            m_waitCondition.wait(&m_mutex);
+        }
+        if(m_stop)
+        {
+            m_mutex.unlock();
+            break;
+        }
+        m_sendIsPending = true;
+        QByteArray payload = m_isConstantPayload ? m_payloads.head() : m_payloads.dequeue();
+        m_mutex.unlock();
+
+        qint64 nowNs = m_elapsedTimer.nsecsElapsed();
+        emit sendDataSignal(payload, MainInterfaceThread::SEND_ID_SEND_WINDOW_CYCLIC);
+
+        m_mutex.lock();
+        m_statistics.numberOfSends++;
+        if(m_periodNs > 0)
+        {
+            qint64 jitterNs = nowNs - nextDeadlineNs;
+            addToHistogram(m_statistics.jitterHistogram, jitterNs);
+            if(((double)jitterNs / 1000000.0) > m_statistics.maxJitterMs)
+            {
+                m_statistics.maxJitterMs = (double)jitterNs / 1000000.0;
+            }
+        }
+        if(i > 0)
+        {
+            qint64 periodNs = nowNs - lastSendNs;
+            double periodMs = (double)periodNs / 1000000.0;
+
+            m_periodSumNs += periodNs;
+            addToHistogram(m_statistics.periodHistogram, qAbs(periodNs - m_periodNs));
+            if((i == 1) || (periodMs < m_statistics.minPeriodMs))
+            {
+                m_statistics.minPeriodMs = periodMs;
+            }
+            if(periodMs > m_statistics.maxPeriodMs)
+            {
+                m_statistics.maxPeriodMs = periodMs;
+            }
+        }
+
+        lastSendNs = nowNs;
+        nextDeadlineNs += m_periodNs;
+        if((m_periodNs > 0) && ((nowNs - nextDeadlineNs) >= m_periodNs))
+        {//More than one period late, skip the missed periods (the deadlines stay on the same grid).
+            qint64 missedPeriods = (nowNs - nextDeadlineNs) / m_periodNs;
+            m_statistics.missedPeriods += missedPeriods;
+            nextDeadlineNs += missedPeriods * m_periodNs;
+        }
+        m_mutex.unlock();
+    }
+}
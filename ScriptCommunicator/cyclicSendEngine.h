@@ -0,0 +1,178 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef CYCLICSENDENGINE_H
+#define CYCLICSENDENGINE_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QQueue>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+///The statistics of a cyclic send process.
+typedef struct
+{
+    ///The number of sent payloads.
+    quint64 numberOfSends;
+
+    ///The nominal period (ms).
+    double nominalPeriodMs;
+
+    ///The min. measured period (ms).
+    double minPeriodMs;
+
+    ///The max. measured period (ms).
+    double maxPeriodMs;
+
+    ///The mean measured period (ms).
+    double meanPeriodMs;
+
+    ///The max. jitter (delay between the deadline and the actual send time, ms).
+    double maxJitterMs;
+
+    ///The number of periods which have been skipped (the send process was more than one period late).
+    quint64 missedPeriods;
+
+    ///Histogram of the deviation between the measured and the nominal period (see HISTOGRAM_LIMITS_US).
+    QVector<quint64> periodHistogram;
+
+    ///Histogram of the jitter (see HISTOGRAM_LIMITS_US).
+    QVector<quint64> jitterHistogram;
+}CyclicSendStatistics;
+
+///Sends precomputed payloads with a fixed period. The send times are absolute
+///deadlines (no drift) and are independent of the GUI thread.
+///The payloads are sent with sendDataSignal and the next payload is sent only after
+///the previous one has been sent (sendingFinishedSlot). If the payloads are created by a script,
+///then the engine requests the next payloads with payloadsNeededSignal while it is sending.
+class CyclicSendEngine : public QThread
+{
+    Q_OBJECT
+
+public:
+    CyclicSendEngine();
+    virtual ~CyclicSendEngine();
+
+    ///Starts sending. If isConstantPayload is true, then payloads[0] is sent numberOfSends times. Otherwise every
+    ///payload is sent once and the following payloads are added with appendPayloads (see payloadsNeededSignal).
+    void startSending(const QVector<QByteArray>& payloads, quint64 numberOfSends, quint32 periodMs, bool isConstantPayload);
+
+    ///Adds payloads to the current send process (the answer to payloadsNeededSignal).
+    ///If noMorePayloads is true, then the send process ends after the last payload.
+    void appendPayloads(const QVector<QByteArray>& payloads, bool noMorePayloads);
+
+    ///Stops sending and waits until the send thread has been finished.
+    void stopSending(void);
+
+    ///Returns the statistics of the current (or last) send process.
+    CyclicSendStatistics getStatistics(void);
+
+    ///Converts statistics into a text (for displaying).
+    static QString statisticsToString(const CyclicSendStatistics& statistics);
+
+    ///The upper limits of the histogram bins (us). The last bin contains all greater values.
+    static const quint32 HISTOGRAM_LIMITS_US[];
+
+    ///The number of histogram bins.
+    static const int HISTOGRAM_BIN_COUNT = 9;
+
+    ///If the remaining time to the next deadline is smaller than this value (ns),
+    ///the send thread sleeps in small steps instead of waiting for the wait condition.
+    static const qint64 FINE_WAIT_THRESHOLD_NS = 2000000;
+
+    ///payloadsNeededSignal is emitted if less than this number of payloads are waiting for sending.
+    static const int PAYLOAD_REFILL_THRESHOLD = 500;
+
+signals:
+    ///Is emitted for every payload which shall be sent.
+    void sendDataSignal(const QByteArray data, uint id);
+
+    ///Is emitted if the send thread needs more payloads (see appendPayloads). The signal is emitted again
+    ///after appendPayloads has been called.
+    void payloadsNeededSignal(void);
+
+public slots:
+
+    ///Must be called (direct connection) if the main interface has sent data.
+    void sendingFinishedSlot(bool success, uint id);
+
+protected:
+    ///The send loop.
+    void run();
+
+private:
+
+    ///Waits until deadlineNs. Returns false if the send process has been stopped.
+    bool waitForDeadline(qint64 deadlineNs);
+
+    ///Adds a value to a histogram.
+    static void addToHistogram(QVector<quint64>& histogram, qint64 valueNs);
+
+    ///Protects all members which are used by more than one thread.
+    QMutex m_mutex;
+
+    ///Is used to wake the send thread (send finished, stop).
+    QWaitCondition m_waitCondition;
+
+    ///Waits until a payload is available. Returns false if the send process has been stopped or if no more payloads follow.
+    bool waitForPayload(void);
+
+    ///The payloads which are waiting for sending.
+    QQueue<QByteArray> m_payloads;
+
+    ///True if m_payloads contains one payload which is sent numberOfSends times.
+    bool m_isConstantPayload;
+
+    ///True if no more payloads are added with appendPayloads.
+    bool m_noMorePayloads;
+
+    ///True if payloadsNeededSignal has been emitted and appendPayloads has not been called yet.
+    bool m_payloadsRequested;
+
+    ///The number of payloads which shall be sent.
+    quint64 m_numberOfSends;
+
+    ///The period (ns).
+    qint64 m_periodNs;
+
+    ///True if the send process shall be stopped.
+    bool m_stop;
+
+    ///True if a payload has been sent but the main interface has not finished sending it yet.
+    bool m_sendIsPending;
+
+    ///The statistics.
+    CyclicSendStatistics m_statistics;
+
+    ///The sum of all measured periods (ns).
+    qint64 m_periodSumNs;
+
+    ///The time base of the send process.
+    QElapsedTimer m_elapsedTimer;
+};
+
+#endif // CYCLICSENDENGINE_H
@@ -0,0 +1,61 @@
+/*************************************************************************
+This script demonstrates how to create a custom log/console script which processes
+several data chunks in one call (batch mode).
+IMPORTANT!
+To reload a changed custom console/log script the corresponding checkbox in the settings dialog must
+be unchecked and then checked again or the corresponding search button must be pressed.
+***************************************************************************/
+
+
+/*
+  * If a custom console/log script contains this function, then it is called instead of createString.
+  * All data chunks which have been sent/received since the last console/log update are passed in one call.
+  * If the script contains createStringBatch, then createString is optional.
+  *
+  * @param chunks
+  *   An array of chunks. Each chunk is an object with the following properties:
+  *   - data: the data (see createString)
+  *   - timeStamp: the time stamp (the format is set in the settings dialog)
+  *   - type: the type (see createString)
+  * @param isLog
+  *   True if this call is for the custom log (false=custom console)
+  * @return
+  *   An array of strings (one for each chunk) or one string.
+  */
+function createStringBatch(chunks, isLog)
+{
+	var results = [];
+	
+	for(var i = 0; i < chunks.length; i++)
+	{
+		var chunk = chunks[i];
+		var resultString = chunk.timeStamp;
+		resultString += "type: " + chunk.type
+		resultString += "  isLog: " + isLog;
+		resultString += "  size: " + chunk.data.length;
+		resultString += "  value: ";
+		
+		//Convert the received bytes (unsigned char) to an ascii string (char)
+		for(var j = 0; j < chunk.data.length; j++)
+		{
+			resultString += String.fromCharCode(chunk.data[j])
+		}
+		
+		if(!isLog)
+		{
+			//The console is a HTML console therefore following characters must be replaced with their HTML representation.
+			resultString = resultString.replace(/</gm, "&lt;")//replace < with &lt
+			resultString = resultString.replace(/>/gm, "&gt;")//replace > with &gt
+			resultString = resultString.replace(/(\r\n|\n|\r)/gm, "<br>")//replace \r\n, \n and \r with <br>
+			resultString = resultString.replace(/ /gm, "&nbsp;")//replace space with &nbsp;
+			resultString += "<br>";
+		}
+		else
+		{
+			resultString += "\n";
+		}
+		results.push(resultString);
+	}
+	
+	return results;
+}
@@ -0,0 +1,31 @@
+/**********************************************************************
+This is an example sequence send script which can be added to a sequence (send window). It demonstrates
+the binary string interface (sendDataBuffer) and the payload lookahead for cyclic sequences.
+
+If a sequence script contains the function sendDataBuffer, this function is called instead of sendData.
+The data is passed as binary string (each character is one byte) and the function may return a
+binary string or a byte array.
+
+This script can not be executed by the "normal" script interface (script window).
+***********************************************************************/
+
+//Create the next 16 payloads in advance (cyclic sequences).
+seq.setPayloadLookahead(16);
+
+var counter = 0;
+
+//This function appends a counter and an XOR checksum at data.
+function sendDataBuffer(data)
+{
+	data += String.fromCharCode((counter >> 8) & 0xff, counter & 0xff);
+
+	var checksum = 0;
+	for(var i = 0; i < data.length; i++)
+	{
+		checksum ^= data.charCodeAt(i);
+	}
+	data += String.fromCharCode(checksum);
+
+	counter = (counter + 1) & 0xffff;
+	return data;
+}
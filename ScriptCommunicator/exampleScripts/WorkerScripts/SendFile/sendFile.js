@@ -27,6 +27,18 @@ function UI_SendFilePushButtonClickedSlot()
 			UI_InformationLabel.setText("read file");
 			var succeeded = false;
 				
+			if(!scriptThread.isConnectedWithCan())
+			{
+				//The file is streamed in the main interface thread (see fileTransferProgress and fileTransferFinished).
+				UI_InformationLabel.setText("sending");
+				if(!fileTransfer.sendFileRaw(UI_FilePathLineEdit.text(), 20000, 10))
+				{
+					UI_InformationLabel.setText("could not read file");
+					UI_OpenFilePushButton.setEnabled(true);
+					UI_SendFilePushButton.setEnabled(true);
+				}
+				return;
+			}
 			
 			var fileSize = scriptThread.getFileSize(UI_FilePathLineEdit.text(), false);
 			if(fileSize > 0)
@@ -37,21 +49,10 @@ function UI_SendFilePushButtonClickedSlot()
 					var array = scriptThread.readBinaryFile(UI_FilePathLineEdit.text(), false, send, 20000);
 					if(array.length > 0)
 					{
-						if(scriptThread.isConnectedWithCan())
-						{
-							if(!scriptThread.sendCanMessage(2, 0x1, array))
-							{
-								succeeded =  false;
-								break;
-							}
-						}
-						else
+						if(!scriptThread.sendCanMessage(2, 0x1, array))
 						{
-							if(!scriptThread.sendDataArray(array))
-							{
-								succeeded = false;
-								break;
-							}
+							succeeded =  false;
+							break;
 						}
 						send += array.length;
 						UI_InformationLabel.setText("bytes send: " + send);
@@ -91,6 +92,32 @@ function UI_SendFilePushButtonClickedSlot()
 	}
 }
 	
+//Is called periodically during the file transfer.
+function fileTransferProgress(fileName, transferredBytes, totalBytes, bytesPerSecond)
+{
+	UI_InformationLabel.setText("bytes send: " + transferredBytes + " (" + (bytesPerSecond / 1024).toFixed(1) + " KiB/s)");
+	if(totalBytes > 0)
+	{
+		UI_SendFileProgressBar.setValue((transferredBytes * 100) / totalBytes);
+	}
+}
+
+//Is called if the file transfer has finished.
+function fileTransferFinished(success, message)
+{
+	if(success)
+	{
+		UI_SendFileProgressBar.setValue(100);
+		UI_InformationLabel.setText("sending finished, " + UI_InformationLabel.text());
+	}
+	else
+	{
+		UI_InformationLabel.setText("sending failed (" + message + "), " + UI_InformationLabel.text());
+	}
+	UI_OpenFilePushButton.setEnabled(true);
+	UI_SendFilePushButton.setEnabled(true);
+}
+	
 function UI_OpenFilePushButtonClickedSlot()
 {
 	var path = scriptThread.showFileDialog (false, "Open File", "","Files (*)")
@@ -104,6 +131,10 @@ function UI_OpenFilePushButtonClickedSlot()
 
 scriptThread.appendTextToConsole('script send file started');
 
+var fileTransfer = scriptThread.createFileTransfer();
+fileTransfer.progressSignal.connect(fileTransferProgress);
+fileTransfer.transferFinishedSignal.connect(fileTransferFinished);
+
 UI_SendFileDialog.finishedSignal.connect(UI_DialogFinished);
 UI_OpenFilePushButton.clickedSignal.connect(UI_OpenFilePushButtonClickedSlot)
 UI_SendFilePushButton.clickedSignal.connect(UI_SendFilePushButtonClickedSlot)
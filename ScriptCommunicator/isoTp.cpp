@@ -0,0 +1,870 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "isoTp.h"
+#include <QThread>
+#include <QMutexLocker>
+
+///The protocol control information (upper nibble of the first byte).
+#define ISOTP_PCI_SINGLE_FRAME 0x00
+#define ISOTP_PCI_FIRST_FRAME 0x10
+#define ISOTP_PCI_CONSECUTIVE_FRAME 0x20
+#define ISOTP_PCI_FLOW_CONTROL 0x30
+
+///The flow status of a flow control frame.
+#define ISOTP_FLOW_STATUS_CONTINUE 0
+#define ISOTP_FLOW_STATUS_WAIT 1
+#define ISOTP_FLOW_STATUS_OVERFLOW 2
+
+///The size of a classic can frame.
+#define ISOTP_FRAME_SIZE 8
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ */
+IsoTpEngine::IsoTpEngine(QObject *parent) : QObject(parent), m_mutex(), m_sessions(), m_indexes(), m_notifications(), m_numberOfSessions(0), m_clock(), m_timer(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(timerSlot()));
+
+    m_clock.start();
+}
+
+/**
+ * Opens a session.
+ * @param ownerId
+ *      The id of the owner (send id of the script thread).
+ * @param type
+ *      The can type (0=standard, 2=extended).
+ * @param txId
+ *      The id of the sent frames.
+ * @param rxId
+ *      The id of the received frames.
+ * @param blockSize
+ *      The block size which is sent in the flow control frames (0=no further flow control frames).
+ * @param separationTime
+ *      The STmin which is sent in the flow control frames (ISO-TP encoding, see encodeSeparationTime).
+ * @param paddingByte
+ *      The padding byte (-1=no padding).
+ * @return
+ *      False if txId or rxId is used by another session or if txId equals rxId.
+ */
+bool IsoTpEngine::openSession(quint32 ownerId, quint8 type, quint32 txId, quint32 rxId, quint8 blockSize, quint8 separationTime, qint16 paddingByte)
+{
+    type &= CAN_FRAME_FLAG_EXTENDED;
+    quint32 idMask = (type & CAN_FRAME_FLAG_EXTENDED) ? 0x1fffffff : 0x7ff;
+    txId &= idMask;
+    rxId &= idMask;
+    if(txId == rxId)
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if(m_indexes.contains(createKey(type, rxId)) || m_indexes.contains(createKey(type, txId)))
+    {
+        return false;
+    }
+    for(const auto& el : m_sessions)
+    {
+        if((el.type == type) && ((el.txId == txId) || (el.txId == rxId)))
+        {
+            return false;
+        }
+    }
+
+    IsoTpSession session;
+    session.ownerId = ownerId;
+    session.type = type;
+    session.txId = txId;
+    session.rxId = rxId;
+    session.blockSize = blockSize;
+    session.separationTime = separationTime;
+    session.paddingByte = paddingByte;
+    session.txState = ISOTP_TX_IDLE;
+    session.txOffset = 0;
+    session.txSequenceNumber = 0;
+    session.txBlockRemaining = -1;
+    session.txSeparationTimeNs = 0;
+    session.txDeadlineNs = 0;
+    session.txWaitFrames = 0;
+    session.rxIsActive = false;
+    session.rxLength = 0;
+    session.rxSequenceNumber = 0;
+    session.rxBlockCounter = 0;
+    session.rxTimeoutNs = 0;
+
+    m_indexes[createKey(type, rxId)] = m_sessions.size();
+    m_sessions.append(session);
+    m_numberOfSessions.store(m_sessions.size());
+    return true;
+}
+
+/**
+ * Returns the index of the session with txId (-1 if the session does not exist).
+ * m_mutex must be locked by the caller.
+ * @param sessions
+ *      The sessions.
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ * @return
+ *      The index.
+ */
+static qint32 findSession(const QVector<IsoTpSession>& sessions, quint8 type, quint32 txId)
+{
+    for(qint32 index = 0; index < sessions.size(); index++)
+    {
+        if((sessions[index].type == (type & CAN_FRAME_FLAG_EXTENDED)) && (sessions[index].txId == txId))
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Closes a session (a running transfer is aborted without notification).
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ */
+void IsoTpEngine::closeSession(quint8 type, quint32 txId)
+{
+    QMutexLocker locker(&m_mutex);
+    qint32 index = findSession(m_sessions, type, txId);
+    if(index >= 0)
+    {
+        removeAt(index);
+    }
+}
+
+/**
+ * Closes all sessions of an owner.
+ * @param ownerId
+ *      The id of the owner.
+ */
+void IsoTpEngine::closeAllSessions(quint32 ownerId)
+{
+    QMutexLocker locker(&m_mutex);
+    for(qint32 index = m_sessions.size() - 1; index >= 0; index--)
+    {
+        if(m_sessions[index].ownerId == ownerId)
+        {
+            removeAt(index);
+        }
+    }
+}
+
+/**
+ * Removes the session at index (the last session is moved to index).
+ * m_mutex must be locked by the caller.
+ * @param index
+ *      The index.
+ */
+void IsoTpEngine::removeAt(qint32 index)
+{
+    m_indexes.remove(createKey(m_sessions[index].type, m_sessions[index].rxId));
+
+    qint32 lastIndex = m_sessions.size() - 1;
+    if(index != lastIndex)
+    {
+        m_sessions[index] = m_sessions[lastIndex];
+        m_indexes[createKey(m_sessions[index].type, m_sessions[index].rxId)] = index;
+    }
+    m_sessions.removeLast();
+    m_numberOfSessions.store(m_sessions.size());
+}
+
+/**
+ * Sends a message. The single frame or the first frame is sent in the thread of the engine
+ * and the result is emitted with messageSentSignal.
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ * @param data
+ *      The message (1 - MAX_MESSAGE_SIZE bytes).
+ * @return
+ *      False if the session does not exist, if the session is sending or if the message size is invalid.
+ */
+bool IsoTpEngine::send(quint8 type, quint32 txId, const QByteArray& data)
+{
+    if(data.isEmpty() || (data.size() > MAX_MESSAGE_SIZE))
+    {
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        qint32 index = findSession(m_sessions, type, txId);
+        if((index < 0) || (m_sessions[index].txState != ISOTP_TX_IDLE))
+        {
+            return false;
+        }
+
+        IsoTpSession& session = m_sessions[index];
+        session.txData = data;
+        session.txOffset = 0;
+        session.txWaitFrames = 0;
+        session.txState = ISOTP_TX_PENDING;
+    }
+
+    triggerReschedule();
+    return true;
+}
+
+/**
+ * Converts a separation time into the ISO-TP encoding.
+ * @param separationTime
+ *      The separation time (ms). Values below 1 ms are rounded to 100 us steps, values above 127 ms are limited.
+ * @return
+ *      The encoded separation time (0x00-0x7F: 0-127 ms, 0xF1-0xF9: 100-900 us).
+ */
+quint8 IsoTpEngine::encodeSeparationTime(double separationTime)
+{
+    if(separationTime <= 0.0)
+    {
+        return 0;
+    }
+    else if(separationTime < 0.95)
+    {
+        qint32 steps = (qint32)(separationTime * 10.0 + 0.5);
+        return 0xf0 + (quint8)((steps < 1) ? 1 : steps);
+    }
+    else
+    {
+        qint32 ms = (qint32)(separationTime + 0.5);
+        return (quint8)((ms > 127) ? 127 : ms);
+    }
+}
+
+/**
+ * Converts an ISO-TP separation time into ns.
+ * @param separationTime
+ *      The encoded separation time.
+ * @return
+ *      The separation time (ns). Reserved values are treated as 127 ms (ISO 15765-2).
+ */
+qint64 IsoTpEngine::decodeSeparationTime(quint8 separationTime)
+{
+    if(separationTime <= 0x7f)
+    {
+        return (qint64)separationTime * 1000000;
+    }
+    else if((separationTime >= 0xf1) && (separationTime <= 0xf9))
+    {
+        return (qint64)(separationTime - 0xf0) * 100000;
+    }
+    else
+    {
+        return (qint64)127 * 1000000;
+    }
+}
+
+/**
+ * Creates a frame of a session. The frame is padded to 8 bytes if the padding byte of the session is set.
+ * @param session
+ *      The session.
+ * @param data
+ *      The payload.
+ * @param length
+ *      The length of the payload.
+ * @return
+ *      The frame.
+ */
+CanFrame IsoTpEngine::createFrame(const IsoTpSession& session, const quint8* data, int length)
+{
+    CanFrame frame;
+    quint8 buffer[ISOTP_FRAME_SIZE];
+
+    memcpy(buffer, data, length);
+    if((session.paddingByte >= 0) && (length < ISOTP_FRAME_SIZE))
+    {
+        memset(&buffer[length], (quint8)session.paddingByte, ISOTP_FRAME_SIZE - length);
+        length = ISOTP_FRAME_SIZE;
+    }
+
+    initCanFrame(&frame, session.type, session.txId, (const char*)buffer, length, 0);
+    return frame;
+}
+
+/**
+ * Adds a notification of the owner of a session to m_notifications (m_mutex must be locked).
+ * @param isReceived
+ *      True for messageReceivedSignal, false for messageSentSignal.
+ * @param session
+ *      The session.
+ * @param data
+ *      The received message.
+ * @param success
+ *      True on success.
+ * @param errorString
+ *      The error description.
+ */
+void IsoTpEngine::addNotification(bool isReceived, const IsoTpSession& session, const QByteArray& data, bool success, QString errorString)
+{
+    IsoTpNotification notification;
+    notification.isReceived = isReceived;
+    notification.ownerId = session.ownerId;
+    notification.type = session.type;
+    notification.id = isReceived ? session.rxId : session.txId;
+    notification.data = data;
+    notification.success = success;
+    notification.errorString = errorString;
+    m_notifications.append(notification);
+}
+
+/**
+ * Emits the notifications (m_mutex must not be locked, so that the receivers can call send or closeSession).
+ * @param notifications
+ *      The notifications.
+ */
+void IsoTpEngine::emitNotifications(const QVector<IsoTpNotification>& notifications)
+{
+    for(const auto& el : notifications)
+    {
+        if(el.isReceived)
+        {
+            emit messageReceivedSignal(el.ownerId, el.type, el.id, el.data, el.success, el.errorString);
+        }
+        else
+        {
+            emit messageSentSignal(el.ownerId, el.type, el.id, el.success, el.errorString);
+        }
+    }
+}
+
+/**
+ * Finishes the transmission of a session and notifies the owner (m_mutex must be locked).
+ * @param session
+ *      The session.
+ * @param success
+ *      True if the message has been sent.
+ * @param errorString
+ *      The error description.
+ */
+void IsoTpEngine::finishTransmission(IsoTpSession& session, bool success, QString errorString)
+{
+    session.txState = ISOTP_TX_IDLE;
+    session.txData.clear();
+    addNotification(false, session, QByteArray(), success, errorString);
+}
+
+/**
+ * Aborts the reception of a session and notifies the owner (m_mutex must be locked).
+ * @param session
+ *      The session.
+ * @param errorString
+ *      The error description.
+ */
+void IsoTpEngine::abortReception(IsoTpSession& session, QString errorString)
+{
+    session.rxIsActive = false;
+    addNotification(true, session, session.rxData, false, errorString);
+    session.rxData.clear();
+}
+
+/**
+ * Sends a flow control frame.
+ * m_mutex must be locked by the caller.
+ * @param session
+ *      The session.
+ * @param flowStatus
+ *      The flow status.
+ * @return
+ *      True on success.
+ */
+bool IsoTpEngine::sendFlowControl(IsoTpSession& session, quint8 flowStatus)
+{
+    quint8 data[3] = {(quint8)(ISOTP_PCI_FLOW_CONTROL | flowStatus), session.blockSize, session.separationTime};
+    QVector<CanFrame> frames;
+    frames.append(createFrame(session, data, sizeof(data)));
+
+    bool success = false;
+    emit sendFramesSignal(frames, &success);
+    return success;
+}
+
+/**
+ * Sends the single frame or the first frame of a session.
+ * m_mutex must be locked by the caller.
+ * @param session
+ *      The session.
+ * @param now
+ *      The current time (ns).
+ */
+void IsoTpEngine::sendFirstFrame(IsoTpSession& session, qint64 now)
+{
+    const quint8* message = (const quint8*)session.txData.constData();
+    qint32 size = session.txData.size();
+    quint8 data[ISOTP_FRAME_SIZE];
+    qint32 headerSize;
+
+    if(size < ISOTP_FRAME_SIZE)
+    {
+        data[0] = ISOTP_PCI_SINGLE_FRAME | (quint8)size;
+        headerSize = 1;
+    }
+    else if(size <= 0xfff)
+    {
+        data[0] = ISOTP_PCI_FIRST_FRAME | (quint8)(size >> 8);
+        data[1] = (quint8)size;
+        headerSize = 2;
+    }
+    else
+    {//Escape sequence for messages bigger than 4095 bytes.
+        data[0] = ISOTP_PCI_FIRST_FRAME;
+        data[1] = 0;
+        data[2] = (quint8)(size >> 24);
+        data[3] = (quint8)(size >> 16);
+        data[4] = (quint8)(size >> 8);
+        data[5] = (quint8)size;
+        headerSize = 6;
+    }
+
+    qint32 payloadSize = qMin(size, ISOTP_FRAME_SIZE - headerSize);
+    memcpy(&data[headerSize], message, payloadSize);
+
+    QVector<CanFrame> frames;
+    frames.append(createFrame(session, data, headerSize + payloadSize));
+
+    bool success = false;
+    emit sendFramesSignal(frames, &success);
+    if(!success)
+    {
+        finishTransmission(session, false, "could not send the first frame");
+    }
+    else if(headerSize == 1)
+    {
+        finishTransmission(session, true, "");
+    }
+    else
+    {
+        session.txOffset = payloadSize;
+        session.txSequenceNumber = 1;
+        session.txDeadlineNs = now + TIMEOUT_NS;
+        session.txState = ISOTP_TX_WAIT_FLOW_CONTROL;
+    }
+}
+
+/**
+ * Sends the next consecutive frames of a session. All frames of the current block (max. MAX_FRAMES_PER_BURST)
+ * are sent at once if STmin is 0, otherwise one frame is sent and the next deadline is now + STmin.
+ * m_mutex must be locked by the caller.
+ * @param session
+ *      The session.
+ * @param now
+ *      The current time (ns).
+ */
+void IsoTpEngine::sendConsecutiveFrames(IsoTpSession& session, qint64 now)
+{
+    const quint8* message = (const quint8*)session.txData.constData();
+    qint32 size = session.txData.size();
+    QVector<CanFrame> frames;
+    quint8 data[ISOTP_FRAME_SIZE];
+
+    while(session.txOffset < size)
+    {
+        qint32 payloadSize = qMin(size - session.txOffset, ISOTP_FRAME_SIZE - 1);
+        data[0] = ISOTP_PCI_CONSECUTIVE_FRAME | session.txSequenceNumber;
+        memcpy(&data[1], &message[session.txOffset], payloadSize);
+        frames.append(createFrame(session, data, payloadSize + 1));
+
+        session.txOffset += payloadSize;
+        session.txSequenceNumber = (session.txSequenceNumber + 1) & 0x0f;
+
+        if((session.txBlockRemaining > 0) && (--session.txBlockRemaining == 0))
+        {
+            break;
+        }
+        if((session.txSeparationTimeNs > 0) || (frames.size() >= MAX_FRAMES_PER_BURST))
+        {
+            break;
+        }
+    }
+
+    bool success = false;
+    emit sendFramesSignal(frames, &success);
+    if(!success)
+    {
+        finishTransmission(session, false, "could not send a consecutive frame");
+    }
+    else if(session.txOffset >= size)
+    {
+        finishTransmission(session, true, "");
+    }
+    else if(session.txBlockRemaining == 0)
+    {
+        session.txDeadlineNs = now + TIMEOUT_NS;
+        session.txState = ISOTP_TX_WAIT_FLOW_CONTROL;
+    }
+    else
+    {
+        session.txDeadlineNs = now + session.txSeparationTimeNs;
+    }
+}
+
+/**
+ * Processes a received frame of a session.
+ * m_mutex must be locked by the caller.
+ * @param session
+ *      The session.
+ * @param frame
+ *      The frame.
+ * @param now
+ *      The current time (ns).
+ */
+void IsoTpEngine::handleFrame(IsoTpSession& session, const CanFrame& frame, qint64 now)
+{
+    if((frame.length < 1) || (frame.flags & (CAN_FRAME_FLAG_RTR | CAN_FRAME_FLAG_FD)))
+    {
+        return;
+    }
+
+    const quint8* data = frame.data;
+    switch(data[0] & 0xf0)
+    {
+    case ISOTP_PCI_SINGLE_FRAME:
+    {
+        qint32 length = data[0] & 0x0f;
+        if((length == 0) || (length >= frame.length))
+        {
+            return;
+        }
+        if(session.rxIsActive)
+        {
+            abortReception(session, "reception interrupted by a single frame");
+        }
+        addNotification(true, session, QByteArray((const char*)&data[1], length), true, "");
+        break;
+    }
+    case ISOTP_PCI_FIRST_FRAME:
+    {
+        if(frame.length < ISOTP_FRAME_SIZE)
+        {
+            return;
+        }
+
+        qint64 length = ((data[0] & 0x0f) << 8) | data[1];
+        qint32 headerSize = 2;
+        if(length == 0)
+        {//Escape sequence for messages bigger than 4095 bytes.
+            length = ((qint64)data[2] << 24) | ((qint64)data[3] << 16) | ((qint64)data[4] << 8) | (qint64)data[5];
+            headerSize = 6;
+        }
+        if(length < ISOTP_FRAME_SIZE)
+        {
+            return;
+        }
+
+        if(session.rxIsActive)
+        {
+            abortReception(session, "reception interrupted by a first frame");
+        }
+        if(length > MAX_MESSAGE_SIZE)
+        {
+            sendFlowControl(session, ISOTP_FLOW_STATUS_OVERFLOW);
+            return;
+        }
+
+        session.rxData.clear();
+        session.rxData.reserve((qint32)length);
+        session.rxData.append((const char*)&data[headerSize], ISOTP_FRAME_SIZE - headerSize);
+        session.rxLength = (qint32)length;
+        session.rxSequenceNumber = 1;
+        session.rxBlockCounter = session.blockSize;
+        session.rxTimeoutNs = now + TIMEOUT_NS;
+        session.rxIsActive = true;
+
+        if(!sendFlowControl(session, ISOTP_FLOW_STATUS_CONTINUE))
+        {
+            abortReception(session, "could not send the flow control frame");
+        }
+        break;
+    }
+    case ISOTP_PCI_CONSECUTIVE_FRAME:
+    {
+        if(!session.rxIsActive)
+        {
+            return;
+        }
+        if((data[0] & 0x0f) != session.rxSequenceNumber)
+        {
+            abortReception(session, "wrong sequence number");
+            return;
+        }
+
+        qint32 payloadSize = qMin(session.rxLength - session.rxData.size(), qMin((qint32)frame.length - 1, ISOTP_FRAME_SIZE - 1));
+        session.rxData.append((const char*)&data[1], payloadSize);
+        session.rxSequenceNumber = (session.rxSequenceNumber + 1) & 0x0f;
+
+        if(session.rxData.size() >= session.rxLength)
+        {
+            session.rxIsActive = false;
+            addNotification(true, session, session.rxData, true, "");
+            session.rxData.clear();
+        }
+        else
+        {
+            session.rxTimeoutNs = now + TIMEOUT_NS;
+            if((session.blockSize > 0) && (--session.rxBlockCounter == 0))
+            {
+                session.rxBlockCounter = session.blockSize;
+                if(!sendFlowControl(session, ISOTP_FLOW_STATUS_CONTINUE))
+                {
+                    abortReception(session, "could not send the flow control frame");
+                }
+            }
+        }
+        break;
+    }
+    case ISOTP_PCI_FLOW_CONTROL:
+    {
+        if((session.txState != ISOTP_TX_WAIT_FLOW_CONTROL) || (frame.length < 3))
+        {
+            return;
+        }
+
+        switch(data[0] & 0x0f)
+        {
+        case ISOTP_FLOW_STATUS_CONTINUE:
+            session.txBlockRemaining = (data[1] > 0) ? data[1] : -1;
+            session.txSeparationTimeNs = decodeSeparationTime(data[2]);
+            session.txDeadlineNs = now;
+            session.txWaitFrames = 0;
+            session.txState = ISOTP_TX_SENDING;
+            break;
+        case ISOTP_FLOW_STATUS_WAIT:
+            if(++session.txWaitFrames > MAX_WAIT_FRAMES)
+            {
+                finishTransmission(session, false, "too many flow control wait frames");
+            }
+            else
+            {
+                session.txDeadlineNs = now + TIMEOUT_NS;
+            }
+            break;
+        case ISOTP_FLOW_STATUS_OVERFLOW:
+            finishTransmission(session, false, "the receiver has reported an overflow");
+            break;
+        default:
+            finishTransmission(session, false, "invalid flow status");
+            break;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+/**
+ * Processes received frames. Frames which do not belong to a session are ignored.
+ * Must be called in the thread of the engine.
+ * @param frames
+ *      The received frames.
+ */
+void IsoTpEngine::framesReceived(const QVector<CanFrame>& frames)
+{
+    if(m_numberOfSessions.load() == 0)
+    {
+        return;
+    }
+
+    bool sessionFound = false;
+    QVector<IsoTpNotification> notifications;
+    {
+        QMutexLocker locker(&m_mutex);
+        qint64 now = m_clock.nsecsElapsed();
+        for(const auto& el : frames)
+        {
+            qint32 index = m_indexes.value(createKey(el.flags, el.id), -1);
+            if(index >= 0)
+            {
+                handleFrame(m_sessions[index], el, now);
+                sessionFound = true;
+            }
+        }
+        notifications.swap(m_notifications);
+    }
+
+    emitNotifications(notifications);
+    if(sessionFound)
+    {
+        rescheduleSlot();
+    }
+}
+
+/**
+ * Stops the engine (must be called in the thread of the engine).
+ */
+void IsoTpEngine::stopSlot(void)
+{
+    m_timer->stop();
+}
+
+/**
+ * Triggers rescheduleSlot in the thread of the engine.
+ */
+void IsoTpEngine::triggerReschedule(void)
+{
+    QMetaObject::invokeMethod(this, "rescheduleSlot", Qt::QueuedConnection);
+}
+
+/**
+ * Returns the earliest deadline of all sessions (pending messages are due immediately).
+ * @param activeWait
+ *      Is set to true if the deadline is the next consecutive frame of a session with a STmin
+ *      below MAX_ACTIVE_WAIT_NS (the deadline must be waited actively).
+ * @return
+ *      The deadline (ns since the start of the engine, -1 if no deadline exists).
+ */
+qint64 IsoTpEngine::nextDeadline(bool* activeWait)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 deadline = -1;
+    *activeWait = false;
+    for(const auto& el : m_sessions)
+    {
+        if(el.txState == ISOTP_TX_PENDING)
+        {
+            *activeWait = false;
+            return 0;
+        }
+        if((el.txState != ISOTP_TX_IDLE) && ((deadline < 0) || (el.txDeadlineNs < deadline)))
+        {
+            deadline = el.txDeadlineNs;
+            *activeWait = (el.txState == ISOTP_TX_SENDING) && (el.txSeparationTimeNs < MAX_ACTIVE_WAIT_NS);
+        }
+        if(el.rxIsActive && ((deadline < 0) || (el.rxTimeoutNs < deadline)))
+        {
+            deadline = el.rxTimeoutNs;
+            *activeWait = false;
+        }
+    }
+    return deadline;
+}
+
+/**
+ * Starts the timer for the next deadline (must be called in the thread of the engine).
+ */
+void IsoTpEngine::rescheduleSlot(void)
+{
+    bool activeWait;
+    qint64 deadline = nextDeadline(&activeWait);
+    if(deadline < 0)
+    {
+        m_timer->stop();
+        return;
+    }
+
+    qint64 remainingNs = deadline - m_clock.nsecsElapsed();
+    if((remainingNs <= 0) || (activeWait && (remainingNs < MAX_ACTIVE_WAIT_NS)))
+    {
+        m_timer->start(0);
+    }
+    else
+    {
+        //The timer is rounded up (it must not expire before the deadline, STmin is a minimum).
+        m_timer->start((int)((remainingNs + 999999) / 1000000));
+    }
+}
+
+/**
+ * Processes the due sessions and starts the timer for the next deadline.
+ */
+void IsoTpEngine::timerSlot(void)
+{
+    bool activeWait;
+    qint64 deadline = nextDeadline(&activeWait);
+    if(deadline < 0)
+    {
+        return;
+    }
+
+    qint64 remainingNs = deadline - m_clock.nsecsElapsed();
+    if(remainingNs > 0)
+    {
+        if(!activeWait || (remainingNs >= MAX_ACTIVE_WAIT_NS))
+        {//The timer has expired early or has been started for an earlier (finished or closed) session.
+            rescheduleSlot();
+            return;
+        }
+        //Spin until the consecutive frame with a sub-ms STmin is due (max. MAX_ACTIVE_WAIT_NS,
+        //QThread::usleep sleeps at least one scheduler tick on Windows).
+        while(m_clock.nsecsElapsed() < deadline)
+        {
+            QThread::yieldCurrentThread();
+        }
+    }
+
+    processDueSessions();
+    rescheduleSlot();
+}
+
+/**
+ * Processes all sessions whose deadline has been reached: sends pending messages and due consecutive frames
+ * and aborts transfers whose flow control or consecutive frame timeout has elapsed.
+ * The mutex is locked during the sending (the engine is the only sender of the session frames), the owners are
+ * notified after the mutex has been unlocked.
+ */
+void IsoTpEngine::processDueSessions(void)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 now = m_clock.nsecsElapsed();
+    QVector<IsoTpNotification> notifications;
+
+    for(auto& el : m_sessions)
+    {
+        if(el.txState == ISOTP_TX_PENDING)
+        {
+            sendFirstFrame(el, now);
+        }
+        else if((el.txState == ISOTP_TX_SENDING) && (el.txDeadlineNs <= now))
+        {
+            sendConsecutiveFrames(el, now);
+        }
+        else if((el.txState == ISOTP_TX_WAIT_FLOW_CONTROL) && (el.txDeadlineNs <= now))
+        {
+            finishTransmission(el, false, "flow control timeout (N_Bs)");
+        }
+
+        if(el.rxIsActive && (el.rxTimeoutNs <= now))
+        {
+            abortReception(el, "consecutive frame timeout (N_Cr)");
+        }
+    }
+
+    notifications.swap(m_notifications);
+    locker.unlock();
+    emitNotifications(notifications);
+}
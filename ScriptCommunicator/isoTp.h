@@ -0,0 +1,285 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef ISOTP_H
+#define ISOTP_H
+
+#include <QObject>
+#include <QTimer>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include "canFrame.h"
+
+///The transmit states of an ISO-TP session.
+typedef enum
+{
+    ///No message is sent.
+    ISOTP_TX_IDLE,
+
+    ///The single frame or the first frame has not been sent yet.
+    ISOTP_TX_PENDING,
+
+    ///Waiting for a flow control frame.
+    ISOTP_TX_WAIT_FLOW_CONTROL,
+
+    ///Sending consecutive frames.
+    ISOTP_TX_SENDING
+}IsoTpTxState;
+
+///An ISO-TP session (one transmit id and one receive id, normal addressing, classic can frames).
+typedef struct
+{
+    ///The id of the owner (send id of the script thread).
+    quint32 ownerId;
+
+    ///The can type (0=standard, 2=extended).
+    quint8 type;
+
+    ///The id of the sent frames.
+    quint32 txId;
+
+    ///The id of the received frames.
+    quint32 rxId;
+
+    ///The block size which is sent in the flow control frames (0=no further flow control frames).
+    quint8 blockSize;
+
+    ///The STmin which is sent in the flow control frames (ISO-TP encoding).
+    quint8 separationTime;
+
+    ///The padding byte (-1=no padding).
+    qint16 paddingByte;
+
+    ///The transmit state.
+    IsoTpTxState txState;
+
+    ///The message which is sent.
+    QByteArray txData;
+
+    ///The number of sent bytes of txData.
+    qint32 txOffset;
+
+    ///The sequence number of the next consecutive frame.
+    quint8 txSequenceNumber;
+
+    ///The number of consecutive frames until the next flow control frame (-1=unlimited).
+    qint32 txBlockRemaining;
+
+    ///The STmin of the last received flow control frame (ns).
+    qint64 txSeparationTimeNs;
+
+    ///The time of the next consecutive frame or the flow control timeout (ns).
+    qint64 txDeadlineNs;
+
+    ///The number of received flow control wait frames.
+    quint32 txWaitFrames;
+
+    ///True if a segmented message is received.
+    bool rxIsActive;
+
+    ///The received bytes.
+    QByteArray rxData;
+
+    ///The length of the received message.
+    qint32 rxLength;
+
+    ///The expected sequence number of the next consecutive frame.
+    quint8 rxSequenceNumber;
+
+    ///The number of consecutive frames until the next flow control frame is sent.
+    qint32 rxBlockCounter;
+
+    ///The consecutive frame timeout (ns).
+    qint64 rxTimeoutNs;
+}IsoTpSession;
+
+///A notification of the owner of a session (messageReceivedSignal or messageSentSignal).
+typedef struct
+{
+    ///True for messageReceivedSignal, false for messageSentSignal.
+    bool isReceived;
+
+    ///The id of the owner.
+    quint32 ownerId;
+
+    ///The can type.
+    quint8 type;
+
+    ///The receive id (isReceived=true) or the transmit id.
+    quint32 id;
+
+    ///The received message.
+    QByteArray data;
+
+    ///True on success.
+    bool success;
+
+    ///The error description.
+    QString errorString;
+}IsoTpNotification;
+
+///ISO-TP (ISO 15765-2) transport layer: segments and reassembles messages with single, first, consecutive and
+///flow control frames (normal addressing, classic can frames). Several sessions (id pairs) can be active at the
+///same time. The engine lives in the main interface thread, the received frames are passed with framesReceived and
+///the frames are sent with sendFramesSignal (consecutive frames are sent with STmin, see CanTransmitScheduler for
+///the timing). The public functions (except framesReceived) are thread safe.
+class IsoTpEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    IsoTpEngine(QObject *parent = 0);
+
+    ///The max. size of a message.
+    static const qint32 MAX_MESSAGE_SIZE = 1024 * 1024;
+
+    ///The flow control and consecutive frame timeout (N_Bs, N_Cr).
+    static const qint64 TIMEOUT_NS = 1000000000;
+
+    ///The max. number of flow control wait frames for one message (N_WFTmax).
+    static const quint32 MAX_WAIT_FRAMES = 16;
+
+    ///The max. number of consecutive frames which are sent with one call (STmin=0).
+    static const qint32 MAX_FRAMES_PER_BURST = 32;
+
+    ///The engine spins on the clock only for a consecutive frame of a session with a STmin below this time (ns)
+    ///if the frame is due in less than this time (the timer has a resolution of 1 ms). All other deadlines
+    ///(STmin >= 1 ms, timeouts) are waited with the timer.
+    static const qint64 MAX_ACTIVE_WAIT_NS = 1000000;
+
+    ///Opens a session (false if txId or rxId is used by another session).
+    bool openSession(quint32 ownerId, quint8 type, quint32 txId, quint32 rxId, quint8 blockSize, quint8 separationTime, qint16 paddingByte);
+
+    ///Closes a session (a running transfer is aborted without notification).
+    void closeSession(quint8 type, quint32 txId);
+
+    ///Closes all sessions of an owner.
+    void closeAllSessions(quint32 ownerId);
+
+    ///Sends a message (the result is emitted with messageSentSignal). Returns false if the session
+    ///does not exist, if it is sending or if the message size is invalid.
+    bool send(quint8 type, quint32 txId, const QByteArray& data);
+
+    ///Processes received frames (must be called in the thread of the engine).
+    void framesReceived(const QVector<CanFrame>& frames);
+
+    ///Converts a separation time (ms) into the ISO-TP encoding (0-127 ms, 0.1-0.9 ms).
+    static quint8 encodeSeparationTime(double separationTime);
+
+    ///Converts an ISO-TP separation time into ns.
+    static qint64 decodeSeparationTime(quint8 separationTime);
+
+    ///Returns the key of an id (the same as CanTransmitScheduler::createKey).
+    static quint32 createKey(quint8 type, quint32 id){return (type & CAN_FRAME_FLAG_EXTENDED) ? (id | 0x80000000) : id;}
+
+signals:
+    ///Is emitted if frames shall be sent. The receiver sends the frames and sets success.
+    ///This signal must be connected with a direct connection.
+    void sendFramesSignal(const QVector<CanFrame>& frames, bool* success);
+
+    ///Is emitted if a message has been received (or if the reception has failed).
+    void messageReceivedSignal(quint32 ownerId, quint8 type, quint32 rxId, QByteArray data, bool success, QString errorString);
+
+    ///Is emitted if a message has been sent (or if the sending has failed).
+    void messageSentSignal(quint32 ownerId, quint8 type, quint32 txId, bool success, QString errorString);
+
+public slots:
+    ///Stops the engine (must be called in the thread of the engine).
+    void stopSlot(void);
+
+private slots:
+    ///Processes the due sessions and starts the timer for the next deadline.
+    void timerSlot(void);
+
+    ///Starts the timer for the next deadline (must be called in the thread of the engine).
+    void rescheduleSlot(void);
+
+private:
+
+    ///Triggers rescheduleSlot in the thread of the engine.
+    void triggerReschedule(void);
+
+    ///Returns the earliest deadline of all sessions (-1 if no deadline exists).
+    qint64 nextDeadline(bool* activeWait);
+
+    ///Processes all sessions whose deadline has been reached (m_mutex must be locked).
+    void processDueSessions(void);
+
+    ///Processes a received frame of a session (m_mutex must be locked).
+    void handleFrame(IsoTpSession& session, const CanFrame& frame, qint64 now);
+
+    ///Sends the single frame or the first frame of a session (m_mutex must be locked).
+    void sendFirstFrame(IsoTpSession& session, qint64 now);
+
+    ///Sends the next consecutive frames of a session (m_mutex must be locked).
+    void sendConsecutiveFrames(IsoTpSession& session, qint64 now);
+
+    ///Sends a flow control frame (m_mutex must be locked).
+    bool sendFlowControl(IsoTpSession& session, quint8 flowStatus);
+
+    ///Creates a frame of a session (the frame is padded if the padding byte is set).
+    static CanFrame createFrame(const IsoTpSession& session, const quint8* data, int length);
+
+    ///Finishes the transmission of a session (m_mutex must be locked).
+    void finishTransmission(IsoTpSession& session, bool success, QString errorString);
+
+    ///Aborts the reception of a session (m_mutex must be locked).
+    void abortReception(IsoTpSession& session, QString errorString);
+
+    ///Adds a notification of the owner of a session to m_notifications (m_mutex must be locked).
+    void addNotification(bool isReceived, const IsoTpSession& session, const QByteArray& data, bool success, QString errorString);
+
+    ///Emits the notifications (m_mutex must not be locked, so that the receivers can call send or closeSession).
+    void emitNotifications(const QVector<IsoTpNotification>& notifications);
+
+    ///Removes the session at index (the last session is moved to index, m_mutex must be locked).
+    void removeAt(qint32 index);
+
+    ///Protects m_sessions and m_indexes.
+    QMutex m_mutex;
+
+    ///All sessions.
+    QVector<IsoTpSession> m_sessions;
+
+    ///Maps the key (createKey) of the receive id of a session to its index in m_sessions.
+    QHash<quint32, qint32> m_indexes;
+
+    ///The notifications which are emitted after m_mutex has been unlocked.
+    QVector<IsoTpNotification> m_notifications;
+
+    ///The number of sessions (is read without m_mutex in framesReceived).
+    QAtomicInt m_numberOfSessions;
+
+    ///The time base of all deadlines.
+    QElapsedTimer m_clock;
+
+    ///The timer for the next deadline.
+    QTimer* m_timer;
+};
+
+#endif // ISOTP_H
@@ -29,6 +29,7 @@
 #include <QTimer>
 #include <QScrollBar>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QTime>
 
 #include <QMessageBox>
@@ -49,10 +50,40 @@
  */
 MainInterfaceThread::MainInterfaceThread(MainWindow* mainWindow):m_exit(false),
     m_serial(0),m_tcpServer(0),m_tcpServerSocket(0),m_tcpClientSocket(0),
-    m_udpServerSocket(0), m_udpClientSocket(0), m_cheetahSpi(0), m_isConnected(false), m_showAdditionalInformationTimer(0), m_pcanInterface(0),
-    m_numberOfSentBytes(0), m_lastNumberOfSentBytes(0), m_numberOfReceivedBytes(0),m_lastNumberOfReceivedBytes(0),  m_dataRateTimer(0)
+    m_udpServerSocket(0), m_udpClientSocket(0), m_cheetahSpi(0), m_isConnected(false), m_showAdditionalInformationTimer(0), m_pcanInterface(0), m_socketCan(0),
+    m_canTransmitScheduler(0), m_triggerCapture(0), m_isoTpEngine(0), m_numberOfSentBytes(0), m_lastNumberOfSentBytes(0), m_numberOfReceivedBytes(0),m_lastNumberOfReceivedBytes(0),  m_dataRateTimer(0),
+    m_canBusStatistics(), m_canBusStatisticsTimer(0), m_canBusStatisticsClock(), m_lastCanBusStatistics(), m_canBusStatisticsMutex()
 {
     m_mainWindow = mainWindow;
+
+    qRegisterMetaType<CanBusStatisticsSnapshot>("CanBusStatisticsSnapshot");
+    m_lastCanBusStatistics = m_canBusStatistics.update(0);
+
+    //The scheduler is created here (and not in run), so that the script threads can use it at any time.
+    m_canTransmitScheduler = new CanTransmitScheduler();
+    m_canTransmitScheduler->moveToThread(this);
+    connect(m_canTransmitScheduler, SIGNAL(framesDueSignal(QVector<CanFrame>,bool*)),
+            this, SLOT(canFramesDueSlot(QVector<CanFrame>,bool*)), Qt::DirectConnection);
+
+    m_triggerCapture = new TriggerCapture();
+    m_triggerCapture->moveToThread(this);
+
+    m_isoTpEngine = new IsoTpEngine();
+    m_isoTpEngine->moveToThread(this);
+    connect(m_isoTpEngine, SIGNAL(sendFramesSignal(QVector<CanFrame>,bool*)),
+            this, SLOT(canFramesDueSlot(QVector<CanFrame>,bool*)), Qt::DirectConnection);
+}
+
+/**
+ * Returns the send id for a new send engine (see SEND_ID_SEND_ENGINES_START).
+ * @return
+ *      The send id.
+ */
+quint32 MainInterfaceThread::getNextSendEngineId(void)
+{
+    static QAtomicInt nextId(0);
+    quint32 numberOfIds = SEND_ID_SCRIPTS_START - SEND_ID_SEND_ENGINES_START;
+    return SEND_ID_SEND_ENGINES_START + ((quint32)nextId.fetchAndAddOrdered(1) % numberOfIds);
 }
 
 /**
@@ -60,7 +91,9 @@ MainInterfaceThread::MainInterfaceThread(MainWindow* mainWindow):m_exit(false),
  */
 MainInterfaceThread::~MainInterfaceThread()
 {
-
+    delete m_canTransmitScheduler;
+    delete m_triggerCapture;
+    delete m_isoTpEngine;
 }
 
 /**
@@ -68,15 +101,26 @@ MainInterfaceThread::~MainInterfaceThread()
  */
 void MainInterfaceThread::pcanReceivedDataSlot(void)
 {
-    QByteArray data = m_pcanInterface->readLastMessage();
-    QVector<QByteArray> messages;
-    while(!data.isEmpty())
-    {
-        messages.append(data);
-        m_numberOfReceivedBytes += data.size() - 9;
+    QVector<CanFrame> messages = m_pcanInterface->readMessages();
+    countReceivedCanFrames(messages);
+    m_triggerCapture->addCanFrames(messages);
+    m_isoTpEngine->framesReceived(messages);
 
-        data = m_pcanInterface->readLastMessage();
+    if(!messages.empty())
+    {
+        emit canMessagesReceivedSignal(messages);
     }
+}
+
+/**
+ * This slot function is called if frames have been received from the SocketCAN interface.
+ */
+void MainInterfaceThread::socketCanReceivedDataSlot(void)
+{
+    QVector<CanFrame> messages = m_socketCan->readMessages();
+    countReceivedCanFrames(messages);
+    m_triggerCapture->addCanFrames(messages);
+    m_isoTpEngine->framesReceived(messages);
 
     if(!messages.empty())
     {
@@ -159,7 +203,7 @@ bool MainInterfaceThread::isConnected()
  */
 bool MainInterfaceThread::isConnectedWithCan()
 {
-    return m_pcanInterface->isConnected();
+    return m_pcanInterface->isConnected() || m_socketCan->isConnected();
 }
 
 /**
@@ -199,6 +243,7 @@ void MainInterfaceThread::dataReceived(QByteArray& data)
 {
     emit dataReceivedSignal(data);
     m_numberOfReceivedBytes += data.size();
+    m_triggerCapture->addData(data);
 }
 
 /**
@@ -319,6 +364,93 @@ void MainInterfaceThread::dataRateTimerSlot(void)
     m_lastNumberOfReceivedBytes = m_numberOfReceivedBytes;
 }
 
+/**
+ * Can bus statistics timer slot.
+ */
+void MainInterfaceThread::canBusStatisticsTimerSlot(void)
+{
+    qint64 elapsedNs = m_canBusStatisticsClock.nsecsElapsed();
+    m_canBusStatisticsClock.restart();
+
+    if(!isConnectedWithCan())
+    {
+        return;
+    }
+
+    if(m_currentGlobalSettings.connectionType == CONNECTION_TYPE_PCAN)
+    {
+        m_canBusStatistics.setErrorFrames(m_pcanInterface->getStatusMessages());
+    }
+    else
+    {
+        m_canBusStatistics.setErrorFrames(m_socketCan->getErrorFrames());
+    }
+
+    CanBusStatisticsSnapshot statistics = m_canBusStatistics.update(elapsedNs);
+    {
+        QMutexLocker locker(&m_canBusStatisticsMutex);
+        m_lastCanBusStatistics = statistics;
+    }
+    emit canBusStatisticsSignal(statistics);
+}
+
+/**
+ * Returns the current can bus statistics (thread safe).
+ * @return
+ *      The statistics of the last interval.
+ */
+CanBusStatisticsSnapshot MainInterfaceThread::getCanBusStatistics(void)
+{
+    QMutexLocker locker(&m_canBusStatisticsMutex);
+    return m_lastCanBusStatistics;
+}
+
+/**
+ * Counts received can frames (data rate and can bus statistics).
+ * @param frames
+ *      The frames.
+ */
+void MainInterfaceThread::countReceivedCanFrames(const QVector<CanFrame>& frames)
+{
+    for(const auto& el : frames)
+    {
+        m_numberOfReceivedBytes += el.length;
+    }
+    m_canBusStatistics.addFrames(frames, true);
+}
+
+/**
+ * Counts sent can frames (data rate and can bus statistics).
+ * @param frames
+ *      The frames.
+ */
+void MainInterfaceThread::countSentCanFrames(const QVector<CanFrame>& frames)
+{
+    for(const auto& el : frames)
+    {
+        m_numberOfSentBytes += el.length;
+    }
+    m_canBusStatistics.addFrames(frames, false);
+}
+
+/**
+ * Resets the can bus statistics (after a can interface has been connected).
+ */
+void MainInterfaceThread::resetCanBusStatistics(void)
+{
+    if(m_currentGlobalSettings.connectionType == CONNECTION_TYPE_PCAN)
+    {
+        m_canBusStatistics.setBitrate(SettingsDialog::convertPcanBaudrate(m_currentGlobalSettings.pcanInterface.baudRate).toUInt() * 1000);
+    }
+    else
+    {
+        m_canBusStatistics.setBitrate(m_socketCan->getBitrate());
+    }
+    m_canBusStatistics.reset();
+    m_canBusStatistics.update(0);
+    m_canBusStatisticsClock.restart();
+}
+
 /**
  * Creates a network proxy.
  * @return
@@ -376,14 +508,25 @@ void MainInterfaceThread::run(void)
     m_pcanInterface = new PCANBasicClass(this);
     connect(m_pcanInterface, SIGNAL(readyRead()),this, SLOT(pcanReceivedDataSlot()));
 
+    m_socketCan = new SocketCan(this);
+    connect(m_socketCan, SIGNAL(readyRead()),this, SLOT(socketCanReceivedDataSlot()));
+
     m_dataRateTimer = new QTimer(this);
     connect(m_dataRateTimer, SIGNAL(timeout()),this, SLOT(dataRateTimerSlot()));
     m_dataRateTimer->start(DATA_RATE_TIME_BASE_SECONDS * 1000);
 
+    m_canBusStatisticsTimer = new QTimer(this);
+    connect(m_canBusStatisticsTimer, SIGNAL(timeout()),this, SLOT(canBusStatisticsTimerSlot()));
+    m_canBusStatisticsTimer->start(CAN_BUS_STATISTICS_INTERVAL_MS);
+    m_canBusStatisticsClock.start();
+
     exec();
 
     m_showAdditionalInformationTimer->stop();
     m_dataRateTimer->stop();
+    m_canBusStatisticsTimer->stop();
+    m_canTransmitScheduler->stopSlot();
+    m_isoTpEngine->stopSlot();
 }
 
 /**
@@ -403,12 +546,16 @@ void MainInterfaceThread::sendDataSlot(const QByteArray data, uint id)
         {
             sendingFinishedSignal(true, id);
             sendingFinishedSignal(data, true, id);
-            m_numberOfSentBytes += data.size();
 
             if(isConnectedWithCan())
             {
-                ///1 Byte type and 4 bytes CAN id.
-                m_numberOfSentBytes -= PCANBasicClass::BYTES_METADATA_SEND;
+                QVector<CanFrame> frames;
+                canFramesFromSendData(data, PCANBasicClass::MAX_BYTES_PER_MESSAGE, &frames);
+                countSentCanFrames(frames);
+            }
+            else
+            {
+                m_numberOfSentBytes += data.size();
             }
         }
         else
@@ -423,6 +570,50 @@ void MainInterfaceThread::sendDataSlot(const QByteArray data, uint id)
     }
 }
 
+/**
+ * Slot function for sending several can frames with one call (main interface must be a can interface).
+ * @param frames
+ *      The frames.
+ * @param id
+ *      The send id.
+ */
+void MainInterfaceThread::sendCanFramesSlot(const QVector<CanFrame> frames, uint id)
+{
+    if(!frames.isEmpty() && sendCanFramesWithTheMainInterface(frames))
+    {
+        for(const auto& el : frames)
+        {
+            QByteArray data = canFrameToSendData(el);
+            emit sendDataWithWorkerScriptsSignal(data);
+            emit sendingFinishedSignal(data, true, id);
+        }
+        countSentCanFrames(frames);
+        emit sendingFinishedSignal(true, id);
+    }
+    else
+    {
+        emit sendingFinishedSignal(false, id);
+    }
+}
+
+/**
+ * Sends the due periodic can messages and the ISO-TP frames (is connected with CanTransmitScheduler::framesDueSignal
+ * and IsoTpEngine::sendFramesSignal).
+ * The frames are not shown in the consoles (only the sent bytes are counted).
+ * @param frames
+ *      The frames.
+ * @param success
+ *      Is set to true on success.
+ */
+void MainInterfaceThread::canFramesDueSlot(const QVector<CanFrame>& frames, bool* success)
+{
+    *success = sendCanFramesWithTheMainInterface(frames);
+    if(*success)
+    {
+        countSentCanFrames(frames);
+    }
+}
+
 /**
  * Call this slot function to exit the main interface thread.
  */
@@ -453,6 +644,10 @@ void MainInterfaceThread::showAdditionalInformationTimerSlot(void)
     {
         emit showAdditionalConnectionInformationSignal(serialPortPinoutSignalsToInfoString());
     }
+    else if(m_socketCan->isConnected() && (m_socketCan->getDroppedFrames() != 0))
+    {
+        emit showAdditionalConnectionInformationSignal(QString("dropped frames: %1").arg(m_socketCan->getDroppedFrames()));
+    }
 }
 
 
@@ -505,6 +700,7 @@ void MainInterfaceThread::connectDataConnectionSlot(Settings globalSettings, boo
     m_udpServerSocket->close();
     m_cheetahSpi->disconnect();
     m_pcanInterface->close();
+    m_socketCan->close();
     m_isConnected = false;
 
     m_numberOfSentBytes = 0;
@@ -671,6 +867,7 @@ void MainInterfaceThread::connectDataConnectionSlot(Settings globalSettings, boo
             }
             if(m_isConnected)
             {
+                resetCanBusStatistics();
                 emit dataConnectionStatusSignal(true, tr("Connected to pcan %1: baud.=%2 (kHz), 5V=%3, reset=%4, filter=%5 %6-%7")
                                                 .arg(m_currentGlobalSettings.pcanInterface.channel)
                                                 .arg(SettingsDialog::convertPcanBaudrate(m_currentGlobalSettings.pcanInterface.baudRate))
@@ -683,8 +880,6 @@ void MainInterfaceThread::connectDataConnectionSlot(Settings globalSettings, boo
             }
             else
             {
- #if defined(WIN32) || defined(_WIN32)
-
                 if(m_currentGlobalSettings.pcanInterface.channel != 0)
                 {
                     showMessageBox(QMessageBox::Critical, tr("pcan error"),
@@ -698,15 +893,33 @@ void MainInterfaceThread::connectDataConnectionSlot(Settings globalSettings, boo
                 {
                     showMessageBox(QMessageBox::Critical, tr("pcan open error"), "invalid pcan channel");
                 }
-#else
-                showMessageBox(QMessageBox::Critical, tr("pcan open error"), "pcan is only available on windows");
-#endif
                 m_isConnected = false;
                 emit dataConnectionStatusSignal(false, tr("open error"), false);
                 emit showAdditionalConnectionInformationSignal("");
             }
 
         }
+        else if(m_currentGlobalSettings.connectionType == CONNECTION_TYPE_SOCKETCAN)
+        {
+            m_isConnected = m_socketCan->open(m_currentGlobalSettings.socketCan.interfaceName, m_currentGlobalSettings.socketCan.filters);
+
+            if(m_isConnected)
+            {
+                resetCanBusStatistics();
+                emit dataConnectionStatusSignal(true, tr("Connected to SocketCAN %1: filter=%2")
+                                                .arg(m_currentGlobalSettings.socketCan.interfaceName)
+                                                .arg(m_currentGlobalSettings.socketCan.filters.isEmpty() ? "none" : m_currentGlobalSettings.socketCan.filters), false);
+            }
+            else
+            {
+                showMessageBox(QMessageBox::Critical, tr("SocketCAN error"),
+                                          tr("could not open SocketCAN interface %1: %2")
+                                          .arg(m_currentGlobalSettings.socketCan.interfaceName)
+                                          .arg(m_socketCan->getErrorString()));
+                emit dataConnectionStatusSignal(false, tr("open error"), false);
+                emit showAdditionalConnectionInformationSignal("");
+            }
+        }
         else
         {
             m_isConnected = false;
@@ -874,6 +1087,15 @@ bool MainInterfaceThread::sendDataWithTheMainInterface(const QByteArray &data, b
                  emit showAdditionalConnectionInformationSignal("Bus off event occurred (interface has been restartet)");
             }
         }
+        else if(m_currentGlobalSettings.connectionType == CONNECTION_TYPE_SOCKETCAN)
+        {
+            success = m_socketCan->sendData(data);
+
+            if(!success)
+            {
+                emit showAdditionalConnectionInformationSignal(m_socketCan->getErrorString());
+            }
+        }
         else
         {
             success = false;
@@ -898,3 +1120,43 @@ bool MainInterfaceThread::sendDataWithTheMainInterface(const QByteArray &data, b
 
     return success;
 }
+
+/**
+ * Sends several can frames with the main interface (PCAN or SocketCAN).
+ * @param frames
+ *      The frames.
+ * @return
+ *      True for success.
+ */
+bool MainInterfaceThread::sendCanFramesWithTheMainInterface(const QVector<CanFrame>& frames)
+{
+    bool success = false;
+
+    if(m_isConnected && (m_currentGlobalSettings.connectionType == CONNECTION_TYPE_PCAN))
+    {
+        bool queueIsFull = false;
+        success = m_pcanInterface->sendFrames(frames, &queueIsFull);
+
+        if(queueIsFull)
+        {//The bus is busy (no bus off), the interface must not be restarted.
+            emit showAdditionalConnectionInformationSignal("could not send can frames: transmit queue is full");
+        }
+        else if(!success)
+        {
+            m_pcanInterface->close();
+            connectDataConnectionSlot(m_currentGlobalSettings, true);
+            emit showAdditionalConnectionInformationSignal("Bus off event occurred (interface has been restartet)");
+        }
+    }
+    else if(m_isConnected && (m_currentGlobalSettings.connectionType == CONNECTION_TYPE_SOCKETCAN))
+    {
+        success = m_socketCan->sendFrames(frames);
+
+        if(!success)
+        {
+            emit showAdditionalConnectionInformationSignal(m_socketCan->getErrorString());
+        }
+    }
+
+    return success;
+}
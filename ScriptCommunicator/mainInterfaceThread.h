@@ -29,6 +29,13 @@
 #include <QTimer>
 #include "cheetahspi.h"
 #include "PCANBasicClass.h"
+#include "socketCan.h"
+#include "canTransmitScheduler.h"
+#include "canBusStatistics.h"
+#include "triggerCapture.h"
+#include "isoTp.h"
+#include <QMutex>
+#include <QElapsedTimer>
 #include <QNetworkProxy>
 
 
@@ -48,6 +55,13 @@ public:
     ///Start value for the send thread send ids .
     static const quint32 SEND_ID_SCRIPTS_START = 1000;
 
+    ///Start value for the send engine send ids (ScriptSequencePlaylist, ScriptTransactionEngine).
+    ///The ids end at SEND_ID_SCRIPTS_START.
+    static const quint32 SEND_ID_SEND_ENGINES_START = 100;
+
+    ///Returns the send id for a new send engine (see SEND_ID_SEND_ENGINES_START).
+    static quint32 getNextSendEngineId(void);
+
     ///Send id for the cyclic sending in the send window.
     static const quint32 SEND_ID_SEND_WINDOW_CYCLIC = 1;
 
@@ -69,6 +83,18 @@ public:
     ///True if the main interface thread is connected with a can interface.
     bool isConnectedWithCan();
 
+    ///Returns the transmit scheduler for periodic can messages (the scheduler lives in the main interface thread).
+    CanTransmitScheduler* getCanTransmitScheduler(void){return m_canTransmitScheduler;}
+
+    ///Returns the trigger capture of the received data (the trigger capture lives in the main interface thread).
+    TriggerCapture* getTriggerCapture(void){return m_triggerCapture;}
+
+    ///Returns the ISO-TP engine (the engine lives in the main interface thread).
+    IsoTpEngine* getIsoTpEngine(void){return m_isoTpEngine;}
+
+    ///Returns the current can bus statistics (thread safe).
+    CanBusStatisticsSnapshot getCanBusStatistics(void);
+
     ///Converts the serial port pinout signal to an information string
     ///(RTS=0, CTS=0, DSR=0, DCD=0, DTR=0, RI=0).
     QString serialPortPinoutSignalsToInfoString(void);
@@ -83,6 +109,9 @@ public:
     ///The time base for the data rate calcualtion.
     static const quint32 DATA_RATE_TIME_BASE_SECONDS = 2;
 
+    ///The interval of the can bus statistics (ms).
+    static const qint32 CAN_BUS_STATISTICS_INTERVAL_MS = 1000;
+
 signals:
 
     ///The main interface thread emits this signal if his connection state has been changed.
@@ -95,7 +124,7 @@ signals:
     void dataReceivedSignal(QByteArray data);
 
     ///The main interface thread emits this signal if can messages have been received.
-    void canMessagesReceivedSignal(QVector<QByteArray> messages);
+    void canMessagesReceivedSignal(QVector<CanFrame> messages);
 
     ///The main interface thread emits this signal if the sending of data has been finished.
     void sendingFinishedSignal(bool success, uint id);
@@ -118,6 +147,9 @@ signals:
     ///Signal which publishes the current data rates.
     void dataRateUpdateSignal(quint32 dataRateSend, quint32 dataRateReceive);
 
+    ///Signal which publishes the can bus statistics (once per CAN_BUS_STATISTICS_INTERVAL_MS, only if connected with a can interface).
+    void canBusStatisticsSignal(CanBusStatisticsSnapshot statistics);
+
     ///Send the send data to all worker scripts which must send the data too.
     void sendDataWithWorkerScriptsSignal(const QByteArray data);
 
@@ -140,6 +172,9 @@ public slots:
     ///Slot function for sending data with main interface thread.
     void sendDataSlot(const QByteArray data, uint id);
 
+    ///Slot function for sending several can frames with one call (main interface must be a can interface).
+    void sendCanFramesSlot(const QVector<CanFrame> frames, uint id);
+
 
 private slots:
 
@@ -152,6 +187,9 @@ private slots:
     ///This slot function is called if data has been received from the pcan interface.
     void pcanReceivedDataSlot(void);
 
+    ///This slot function is called if frames have been received from the SocketCAN interface.
+    void socketCanReceivedDataSlot(void);
+
     ///This slot function is called if an external tcp client has been connected to the internal tcp server.
     void tcpServerOnNewConnectionSlot(void);
 
@@ -179,6 +217,13 @@ private slots:
     ///Data rate timer slot.
     void dataRateTimerSlot(void);
 
+    ///Can bus statistics timer slot.
+    void canBusStatisticsTimerSlot(void);
+
+    ///Sends the due periodic can messages and the ISO-TP frames (is connected with CanTransmitScheduler::framesDueSignal
+    ///and IsoTpEngine::sendFramesSignal).
+    void canFramesDueSlot(const QVector<CanFrame>& frames, bool* success);
+
 private:
 
     ///Creates a network proxy.
@@ -190,6 +235,18 @@ private:
     ///Sends data with the main interface.
     bool sendDataWithTheMainInterface(const QByteArray &data, bool waitForSendingFinished);
 
+    ///Sends several can frames with the main interface (PCAN or SocketCAN).
+    bool sendCanFramesWithTheMainInterface(const QVector<CanFrame>& frames);
+
+    ///Counts received can frames (data rate and can bus statistics).
+    void countReceivedCanFrames(const QVector<CanFrame>& frames);
+
+    ///Counts sent can frames (data rate and can bus statistics).
+    void countSentCanFrames(const QVector<CanFrame>& frames);
+
+    ///Resets the can bus statistics (after a can interface has been connected).
+    void resetCanBusStatistics(void);
+
     ///If true, then the main interface thread shall exit.
     bool m_exit;
 
@@ -230,6 +287,18 @@ private:
     ///PCAN Interface.
     PCANBasicClass* m_pcanInterface;
 
+    ///SocketCAN interface.
+    SocketCan* m_socketCan;
+
+    ///The transmit scheduler for periodic can messages.
+    CanTransmitScheduler* m_canTransmitScheduler;
+
+    ///The trigger capture of the received data.
+    TriggerCapture* m_triggerCapture;
+
+    ///The ISO-TP engine.
+    IsoTpEngine* m_isoTpEngine;
+
     ///The current number of sent bytes.
     uint64_t m_numberOfSentBytes;
 
@@ -245,6 +314,21 @@ private:
     ///Data rate timer.
     QTimer* m_dataRateTimer;
 
+    ///The can bus statistics (are only used in the main interface thread).
+    CanBusStatistics m_canBusStatistics;
+
+    ///The can bus statistics timer.
+    QTimer* m_canBusStatisticsTimer;
+
+    ///Measures the time between two canBusStatisticsTimerSlot calls.
+    QElapsedTimer m_canBusStatisticsClock;
+
+    ///The last can bus statistics (is read by getCanBusStatistics).
+    CanBusStatisticsSnapshot m_lastCanBusStatistics;
+
+    ///Protects m_lastCanBusStatistics.
+    QMutex m_canBusStatisticsMutex;
+
 };
 
 #endif // MAININTERFACETHREAD_H
@@ -241,12 +241,14 @@ MainWindow::MainWindow(QStringList scripts, bool withScriptWindow, bool scriptWi
 
 
     qRegisterMetaType< QVector<QByteArray>>("QVector<QByteArray>");
+    qRegisterMetaType< QVector<CanFrame>>("QVector<CanFrame>");
 
     connect(m_addMessageDialog, SIGNAL(messageEnteredSignal(QString, bool)),this, SLOT(messageEnteredSlot(QString, bool)));
 
     connect(&m_resizeTimer, SIGNAL(timeout()),m_handleData, SLOT(reInsertDataInMixecConsoleSlot()));
 
     connect(m_sendWindow, SIGNAL(sendDataWithTheMainInterfaceSignal(QByteArray,uint)), m_mainInterface, SLOT(sendDataSlot(QByteArray, uint)), Qt::QueuedConnection);
+    connect(m_sendWindow->getCyclicSendEngine(), SIGNAL(sendDataSignal(QByteArray,uint)), m_mainInterface, SLOT(sendDataSlot(QByteArray, uint)), Qt::QueuedConnection);
     connect(m_handleData, SIGNAL(sendDataWithTheMainInterfaceSignal(QByteArray,uint)), m_mainInterface, SLOT(sendDataSlot(QByteArray, uint)), Qt::QueuedConnection);
 
 
@@ -324,6 +326,13 @@ MainWindow::MainWindow(QStringList scripts, bool withScriptWindow, bool scriptWi
     connect(m_userInterface->sendHistoryPushButton, SIGNAL(pressed()),this, SLOT(sendHistoryButtonSlot()), Qt::QueuedConnection);
     connect(m_userInterface->clearHistoryPushButton, SIGNAL(pressed()),this, SLOT(clearHistoryButtonSlot()), Qt::QueuedConnection);
     connect(m_userInterface->createScriptPushButton, SIGNAL(pressed()),this, SLOT(createScriptButtonSlot()), Qt::QueuedConnection);
+    connect(m_userInterface->importHistoryPushButton, SIGNAL(pressed()),this, SLOT(importHistoryButtonSlot()), Qt::QueuedConnection);
+    connect(m_userInterface->exportHistoryPushButton, SIGNAL(pressed()),this, SLOT(exportHistoryButtonSlot()), Qt::QueuedConnection);
+    connect(m_userInterface->historySearchLineEdit, SIGNAL(returnPressed()),this, SLOT(historySearchSlot()), Qt::QueuedConnection);
+
+    m_userInterface->historyListView->setModel(m_handleData->m_sendHistoryModel);
+    connect(m_userInterface->historyListView->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
+            this, SLOT(historySelectionChangedSlot()), Qt::QueuedConnection);
 
     m_scriptWindow = new ScriptWindow(this, m_mainInterface, m_commandLineScripts);
     connect(m_scriptWindow, SIGNAL(configHasToBeSavedSignal()),this, SLOT(configHasToBeSavedSlot()));
@@ -345,11 +354,18 @@ MainWindow::MainWindow(QStringList scripts, bool withScriptWindow, bool scriptWi
     if(m_commandLineScripts.isEmpty())
     {
         connect(m_mainInterface, SIGNAL(dataReceivedSignal(QByteArray)),m_handleData, SLOT(dataReceivedSlot(QByteArray)), Qt::QueuedConnection);
-        connect(m_mainInterface, SIGNAL(canMessagesReceivedSignal(QVector<QByteArray>)),m_handleData, SLOT(canMessagesReceivedSlot(QVector<QByteArray>)), Qt::QueuedConnection);
+        //The can filters of the consoles/logs and of the can table are evaluated in the main interface thread.
+        connect(m_mainInterface, SIGNAL(canMessagesReceivedSignal(QVector<CanFrame>)),m_canTab->getConsoleFilter(), SLOT(framesReceivedSlot(QVector<CanFrame>)), Qt::DirectConnection);
+        connect(m_canTab->getConsoleFilter(), SIGNAL(framesAcceptedSignal(QVector<CanFrame>)),m_handleData, SLOT(canMessagesReceivedSlot(QVector<CanFrame>)), Qt::QueuedConnection);
+        connect(m_mainInterface, SIGNAL(canMessagesReceivedSignal(QVector<CanFrame>)),m_canTab->getTableFilter(), SLOT(framesReceivedSlot(QVector<CanFrame>)), Qt::DirectConnection);
         connect(m_mainInterface, SIGNAL(sendingFinishedSignal(QByteArray, bool, uint)),m_handleData, SLOT(dataHasBeenSendSlot(QByteArray, bool, uint)), Qt::QueuedConnection);
 
         connect(m_mainInterface, SIGNAL(sendingFinishedSignal(bool, uint)),m_sendWindow, SLOT(dataHasBeenSendSlot(bool, uint)), Qt::QueuedConnection);
+
+        //The cyclic send engine is called directly (in the main interface thread) to be independent of the main thread.
+        connect(m_mainInterface, SIGNAL(sendingFinishedSignal(bool, uint)),m_sendWindow->getCyclicSendEngine(), SLOT(sendingFinishedSlot(bool, uint)), Qt::DirectConnection);
         connect(m_mainInterface, SIGNAL(dataRateUpdateSignal(quint32,quint32)),this, SLOT(dataRateUpdateSlot(quint32,quint32)), Qt::QueuedConnection);
+        connect(m_mainInterface, SIGNAL(canBusStatisticsSignal(CanBusStatisticsSnapshot)),m_canTab, SLOT(canBusStatisticsSlot(CanBusStatisticsSnapshot)), Qt::QueuedConnection);
 
         m_mainConfigFileList = getAndCreateProgramUserFolder() + "/mainConfigFileList.txt";
 
@@ -632,7 +648,7 @@ void MainWindow::clearHistoryButtonSlot()
     m_userInterface->endIndexSpinBox->setValue(0);
 
     m_handleData->m_sendHistory.clear();
-    m_userInterface->historyTextEdit->clear();
+    m_handleData->m_sendHistoryModel->update();
 
     m_userInterface->startIndexSpinBox->blockSignals(false);
     m_userInterface->endIndexSpinBox->blockSignals(false);
@@ -640,6 +656,103 @@ void MainWindow::clearHistoryButtonSlot()
     saveSettings();
 }
 
+/**
+ * Is called if the user presses the import history button.
+ */
+void MainWindow::importHistoryButtonSlot()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("select the history file"), "", tr("history files (*.txt);;Files (*)"));
+    if(!fileName.isEmpty())
+    {
+        QString errorString;
+        qint32 count = m_handleData->m_sendHistory.importFromFile(fileName, &errorString);
+        if(count < 0)
+        {
+            QMessageBox::critical(this, "error", "could not read " + fileName + ": " + errorString);
+        }
+        else
+        {
+            m_userInterface->startIndexSpinBox->setMaximum(m_handleData->m_sendHistory.size() - 1);
+            m_userInterface->endIndexSpinBox->setMaximum(m_handleData->m_sendHistory.size() - 1);
+            m_handleData->historyConsoleTimerSlot();
+        }
+    }
+}
+
+/**
+ * Is called if the user presses the export history button.
+ */
+void MainWindow::exportHistoryButtonSlot()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("select the history file"), "", tr("history files (*.txt);;Files (*)"));
+    if(!fileName.isEmpty())
+    {
+        QString errorString;
+        if(!m_handleData->m_sendHistory.exportToFile(fileName, &errorString))
+        {
+            QMessageBox::critical(this, "error", "could not write " + fileName + ": " + errorString);
+        }
+    }
+}
+
+/**
+ * Is called if the user presses enter in the history search line edit.
+ * Searches the next entry (towards the older entries) which contains the entered data
+ * (the data is interpreted in the current history format).
+ */
+void MainWindow::historySearchSlot()
+{
+    const Settings* currentSettings = m_settingsDialog->settings();
+    QString format = m_userInterface->historyFormatComboBox->currentText();
+    QByteArray pattern = SendWindow::textToByteArray(format, m_userInterface->historySearchLineEdit->text(),
+                                                     SendWindow::formatToDecimalType(format), currentSettings->targetEndianess);
+
+    //Update the view (the search uses the current indexes of the history).
+    m_handleData->historyConsoleTimerSlot();
+
+    QModelIndex current = m_userInterface->historyListView->currentIndex();
+    qint32 startIndex = current.isValid() ? current.row() + 1 : 0;
+
+    qint32 index = m_handleData->m_sendHistory.search(pattern, startIndex, true);
+    if((index == -1) && (startIndex > 0))
+    {//Wrap around.
+        index = m_handleData->m_sendHistory.search(pattern, 0, true);
+    }
+
+    if(index == -1)
+    {
+        m_userInterface->statusBar->showMessage("send history: no match", 3000);
+    }
+    else
+    {
+        QModelIndex modelIndex = m_handleData->m_sendHistoryModel->index(index);
+        m_userInterface->historyListView->setCurrentIndex(modelIndex);
+        m_userInterface->historyListView->scrollTo(modelIndex);
+    }
+}
+
+/**
+ * Is called if the selection in the history view has been changed.
+ * The first and the last selected index are used as start and end index.
+ */
+void MainWindow::historySelectionChangedSlot()
+{
+    QModelIndexList selectedRows = m_userInterface->historyListView->selectionModel()->selectedRows();
+    if(!selectedRows.isEmpty() && !m_handleData->m_historySendIsInProgress)
+    {
+        qint32 first = selectedRows[0].row();
+        qint32 last = first;
+        for(auto el : selectedRows)
+        {
+            first = qMin(first, el.row());
+            last = qMax(last, el.row());
+        }
+
+        m_userInterface->startIndexSpinBox->setValue(first);
+        m_userInterface->endIndexSpinBox->setValue(last);
+    }
+}
+
 /**
  * Is called if the user presses the send history button.
  */
@@ -695,7 +808,7 @@ void MainWindow::createScriptButtonSlot()
             quint32 arrayIndex = 0;
 
             //Creates on entry in the script sendElements array.
-            auto createElementString = [](quint32 arrayIndex, QByteArray* data)
+            auto createElementString = [](quint32 arrayIndex, const QByteArray* data)
             {
                 QString elementString = QString("sendElements[%1] = Array(").arg(arrayIndex);
                 QString currentElement = byteArrayToNumberString(*data, false , false, false, false, true,
@@ -708,17 +821,17 @@ void MainWindow::createScriptButtonSlot()
             //Create all sendElements array entries.
             if(startIndex < endIndex)
             {
-                for(qint32 i = startIndex; (i <= endIndex) && (i < m_handleData->m_sendHistory.length()); i++)
+                for(qint32 i = startIndex; (i <= endIndex) && (i < m_handleData->m_sendHistory.size()); i++)
                 {
-                    elementsString +=createElementString(arrayIndex, &m_handleData->m_sendHistory[i]);
+                    elementsString +=createElementString(arrayIndex, &m_handleData->m_sendHistory.at(i));
                     arrayIndex++;
                 }
             }
             else
             {
-                for(qint32 i = startIndex; (i >= endIndex) && (i < m_handleData->m_sendHistory.length()); i--)
+                for(qint32 i = startIndex; (i >= endIndex) && (i < m_handleData->m_sendHistory.size()); i--)
                 {
-                    elementsString +=createElementString(arrayIndex, &m_handleData->m_sendHistory[i]);
+                    elementsString +=createElementString(arrayIndex, &m_handleData->m_sendHistory.at(i));
                     arrayIndex++;
                 }
             }
@@ -1353,6 +1466,44 @@ void MainWindow::loadSettings()
                         currentSettings.pcanInterface.filterTo = node.attributes().namedItem("filterTo").nodeValue();
                     }
                 }
+                {//can database
+
+                    QString fileName;
+                    QDomNodeList nodeList = docElem.elementsByTagName("canDatabase");
+                    if(!nodeList.isEmpty())
+                    {
+                        QDomNode node = nodeList.at(0);
+                        fileName = convertToAbsolutePath(m_mainConfigFile, node.attributes().namedItem("fileName").nodeValue());
+                    }
+                    if(fileName != m_canTab->getDatabaseFileName())
+                    {
+                        m_canTab->loadDatabase(fileName);
+                    }
+                }
+                {//can filters
+
+                    QString tableFilter;
+                    QString consoleFilter;
+                    QDomNodeList nodeList = docElem.elementsByTagName("canFilters");
+                    if(!nodeList.isEmpty())
+                    {
+                        QDomNode node = nodeList.at(0);
+                        tableFilter = node.attributes().namedItem("tableFilter").nodeValue();
+                        consoleFilter = node.attributes().namedItem("consoleFilter").nodeValue();
+                    }
+                    m_canTab->setFilters(tableFilter, consoleFilter);
+                }
+                {//SocketCAN
+
+                    QDomNodeList nodeList = docElem.elementsByTagName("socketCanSetting");
+                    if(!nodeList.isEmpty())
+                    {
+                        QDomNode node = nodeList.at(0);
+
+                        currentSettings.socketCan.interfaceName = node.attributes().namedItem("interfaceName").nodeValue();
+                        currentSettings.socketCan.filters = node.attributes().namedItem("filters").nodeValue();
+                    }
+                }
                 {//send window
 
                     QDomNodeList nodeList = docElem.elementsByTagName("sendWindow");
@@ -1380,6 +1531,7 @@ void MainWindow::loadSettings()
                         m_userInterface->interactiveConsoleCheckBox->setChecked((node.attributes().namedItem("interactiveConsoleCheckBox").nodeValue() == "1") ? true : false);
                         currentSettings.targetEndianess = (Endianess)node.attributes().namedItem("targetEndianess").nodeValue().toUInt();
                         m_sendWindow->setAddToHistoryCheckBox((node.attributes().namedItem("addToHistoryCheckBox").nodeValue() == "1") ? true : false);
+                        m_sendWindow->setPrecomputeScriptCheckBox((node.attributes().namedItem("precomputeScriptCheckBox").nodeValue() == "1") ? true : false);
 
                         //Read the 2 splitter sizes.
                         for(quint32 i = 0; i < 2; i++)
@@ -1800,7 +1952,7 @@ void MainWindow::setWidgetBackgroundColorFromString(QString colorString, QWidget
  * @param textEdit
  *      The console.
  */
-void MainWindow::setConsoleFont(QString fontFamily, QString fontSize, QTextEdit* textEdit)
+void MainWindow::setConsoleFont(QString fontFamily, QString fontSize, QWidget* textEdit)
 {
     QFont font = textEdit->font();
     font.setFamily(fontFamily);
@@ -1974,9 +2126,9 @@ void MainWindow::inititializeTab(void)
         m_settingsDialog->setEnabled(false);
         QCoreApplication::processEvents();
 
-        setWidgetBackgroundColorFromString(currentSettings->consoleBackgroundColor, m_userInterface->historyTextEdit);
-        setWidgetTextColorFromString(currentSettings->consoleReceiveColor, m_userInterface->historyTextEdit);
-        setConsoleFont(currentSettings->stringConsoleFont, currentSettings->stringConsoleFontSize, m_userInterface->historyTextEdit);
+        setWidgetBackgroundColorFromString(currentSettings->consoleBackgroundColor, m_userInterface->historyListView);
+        setWidgetTextColorFromString(currentSettings->consoleReceiveColor, m_userInterface->historyListView);
+        setConsoleFont(currentSettings->stringConsoleFont, currentSettings->stringConsoleFontSize, m_userInterface->historyListView);
 
 
         int index = m_userInterface->tabWidget->currentIndex();
@@ -2301,6 +2453,29 @@ void MainWindow::saveSettings()
 
                 writeXmlElement(xmlWriter, "pcanSetting", consoleSetting);
             }
+            {//can database
+                std::map<QString, QString> consoleSetting =
+                {std::make_pair(QString("fileName"), convertToRelativePath(m_mainConfigFile, m_canTab->getDatabaseFileName())),
+                };
+
+                writeXmlElement(xmlWriter, "canDatabase", consoleSetting);
+            }
+            {//can filters
+                std::map<QString, QString> consoleSetting =
+                {std::make_pair(QString("tableFilter"), m_userInterface->canTableFilterLineEdit->text()),
+                 std::make_pair(QString("consoleFilter"), m_userInterface->canConsoleFilterLineEdit->text()),
+                };
+
+                writeXmlElement(xmlWriter, "canFilters", consoleSetting);
+            }
+            {//SocketCAN
+                std::map<QString, QString> consoleSetting =
+                {std::make_pair(QString("interfaceName"), currentSettings->socketCan.interfaceName),
+                 std::make_pair(QString("filters"), currentSettings->socketCan.filters),
+                };
+
+                writeXmlElement(xmlWriter, "socketCanSetting", consoleSetting);
+            }
             {//send window
                 QList<int> windowSplitterSizes = m_sendWindow->getWindowSplitter()->sizes();
                 QList<int> cyclicAreSizes = m_sendWindow->getCyclicAreaSplitter()->sizes();
@@ -2318,6 +2493,7 @@ void MainWindow::saveSettings()
                  std::make_pair(QString("cyclicAreaSplitter"), QString("%1:%2").arg(cyclicAreSizes[0]).arg(cyclicAreSizes[1])),
                  std::make_pair(QString("targetEndianess"), QString("%1").arg(currentSettings->targetEndianess)),
                  std::make_pair(QString("addToHistoryCheckBox"),QString("%1").arg(m_sendWindow->getAddToHistoryCheckBox())),
+                 std::make_pair(QString("precomputeScriptCheckBox"),QString("%1").arg(m_sendWindow->getPrecomputeScriptCheckBox())),
 
                 };
 
@@ -2426,13 +2602,18 @@ void MainWindow::saveSettings()
                 writeXmlElement(xmlWriter, "sendHistory", consoleSetting);
 
                 xmlWriter.writeStartElement("historyData");
-                for(qint32 i = 0; i < m_handleData->m_sendHistory.size(); i++)
+                qint32 savedEntries = m_handleData->m_sendHistory.size();
+                if(savedEntries > MainWindowHandleData::MAX_SAVED_SEND_HISTORY_ENTRIES)
+                {//The whole history can be exported (export button).
+                    savedEntries = MainWindowHandleData::MAX_SAVED_SEND_HISTORY_ENTRIES;
+                }
+                for(qint32 i = 0; i < savedEntries; i++)
                 {
                     xmlWriter.writeStartElement("historyItem");
 
                     xmlWriter.writeAttribute("index", QString("%1").arg(i));
 
-                    QString text = MainWindow::byteArrayToNumberString(m_handleData->m_sendHistory[i],
+                    QString text = MainWindow::byteArrayToNumberString(m_handleData->m_sendHistory.at(i),
                                                                        false , true, false, true, true, DECIMAL_TYPE_UINT8, LITTLE_ENDIAN_TARGET);
                     xmlWriter.writeAttribute("data", text);
 
@@ -2848,7 +3029,8 @@ void MainWindow::dataConnectionStatusSlot(bool isConnected, QString message, boo
         const Settings* currentSettings = m_settingsDialog->settings();
 
         m_isConnected = true;
-        m_isConnectedWithCan = (currentSettings->connectionType == CONNECTION_TYPE_PCAN) ? true : false;
+        m_isConnectedWithCan = ((currentSettings->connectionType == CONNECTION_TYPE_PCAN) ||
+                                (currentSettings->connectionType == CONNECTION_TYPE_SOCKETCAN)) ? true : false;
         showConnect = false;
         m_userInterface->actionConnect->setText("Disconnect");
     }
@@ -3222,7 +3404,32 @@ void MainWindow::setWindowPositionAndSize(QWidget* widget, const QRect& position
 void MainWindow::showNumberOfReceivedAndSentBytes(void)
 {
     m_userInterface->ReceiveLable->setText(QString("%1 bytes received (%2 b/s)").arg(m_handleData->m_receivedBytes).arg(m_dataRateReceive)
-                                           + QString("  %1 bytes sent (%2 b/s)").arg(m_handleData->m_sentBytes).arg(m_dataRateSend));
+                                           + QString("  %1 bytes sent (%2 b/s)").arg(m_handleData->m_sentBytes).arg(m_dataRateSend)
+                                           + createCustomScriptLagString());
+}
+
+/**
+ * Creates the lag string of the custom console/log scripts (is shown in the receive label).
+ * @return
+ *      The lag string (empty if the scripts have no lag).
+ */
+QString MainWindow::createCustomScriptLagString(void)
+{
+    QString result;
+    QString lag = m_handleData->m_customConsoleObject->lagToString();
+
+    if(!lag.isEmpty())
+    {
+        result += "  custom console: " + lag;
+    }
+
+    lag = m_handleData->m_customLogObject->lagToString();
+    if(!lag.isEmpty())
+    {
+        result += "  custom log: " + lag;
+    }
+
+    return result;
 }
 
 
@@ -3288,6 +3495,44 @@ void MainWindow::dataRateUpdateSlot(quint32 dataRateSend, quint32 dataRateReceiv
     showNumberOfReceivedAndSentBytes();
 }
 
+/**
+ * Shows the progress of a script file transfer (ScriptFileTransfer) in the status bar.
+ * @param fileName
+ *      The name of the current file.
+ * @param transferredBytes
+ *      The number of transferred bytes.
+ * @param totalBytes
+ *      The file size (0 if unknown).
+ * @param bytesPerSecond
+ *      The current throughput.
+ */
+void MainWindow::fileTransferProgressSlot(QString fileName, quint64 transferredBytes, quint64 totalBytes, double bytesPerSecond)
+{
+    QString text = "file transfer " + fileName + ": " + QString::number(transferredBytes);
+    if(totalBytes > 0)
+    {
+        text += "/" + QString::number(totalBytes) + " bytes (" + QString::number((transferredBytes * 100) / totalBytes) + "%)";
+    }
+    else
+    {
+        text += " bytes";
+    }
+    text += ", " + QString::number(bytesPerSecond / 1024.0, 'f', 1) + " KiB/s";
+    m_userInterface->statusBar->showMessage(text);
+}
+
+/**
+ * Shows the result of a script file transfer (ScriptFileTransfer) in the status bar.
+ * @param success
+ *      True if the transfer was successful.
+ * @param message
+ *      The result message.
+ */
+void MainWindow::fileTransferFinishedSlot(bool success, QString message)
+{
+    m_userInterface->statusBar->showMessage(QString("file transfer ") + (success ? "finished: " : "failed: ") + message, 10000);
+}
+
 /**
  * Slot function for the connect button.
  */
@@ -4519,7 +4764,7 @@ bool MainWindow::createConfig(bool isCallFromButton)
             disconnect(m_scriptWindow->getCreateSceFileDialog(), SIGNAL(configHasToBeSavedSignal()),this, SLOT(configHasToBeSavedSlot()));
 
             m_handleData->m_sendHistory.clear();
-            m_userInterface->historyTextEdit->clear();
+            m_handleData->m_sendHistoryModel->update();
             m_searchConsole->m_lastSearchString.clear();
             m_userInterface->findWhatComboBox->clear();
             m_sendWindow->unloadFileSlot();
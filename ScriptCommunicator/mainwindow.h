@@ -214,6 +214,9 @@ public:
     ///Returns m_handleData.
     MainWindowHandleData* getHandleDataObject(){return m_handleData;}
 
+    ///Returns the send window.
+    SendWindow* getSendWindow(){return m_sendWindow;}
+
     ///Parses an Sce file.
     static bool parseSceFile(QString fileName, QStringList* scripts, QStringList* extraPluginPaths, QStringList* scriptArguments,
                                          bool* withScriptWindow, bool* scriptWindowIsMinimized, QString *minimumScVersion, QStringList* extraPlugInPath);
@@ -328,6 +331,12 @@ public slots:
     ///Adds data to the main window send history.
     void addDataToMainWindowSendHistorySlot(QByteArray data);
 
+    ///Shows the progress of a script file transfer (ScriptFileTransfer) in the status bar.
+    void fileTransferProgressSlot(QString fileName, quint64 transferredBytes, quint64 totalBytes, double bytesPerSecond);
+
+    ///Shows the result of a script file transfer (ScriptFileTransfer) in the status bar.
+    void fileTransferFinishedSlot(bool success, QString message);
+
 private slots:
 
     ///Menu debug sequence script slot function.
@@ -372,6 +381,18 @@ private slots:
     ///Slot function for the send button.
     void sendButtonPressedSlot(bool debug = false);
 
+    ///Is called if the user presses the import history button.
+    void importHistoryButtonSlot();
+
+    ///Is called if the user presses the export history button.
+    void exportHistoryButtonSlot();
+
+    ///Is called if the user presses enter in the history search line edit.
+    void historySearchSlot();
+
+    ///Is called if the selection in the history view has been changed.
+    void historySelectionChangedSlot();
+
     ///Is called if the history start index has been changed.
     void historyStartIndexChangedSlot(int value);
 
@@ -538,12 +559,16 @@ private:
     void setWidgetTextColorFromString(QString colorString, QWidget *widget);
 
     ///Sets the font of a console.
-    void setConsoleFont(QString fontFamily, QString fontSize, QTextEdit* textEdit);
+    void setConsoleFont(QString fontFamily, QString fontSize, QWidget* textEdit);
 
     ///Shows the number of received and sent bytes.
     void showNumberOfReceivedAndSentBytes(void);
 
 private:
+
+    ///Creates the lag string of the custom console/log scripts (is shown in the receive label).
+    QString createCustomScriptLagString(void);
+
     ///Pointer to the user interface.
     Ui::MainWindow *m_userInterface;
 
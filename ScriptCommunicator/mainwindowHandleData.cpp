@@ -22,12 +22,19 @@ MainWindowHandleData::MainWindowHandleData(MainWindow *mainWindow, SettingsDialo
     m_sentBytes(0),m_htmlLogFile(), m_HtmlLogFileStream(&m_htmlLogFile),
     m_textLogFile(), m_customLogFile(), m_textLogFileStream(&m_textLogFile), m_customLogFileStream(&m_customLogFile),
     m_bytesInUnprocessedConsoleData(0), m_bytesInStoredConsoleData(0), m_bytesSinceLastNewLineInConsole(0), m_bytesSinceLastNewLineInLog(0),
-    m_customLogString(), m_customConsoleObject(0), m_customLogObject(0), m_customConsoleStrings(), m_customConsoleStoredStrings(),
-    m_numberOfBytesInCustomConsoleStrings(0), m_numberOfBytesInCustomConsoleStoredStrings(0), m_historySendIsInProgress(false), m_checkDebugWindowsIsClosed()
+    m_customLogString(), m_customConsoleObject(0), m_customLogObject(0), m_customConsoleStrings(), m_customConsoleBlocks(),
+    m_numberOfBytesInCustomConsoleStrings(0), m_sendHistory(), m_sendHistoryModel(0), m_sendHistoryStartSequence(0),
+    m_sendHistoryEndSequence(0), m_sendHistoryNextSequence(0), m_sendHistoryRemainingEntries(0), m_sendHistoryTotalEntries(0),
+    m_sendHistoryEntriesInCurrentSend(0), m_sendHistoryPause(0), m_historySendIsInProgress(false), m_checkDebugWindowsIsClosed()
 {
+    m_sendHistoryModel = new SendHistoryModel(&m_sendHistory, this);
+
     m_customConsoleObject = new CustomConsoleLogObject(m_mainWindow);
     m_customLogObject = new CustomConsoleLogObject(m_mainWindow);
 
+    connect(m_customConsoleObject, SIGNAL(scriptResultSignal(QString,bool)), this, SLOT(customConsoleLogResultSlot(QString,bool)));
+    connect(m_customLogObject, SIGNAL(scriptResultSignal(QString,bool)), this, SLOT(customConsoleLogResultSlot(QString,bool)));
+
     m_updateConsoleAndLogTimer = new QTimer(this);
     connect(m_updateConsoleAndLogTimer, SIGNAL(timeout()), this, SLOT(updateConsoleAndLog()));
 }
@@ -53,6 +60,10 @@ void MainWindowHandleData::updateConsoleAndLog(void)
 
     m_updateConsoleAndLogTimer->stop();
 
+    //Pass the collected chunks to the custom console/log scripts (batch mode).
+    m_customConsoleObject->flushBatch();
+    m_customLogObject->flushBatch();
+
     //Create the log entries and the console strings.
     processDataInStoredData();
 
@@ -107,53 +118,96 @@ void MainWindowHandleData::updateConsoleAndLog(void)
     if(settings->showBinaryConsole){m_mainWindow->appendConsoleStringToConsole(&m_consoleDataBufferBinary, m_userInterface->ReceiveTextEditBinary);}
     else{ m_consoleDataBufferBinary.clear();}
 
-    if(settings->consoleShowCustomConsole)
+    bool customConsoleHasChanged = false;
+    if(settings->consoleShowCustomConsole && !m_customConsoleStrings.isEmpty())
     {
-        QString consoleString;
-        for(auto el : m_customConsoleStrings)
-        {
-            m_customConsoleStoredStrings.append(el);
-            m_numberOfBytesInCustomConsoleStoredStrings += el.length();
-            consoleString += el;
+        QString consoleString = m_consoleData.htmlReceived + m_customConsoleStrings.join("") + QString("</span>");
+        m_customConsoleStrings.clear();
+        m_numberOfBytesInCustomConsoleStrings = 0;
 
-        }
+        appendBlockToCustomConsole(consoleString);
+        customConsoleHasChanged = true;
+    }
 
-        while((m_numberOfBytesInCustomConsoleStoredStrings > (settings->maxCharsInConsole * 2)) && m_customConsoleStoredStrings.length() > 1)
-        {
-            //Limit the number of bytes in m_customConsoleStoredStrings.
-            m_numberOfBytesInCustomConsoleStoredStrings -= m_customConsoleStoredStrings.first().length();
-            m_customConsoleStoredStrings.removeFirst();
-        }
+    /***************************************************************************************************/
 
+    m_mainWindow->showNumberOfReceivedAndSentBytes();
+    m_mainWindow->setUpdatesEnabled(true);
 
-        if(!consoleString.isEmpty())
-        {
-            bool consoleWasEmpty = (m_userInterface->ReceiveTextEditCustom->document()->characterCount() <= 1) ? true : false;
-            consoleString = m_consoleData.htmlReceived + consoleString + QString("</span>");
+    if(customConsoleHasChanged)
+    {
+        m_userInterface->ReceiveTextEditCustom->viewport()->update();
+    }
+}
+
+/**
+ * Appends one block (the custom console strings of one console update) to the end of the custom console.
+ * Only the new block is rendered (the existing content is not touched) and the oldest blocks are removed
+ * if the custom console contains more than maxCharsInConsole characters.
+ * @param consoleString
+ *      The block (HTML).
+ */
+void MainWindowHandleData::appendBlockToCustomConsole(const QString& consoleString)
+{
+    const Settings* settings = m_settingsDialog->settings();
+    QTextEdit* textEdit = m_userInterface->ReceiveTextEditCustom;
 
-            m_mainWindow->appendConsoleStringToConsole(&consoleString, m_userInterface->ReceiveTextEditCustom);
-            m_customConsoleStrings.clear();
-            m_numberOfBytesInCustomConsoleStrings = 0;
+    //Store the scroll bar position.
+    int val = textEdit->verticalScrollBar()->value();
 
-            if(consoleWasEmpty)
-            {
-                //Force the custom console to render the content.
-                QRect rect = MainWindow::windowPositionAndSize(m_mainWindow);
-                rect.setWidth(rect.width() + 1);
-                m_mainWindow->m_ignoreNextResizeEventTime = QDateTime::currentDateTime();
-                MainWindow::setWindowPositionAndSize(m_mainWindow, rect);
-
-                rect.setWidth(rect.width() - 1);
-                MainWindow::setWindowPositionAndSize(m_mainWindow, rect);
-            }
+    QTextCursor cursor(textEdit->document());
+    cursor.movePosition(QTextCursor::End);
+    int startPosition = cursor.position();
+    cursor.insertHtml(consoleString);
+    m_customConsoleBlocks.enqueue(cursor.position() - startPosition);
 
-        }
+    limitCustomConsoleBlocks(settings->maxCharsInConsole);
+
+    if(settings->lockScrollingInConsole)
+    {
+        //Restore the scroll bar position.
+        textEdit->verticalScrollBar()->setValue(val);
     }
+    else
+    {   //Move the scroll bar to the end.
+        textEdit->verticalScrollBar()->setValue(textEdit->verticalScrollBar()->maximum());
+        textEdit->horizontalScrollBar()->setSliderPosition(0);
+    }
+}
 
-    /***************************************************************************************************/
+/**
+ * Removes the oldest blocks from the custom console if it contains more than maxChars characters.
+ * @param maxChars
+ *      The max. number of characters.
+ */
+void MainWindowHandleData::limitCustomConsoleBlocks(int maxChars)
+{
+    QTextDocument* document = m_userInterface->ReceiveTextEditCustom->document();
+    int currentCount = document->characterCount() - 1;
 
-    m_mainWindow->showNumberOfReceivedAndSentBytes();
-    m_mainWindow->setUpdatesEnabled(true);
+    if(currentCount > (maxChars + (maxChars / 5)))
+    {
+        int charsToRemove = 0;
+        while((m_customConsoleBlocks.size() > 1) && ((currentCount - charsToRemove - m_customConsoleBlocks.head()) >= maxChars))
+        {//Remove whole blocks.
+            charsToRemove += m_customConsoleBlocks.dequeue();
+        }
+
+        if((currentCount - charsToRemove) > (maxChars + (maxChars / 5)))
+        {//The oldest block is too big, remove the beginning of the block.
+            int diff = (currentCount - charsToRemove) - maxChars;
+            if(!m_customConsoleBlocks.isEmpty())
+            {
+                m_customConsoleBlocks.head() -= diff;
+            }
+            charsToRemove += diff;
+        }
+
+        QTextCursor cursor(document);
+        cursor.setPosition(0);
+        cursor.setPosition(charsToRemove, QTextCursor::KeepAnchor);
+        cursor.removeSelectedText();
+    }
 }
 
 
@@ -189,7 +243,12 @@ void MainWindowHandleData::appendDataToStoredData(QByteArray &data, bool isSend,
             if(m_customLogObject->scriptHasBeenLoaded() || m_customLogObject->scriptIsBlocked())
             {
                 QString timeStamp = QDateTime::currentDateTime().toString(currentSettings->consoleTimestampFormat).toLocal8Bit();
-                m_customLogString += m_customLogObject->callScriptFunction(&data, timeStamp, isSend, isUserMessage, isFromCan, true);
+                m_customLogObject->queueScriptFunctionCall(data, timeStamp, isSend, isUserMessage, isFromCan, true);
+
+                if(!m_updateConsoleAndLogTimer->isActive())
+                {//The timer flushes the collected chunks (batch mode).
+                    m_updateConsoleAndLogTimer->start(currentSettings->updateIntervalConsole);
+                }
 
             }
             else
@@ -216,47 +275,17 @@ void MainWindowHandleData::appendDataToStoredData(QByteArray &data, bool isSend,
             if(m_customConsoleObject->scriptHasBeenLoaded() || m_customConsoleObject->scriptIsBlocked())
             {
                 QString timeStamp = QDateTime::currentDateTime().toString(currentSettings->consoleTimestampFormat).toLocal8Bit();
-                QString result = m_customConsoleObject->callScriptFunction(&data, timeStamp, isSend, isUserMessage, isFromCan, false);
-                m_customConsoleStrings.append(result);
-                m_numberOfBytesInCustomConsoleStrings += result.length();
+                m_customConsoleObject->queueScriptFunctionCall(data, timeStamp, isSend, isUserMessage, isFromCan, false);
             }
             else
             {
                 if(currentSettings->consoleScript.isEmpty())
                 {
-                    m_customConsoleStrings.append("<br>no script given");
+                    appendCustomConsoleString("<br>no script given");
                 }
                 else
                 {
-                    m_customConsoleStrings.append("<br>the script contains an error (uncheck and then check the custom console check box to reload the script))");
-                }
-                m_numberOfBytesInCustomConsoleStrings += m_customConsoleStrings.last().length();
-            }
-
-            if ((m_numberOfBytesInCustomConsoleStrings > (currentSettings->maxCharsInConsole * 2)))
-            {
-                while(m_numberOfBytesInCustomConsoleStrings > (currentSettings->maxCharsInConsole * 2))
-                {//Limit the number of bytes in m_customConsoleStrings.
-
-                    if(m_customConsoleStrings.length() > 1)
-                    {
-                        m_numberOfBytesInCustomConsoleStrings -= m_customConsoleStrings.first().length();
-                        m_customConsoleStrings.removeFirst();
-                    }
-                    else
-                    {
-                        m_customConsoleStrings.first().remove(0, m_numberOfBytesInCustomConsoleStrings - currentSettings->maxCharsInConsole);
-                        m_numberOfBytesInCustomConsoleStrings -= m_numberOfBytesInCustomConsoleStrings - currentSettings->maxCharsInConsole;
-
-                    }
-
-
-                }
-
-                if(m_bytesInStoredConsoleData != 0)
-                {
-                    //Restart the console/log timer.
-                    m_updateConsoleAndLogTimer->start(1);
+                    appendCustomConsoleString("<br>the script contains an error (uncheck and then check the custom console check box to reload the script))");
                 }
             }
         }
@@ -298,6 +327,81 @@ void MainWindowHandleData::appendDataToStoredData(QByteArray &data, bool isSend,
 }
 
 
+/**
+ * Appends a string to m_customConsoleStrings and limits the number of bytes in m_customConsoleStrings.
+ * @param consoleString
+ *      The string.
+ */
+void MainWindowHandleData::appendCustomConsoleString(const QString& consoleString)
+{
+    const Settings* currentSettings = m_settingsDialog->settings();
+
+    m_customConsoleStrings.append(consoleString);
+    m_numberOfBytesInCustomConsoleStrings += consoleString.length();
+
+    if ((m_numberOfBytesInCustomConsoleStrings > (currentSettings->maxCharsInConsole * 2)))
+    {
+        while(m_numberOfBytesInCustomConsoleStrings > (currentSettings->maxCharsInConsole * 2))
+        {//Limit the number of bytes in m_customConsoleStrings.
+
+            if(m_customConsoleStrings.length() > 1)
+            {
+                m_numberOfBytesInCustomConsoleStrings -= m_customConsoleStrings.first().length();
+                m_customConsoleStrings.removeFirst();
+            }
+            else
+            {
+                m_customConsoleStrings.first().remove(0, m_numberOfBytesInCustomConsoleStrings - currentSettings->maxCharsInConsole);
+                m_numberOfBytesInCustomConsoleStrings -= m_numberOfBytesInCustomConsoleStrings - currentSettings->maxCharsInConsole;
+
+            }
+
+
+        }
+
+        if(m_bytesInStoredConsoleData != 0)
+        {
+            //Restart the console/log timer.
+            m_updateConsoleAndLogTimer->start(1);
+        }
+    }
+}
+
+/**
+ * Is called if a custom console/log script has created a string (the results are
+ * delivered asynchronously and in call order).
+ * @param result
+ *      The created string.
+ * @param isLog
+ *      True if the string is for the custom log (false=custom console).
+ */
+void MainWindowHandleData::customConsoleLogResultSlot(QString result, bool isLog)
+{
+    const Settings* currentSettings = m_settingsDialog->settings();
+
+    if(isLog)
+    {
+        if(!currentSettings->logGenerateCustomLog)
+        {
+            return;
+        }
+        m_customLogString += result;
+    }
+    else
+    {
+        if(!currentSettings->consoleShowCustomConsole)
+        {
+            return;
+        }
+        appendCustomConsoleString(result);
+    }
+
+    if(!m_updateConsoleAndLogTimer->isActive())
+    {
+        m_updateConsoleAndLogTimer->start(currentSettings->updateIntervalConsole);
+    }
+}
+
 /**
  * Caclulates the console data.
  */
@@ -866,26 +970,27 @@ void MainWindowHandleData::appendDataToLog(const QByteArray &data, bool isSend,
 
         QString dataString;
         QString canInformation;
+        QString canSignals;
         if(isFromCan && !isUserMessage && !isTimeStamp && !isNewLine)
         {
             canArray = QByteArray(data);
 
-            if(currentSettings->writeCanMetaInformationInToLog)
+            quint8 type = canArray[0];
+            QByteArray idArray = canArray.mid(PCANBasicClass::BYTES_FOR_CAN_TYPE, PCANBasicClass::BYTES_FOR_CAN_ID);
+            int length = idArray.length();
+            for(int i = length; i < PCANBasicClass::BYTES_FOR_CAN_ID; i++)
             {
-                quint8 type = canArray[0];
-                QString typeString;
+                idArray.push_front((char)0);
+            }
+            quint32 messageId = ((quint8)idArray[0] << 24) + ((quint8)idArray[1] << 16) +
+                    ((quint8)idArray[2] << 8) + ((quint8)idArray[3] & 0xff);
 
-                QByteArray idArray = canArray.mid(PCANBasicClass::BYTES_FOR_CAN_TYPE, PCANBasicClass::BYTES_FOR_CAN_ID);
-                int length = idArray.length();
-                for(int i = length; i < PCANBasicClass::BYTES_FOR_CAN_ID; i++)
-                {
-                    idArray.push_front((char)0);
-                }
-                quint32 messageId = ((quint8)idArray[0] << 24) + ((quint8)idArray[1] << 16) +
-                        ((quint8)idArray[2] << 8) + ((quint8)idArray[3] & 0xff);
+            if(type <= PCAN_MESSAGE_RTR){messageId = messageId & 0x7ff;}
+            else{messageId = messageId & 0x1fffffff;}
 
-                if(type <= PCAN_MESSAGE_RTR){messageId = messageId & 0x7ff;}
-                else{messageId = messageId & 0x1fffffff;}
+            if(currentSettings->writeCanMetaInformationInToLog)
+            {
+                QString typeString;
 
                 QString messageIdString = QString::number(messageId, 16);
 
@@ -913,6 +1018,14 @@ void MainWindowHandleData::appendDataToLog(const QByteArray &data, bool isSend,
             else{canArray.remove(0, PCANBasicClass::BYTES_METADATA_RECEIVE);}
             dataArray = &canArray;
 
+            const CanDatabase* database = m_mainWindow->m_canTab->getDatabase();
+            if(database != 0)
+            {
+                CanFrame frame;
+                initCanFrame(&frame, type, messageId, canArray.constData(), canArray.size(), 0);
+                canSignals = database->decodeFrameToString(frame);
+            }
+
         }
 
         if(isNewLine && !currentSettings->writeAsciiInToLog)
@@ -973,6 +1086,10 @@ void MainWindowHandleData::appendDataToLog(const QByteArray &data, bool isSend,
                 dataString.append(MainWindow::byteArrayToNumberString(*dataArray, true, false,
                                                           (currentSettings->writeAsciiInToLog || currentSettings->writeDecimalInToLog || currentSettings->writeHexInToLog)));
             }
+            if(!canSignals.isEmpty())
+            {
+                dataString.append("   " + canSignals);
+            }
         }
 
         if(dataString.size() > 0)
@@ -1050,20 +1167,20 @@ void MainWindowHandleData::dataReceivedSlot(QByteArray data)
 }
 
 /**
- * The slot is called if the main interface thread has received CAN messages..
- * This slot is connected to the MainInterfaceThread::dataReceivedSignal signal.
+ * The slot is called if the main interface thread has received CAN messages.
+ * This slot is connected to the CanFilterRelay::framesAcceptedSignal signal of the console/log filter (CanTab).
  * @param messages
  *      The received messages.
  */
-void MainWindowHandleData::canMessagesReceivedSlot(QVector<QByteArray> messages)
+void MainWindowHandleData::canMessagesReceivedSlot(QVector<CanFrame> messages)
 {
-    for(auto el : messages)
+    for(const auto& el : messages)
     {
-        m_receivedBytes += el.size();
-        m_receivedBytes -= PCANBasicClass::BYTES_METADATA_RECEIVE;
+        m_receivedBytes += el.length;
 
-        appendDataToStoredData(el, false, false, m_mainWindow->m_isConnectedWithCan, false);
-        m_mainWindow->m_canTab->canMessageReceived(el);
+        //The console and the logs store the frames in the byte format of the custom console/log scripts.
+        QByteArray data = canFrameToByteArray(el);
+        appendDataToStoredData(data, false, false, m_mainWindow->m_isConnectedWithCan, false);
     }
 }
 
@@ -1092,9 +1209,14 @@ void MainWindowHandleData::dataHasBeenSendSlot(QByteArray data, bool success, ui
             for(int i = PCANBasicClass::BYTES_METADATA_SEND; i < data.length(); i += PCANBasicClass::MAX_BYTES_PER_MESSAGE)
             {
                 QByteArray tmpArray = tmpIdAndType + data.mid(i, PCANBasicClass::MAX_BYTES_PER_MESSAGE);
-
                 appendDataToStoredData(tmpArray, true, false, m_mainWindow->m_isConnectedWithCan, false);
-                m_mainWindow->m_canTab->canMessageTransmitted(tmpArray);
+            }
+
+            QVector<CanFrame> frames;
+            canFramesFromSendData(data, PCANBasicClass::MAX_BYTES_PER_MESSAGE, &frames);
+            for(const auto& el : frames)
+            {
+                m_mainWindow->m_canTab->canMessageTransmitted(el);
             }
         }
         else
@@ -1103,27 +1225,32 @@ void MainWindowHandleData::dataHasBeenSendSlot(QByteArray data, bool success, ui
         }
     }
 
-    if(id == MainInterfaceThread::SEND_ID_HISTOTRY)
+    if((id == MainInterfaceThread::SEND_ID_HISTOTRY) && m_historySendIsInProgress)
     {
         if(success)
         {
-            if(!m_sendHistorySendData.isEmpty())
+            qint64 sentEntries = m_sendHistoryTotalEntries - m_sendHistoryRemainingEntries;
+            m_mainWindow->m_userInterface->progressBar->setValue((sentEntries * HISTORY_PROGRESS_MAXIMUM) / m_sendHistoryTotalEntries);
+
+            if(m_sendHistoryRemainingEntries > 0)
             {
-                m_sendHistoryTimer.start(m_mainWindow->m_userInterface->sendPauseSpinBox->value());
+                if(m_sendHistoryPause > 0)
+                {
+                    m_sendHistoryTimer.start(m_sendHistoryPause);
+                }
+                else
+                {//Line rate: the next entries are sent immediately.
+                    sendNextHistoryData();
+                }
             }
             else
             {
-                m_historySendIsInProgress = false;
-                enableHistoryGuiElements(true);
-                historyConsoleTimerSlot();
+                finishSendHistory();
             }
-            m_mainWindow->m_userInterface->progressBar->setValue(m_mainWindow->m_userInterface->progressBar->value() + 1);
         }
         else
         {
-            m_historySendIsInProgress = false;
-            enableHistoryGuiElements(true);
-            historyConsoleTimerSlot();
+            finishSendHistory();
         }
     }
 }
@@ -1137,8 +1264,7 @@ void MainWindowHandleData::clear(void)
     m_consoleDataBufferHex.clear();
     m_consoleDataBufferDec.clear();
     m_consoleDataBufferMixed.clear();;
-    m_customConsoleStoredStrings.clear();
-    m_numberOfBytesInCustomConsoleStoredStrings = 0;
+    m_customConsoleBlocks.clear();
     m_customConsoleStrings.clear();
     m_numberOfBytesInCustomConsoleStrings = 0;
     m_consoleDataBufferBinary.clear();
@@ -1756,12 +1882,7 @@ void MainWindowHandleData::addDataToSendHistory(const QByteArray* data)
 {
     const Settings* currentSettings = m_settingsDialog->settings();
 
-    m_sendHistory.push_front(*data);
-
-    if(m_sendHistory.size() > MAX_SEND_HISTORY_ENTRIES)
-    {
-        m_sendHistory.pop_back();
-    }
+    m_sendHistory.append(*data);
 
     m_mainWindow->m_userInterface->startIndexSpinBox->setMaximum(m_sendHistory.size() - 1);
     m_mainWindow->m_userInterface->endIndexSpinBox->setMaximum(m_sendHistory.size() - 1);
@@ -1781,14 +1902,11 @@ void MainWindowHandleData::sendHistoryTimerSlot()
 
     if(m_mainWindow->m_isConnected)
     {
-        emit sendDataWithTheMainInterfaceSignal(m_sendHistorySendData.first(), MainInterfaceThread::SEND_ID_HISTOTRY);
-        m_sendHistorySendData.pop_front();
+        sendNextHistoryData();
     }
     else
     {
-        m_historySendIsInProgress = false;
-        enableHistoryGuiElements(true);
-        historyConsoleTimerSlot();
+        finishSendHistory();
         QMessageBox::critical(m_mainWindow, "error", "sending failed: no connection");
     }
 }
@@ -1833,6 +1951,8 @@ void MainWindowHandleData::enableHistoryGuiElements(bool enable)
     m_mainWindow->m_userInterface->sendPauseSpinBox->setEnabled(enable);
     m_mainWindow->m_userInterface->clearHistoryPushButton->setEnabled(enable);
     m_mainWindow->m_userInterface->createScriptPushButton->setEnabled(enable);
+    m_mainWindow->m_userInterface->importHistoryPushButton->setEnabled(enable);
+    m_mainWindow->m_userInterface->exportHistoryPushButton->setEnabled(enable);
 
     if(enable)
     {
@@ -1851,111 +1971,126 @@ void MainWindowHandleData::enableHistoryGuiElements(bool enable)
  */
 void MainWindowHandleData::cancelSendHistory(void)
 {
-    m_historySendIsInProgress = false;
     m_sendHistoryTimer.stop();
-    m_sendHistorySendData.clear();
+    finishSendHistory();
+}
+
+/**
+ * Is called if the sending of the history has finished (or failed).
+ */
+void MainWindowHandleData::finishSendHistory(void)
+{
+    m_historySendIsInProgress = false;
+    m_sendHistoryRemainingEntries = 0;
     enableHistoryGuiElements(true);
     historyConsoleTimerSlot();
 }
 
 /**
- * Send the history.
+ * Send the history (the selected range is stored as sequence numbers, so that
+ * entries which are added during the sending do not shift the range).
  */
 void MainWindowHandleData::sendHistory(void)
 {
     qint32 endIndex = m_mainWindow->m_userInterface->endIndexSpinBox->value();
     qint32 startIndex = m_mainWindow->m_userInterface->startIndexSpinBox->value();
-    qint32 repetitionCount = m_mainWindow->m_userInterface->sendRepetitionCountSpinBox->value() + 1U;
-    qint32 count = 0;
-    m_sendHistorySendData.clear();
+    qint64 repetitionCount = m_mainWindow->m_userInterface->sendRepetitionCountSpinBox->value() + 1U;
 
-    for(qint32 i = 0; i < repetitionCount; i++)
+    if(m_sendHistory.size() == 0)
     {
-        if(startIndex < endIndex)
-        {
-            for(qint32 i = startIndex; (i <= endIndex) && (i < m_sendHistory.length()); i++)
-            {
-                m_sendHistorySendData.push_back(m_sendHistory[i]);
-            }
-            count += (endIndex - startIndex) + 1;
-        }
-        else
-        {
-            for(qint32 i = startIndex; (i >= endIndex) && (i < m_sendHistory.length()); i--)
-            {
-                m_sendHistorySendData.push_back(m_sendHistory[i]);
-            }
-            count += (startIndex - endIndex) + 1;
-        }
+        return;
+    }
+    if(startIndex >= m_sendHistory.size())
+    {
+        startIndex = m_sendHistory.size() - 1;
     }
+    if(endIndex >= m_sendHistory.size())
+    {
+        endIndex = m_sendHistory.size() - 1;
+    }
+
+    m_sendHistoryStartSequence = m_sendHistory.sequenceOf(startIndex);
+    m_sendHistoryEndSequence = m_sendHistory.sequenceOf(endIndex);
+    m_sendHistoryNextSequence = m_sendHistoryStartSequence;
+    m_sendHistoryTotalEntries = (qAbs(endIndex - startIndex) + 1) * repetitionCount;
+    m_sendHistoryRemainingEntries = m_sendHistoryTotalEntries;
+    m_sendHistoryPause = m_mainWindow->m_userInterface->sendPauseSpinBox->value();
 
     m_historySendIsInProgress = true;
 
     enableHistoryGuiElements(false);
 
-    m_mainWindow->m_userInterface->progressBar->setMaximum(count);
+    m_mainWindow->m_userInterface->progressBar->setMaximum(HISTORY_PROGRESS_MAXIMUM);
     m_mainWindow->m_userInterface->progressBar->setValue(0);
 
-    emit sendDataWithTheMainInterfaceSignal(m_sendHistorySendData.first(), MainInterfaceThread::SEND_ID_HISTOTRY);
-    m_sendHistorySendData.pop_front();
+    sendNextHistoryData();
 }
 
-
-
 /**
- * The history console timer slot.
+ * Sends the next history entries. If the send pause is 0, then consecutive entries are
+ * sent back-to-back in one send (max. MAX_HISTORY_SEND_BATCH_SIZE bytes, not for CAN).
  */
-void MainWindowHandleData::historyConsoleTimerSlot()
+void MainWindowHandleData::sendNextHistoryData(void)
 {
-    m_historyConsoleTimer.stop();
-
-    m_mainWindow->m_userInterface->clearHistoryPushButton->setEnabled(true);
-    m_mainWindow->m_userInterface->sendHistoryPushButton->setEnabled(true);
-    m_mainWindow->m_userInterface->createScriptPushButton->setEnabled(true);
-
-    QString currentFormat = m_mainWindow->m_userInterface->historyFormatComboBox->currentText();
-    const Settings* currentSettings = m_settingsDialog->settings();
-
-    bool isBinary = (currentFormat == "bin") ? true : false;
-    bool isHex = (currentFormat == "hex") ? true : false;
-    bool isAscii = (currentFormat == "ascii") ? true : false;
-    DecimalType decimalType = SendWindow::formatToDecimalType(currentFormat);
-
-    m_mainWindow->setUpdatesEnabled(false);
-    m_mainWindow->m_userInterface->historyTextEdit->clear();
+    bool sendSeveralEntries = (m_sendHistoryPause == 0) && !m_mainWindow->m_isConnectedWithCan;
+    QByteArray sendData;
+    m_sendHistoryEntriesInCurrentSend = 0;
 
-    for(qint32 i = 0; m_sendHistory.size() > i ; i++)
+    while(m_sendHistoryRemainingEntries > 0)
     {
-        QString text = QString("index: %1<br>").arg(i);
+        const QByteArray* entry = m_sendHistory.bySequence(m_sendHistoryNextSequence);
 
-        if(isAscii)
+        //Index ascending means sequence number descending.
+        if(m_sendHistoryNextSequence == m_sendHistoryEndSequence)
         {
-            QString tmpString;
-            for(auto el : m_sendHistory[i])
-            {
-                if (el == '<')tmpString += "&lt;";
-                else if (el == '>')tmpString += "&gt;";
-                else if (el == ' ')tmpString += "&nbsp;";
-                else if (el == '\n')tmpString += "";
-                else if (el == '\r')tmpString += "";
-                else if (el < 33 || el > 126) tmpString += 255;
-                else tmpString += el;
-            }
-            text += tmpString;
+            m_sendHistoryNextSequence = m_sendHistoryStartSequence;
+        }
+        else if(m_sendHistoryStartSequence > m_sendHistoryEndSequence)
+        {
+            m_sendHistoryNextSequence--;
         }
         else
         {
-            text += MainWindow::byteArrayToNumberString(m_sendHistory[i], isBinary , isHex, false, true, true,
-                                                        decimalType, currentSettings->targetEndianess);
+            m_sendHistoryNextSequence++;
+        }
+        m_sendHistoryRemainingEntries--;
+        m_sendHistoryEntriesInCurrentSend++;
+
+        if(entry != 0)
+        {//Entries which have been removed from the history are skipped.
+            sendData.append(*entry);
+            if(!sendSeveralEntries || (sendData.size() >= MAX_HISTORY_SEND_BATCH_SIZE))
+            {
+                break;
+            }
         }
-        text += "<br>";
-        m_mainWindow->m_userInterface->historyTextEdit->append(text);
     }
 
-    m_mainWindow->m_userInterface->historyTextEdit->verticalScrollBar()->setValue(0);
-    m_mainWindow->m_userInterface->historyTextEdit->moveCursor(QTextCursor::Start);
-    m_mainWindow->setUpdatesEnabled(true);
+    if(sendData.isEmpty())
+    {
+        finishSendHistory();
+    }
+    else
+    {
+        emit sendDataWithTheMainInterfaceSignal(sendData, MainInterfaceThread::SEND_ID_HISTOTRY);
+    }
+}
+
+/**
+ * The history console timer slot (updates the history view).
+ */
+void MainWindowHandleData::historyConsoleTimerSlot()
+{
+    m_historyConsoleTimer.stop();
+
+    m_mainWindow->m_userInterface->clearHistoryPushButton->setEnabled(true);
+    m_mainWindow->m_userInterface->sendHistoryPushButton->setEnabled(true);
+    m_mainWindow->m_userInterface->createScriptPushButton->setEnabled(true);
+    m_mainWindow->m_userInterface->exportHistoryPushButton->setEnabled(true);
 
+    const Settings* currentSettings = m_settingsDialog->settings();
+    m_sendHistoryModel->setFormat(m_mainWindow->m_userInterface->historyFormatComboBox->currentText(), currentSettings->targetEndianess);
+    m_sendHistoryModel->update();
 }
 
 /**
@@ -1995,7 +2130,6 @@ void MainWindowHandleData::reInsertDataInConsole(void)
     int val3 = 0;
     int val4 = 0;
     int val5 = 0;
-    int val6 = 0;
     QMessageBox box(QMessageBox::Information, "ScriptCommunicator", "Recalculating console data",
                     QMessageBox::NoButton, m_mainWindow);
     box.setStandardButtons(QMessageBox::NoButton);
@@ -2016,14 +2150,12 @@ void MainWindowHandleData::reInsertDataInConsole(void)
     if(settings->showDecimalInConsole){val3 = m_userInterface->ReceiveTextEditDecimal->verticalScrollBar()->value();}
     if(settings->showMixedConsole){val4 = m_userInterface->ReceiveTextEditMixed->verticalScrollBar()->value();}
     if(settings->showBinaryConsole){val5 = m_userInterface->ReceiveTextEditBinary->verticalScrollBar()->value();}
-    if(settings->consoleShowCustomConsole){val6 = m_userInterface->ReceiveTextEditCustom->verticalScrollBar()->value();}
 
     m_userInterface->ReceiveTextEditMixed->clear();
     m_userInterface->ReceiveTextEditAscii->clear();
     m_userInterface->ReceiveTextEditDecimal->clear();
     m_userInterface->ReceiveTextEditHex->clear();
     m_userInterface->ReceiveTextEditBinary->clear();
-    m_userInterface->ReceiveTextEditCustom->clear();
     m_decimalConsoleByteBuffer.clear();
     m_mixedConsoleByteBuffer.clear();
 
@@ -2038,13 +2170,7 @@ void MainWindowHandleData::reInsertDataInConsole(void)
         appendDataToConsoleStrings(el.data, settings, el.isSend , isFromAddMessageDialog, isTimeStamp, el.isFromCan, isNewLine);
     }
 
-    if(settings->consoleShowCustomConsole)
-    {
-        m_customConsoleStrings = m_customConsoleStoredStrings;
-        m_customConsoleStoredStrings.clear();
-        m_numberOfBytesInCustomConsoleStoredStrings = 0;
-    }
-
+    //The custom console is not re-rendered (its content does not depend on the console settings).
     updateConsoleAndLog();
 
     if(settings->showAsciiInConsole){m_userInterface->ReceiveTextEditAscii->verticalScrollBar()->setValue(val1);}
@@ -2052,7 +2178,6 @@ void MainWindowHandleData::reInsertDataInConsole(void)
     if(settings->showDecimalInConsole){m_userInterface->ReceiveTextEditDecimal->verticalScrollBar()->setValue(val3);}
     if(settings->showMixedConsole){m_userInterface->ReceiveTextEditMixed->verticalScrollBar()->setValue(val4);}
     if(settings->showBinaryConsole){m_userInterface->ReceiveTextEditBinary->verticalScrollBar()->setValue(val5);}
-    if(settings->consoleShowCustomConsole){m_userInterface->ReceiveTextEditCustom->verticalScrollBar()->setValue(val6);}
 
     box.close();
 }
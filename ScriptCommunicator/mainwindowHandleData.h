@@ -9,8 +9,11 @@
 #include <QMessageBox>
 #include <QXmlStreamWriter>
 #include <QTimer>
+#include <QQueue>
 #include <QScriptEngine>
 #include "settingsdialog.h"
+#include "sendHistory.h"
+#include "canFrame.h"
 
 
 class MainWindow;
@@ -177,7 +180,7 @@ public slots:
 
     ///The slot is called if the main interface thread has received data.
     ///This slot is connected to the MainInterfaceThread::dataReceivedSignal signal.
-    void canMessagesReceivedSlot(QVector<QByteArray> messages);
+    void canMessagesReceivedSlot(QVector<CanFrame> messages);
 
     ///The slot is called if the main interface thread has send data.
     ///This slot is connected to the MainInterfaceThread::sendingFinishedSignal signal.
@@ -186,11 +189,30 @@ public slots:
     ///Reinserts the data into the mixed consoles.
     void reInsertDataInMixecConsoleSlot(void);
 
+    ///Is called if a custom console/log script has created a string.
+    ///This slot is connected to the CustomConsoleLogObject::scriptResultSignal signal.
+    void customConsoleLogResultSlot(QString result, bool isLog);
+
 private:
 
+    ///Appends a string to m_customConsoleStrings and limits the number of bytes in m_customConsoleStrings.
+    void appendCustomConsoleString(const QString& consoleString);
+
+    ///Appends one block to the end of the custom console (only the new block is rendered).
+    void appendBlockToCustomConsole(const QString& consoleString);
+
+    ///Removes the oldest blocks from the custom console if it contains more than maxChars characters.
+    void limitCustomConsoleBlocks(int maxChars);
+
     ///Enables/disables the send history GUI elements.
     void enableHistoryGuiElements(bool enable);
 
+    ///Sends the next history entries (back-to-back in one send if the send pause is 0).
+    void sendNextHistoryData(void);
+
+    ///Is called if the sending of the history has finished (or failed).
+    void finishSendHistory(void);
+
     ///Append a time stamp to a stored data vector.
     void appendTimestamp(QVector<StoredData>* storedDataVector, bool isSend, bool isUserMessage,
                          bool isFromCan, QString timeStampFormat);
@@ -296,14 +318,12 @@ private:
     ///The custom console strings.
     QStringList m_customConsoleStrings;
 
-    ///The custom console stored strings.
-    QStringList m_customConsoleStoredStrings;
+    ///The number of characters of each block in the custom console (oldest block first).
+    QQueue<int> m_customConsoleBlocks;
 
     ///The number of bytes in m_customConsoleStrings.
     quint32 m_numberOfBytesInCustomConsoleStrings;
 
-    ///The number of bytes in m_customConsoleStoredStrings
-    quint32 m_numberOfBytesInCustomConsoleStoredStrings;
 
     ///The precalculated console data.
     ConsoleData m_consoleData;
@@ -320,14 +340,42 @@ private:
     ///If insufficent number of bytes for a decimal are received then these a bytes are stored here.
     QByteArray m_decimalLogByteBuffer;
 
-    ///The send history buffer.
-    QVector<QByteArray> m_sendHistory;
+    ///The send history.
+    SendHistoryStore m_sendHistory;
+
+    ///The model of the send history view.
+    SendHistoryModel* m_sendHistoryModel;
+
+    ///The max. number of send history entries which are stored in the main config file
+    ///(the whole history can be exported).
+    static const qint32 MAX_SAVED_SEND_HISTORY_ENTRIES = 30;
+
+    ///The max. number of bytes which are sent at once if the history is sent without pause.
+    static const qint32 MAX_HISTORY_SEND_BATCH_SIZE = 64 * 1024;
+
+    ///The maximum of the send history progress bar.
+    static const qint32 HISTORY_PROGRESS_MAXIMUM = 1000;
+
+    ///The sequence number of the first entry of the sent history range.
+    quint64 m_sendHistoryStartSequence;
+
+    ///The sequence number of the last entry of the sent history range.
+    quint64 m_sendHistoryEndSequence;
+
+    ///The sequence number of the next history entry which must be sent.
+    quint64 m_sendHistoryNextSequence;
+
+    ///The number of history entries which must be sent (all repetitions).
+    qint64 m_sendHistoryRemainingEntries;
+
+    ///The number of history entries which have to be sent (all repetitions).
+    qint64 m_sendHistoryTotalEntries;
 
-    ///The history data which must be sent.
-    QVector<QByteArray> m_sendHistorySendData;
+    ///The number of history entries in the current send.
+    qint32 m_sendHistoryEntriesInCurrentSend;
 
-    ///The max. number of elements in m_sendHistory.
-    static const qint32 MAX_SEND_HISTORY_ENTRIES = 30;
+    ///The pause between two history entries (ms).
+    qint32 m_sendHistoryPause;
 
     ///The history console timer.
     QTimer m_historyConsoleTimer;
@@ -26,6 +26,10 @@
 typedef quint32 DWORD;
 typedef quint16 WORD;
 typedef quint8 BYTE;
+typedef char* LPSTR;
+
+//The Linux PCANBasic library uses the default calling convention.
+#define __stdcall
 #endif
 
 ////////////////////////////////////////////////////////////
@@ -208,7 +212,6 @@ typedef quint8 BYTE;
 #define TPCANMode                BYTE  // Represents a PCAN filter mode
 #define TPCANBaudrate            WORD  // Represents a PCAN Baud rate register value
 
-#if defined(WIN32) || defined(_WIN32)
 ////////////////////////////////////////////////////////////
 // Structure definitions
 ////////////////////////////////////////////////////////////
@@ -396,4 +399,3 @@ TPCANStatus __stdcall CAN_GetErrorText(
 #endif
 
 #endif
-#endif
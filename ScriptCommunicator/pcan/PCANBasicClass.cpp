@@ -22,11 +22,63 @@
 **  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
 ****************************************************************************/
 
-#if defined(WIN32) || defined(_WIN32)
-
 #include "PCANBasicClass.h"
 #include <QThread>
+#include <QElapsedTimer>
+
+#if !defined(WIN32) && !defined(_WIN32)
+#include <sys/select.h>
+#endif
+
+/**
+ * Constructor.
+ * @param pcan
+ *      The pcan interface.
+ */
+PcanReceiveThread::PcanReceiveThread(PCANBasicClass* pcan) : QThread(), m_pcan(pcan), m_running(0)
+{
+}
+
+/**
+ * Starts the thread.
+ */
+void PcanReceiveThread::startReceiving(void)
+{
+    m_running.store(1);
+    start(QThread::TimeCriticalPriority);
+}
+
+/**
+ * Stops the thread (returns after the thread has been finished).
+ */
+void PcanReceiveThread::stopReceiving(void)
+{
+    m_running.store(0);
+    m_pcan->wakeUpReceiveThread();
+    wait();
+}
 
+/**
+ * The thread main function. Waits for the receive event of the driver and copies all
+ * received messages into the receive ring.
+ */
+void PcanReceiveThread::run()
+{
+    bool queueIsEmpty = true;
+
+    while(m_running.load())
+    {
+        if(queueIsEmpty)
+        {
+            m_pcan->waitForReceiveEvent(PCANBasicClass::RECEIVE_EVENT_TIMEOUT_MS);
+        }
+
+        if(m_pcan->drainDriverQueue(&queueIsEmpty))
+        {
+            emit messagesReceivedSignal();
+        }
+    }
+}
 
 
 
@@ -35,21 +87,26 @@
  * @param parent
  *      The parent pointer.
  */
-PCANBasicClass::PCANBasicClass(QObject *parent) : QObject(parent), m_dataReadyForRead(false)
+PCANBasicClass::PCANBasicClass(QObject *parent) : QObject(parent), m_receiveThread(this),
+#if defined(WIN32) || defined(_WIN32)
+    m_receiveEvent(0),
+#else
+    m_receiveEventDescriptor(-1),
+#endif
+    m_receiveRing((int)RECEIVE_RING_SIZE), m_ringWriteCounter(0), m_ringReadCounter(0), m_notificationPending(0),
+    m_discardedMessages(0), m_queueOverruns(0), m_statusMessages(0)
 {
 
     m_pcanAlreadyLoaded = false;
-	m_hDll = NULL;
     m_currentHandle = PCAN_NONEBUS;
 
-    m_lastReadMessage.ID = 0xffffffff;
-
     m_timeStampFirstReceivedMessage = 0;
     m_firstMessageReceived = true;
 
-    m_currentStatus = PCAN_ERROR_OK;
+    m_currentStatus.store(PCAN_ERROR_OK);
 
-     connect(&m_receiveTimer, SIGNAL(timeout()),this, SLOT(receiveTimerSlot()));
+    //The receive thread emits messagesReceivedSignal, readyRead is emitted in the thread of this object.
+    connect(&m_receiveThread, SIGNAL(messagesReceivedSignal()),this, SIGNAL(readyRead()), Qt::QueuedConnection);
 
     //Load the API.
     loadAPI();
@@ -118,7 +175,6 @@ bool PCANBasicClass::open(quint8 channel, quint32 baudRate, bool busOffAutoReset
     if(status == PCAN_ERROR_OK)
     {
        reset(m_currentHandle);
-       m_dataReadyForRead = false;
 
        quint32 buffer = busOffAutoReset ? 1 : 0;
        status = setValue(m_currentHandle, PCAN_BUSOFF_AUTORESET, (void*)&buffer, sizeof(buffer));
@@ -135,16 +191,21 @@ bool PCANBasicClass::open(quint8 channel, quint32 baudRate, bool busOffAutoReset
                TPCANTimestamp time;
                do
                {
-                   m_currentStatus = read(m_currentHandle, &message, &time);
-                   if((m_currentStatus & PCAN_ERROR_QRCVEMPTY) || (message.MSGTYPE == PCAN_MESSAGE_STATUS))
-                   {//Message received.
+                   status = read(m_currentHandle, &message, &time);
+               }while((status == PCAN_ERROR_OK) || (status == PCAN_ERROR_QOVERRUN));
+               m_currentStatus.store(status);
+
+               m_ringWriteCounter.store(0);
+               m_ringReadCounter.store(0);
+               m_notificationPending.store(0);
+               m_discardedMessages.store(0);
+               m_queueOverruns.store(0);
+               m_statusMessages.store(0);
 
-                       message.ID = 0xffffffff;
-                   }
-               }while(message.ID != 0xffffffff);
+               createReceiveEvent();
+               m_receiveThread.startReceiving();
 
                result = true;
-               m_receiveTimer.start(1);
            }
            else
            {
@@ -172,10 +233,11 @@ void PCANBasicClass::close()
 {
     if(m_currentHandle != PCAN_NONEBUS)
     {
-        m_receiveTimer.stop();
+        m_receiveThread.stopReceiving();
+        destroyReceiveEvent();
         uninitialize(m_currentHandle);
         m_currentHandle = PCAN_NONEBUS;
-        m_currentStatus = PCAN_ERROR_OK;
+        m_currentStatus.store(PCAN_ERROR_OK);
     }
 }
 
@@ -400,6 +462,63 @@ bool PCANBasicClass::sendData(const QByteArray &data)
     return result;
 }
 
+/**
+ * Sends several can frames (max. 8 data bytes per frame) with one call.
+ * @param frames
+ *      The frames.
+ * @param queueIsFull
+ *      Is set to true if the frames could not be sent because the transmit queue was full
+ *      for SEND_QUEUE_TIMEOUT_MS.
+ * @return
+ *      True on success.
+ */
+bool PCANBasicClass::sendFrames(const QVector<CanFrame>& frames, bool* queueIsFull)
+{
+    TPCANMsg messageBuffer;
+    TPCANStatus status = PCAN_ERROR_UNKNOWN;
+    QElapsedTimer queueFullTimer;
+
+    *queueIsFull = false;
+
+    if(m_currentHandle == PCAN_NONEBUS)
+    {
+        return false;
+    }
+
+    for(const auto& frame : frames)
+    {
+        messageBuffer.MSGTYPE = canFrameType(frame);
+        messageBuffer.ID = frame.id;
+        messageBuffer.LEN = (frame.length > MAX_BYTES_PER_MESSAGE) ? MAX_BYTES_PER_MESSAGE : frame.length;
+        memcpy(messageBuffer.DATA, frame.data, messageBuffer.LEN);
+
+        status = write(m_currentHandle, &messageBuffer);
+        while(status == PCAN_ERROR_QXMTFULL)
+        {//The transmit queue is full (the wait time of all frames is limited to SEND_QUEUE_TIMEOUT_MS).
+
+            if(!queueFullTimer.isValid())
+            {
+                queueFullTimer.start();
+            }
+            else if(queueFullTimer.elapsed() >= SEND_QUEUE_TIMEOUT_MS)
+            {
+                *queueIsFull = true;
+                return false;
+            }
+
+            QThread::msleep(1);
+            status = write(m_currentHandle, &messageBuffer);
+        }
+
+        if(status != PCAN_ERROR_OK)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 /**
  * Returns the current status as string.
  * @return
@@ -408,30 +527,31 @@ bool PCANBasicClass::sendData(const QByteArray &data)
 QString PCANBasicClass::getStatusString(void)
 {
     QString statusString = "Bus error:";
+    TPCANStatus currentStatus = m_currentStatus.load();
 
-    if(m_currentStatus & (PCAN_ERROR_BUSLIGHT | PCAN_ERROR_BUSHEAVY | PCAN_ERROR_BUSOFF))
+    if(currentStatus & (PCAN_ERROR_BUSLIGHT | PCAN_ERROR_BUSHEAVY | PCAN_ERROR_BUSOFF))
     {
 
-        if(m_currentStatus & PCAN_ERROR_BUSLIGHT)
+        if(currentStatus & PCAN_ERROR_BUSLIGHT)
         {
             statusString += " 'light' limit reached";
 
-            if(m_currentStatus & (PCAN_ERROR_BUSHEAVY | PCAN_ERROR_BUSOFF))
+            if(currentStatus & (PCAN_ERROR_BUSHEAVY | PCAN_ERROR_BUSOFF))
             {
                 statusString += ",";
             }
         }
-        if(m_currentStatus & PCAN_ERROR_BUSHEAVY)
+        if(currentStatus & PCAN_ERROR_BUSHEAVY)
         {
 
             statusString += " 'heavy' limit reached";
 
-            if(m_currentStatus & PCAN_ERROR_BUSOFF)
+            if(currentStatus & PCAN_ERROR_BUSOFF)
             {
                 statusString += ",";
             }
         }
-        if(m_currentStatus & PCAN_ERROR_BUSOFF)
+        if(currentStatus & PCAN_ERROR_BUSOFF)
         {
             statusString += " bus-off state";
         }
@@ -445,105 +565,209 @@ QString PCANBasicClass::getStatusString(void)
 }
 
 /**
- * Reads the last received messages.
+ * Converts a driver timestamp into the time since the first received message.
+ * @param timestamp
+ *      The driver timestamp.
  * @return
- *      The received message.
+ *      The time since the first received message (us).
  */
-QByteArray PCANBasicClass::readLastMessage(void)
+quint64 PCANBasicClass::convertTimestamp(const TPCANTimestamp& timestamp)
 {
+    quint64 micros = (quint64)timestamp.micros + (quint64)(1000 * (quint64)timestamp.millis) +
+                     (0x100000000ULL * 1000 * (quint64)timestamp.millis_overflow);
 
-    m_dataReadyForRead = false;
-    QByteArray data;
-
-     if(m_currentHandle != PCAN_NONEBUS)
-     {
+    if(!m_firstMessageReceived)
+    {
+        m_timeStampFirstReceivedMessage = micros;
+        m_firstMessageReceived = true;
+    }
 
-        if(m_lastReadMessage.ID == 0xffffffff)
-        {
+    return micros - m_timeStampFirstReceivedMessage;
+}
 
-            m_currentStatus = read(m_currentHandle, &m_lastReadMessage, &m_timeStampLastReceivedMessage);
+/**
+ * Returns all received messages (all messages in the receive ring).
+ * @return
+ *      The received messages.
+ */
+QVector<CanFrame> PCANBasicClass::readMessages(void)
+{
+    //Must be reset before the ring is read (the receive thread notifies again for all messages
+    //which are added after this point).
+    m_notificationPending.fetchAndStoreOrdered(0);
 
-            if((m_currentStatus & PCAN_ERROR_QRCVEMPTY) || (m_lastReadMessage.MSGTYPE == PCAN_MESSAGE_STATUS))
-            {//Message received.
-                m_lastReadMessage.ID = 0xffffffff;
+    quint32 readCounter = m_ringReadCounter.load();
+    quint32 writeCounter = m_ringWriteCounter.loadAcquire();
+    QVector<CanFrame> messages(writeCounter - readCounter);
+    CanFrame* frame = messages.data();
 
-            }
-        }
+    for(; readCounter != writeCounter; readCounter++, frame++)
+    {
+        const PcanReceivedMessage& entry = m_receiveRing.at(readCounter & (RECEIVE_RING_SIZE - 1));
+        const TPCANMsg& message = entry.message;
+        int length = (message.MSGTYPE & PCAN_MESSAGE_RTR) ? 0 : qMin((int)message.LEN, (int)sizeof(message.DATA));
 
-        if(m_lastReadMessage.ID != 0xffffffff)
-        {
-            if(!m_firstMessageReceived)
-            {
-                m_timeStampFirstReceivedMessage = (quint64)m_timeStampLastReceivedMessage.micros + (quint64)(1000 * (quint64)m_timeStampLastReceivedMessage.millis) +
-                                                   (quint64)(0xFFFFFFFF * 1000 * (quint64)m_timeStampLastReceivedMessage.millis_overflow);
-                m_firstMessageReceived = true;
-            }
+        initCanFrame(frame, message.MSGTYPE, message.ID, message.DATA, length, convertTimestamp(entry.timestamp));
+    }
+    m_ringReadCounter.storeRelease(readCounter);
 
+    return messages;
+}
 
-            quint64 timeStampLast = (quint64)m_timeStampLastReceivedMessage.micros + (quint64)(1000 * (quint64)m_timeStampLastReceivedMessage.millis) +
-                                       (quint64)(0xFFFFFFFF * 1000 * (quint64)m_timeStampLastReceivedMessage.millis_overflow);
+/**
+ * Copies the messages from the driver queue into the receive ring (called by the receive thread).
+ * @param queueIsEmpty
+ *      Is set to true if the driver queue is empty.
+ * @return
+ *      True if the thread of this object must be notified (messagesReceivedSignal).
+ */
+bool PCANBasicClass::drainDriverQueue(bool* queueIsEmpty)
+{
+    bool messagesAdded = false;
+    quint32 writeCounter = m_ringWriteCounter.load();
+    PcanReceivedMessage entry;
 
+    *queueIsEmpty = true;
 
+    for(quint32 i = 0; i < MAX_MESSAGES_PER_DRAIN; i++)
+    {
+        TPCANStatus status = read(m_currentHandle, &entry.message, &entry.timestamp);
 
-            quint32 timeStampDiff = (quint32)((timeStampLast - m_timeStampFirstReceivedMessage) / 1000);
+        if(status == PCAN_ERROR_QOVERRUN)
+        {//Messages have been lost in the driver, the returned message is valid.
+            m_queueOverruns.fetchAndAddRelaxed(1);
+            status = PCAN_ERROR_OK;
+        }
+        m_currentStatus.store(status);
 
-            data.push_back(m_lastReadMessage.MSGTYPE);
-            //CAN id
-            data.push_back((m_lastReadMessage.ID >> 24) & 0xff);
-            data.push_back((m_lastReadMessage.ID >> 16) & 0xff);
-            data.push_back((m_lastReadMessage.ID >> 8) & 0xff);
-            data.push_back(m_lastReadMessage.ID & 0xff);
-            //timestamp
-            data.push_back((timeStampDiff >> 24) & 0xff);
-            data.push_back((timeStampDiff >> 16) & 0xff);
-            data.push_back((timeStampDiff >> 8) & 0xff);
-            data.push_back(timeStampDiff & 0xff);
+        if(status != PCAN_ERROR_OK)
+        {//Queue empty or error.
+            break;
+        }
 
-            if(m_lastReadMessage.MSGTYPE & PCAN_MESSAGE_RTR)
-            {
-                m_lastReadMessage.LEN = 0;
-            }
+        if(i == (MAX_MESSAGES_PER_DRAIN - 1))
+        {
+            *queueIsEmpty = false;
+        }
 
-            for(int i = 0; i < m_lastReadMessage.LEN; i ++)
-            {
-                data.push_back(m_lastReadMessage.DATA[i]);
-            }
+        if(entry.message.MSGTYPE == PCAN_MESSAGE_STATUS)
+        {
+            m_statusMessages.fetchAndAddRelaxed(1);
+            continue;
+        }
 
-            m_lastReadMessage.ID = 0xffffffff;
+        if((writeCounter - m_ringReadCounter.loadAcquire()) >= RECEIVE_RING_SIZE)
+        {//The receive ring is full.
+            m_discardedMessages.fetchAndAddRelaxed(1);
+            continue;
         }
 
-     }
+        m_receiveRing[writeCounter & (RECEIVE_RING_SIZE - 1)] = entry;
+        writeCounter++;
+        m_ringWriteCounter.storeRelease(writeCounter);
+        messagesAdded = true;
+    }
 
-    return data;
+    return messagesAdded && m_notificationPending.testAndSetOrdered(0, 1);
 }
 
 /**
- * Checks if data has been received.
+ * Registers the receive event at the driver. If the driver does not support
+ * receive events, then the receive thread polls the driver queue every ms.
  */
-void PCANBasicClass::receiveTimerSlot()
+void PCANBasicClass::createReceiveEvent(void)
 {
-    if(m_currentHandle != PCAN_NONEBUS)
+#if defined(WIN32) || defined(_WIN32)
+    m_receiveEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if(m_receiveEvent != 0)
     {
-        if(!m_dataReadyForRead)
+        if(setValue(m_currentHandle, PCAN_RECEIVE_EVENT, (void*)&m_receiveEvent, sizeof(m_receiveEvent)) != PCAN_ERROR_OK)
         {
-            m_currentStatus = read(m_currentHandle, &m_lastReadMessage, &m_timeStampLastReceivedMessage);
+            CloseHandle(m_receiveEvent);
+            m_receiveEvent = 0;
+        }
+    }
+#else
+    //On Linux the driver returns a file descriptor which is readable if messages are available.
+    int descriptor = -1;
+    if(getValue(m_currentHandle, PCAN_RECEIVE_EVENT, (void*)&descriptor, sizeof(descriptor)) == PCAN_ERROR_OK)
+    {
+        m_receiveEventDescriptor = descriptor;
+    }
+    else
+    {
+        m_receiveEventDescriptor = -1;
+    }
+#endif
+}
 
-            if(!(m_currentStatus & PCAN_ERROR_QRCVEMPTY))
-            {//message received
+/**
+ * Unregisters and destroys the receive event.
+ */
+void PCANBasicClass::destroyReceiveEvent(void)
+{
+#if defined(WIN32) || defined(_WIN32)
+    if(m_receiveEvent != 0)
+    {
+        HANDLE noEvent = 0;
+        setValue(m_currentHandle, PCAN_RECEIVE_EVENT, (void*)&noEvent, sizeof(noEvent));
+        CloseHandle(m_receiveEvent);
+        m_receiveEvent = 0;
+    }
+#else
+    //The file descriptor is owned by the driver.
+    m_receiveEventDescriptor = -1;
+#endif
+}
 
-                if(m_lastReadMessage.MSGTYPE != PCAN_MESSAGE_STATUS)
-                {
-                    m_dataReadyForRead = true;
-                    emit readyRead();
-                }
-                else
-                {
-                    m_lastReadMessage.ID = 0xffffffff;
-                }
+/**
+ * Waits for the receive event of the driver (called by the receive thread).
+ * @param timeoutMs
+ *      The max. wait time.
+ */
+void PCANBasicClass::waitForReceiveEvent(quint32 timeoutMs)
+{
+#if defined(WIN32) || defined(_WIN32)
+    if(m_receiveEvent != 0)
+    {
+        WaitForSingleObject(m_receiveEvent, timeoutMs);
+    }
+    else
+    {
+        QThread::msleep(1);
+    }
+#else
+    if(m_receiveEventDescriptor >= 0)
+    {
+        fd_set descriptors;
+        FD_ZERO(&descriptors);
+        FD_SET(m_receiveEventDescriptor, &descriptors);
 
-            }
-        }
+        struct timeval timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_usec = (timeoutMs % 1000) * 1000;
+
+        select(m_receiveEventDescriptor + 1, &descriptors, NULL, NULL, &timeout);
     }
+    else
+    {
+        QThread::msleep(1);
+    }
+#endif
+}
+
+/**
+ * Wakes up the receive thread if it waits for the receive event. On Linux the
+ * receive thread wakes up after RECEIVE_EVENT_TIMEOUT_MS.
+ */
+void PCANBasicClass::wakeUpReceiveThread(void)
+{
+#if defined(WIN32) || defined(_WIN32)
+    if(m_receiveEvent != 0)
+    {
+        SetEvent(m_receiveEvent);
+    }
+#endif
 }
 
 /**
@@ -581,10 +805,11 @@ void PCANBasicClass::loadAPI()
  */
 void PCANBasicClass::unloadAPI()
 {
-    // Free the loaded DLL.
-	if(m_hDll != NULL)
-		FreeLibrary(m_hDll);
-	m_hDll = NULL;	
+    // Free the loaded library.
+    if(m_library.isLoaded())
+    {
+        m_library.unload();
+    }
 
     //Initialize the pointers.
     initializePointers();
@@ -611,7 +836,7 @@ void PCANBasicClass::initializePointers()
 }
 
 /**
- * Loads the pcan DLL.
+ * Loads the pcan library (PCANBasic.dll on Windows, libpcanbasic.so on Linux).
  * @return
  *  True on success.
  */
@@ -621,28 +846,32 @@ bool PCANBasicClass::loadDllHandle()
     if(m_pcanAlreadyLoaded)
 		return true;
 
-    //Load Dll.
-    m_hDll = LoadLibraryA("PCANBasic");
+    //Load the library.
+#if defined(WIN32) || defined(_WIN32)
+    m_library.setFileName("PCANBasic");
+#else
+    m_library.setFileName("pcanbasic");
+#endif
 
-    //Return true if the DLL was loaded or false otherwise.
-	return (m_hDll != NULL);
+    //Return true if the library was loaded or false otherwise.
+    return m_library.load();
 }
 
 /**
- * Gets the address of a given function name in a loaded DLL.
+ * Gets the address of a given function name in the loaded library.
  * @param strName
  *  The function name.
  * @return
  *  The function pointer.
  */
-FARPROC PCANBasicClass::getFunction(const char *strName)
+QFunctionPointer PCANBasicClass::getFunction(const char *strName)
 {
-    //There is no DLL loaded.
-	if(m_hDll  == NULL)
+    //There is no library loaded.
+    if(!m_library.isLoaded())
 		return NULL;
 
-    //Get the address of the given function in the loaded DLL.
-    return GetProcAddress(m_hDll, strName);
+    //Get the address of the given function in the loaded library.
+    return m_library.resolve(strName);
 }
 
 TPCANStatus PCANBasicClass::initialize(
@@ -792,6 +1021,3 @@ TPCANStatus PCANBasicClass::setValue(
 
     return (TPCANStatus)m_pSetValue(channel, parameter, buffer, bufferLength);
 }
-
-
-#endif
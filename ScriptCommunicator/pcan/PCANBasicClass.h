@@ -27,13 +27,15 @@
 
 #include <QtCore/QtGlobal>
 #include <QObject>
-#include <QTimer>
+#include <QThread>
 #include <QVector>
+#include <QLibrary>
+#include <QAtomicInteger>
 
 #include "PCANBasic.h"
+#include "canFrame.h"
 
 
-#if defined(WIN32) || defined(_WIN32)
 // Function pointers
 //
 
@@ -53,11 +55,57 @@ typedef TPCANStatus (__stdcall *fpGetErrorText)(TPCANStatus, WORD, LPSTR);
 #define fpGetValue fpGetSetValue
 #define fpSetValue fpGetSetValue
 
-///Class which represents a pcan interface.
+class PCANBasicClass;
+
+///A received can message in the receive ring.
+typedef struct
+{
+    ///The message.
+    TPCANMsg message;
+
+    ///The reception time.
+    TPCANTimestamp timestamp;
+}PcanReceivedMessage;
+
+///Thread which waits for the receive event of the pcan driver and copies all
+///received messages into the receive ring of a PCANBasicClass object.
+class PcanReceiveThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    PcanReceiveThread(PCANBasicClass* pcan);
+
+    ///Starts the thread.
+    void startReceiving(void);
+
+    ///Stops the thread (returns after the thread has been finished).
+    void stopReceiving(void);
+
+signals:
+    ///Is emitted if messages have been added to the receive ring.
+    void messagesReceivedSignal(void);
+
+protected:
+    ///The thread main function.
+    void run();
+
+private:
+    ///The pcan interface.
+    PCANBasicClass* m_pcan;
+
+    ///True if the thread shall run.
+    QAtomicInt m_running;
+};
+
+///Class which represents a pcan interface (uses PCANBasic.dll on Windows and libpcanbasic.so on Linux).
+///The received messages are read by a receive thread (PcanReceiveThread).
 class PCANBasicClass : public QObject
 {
     Q_OBJECT
 
+    friend class PcanReceiveThread;
+
     public:
 
         PCANBasicClass(QObject *parent);
@@ -78,20 +126,33 @@ class PCANBasicClass : public QObject
         ///Sends a can message (max. 8 bytes).
         bool sendCanMessage(quint8 type, quint32 canId, QVector<unsigned char> data);
 
+        ///Sends several can frames (max. 8 data bytes per frame) with one call. If the transmit queue stays
+        ///full for SEND_QUEUE_TIMEOUT_MS, false is returned and queueIsFull is set to true.
+        bool sendFrames(const QVector<CanFrame>& frames, bool* queueIsFull);
+
         ///Returns true if connected to a pcan interface.
         bool isConnected(void);
 
         ///Converts a baudrate to the corresponding string.
         static quint16 convertBaudrateString(QString baudrate);
 
-        ///Reads the last received messages.
-        QByteArray readLastMessage(void);
+        ///Returns all received messages.
+        QVector<CanFrame> readMessages(void);
+
+        ///Returns the number of received messages which have been discarded because the receive ring was full.
+        quint32 getDiscardedMessages(void){return m_discardedMessages.load();}
+
+        ///Returns the number of reported driver queue overruns (messages have been lost in the driver).
+        quint32 getQueueOverruns(void){return m_queueOverruns.load();}
+
+        ///Returns the number of received status messages (bus errors and state changes) since the interface has been opened.
+        quint32 getStatusMessages(void){return m_statusMessages.load();}
 
         ///Returns the current status as string.
         QString getStatusString(void);
 
         ///Returns the current status.
-        TPCANStatus getCurrentStatus(void){return m_currentStatus;}
+        TPCANStatus getCurrentStatus(void){return m_currentStatus.load();}
 
 
         ///Returns a pcan parameter.
@@ -109,6 +170,9 @@ class PCANBasicClass : public QObject
         ///The max. number of allowed send errors for a single CAN message (after this number the sending of data fails).
         const quint32 MAX_SEND_ERROR = 1000;
 
+        ///The max. time (ms) sendFrames waits for space in the full transmit queue (for all frames of one call).
+        static const qint64 SEND_QUEUE_TIMEOUT_MS = 20;
+
         ///The max. number of bytes in a single CAN message.
         static const qint32 MAX_BYTES_PER_MESSAGE = 8;
 
@@ -127,12 +191,18 @@ class PCANBasicClass : public QObject
         ///The number of bytes for the meta data in a received message.
         static const quint32 BYTES_METADATA_RECEIVE = BYTES_FOR_CAN_TYPE + BYTES_FOR_CAN_ID + BYTES_FOR_CAN_TIMESTAMP;
 
+        ///The number of messages in the receive ring (must be a power of 2).
+        static const quint32 RECEIVE_RING_SIZE = 16384;
+
+        ///The max. time the receive thread waits for the receive event (ms).
+        static const quint32 RECEIVE_EVENT_TIMEOUT_MS = 100;
+
+        ///The max. number of messages which are read from the driver queue before the thread of this object is notified.
+        static const quint32 MAX_MESSAGES_PER_DRAIN = RECEIVE_RING_SIZE / 4;
+
 signals:
         ///Is emitted if data has been received.
         void readyRead(void);
-private slots:
-        ///Checks if data has been received.
-        void receiveTimerSlot();
 
 private:
 
@@ -202,9 +272,8 @@ private:
         /// <returns>"A TPCANStatus error code"</returns>
         TPCANStatus filterMessages(TPCANHandle Channel, DWORD FromID, DWORD ToID, TPCANMode Mode);
 
-
-    //DLL PCANBasic
-    HINSTANCE m_hDll;
+    ///The PCANBasic library.
+    QLibrary m_library;
 
     //Function pointers
     fpInitialize m_pInitialize;
@@ -218,7 +287,7 @@ private:
     fpSetValue m_pSetValue;
     fpGetErrorText m_pGetTextError;
 
-    ///True if the pcan dll has already been loaded.
+    ///True if the pcan library has already been loaded.
     bool m_pcanAlreadyLoaded;
 
     ///Loads the PCANBasic API.
@@ -230,114 +299,73 @@ private:
     ///Initializes the pointers for the PCANBasic functions.
     void initializePointers();
 
-    ///Loads the pcan DLL.
+    ///Loads the pcan library.
     bool loadDllHandle();
 
-    ///Gets the address of a given function name in a loaded DLL.
-    FARPROC getFunction(const char* szName);
-
-    TPCANHandle m_currentHandle;
+    ///Gets the address of a given function name in the loaded library.
+    QFunctionPointer getFunction(const char* szName);
 
-    ///True if data is ready for read.
-    bool m_dataReadyForRead;
+    ///Registers the receive event at the driver.
+    void createReceiveEvent(void);
 
-    ///Checks if data has been received.
-    QTimer m_receiveTimer;
+    ///Unregisters and destroys the receive event.
+    void destroyReceiveEvent(void);
 
-    TPCANMsg m_lastReadMessage;
+    ///Waits for the receive event of the driver (called by the receive thread).
+    void waitForReceiveEvent(quint32 timeoutMs);
 
-    ///The time stamp of the first received message.
-    quint64 m_timeStampFirstReceivedMessage;
+    ///Wakes up the receive thread if it waits for the receive event.
+    void wakeUpReceiveThread(void);
 
-    ///The time stamp of the last received message.
-    TPCANTimestamp m_timeStampLastReceivedMessage;
+    ///Copies the messages from the driver queue into the receive ring (called by the receive thread).
+    ///Returns true if the thread of this object must be notified (messagesReceivedSignal).
+    bool drainDriverQueue(bool* queueIsEmpty);
 
-    ///True if a first message has been received.
-    bool m_firstMessageReceived;
+    ///Converts a driver timestamp into the time since the first received message (us).
+    quint64 convertTimestamp(const TPCANTimestamp& timestamp);
 
-    ///The current CAN status.
-    TPCANStatus m_currentStatus;
-};
-#else//Linux is not supported.
-class PCANBasicClass : public QObject
-{
-    Q_OBJECT
-    public:
+    TPCANHandle m_currentHandle;
 
-        PCANBasicClass(QObject *parent) : QObject(parent){}
-        ~PCANBasicClass(){}
-        bool open(quint8 channel, quint32 baudRate, bool busOffAutoReset, bool powerSupply){(void)channel;(void)baudRate;(void)busOffAutoReset;(void)powerSupply;return false;}
-        void close(){}
-        bool sendData(const QByteArray &data){(void)data;return false;}
-        QByteArray readLastMessage(void){QByteArray data;return data;}
-        TPCANStatus getValue(TPCANHandle Channel, TPCANParameter Parameter, void* Buffer, DWORD BufferLength){(void)Channel;(void)Parameter;(void)Buffer;(void)BufferLength;return PCAN_ERROR_INITIALIZE;}
+    ///The receive thread.
+    PcanReceiveThread m_receiveThread;
 
-        ///The max. number of allowed send errors for a single CAN message (after this number the sending of data fails).
-        const quint32 MAX_SEND_ERROR = 1000;
+#if defined(WIN32) || defined(_WIN32)
+    ///The receive event (0 if the driver does not support receive events).
+    HANDLE m_receiveEvent;
+#else
+    ///The file descriptor of the receive event (-1 if the driver does not support receive events).
+    int m_receiveEventDescriptor;
+#endif
 
-        ///The max. number of bytes in a single CAN message.
-        static const qint32 MAX_BYTES_PER_MESSAGE = 8;
+    ///The receive ring (written by the receive thread and read by the thread of this object).
+    QVector<PcanReceivedMessage> m_receiveRing;
 
-        ///The number of bytes for the CAN type.
-        static const qint32 BYTES_FOR_CAN_TYPE = 1;
+    ///The number of messages which have been written into the receive ring.
+    QAtomicInteger<quint32> m_ringWriteCounter;
 
-        ///The number of bytes for the CAN id.
-        static const qint32 BYTES_FOR_CAN_ID = 4;
+    ///The number of messages which have been read from the receive ring.
+    QAtomicInteger<quint32> m_ringReadCounter;
 
-        ///The number of bytes for the CAN timestamp.
-        static const qint32 BYTES_FOR_CAN_TIMESTAMP = 4;
+    ///True if messagesReceivedSignal has been emitted and the messages have not been read.
+    QAtomicInt m_notificationPending;
 
-        ///The number of bytes for the meta data in a send message.
-        static const quint32 BYTES_METADATA_SEND = BYTES_FOR_CAN_TYPE + BYTES_FOR_CAN_ID;
+    ///The number of received messages which have been discarded because the receive ring was full.
+    QAtomicInteger<quint32> m_discardedMessages;
 
-        ///The number of bytes for the meta data in a received message.
-        static const quint32 BYTES_METADATA_RECEIVE = BYTES_FOR_CAN_TYPE + BYTES_FOR_CAN_ID + BYTES_FOR_CAN_TIMESTAMP;
+    ///The number of reported driver queue overruns.
+    QAtomicInteger<quint32> m_queueOverruns;
 
+    ///The number of received status messages (bus errors and state changes).
+    QAtomicInteger<quint32> m_statusMessages;
 
-        QString getStatusString(void){return "";}
-        TPCANStatus getCurrentStatus(void){return PCAN_ERROR_OK;}
-        bool isConnected(void){return false;}
-        static quint16 convertBaudrateString(QString baudrate){(void)baudrate;return 0;}
-        bool sendCanMessage(quint8 type, quint32 canId, QVector<unsigned char> data)
-        {
-            (void)type;
-            (void)canId;
-            (void)data;
-            return true;
-        }
-        bool setFilter(bool filterExtended, quint32 filterFrom, quint32 filterTo){(void) filterExtended;(void)filterFrom;(void)filterTo;return true;}
-
-        TPCANStatus getValue(TPCANParameter parameter, void* buffer, DWORD bufferLength)
-        {
-            (void)parameter;
-            (void)buffer;
-            (void)bufferLength;
-            return PCAN_ERROR_OK;
-        }
-
-        TPCANStatus setValue(TPCANHandle channel, TPCANParameter parameter, void* buffer, DWORD bufferLength)
-        {
-            (void)channel;
-            (void)parameter;
-            (void)buffer;
-            (void)bufferLength;
-            return PCAN_ERROR_OK;
-        }
-
-        TPCANStatus setValue(TPCANParameter parameter, void* buffer, DWORD bufferLength)
-        {
-
-            (void)parameter;
-            (void)buffer;
-            (void)bufferLength;
-            return PCAN_ERROR_OK;
-
-        }
-signals:
-        void readyRead(void);
-};
-#endif
+    ///The time stamp of the first received message.
+    quint64 m_timeStampFirstReceivedMessage;
 
+    ///True if a first message has been received.
+    bool m_firstMessageReceived;
 
+    ///The current CAN status.
+    QAtomicInteger<quint32> m_currentStatus;
+};
 
 #endif
@@ -0,0 +1,455 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+//
+
+//Simulated PCANBasic library for Linux (see pcanBasicSimulation.pro).
+//
+//Every initialized channel has a generator thread which creates cyclic can messages
+//(SIMULATION_IDS different ids, SIMULATION_FRAMES_PER_SECOND messages per second) and all
+//written messages are echoed into the receive queue (SIMULATION_LOOPBACK=0 disables this).
+//The values can be changed with the environment variables PCAN_SIMULATION_FRAMES_PER_SECOND,
+//PCAN_SIMULATION_IDS and PCAN_SIMULATION_LOOPBACK.
+//PCAN_RECEIVE_EVENT returns an eventfd which is readable if the receive queue is not empty.
+
+#include <QtCore/QtGlobal>
+#include "PCANBasic.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+///The default number of generated messages per second.
+static const quint32 SIMULATION_FRAMES_PER_SECOND = 1000;
+
+///The default number of different generated ids.
+static const quint32 SIMULATION_IDS = 16;
+
+///The first generated (standard) id.
+static const quint32 SIMULATION_FIRST_ID = 0x100;
+
+///The max. number of messages in the receive queue.
+static const size_t SIMULATION_QUEUE_SIZE = 32768;
+
+///A received message in the receive queue.
+typedef struct
+{
+    ///The message.
+    TPCANMsg message;
+
+    ///The reception time (us since the channel has been initialized).
+    quint64 micros;
+}SimulatedMessage;
+
+///A simulated pcan channel.
+class SimulatedChannel
+{
+public:
+    SimulatedChannel() : m_eventDescriptor(-1), m_running(false), m_filterFrom(0), m_filterTo(0x1fffffff),
+        m_queueOverrun(false), m_framesPerSecond(SIMULATION_FRAMES_PER_SECOND), m_ids(SIMULATION_IDS), m_loopback(true)
+    {
+        const char* value = getenv("PCAN_SIMULATION_FRAMES_PER_SECOND");
+        if(value)
+        {
+            m_framesPerSecond = (quint32)strtoul(value, NULL, 0);
+        }
+        value = getenv("PCAN_SIMULATION_IDS");
+        if(value)
+        {
+            m_ids = (quint32)strtoul(value, NULL, 0);
+        }
+        value = getenv("PCAN_SIMULATION_LOOPBACK");
+        if(value)
+        {
+            m_loopback = (strcmp(value, "0") != 0);
+        }
+    }
+
+    ///Starts the generator thread.
+    bool start(void)
+    {
+        m_eventDescriptor = eventfd(0, EFD_NONBLOCK);
+        if(m_eventDescriptor < 0)
+        {
+            return false;
+        }
+        m_startTime = std::chrono::steady_clock::now();
+        m_running = true;
+        m_generator = std::thread(&SimulatedChannel::generate, this);
+        return true;
+    }
+
+    ///Stops the generator thread.
+    void stop(void)
+    {
+        m_running = false;
+        if(m_generator.joinable())
+        {
+            m_generator.join();
+        }
+        if(m_eventDescriptor >= 0)
+        {
+            close(m_eventDescriptor);
+            m_eventDescriptor = -1;
+        }
+    }
+
+    ///Adds a message to the receive queue.
+    void push(const TPCANMsg& message)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if((message.ID < m_filterFrom) || (message.ID > m_filterTo))
+        {
+            return;
+        }
+        if(m_queue.size() >= SIMULATION_QUEUE_SIZE)
+        {
+            m_queueOverrun = true;
+            return;
+        }
+
+        SimulatedMessage entry;
+        entry.message = message;
+        entry.micros = elapsedMicros();
+        m_queue.push_back(entry);
+
+        quint64 one = 1;
+        if(::write(m_eventDescriptor, &one, sizeof(one)) < 0)
+        {
+            //The event counter is already set.
+        }
+    }
+
+    ///Reads a message from the receive queue.
+    TPCANStatus read(TPCANMsg* message, TPCANTimestamp* timestamp)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if(m_queue.empty())
+        {
+            //Reset the event (the queue is empty).
+            quint64 counter;
+            if(::read(m_eventDescriptor, &counter, sizeof(counter)) < 0)
+            {
+                //The event is not set.
+            }
+            return PCAN_ERROR_QRCVEMPTY;
+        }
+
+        SimulatedMessage entry = m_queue.front();
+        m_queue.pop_front();
+
+        *message = entry.message;
+        if(timestamp)
+        {
+            quint64 millis = entry.micros / 1000;
+            timestamp->micros = (WORD)(entry.micros % 1000);
+            timestamp->millis = (DWORD)millis;
+            timestamp->millis_overflow = (WORD)(millis >> 32);
+        }
+
+        if(m_queueOverrun)
+        {
+            m_queueOverrun = false;
+            return PCAN_ERROR_QOVERRUN;
+        }
+        return PCAN_ERROR_OK;
+    }
+
+    ///Writes a message (the message is echoed if loopback is enabled).
+    TPCANStatus write(TPCANMsg* message)
+    {
+        if(m_loopback)
+        {
+            push(*message);
+        }
+        return PCAN_ERROR_OK;
+    }
+
+    ///Clears the receive queue.
+    void reset(void)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        m_queueOverrun = false;
+    }
+
+    ///Sets the reception filter.
+    void setFilter(DWORD from, DWORD to)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_filterFrom = from;
+        m_filterTo = to;
+    }
+
+    ///Returns the file descriptor of the receive event.
+    int eventDescriptor(void){return m_eventDescriptor;}
+
+private:
+
+    ///Returns the time since the start (us).
+    quint64 elapsedMicros(void)
+    {
+        return (quint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+    }
+
+    ///The generator thread function.
+    void generate(void)
+    {
+        quint64 generatedFrames = 0;
+        TPCANMsg message;
+        memset(&message, 0, sizeof(message));
+
+        while(m_running)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            if((m_framesPerSecond == 0) || (m_ids == 0))
+            {
+                continue;
+            }
+
+            quint64 dueFrames = (elapsedMicros() * m_framesPerSecond) / 1000000;
+            for(; generatedFrames < dueFrames; generatedFrames++)
+            {
+                quint32 index = (quint32)(generatedFrames % m_ids);
+                quint64 cycle = generatedFrames / m_ids;
+
+                message.ID = SIMULATION_FIRST_ID + index;
+                message.MSGTYPE = PCAN_MESSAGE_STANDARD;
+                message.LEN = 1 + (index % 8);
+                for(int i = 0; i < message.LEN; i++)
+                {
+                    message.DATA[i] = (BYTE)(cycle >> (8 * (i % 8)));
+                }
+                push(message);
+            }
+        }
+    }
+
+    ///The receive event.
+    int m_eventDescriptor;
+
+    ///True if the generator thread shall run.
+    std::atomic<bool> m_running;
+
+    ///The generator thread.
+    std::thread m_generator;
+
+    ///Protects the receive queue and the filter.
+    std::mutex m_mutex;
+
+    ///The receive queue.
+    std::deque<SimulatedMessage> m_queue;
+
+    ///The lowest id which is received.
+    DWORD m_filterFrom;
+
+    ///The highest id which is received.
+    DWORD m_filterTo;
+
+    ///True if messages have been discarded because the receive queue was full.
+    bool m_queueOverrun;
+
+    ///The start time.
+    std::chrono::steady_clock::time_point m_startTime;
+
+    ///The number of generated messages per second.
+    quint32 m_framesPerSecond;
+
+    ///The number of different generated ids.
+    quint32 m_ids;
+
+    ///True if written messages are echoed.
+    bool m_loopback;
+};
+
+///All initialized channels.
+static std::map<TPCANHandle, SimulatedChannel*> g_channels;
+
+///Protects g_channels.
+static std::mutex g_channelsMutex;
+
+///Returns an initialized channel (NULL if the channel is not initialized).
+static SimulatedChannel* findChannel(TPCANHandle channel)
+{
+    std::lock_guard<std::mutex> lock(g_channelsMutex);
+    std::map<TPCANHandle, SimulatedChannel*>::iterator iter = g_channels.find(channel);
+    return (iter != g_channels.end()) ? iter->second : NULL;
+}
+
+///Returns true if channel is a simulated (usb) channel.
+static bool isSimulatedChannel(TPCANHandle channel)
+{
+    return (channel >= PCAN_USBBUS1) && (channel <= PCAN_USBBUS8);
+}
+
+extern "C" {
+
+TPCANStatus CAN_Initialize(TPCANHandle Channel, TPCANBaudrate Btr0Btr1, TPCANType HwType, DWORD IOPort, WORD Interrupt)
+{
+    (void)Btr0Btr1;
+    (void)HwType;
+    (void)IOPort;
+    (void)Interrupt;
+
+    if(!isSimulatedChannel(Channel))
+    {
+        return PCAN_ERROR_ILLHW;
+    }
+    if(findChannel(Channel))
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+
+    SimulatedChannel* channel = new SimulatedChannel();
+    if(!channel->start())
+    {
+        delete channel;
+        return PCAN_ERROR_UNKNOWN;
+    }
+
+    std::lock_guard<std::mutex> lock(g_channelsMutex);
+    g_channels[Channel] = channel;
+    return PCAN_ERROR_OK;
+}
+
+TPCANStatus CAN_Uninitialize(TPCANHandle Channel)
+{
+    SimulatedChannel* channel = NULL;
+    {
+        std::lock_guard<std::mutex> lock(g_channelsMutex);
+        std::map<TPCANHandle, SimulatedChannel*>::iterator iter = g_channels.find(Channel);
+        if(iter == g_channels.end())
+        {
+            return PCAN_ERROR_INITIALIZE;
+        }
+        channel = iter->second;
+        g_channels.erase(iter);
+    }
+
+    channel->stop();
+    delete channel;
+    return PCAN_ERROR_OK;
+}
+
+TPCANStatus CAN_Reset(TPCANHandle Channel)
+{
+    SimulatedChannel* channel = findChannel(Channel);
+    if(!channel)
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+    channel->reset();
+    return PCAN_ERROR_OK;
+}
+
+TPCANStatus CAN_GetStatus(TPCANHandle Channel)
+{
+    return findChannel(Channel) ? PCAN_ERROR_OK : PCAN_ERROR_INITIALIZE;
+}
+
+TPCANStatus CAN_Read(TPCANHandle Channel, TPCANMsg* MessageBuffer, TPCANTimestamp* TimestampBuffer)
+{
+    SimulatedChannel* channel = findChannel(Channel);
+    if(!channel)
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+    return channel->read(MessageBuffer, TimestampBuffer);
+}
+
+TPCANStatus CAN_Write(TPCANHandle Channel, TPCANMsg* MessageBuffer)
+{
+    SimulatedChannel* channel = findChannel(Channel);
+    if(!channel)
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+    return channel->write(MessageBuffer);
+}
+
+TPCANStatus CAN_FilterMessages(TPCANHandle Channel, DWORD FromID, DWORD ToID, TPCANMode Mode)
+{
+    (void)Mode;
+
+    SimulatedChannel* channel = findChannel(Channel);
+    if(!channel)
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+    channel->setFilter(FromID, ToID);
+    return PCAN_ERROR_OK;
+}
+
+TPCANStatus CAN_GetValue(TPCANHandle Channel, TPCANParameter Parameter, void* Buffer, DWORD BufferLength)
+{
+    if((Parameter == PCAN_CHANNEL_CONDITION) && (BufferLength >= sizeof(int)))
+    {
+        int condition = (isSimulatedChannel(Channel) && !findChannel(Channel)) ? PCAN_CHANNEL_AVAILABLE : PCAN_CHANNEL_OCCUPIED;
+        memcpy(Buffer, &condition, sizeof(condition));
+        return PCAN_ERROR_OK;
+    }
+
+    SimulatedChannel* channel = findChannel(Channel);
+    if(!channel)
+    {
+        return PCAN_ERROR_INITIALIZE;
+    }
+
+    if((Parameter == PCAN_RECEIVE_EVENT) && (BufferLength >= sizeof(int)))
+    {
+        int descriptor = channel->eventDescriptor();
+        memcpy(Buffer, &descriptor, sizeof(descriptor));
+        return PCAN_ERROR_OK;
+    }
+    return PCAN_ERROR_ILLPARAMTYPE;
+}
+
+TPCANStatus CAN_SetValue(TPCANHandle Channel, TPCANParameter Parameter, void* Buffer, DWORD BufferLength)
+{
+    (void)Parameter;
+    (void)Buffer;
+    (void)BufferLength;
+
+    //All parameters are accepted (and ignored).
+    return findChannel(Channel) ? PCAN_ERROR_OK : PCAN_ERROR_INITIALIZE;
+}
+
+TPCANStatus CAN_GetErrorText(TPCANStatus Error, WORD Language, LPSTR Buffer)
+{
+    (void)Language;
+    sprintf(Buffer, "simulated pcan status 0x%05x", (unsigned int)Error);
+    return PCAN_ERROR_OK;
+}
+
+}
@@ -0,0 +1,26 @@
+#-------------------------------------------------
+#
+# Simulated PCANBasic library (libpcanbasic.so) for testing the pcan
+# interface on Linux without pcan hardware.
+#
+# Usage: build this project and start ScriptCommunicator with
+# LD_LIBRARY_PATH=<build directory of this project>.
+#
+#-------------------------------------------------
+
+QT = core
+
+CONFIG += c++11
+
+INCLUDEPATH += ../
+
+TARGET = pcanbasic
+TEMPLATE = lib
+
+SOURCES += pcanBasicSimulation.cpp
+
+HEADERS += ../PCANBasic.h
+
+unix {
+    LIBS += -lpthread
+}
@@ -40,8 +40,14 @@ extern bool g_aThreadHasBeenTerminated;
  *      Pointer to the main window.
  */
 CustomConsoleLogObject::CustomConsoleLogObject(MainWindow* mainWindow) : QObject(mainWindow),
-    m_scriptPath(), m_mainWindow(mainWindow), m_script(0), m_scriptFunctionIsFinished(false), m_scriptIsBlocked(false)
+    m_scriptPath(), m_mainWindow(mainWindow), m_script(0), m_scriptFunctionIsFinished(0), m_scriptFunctionMutex(),
+    m_scriptFunctionFinishedCondition(), m_scriptIsBlocked(false),
+    m_pendingCalls(), m_nextSequence(0), m_pendingChunks(0), m_maxPendingCalls(0), m_batchChunks(), m_batchQueueTimeMs(0),
+    m_batchIsLog(false), m_useBatch(false), m_discardedCalls(0), m_lastFinishedTimeMs(0),
+    m_elapsedTimer(), m_blockCheckTimer(this)
 {
+    m_elapsedTimer.start();
+    connect(&m_blockCheckTimer, SIGNAL(timeout()), this, SLOT(blockCheckTimerSlot()));
 }
 
 /**
@@ -77,6 +83,7 @@ void CustomConsoleLogObject::createThread(bool debug)
 
     qRegisterMetaType<QMessageBox::Icon>("QMessageBox::Icon");
     qRegisterMetaType<QMessageBox::StandardButtons>("QMessageBox::StandardButtons");
+    qRegisterMetaType<QVector<CustomConsoleLogChunk>>("QVector<CustomConsoleLogChunk>");
 
 
     if(!debug)
@@ -87,8 +94,14 @@ void CustomConsoleLogObject::createThread(bool debug)
                 m_mainWindow, SLOT(showMessageBoxSlot(QMessageBox::Icon,QString,QString,QMessageBox::StandardButtons)),
                 Qt::QueuedConnection);
 
-        connect(this, SIGNAL(executeScriptSignal(QByteArray*,QString*,bool,bool,bool,bool,QString*)),
-                m_script, SLOT(executeScriptSlot(QByteArray*,QString*,bool,bool,bool,bool,QString*)), Qt::QueuedConnection);
+        connect(this, SIGNAL(executeScriptSignal(quint64,QByteArray,QString,bool,bool,bool,bool)),
+                m_script, SLOT(executeScriptSlot(quint64,QByteArray,QString,bool,bool,bool,bool)), Qt::QueuedConnection);
+
+        connect(this, SIGNAL(executeBatchScriptSignal(quint64,QVector<CustomConsoleLogChunk>,bool)),
+                m_script, SLOT(executeBatchScriptSlot(quint64,QVector<CustomConsoleLogChunk>,bool)), Qt::QueuedConnection);
+
+        connect(m_script, SIGNAL(scriptFunctionFinishedSignal(quint64,QString)),
+                this, SLOT(scriptFunctionFinishedSlot(quint64,QString)), Qt::QueuedConnection);
 
         connect(this, SIGNAL(loadCustomScriptSignal(QString,bool*)),
                 m_script, SLOT(loadCustomScriptSlot(QString,bool*)), Qt::QueuedConnection);
@@ -104,6 +117,10 @@ void CustomConsoleLogObject::createThread(bool debug)
         connect(m_script, SIGNAL(showMessageBoxSignal(QMessageBox::Icon,QString,QString,QMessageBox::StandardButtons)),
                 m_mainWindow, SLOT(showMessageBoxSlot(QMessageBox::Icon,QString,QString,QMessageBox::StandardButtons)),
                 Qt::QueuedConnection);
+
+        //The script is executed in the main thread (direct connection).
+        connect(m_script, SIGNAL(scriptFunctionFinishedSignal(quint64,QString)),
+                this, SLOT(scriptFunctionFinishedSlot(quint64,QString)), Qt::DirectConnection);
         m_script->run();
     }
 
@@ -115,8 +132,14 @@ void CustomConsoleLogObject::createThread(bool debug)
 void CustomConsoleLogObject::terminateThread()
 {
     //Disconnect all external signals.
-    disconnect(this, SIGNAL(executeScriptSignal(QByteArray*,QString*,bool,bool,bool,bool,QString*)),
-            m_script, SLOT(executeScriptSlot(QByteArray*,QString*,bool,bool,bool,bool,QString*)));
+    disconnect(this, SIGNAL(executeScriptSignal(quint64,QByteArray,QString,bool,bool,bool,bool)),
+            m_script, SLOT(executeScriptSlot(quint64,QByteArray,QString,bool,bool,bool,bool)));
+
+    disconnect(this, SIGNAL(executeBatchScriptSignal(quint64,QVector<CustomConsoleLogChunk>,bool)),
+            m_script, SLOT(executeBatchScriptSlot(quint64,QVector<CustomConsoleLogChunk>,bool)));
+
+    disconnect(m_script, SIGNAL(scriptFunctionFinishedSignal(quint64,QString)),
+            this, SLOT(scriptFunctionFinishedSlot(quint64,QString)));
 
     disconnect(this, SIGNAL(loadCustomScriptSignal(QString,bool*)),
             m_script, SLOT(loadCustomScriptSlot(QString,bool*)));
@@ -148,6 +171,9 @@ bool CustomConsoleLogObject::scriptHasBeenLoaded()
  */
 void CustomConsoleLogObject::unloadCustomScript(void)
 {
+    clearPendingCalls();
+    m_useBatch = false;
+
     if(m_script)
     {
         if(m_script->getRunsInDebugger())
@@ -193,6 +219,7 @@ bool CustomConsoleLogObject::loadCustomScript(QString scriptPath, bool debug)
 
     bool hasSucceeded = false;
     m_scriptIsBlocked = false;
+    clearPendingCalls();
 
     m_scriptPath = scriptPath;
     if(!m_script)
@@ -204,23 +231,34 @@ bool CustomConsoleLogObject::loadCustomScript(QString scriptPath, bool debug)
 
     if(!debug)
     {
-        m_scriptFunctionIsFinished = false;
-        QDateTime savedTime = QDateTime::currentDateTime();
+        m_scriptFunctionIsFinished.storeRelease(0);
+        QElapsedTimer elapsedTimer;
+        elapsedTimer.start();
 
         emit loadCustomScriptSignal(scriptPath, &hasSucceeded);
-        while(!m_scriptFunctionIsFinished)
+
+        //Wait (without polling) until the script thread has finished loadCustomScriptSlot or the block time has elapsed.
+        bool isBlocked = false;
+        m_scriptFunctionMutex.lock();
+        while(m_scriptFunctionIsFinished.loadAcquire() == 0)
         {
-            QThread::usleep(1);
-
-            if(savedTime.msecsTo(QDateTime::currentDateTime()) > m_script->m_blockTime)
-            {//Thread is blocked.
-                QMessageBox::critical(m_mainWindow, "error",scriptPath + " is blocked.");
-                QApplication::removePostedEvents(m_script);
-                m_scriptIsBlocked = true;
-                terminateThread();
-                createThread(debug);
+            qint64 remainingTime = (qint64)m_script->m_blockTime + WATCHDOG_GRACE_TIME - elapsedTimer.elapsed();
+            if(remainingTime <= 0)
+            {
+                isBlocked = true;
                 break;
             }
+            m_scriptFunctionFinishedCondition.wait(&m_scriptFunctionMutex, (unsigned long)remainingTime);
+        }
+        m_scriptFunctionMutex.unlock();
+
+        if(isBlocked)
+        {//Thread is blocked.
+            QMessageBox::critical(m_mainWindow, "error",scriptPath + " is blocked.");
+            QApplication::removePostedEvents(m_script);
+            m_scriptIsBlocked = true;
+            terminateThread();
+            createThread(debug);
         }
     }
     else
@@ -233,6 +271,8 @@ bool CustomConsoleLogObject::loadCustomScript(QString scriptPath, bool debug)
         }
     }
 
+    m_useBatch = (hasSucceeded && m_script) ? m_script->hasBatchFunction() : false;
+
     return hasSucceeded;
 }
 
@@ -297,14 +337,36 @@ void CustomConsoleLogThread::loadCustomScriptSlot(QString scriptPath, bool* hasS
                 context->setThisObject(context->parentContext()->thisObject());
             }
 
+            if(!m_runsInDebugger)
+            {//The script engine must process events, else the watchdog cannot abort a call.
+                m_scriptEngine->setProcessEventsInterval(WATCHDOG_PROCESS_EVENTS_INTERVAL);
+            }
+            m_consecutiveAbortedCalls = 0;
+
+            armWatchdog();
             QScriptValue result = m_scriptEngine->evaluate(scriptFile.readAll(), scriptPath);
             scriptFile.close();
 
-
-            if (!result.isError())
+            if(disarmWatchdog())
             {
-                *m_createString = m_scriptEngine->evaluate("createString");
-                *hasSucceeded =  m_createString->isError() ? false : true;
+                emit showMessageBoxSignal(QMessageBox::Critical, "error", scriptPath + " has exceeded the block time and has been aborted.",
+                                          QMessageBox::Ok);
+            }
+            else if (!result.isError())
+            {
+                *m_createStringBatch = m_scriptEngine->globalObject().property("createStringBatch");
+                m_hasBatchFunction = m_createStringBatch->isFunction();
+
+                if(m_hasBatchFunction)
+                {//'createString' is optional if the script contains 'createStringBatch'.
+                    *m_createString = m_scriptEngine->globalObject().property("createString");
+                    *hasSucceeded = true;
+                }
+                else
+                {
+                    *m_createString = m_scriptEngine->evaluate("createString");
+                    *hasSucceeded =  m_createString->isError() ? false : true;
+                }
             }
 
             if(m_scriptEngine->hasUncaughtException())
@@ -336,12 +398,17 @@ void CustomConsoleLogThread::loadCustomScriptSlot(QString scriptPath, bool* hasS
         }
     }
 
-    m_consoleLogObject->m_scriptFunctionIsFinished = true;
+    m_consoleLogObject->m_scriptFunctionMutex.lock();
+    m_consoleLogObject->m_scriptFunctionIsFinished.storeRelease(1);
+    m_consoleLogObject->m_scriptFunctionFinishedCondition.wakeAll();
+    m_consoleLogObject->m_scriptFunctionMutex.unlock();
 
 }
 
 /**
- * Executes the script function 'createString'.
+ * Executes the script function 'createString' (the result is emitted with scriptFunctionFinishedSignal).
+ * @param sequence
+ *      The sequence number of the call (is emitted with scriptFunctionFinishedSignal).
  * @param data
  *      The data argument for the 'createString' function.
  * @param timeStamp
@@ -354,72 +421,317 @@ void CustomConsoleLogThread::loadCustomScriptSlot(QString scriptPath, bool* hasS
  *      The isFromCan argument for the 'createString' function.
  * @param isLog
  *      The isLog argument for the 'createString' function.
- * @param result
- *      The result (the created string).
  */
-void CustomConsoleLogThread::executeScriptSlot(QByteArray* data, QString* timeStamp,
-                                           bool isSend, bool isUserMessage, bool isFromCan, bool isLog,
-                                           QString* result)
+void CustomConsoleLogThread::executeScriptSlot(quint64 sequence, QByteArray data, QString timeStamp,
+                                           bool isSend, bool isUserMessage, bool isFromCan, bool isLog)
 {
-    QScriptValue scriptArray = m_scriptEngine->newArray(data->size());
-    for(int i = 0; i < data->size(); i++)
-    {
-        scriptArray.setProperty(i, QScriptValue(m_scriptEngine, (unsigned char)data->at(i)));
-    }
-    quint32 type;
-    if(isUserMessage)
+    CustomConsoleLogChunk chunk;
+    chunk.data = data;
+    chunk.timeStamp = timeStamp;
+    chunk.isSend = isSend;
+    chunk.isUserMessage = isUserMessage;
+    chunk.isFromCan = isFromCan;
+
+    CustomConsoleLogScriptCall call;
+    call.sequence = sequence;
+    call.chunks.append(chunk);
+    call.isLog = isLog;
+    call.isBatch = false;
+    m_scriptCalls.enqueue(call);
+
+    executeScriptCalls();
+}
+
+/**
+ * Executes the script function 'createStringBatch' (the result is emitted with scriptFunctionFinishedSignal).
+ * @param sequence
+ *      The sequence number of the call (is emitted with scriptFunctionFinishedSignal).
+ * @param chunks
+ *      The chunks.
+ * @param isLog
+ *      The isLog argument for the 'createStringBatch' function.
+ */
+void CustomConsoleLogThread::executeBatchScriptSlot(quint64 sequence, QVector<CustomConsoleLogChunk> chunks, bool isLog)
+{
+    CustomConsoleLogScriptCall call;
+    call.sequence = sequence;
+    call.chunks = chunks;
+    call.isLog = isLog;
+    call.isBatch = true;
+    m_scriptCalls.enqueue(call);
+
+    executeScriptCalls();
+}
+
+/**
+ * Executes all queued calls (m_scriptCalls).
+ * The script engine processes events during a call (see WATCHDOG_PROCESS_EVENTS_INTERVAL), therefore
+ * this function can be called recursively. In this case the call is only queued and executed
+ * (in order) after the current call.
+ */
+void CustomConsoleLogThread::executeScriptCalls(void)
+{
+    if(m_isExecuting)
     {
-        type = 4;
+        return;
     }
-    else
+    m_isExecuting = true;
+
+    while(!m_scriptCalls.isEmpty())
     {
-        if (isSend)
-        {
-            type = isFromCan ? 3 : 1;
+        CustomConsoleLogScriptCall call = m_scriptCalls.dequeue();
+        QString result;
+
+        if((m_consecutiveAbortedCalls >= MAX_CONSECUTIVE_ABORTED_CALLS) && (m_cooldownTimer.elapsed() < COOLDOWN_TIME))
+        {//The script is overloaded, skip the call.
+            if(!m_skippedCallWasReported)
+            {
+                result = call.isLog ? "\n" : "<br>";
+                result += m_scriptPath + " has exceeded the block time several times. Calls are skipped for "
+                        + QString::number(COOLDOWN_TIME) + " ms.";
+                m_skippedCallWasReported = true;
+            }
         }
         else
         {
-            type = isFromCan ? 2 : 0;
+            armWatchdog();
+            result = call.isBatch ? callCreateStringBatch(call.chunks, call.isLog) : callCreateString(call.chunks.at(0), call.isLog);
+
+            if(disarmWatchdog())
+            {
+                result = call.isLog ? "\n" : "<br>";
+                result += m_scriptPath + " has exceeded the block time (" + QString::number(m_blockTime) + " ms). The call has been aborted.";
+            }
         }
+
+        emit scriptFunctionFinishedSignal(call.sequence, result);
     }
 
+    m_isExecuting = false;
+}
+
+/**
+ * Executes the script function 'createString'.
+ * @param chunk
+ *      The data, time stamp and type argument for the 'createString' function.
+ * @param isLog
+ *      The isLog argument for the 'createString' function.
+ * @return
+ *      The created string.
+ */
+QString CustomConsoleLogThread::callCreateString(const CustomConsoleLogChunk& chunk, bool isLog)
+{
+    QString result;
+    QScriptValue scriptArray = m_scriptEngine->newArray(chunk.data.size());
+    for(int i = 0; i < chunk.data.size(); i++)
+    {
+        scriptArray.setProperty(i, QScriptValue(m_scriptEngine, (unsigned char)chunk.data.at(i)));
+    }
+    quint32 type = chunkType(chunk.isSend, chunk.isUserMessage, chunk.isFromCan);
+
     //Call the createString function.
-    QScriptValue val = m_createString->call(QScriptValue(), QScriptValueList() << scriptArray << *timeStamp << type << isLog);
-    *result = val.toVariant().toString();
+    QScriptValue val = m_createString->call(QScriptValue(), QScriptValueList() << scriptArray << chunk.timeStamp << type << isLog);
+    result = val.toVariant().toString();
 
 
     if(m_scriptEngine->hasUncaughtException())
     {
-        QScriptValue exception = m_scriptEngine->uncaughtException();
+        result = createExceptionString(isLog);
+    }
+
+    return result;
+}
 
-        if(isLog)
+/**
+ * Executes the script function 'createStringBatch'.
+ * The function is called with an array of chunks (each chunk is an object with the properties
+ * data, timeStamp and type (see createString)) and isLog. It returns an array of strings (one for each chunk)
+ * or one string.
+ * @param chunks
+ *      The chunks.
+ * @param isLog
+ *      The isLog argument for the 'createStringBatch' function.
+ * @return
+ *      The created string.
+ */
+QString CustomConsoleLogThread::callCreateStringBatch(const QVector<CustomConsoleLogChunk>& chunks, bool isLog)
+{
+    QString result;
+    QScriptValue scriptChunks = m_scriptEngine->newArray(chunks.size());
+    QScriptString dataHandle = m_scriptEngine->toStringHandle("data");
+    QScriptString timeStampHandle = m_scriptEngine->toStringHandle("timeStamp");
+    QScriptString typeHandle = m_scriptEngine->toStringHandle("type");
+
+    for(int i = 0; i < chunks.size(); i++)
+    {
+        const CustomConsoleLogChunk& chunk = chunks.at(i);
+        QScriptValue scriptArray = m_scriptEngine->newArray(chunk.data.size());
+        for(int j = 0; j < chunk.data.size(); j++)
         {
-            *result = "\n";
+            scriptArray.setProperty(j, QScriptValue(m_scriptEngine, (unsigned char)chunk.data.at(j)));
         }
-        else
+
+        QScriptValue scriptChunk = m_scriptEngine->newObject();
+        scriptChunk.setProperty(dataHandle, scriptArray);
+        scriptChunk.setProperty(timeStampHandle, chunk.timeStamp);
+        scriptChunk.setProperty(typeHandle, chunkType(chunk.isSend, chunk.isUserMessage, chunk.isFromCan));
+        scriptChunks.setProperty(i, scriptChunk);
+    }
+
+    //Call the createStringBatch function.
+    QScriptValue val = m_createStringBatch->call(QScriptValue(), QScriptValueList() << scriptChunks << isLog);
+
+    if(m_scriptEngine->hasUncaughtException())
+    {
+        result = createExceptionString(isLog);
+    }
+    else if(val.isArray())
+    {
+        quint32 length = val.property("length").toUInt32();
+        for(quint32 i = 0; i < length; i++)
         {
-            *result = "<br>";
+            result += val.property(i).toString();
         }
-        if(exception.toString().contains("[undefined] is not a function"))
+    }
+    else
+    {
+        result = val.toVariant().toString();
+    }
+
+    return result;
+}
+
+/**
+ * Starts the watchdog for one call (the budget of a call is m_blockTime).
+ */
+void CustomConsoleLogThread::armWatchdog(void)
+{
+    m_callWasAborted = false;
+
+    if(m_watchdogTimer)
+    {
+        m_watchdogTimer->start(m_blockTime);
+    }
+}
+
+/**
+ * Stops the watchdog and updates the budget accounting.
+ * After an aborted call the script engine is re-armed (the same engine is used for the next call).
+ * @return
+ *      True if the call has been aborted.
+ */
+bool CustomConsoleLogThread::disarmWatchdog(void)
+{
+    bool wasAborted = m_callWasAborted;
+
+    if(m_watchdogTimer)
+    {
+        m_watchdogTimer->stop();
+    }
+
+    if(wasAborted)
+    {
+        m_abortedCalls.fetchAndAddRelaxed(1);
+        m_consecutiveAbortedCalls++;
+
+        if(m_consecutiveAbortedCalls >= MAX_CONSECUTIVE_ABORTED_CALLS)
+        {
+            m_cooldownTimer.start();
+            m_skippedCallWasReported = false;
+        }
+
+        //Re-arm the script engine.
+        m_scriptEngine->clearExceptions();
+        m_callWasAborted = false;
+    }
+    else
+    {
+        m_consecutiveAbortedCalls = 0;
+    }
+
+    return wasAborted;
+}
+
+/**
+ * Is called if the current call has exceeded its time budget (aborts the call).
+ * Note: This slot is called while the script engine processes events (see WATCHDOG_PROCESS_EVENTS_INTERVAL).
+ */
+void CustomConsoleLogThread::watchdogTimeoutSlot(void)
+{
+    if(m_scriptEngine && m_scriptEngine->isEvaluating())
+    {
+        m_callWasAborted = true;
+        m_scriptEngine->abortEvaluation();
+    }
+}
+
+/**
+ * Returns the type argument (for 'createString' and 'createStringBatch') of a chunk.
+ * @param isSend
+ *      True if the data has been sent.
+ * @param isUserMessage
+ *      True if the data is a user message.
+ * @param isFromCan
+ *      True if the data is from CAN.
+ * @return
+ *      The type.
+ */
+quint32 CustomConsoleLogThread::chunkType(bool isSend, bool isUserMessage, bool isFromCan)
+{
+    quint32 type;
+    if(isUserMessage)
+    {
+        type = 4;
+    }
+    else
+    {
+        if (isSend)
         {
-            *result += QString::fromLatin1("Exception in line %0: %1")
-                    .arg(exception.property("lineNumber").toInt32())
-                    .arg(exception.toString() + QString((isLog) ? "\n" : "<br>") +
-                    "Note: All functions and properties of an object can be"
-                    " determined with cust.getAllObjectPropertiesAndFunctions.");
+            type = isFromCan ? 3 : 1;
         }
         else
         {
-            *result += QString::fromLatin1("Exception in line %0: %1")
-                    .arg(exception.property("lineNumber").toInt32())
-                    .arg(exception.toString());
+            type = isFromCan ? 2 : 0;
         }
     }
-    m_consoleLogObject->m_scriptFunctionIsFinished = true;
+    return type;
 }
 
 /**
- * Calls the script function 'createString' in the script thread.
+ * Creates the result string for an uncaught exception.
+ * @param isLog
+ *      True if the string is for the custom log (false=custom console).
+ * @return
+ *      The created string.
+ */
+QString CustomConsoleLogThread::createExceptionString(bool isLog)
+{
+    QScriptValue exception = m_scriptEngine->uncaughtException();
+    QString result = isLog ? "\n" : "<br>";
+
+    if(exception.toString().contains("[undefined] is not a function"))
+    {
+        result += QString::fromLatin1("Exception in line %0: %1")
+                .arg(exception.property("lineNumber").toInt32())
+                .arg(exception.toString() + QString((isLog) ? "\n" : "<br>") +
+                "Note: All functions and properties of an object can be"
+                " determined with cust.getAllObjectPropertiesAndFunctions.");
+    }
+    else
+    {
+        result += QString::fromLatin1("Exception in line %0: %1")
+                .arg(exception.property("lineNumber").toInt32())
+                .arg(exception.toString());
+    }
+    return result;
+}
+
+/**
+ * Queues a call of the script function 'createString' in the script thread.
+ * The main thread does not wait for the result, the result is emitted (in call order)
+ * with scriptResultSignal. If the script is slower than the incoming data, the calls
+ * are queued (see getLagMs) and if more than MAX_PENDING_CALLS calls are queued further calls
+ * are discarded.
  * @param data
  *      The data argument.
  * @param timeStamp
@@ -432,56 +744,254 @@ void CustomConsoleLogThread::executeScriptSlot(QByteArray* data, QString* timeSt
  *      True if the data is from CAN.
  * @param isLog
  *      True if this call is for the custom log (false=custom console).
- * @return
- *      The created string (result from the 'createString' call.
- *      If the call fails then a error message will be returned.
  */
-QString CustomConsoleLogObject::callScriptFunction(QByteArray* data, QString& timeStamp,
+void CustomConsoleLogObject::queueScriptFunctionCall(const QByteArray& data, const QString& timeStamp,
                                   bool isSend, bool isUserMessage, bool isFromCan, bool isLog)
 {
-    QString result;
+    if(m_scriptIsBlocked)
+    {
+        emit scriptResultSignal(createBlockedString(isLog), isLog);
+        return;
+    }
 
-    if(!m_script->getRunsInDebugger())
+    if(getPendingCalls() >= MAX_PENDING_CALLS)
+    {//The script is too slow.
+        m_discardedCalls++;
+        return;
+    }
+
+    if(m_useBatch)
     {
-        if(!m_scriptIsBlocked)
+        if(!m_batchChunks.isEmpty() && (m_batchIsLog != isLog))
         {
+            flushBatch();
+        }
 
-            m_scriptFunctionIsFinished = false;
-            QDateTime callTime = QDateTime::currentDateTime();
-
-            emit executeScriptSignal(data, &timeStamp, isSend, isUserMessage, isFromCan, isLog, &result);
-            while(!m_scriptFunctionIsFinished)
-            {
-                QThread::usleep(1);
-
-                if(callTime.msecsTo(QDateTime::currentDateTime()) > m_script->m_blockTime)
-                {//Thread is blocked.
-                    m_scriptIsBlocked = true;
-                    terminateThread();
-                    createThread(false);
-                    break;
-                }
-            }
+        if(m_batchChunks.isEmpty())
+        {
+            m_batchQueueTimeMs = m_elapsedTimer.elapsed();
+            m_batchIsLog = isLog;
         }
 
-        if(m_scriptIsBlocked)
+        CustomConsoleLogChunk chunk;
+        chunk.data = data;
+        chunk.timeStamp = timeStamp;
+        chunk.isSend = isSend;
+        chunk.isUserMessage = isUserMessage;
+        chunk.isFromCan = isFromCan;
+        m_batchChunks.append(chunk);
+
+        if((quint32)m_batchChunks.size() >= MAX_BATCH_CHUNKS)
         {
-            if(isLog)
-            {
-                result = "\n";
-            }
-            else
-            {
-                result = "<br>";
-            }
-            result += m_scriptPath + " is blocked. The script has to be reloaded (uncheck and the check the correspondig check box)";
+            flushBatch();
         }
+        return;
+    }
+
+    CustomConsoleLogPendingCall call = addPendingCall(m_elapsedTimer.elapsed(), 1, isLog);
+
+    if(!m_script->getRunsInDebugger())
+    {
+        emit executeScriptSignal(call.sequence, data, timeStamp, isSend, isUserMessage, isFromCan, isLog);
     }
     else
     {
-        m_script->executeScriptSlot(data, &timeStamp, isSend, isUserMessage, isFromCan, isLog, &result);
+        m_script->executeScriptSlot(call.sequence, data, timeStamp, isSend, isUserMessage, isFromCan, isLog);
+    }
+}
+
+/**
+ * Passes all collected chunks to the script function 'createStringBatch'.
+ * This function is called once per console/log update (and if MAX_BATCH_CHUNKS chunks have
+ * been collected), therefore the thread handoff is paid once per update and not once per chunk.
+ */
+void CustomConsoleLogObject::flushBatch(void)
+{
+    if(m_batchChunks.isEmpty() || !m_script)
+    {
+        return;
+    }
+
+    QVector<CustomConsoleLogChunk> chunks;
+    chunks.swap(m_batchChunks);
+
+    CustomConsoleLogPendingCall call = addPendingCall(m_batchQueueTimeMs, chunks.size(), m_batchIsLog);
+
+    if(!m_script->getRunsInDebugger())
+    {
+        emit executeBatchScriptSignal(call.sequence, chunks, call.isLog);
+    }
+    else
+    {
+        m_script->executeBatchScriptSlot(call.sequence, chunks, call.isLog);
+    }
+}
+
+/**
+ * Adds a call to m_pendingCalls.
+ * @param queueTimeMs
+ *      The time at which the (first) chunk has been queued.
+ * @param numberOfChunks
+ *      The number of chunks in the call.
+ * @param isLog
+ *      True if the call is for the custom log (false=custom console).
+ * @return
+ *      The added call.
+ */
+CustomConsoleLogPendingCall CustomConsoleLogObject::addPendingCall(qint64 queueTimeMs, quint32 numberOfChunks, bool isLog)
+{
+    CustomConsoleLogPendingCall call;
+    call.sequence = m_nextSequence++;
+    call.queueTimeMs = queueTimeMs;
+    call.sendTimeMs = m_elapsedTimer.elapsed();
+    call.numberOfChunks = numberOfChunks;
+    call.isLog = isLog;
+    m_pendingCalls.enqueue(call);
+    m_pendingChunks += numberOfChunks;
+
+    if(m_pendingChunks > m_maxPendingCalls)
+    {
+        m_maxPendingCalls = m_pendingChunks;
     }
 
+    if(!m_script->getRunsInDebugger() && !m_blockCheckTimer.isActive())
+    {
+        m_blockCheckTimer.start(BLOCK_CHECK_INTERVAL);
+    }
+
+    return call;
+}
+
+/**
+ * Is called if the script thread has executed the script function 'createString'.
+ * @param sequence
+ *      The sequence number of the call.
+ * @param result
+ *      The result of the call.
+ */
+void CustomConsoleLogObject::scriptFunctionFinishedSlot(quint64 sequence, QString result)
+{
+    if(m_pendingCalls.isEmpty() || (m_pendingCalls.head().sequence != sequence))
+    {//Result of an unloaded script.
+        return;
+    }
+
+    CustomConsoleLogPendingCall call = m_pendingCalls.dequeue();
+    m_pendingChunks -= call.numberOfChunks;
+    m_lastFinishedTimeMs = m_elapsedTimer.elapsed();
+
+    if(m_pendingCalls.isEmpty())
+    {
+        m_blockCheckTimer.stop();
+    }
+
+    emit scriptResultSignal(result, call.isLog);
+}
+
+/**
+ * Slot function for m_blockCheckTimer (checks if the script thread is blocked).
+ */
+void CustomConsoleLogObject::blockCheckTimerSlot(void)
+{
+    if(m_pendingCalls.isEmpty() || !m_script)
+    {
+        m_blockCheckTimer.stop();
+        return;
+    }
+
+    //The current call has been started after the previous call has been finished
+    //(or after it has been queued).
+    qint64 callStartMs = qMax(m_lastFinishedTimeMs, m_pendingCalls.head().sendTimeMs);
+
+    if((m_elapsedTimer.elapsed() - callStartMs) > (m_script->m_blockTime + WATCHDOG_GRACE_TIME))
+    {//The watchdog could not abort the call (the script thread is blocked), terminate the thread.
+        bool isLog = m_pendingCalls.head().isLog;
+
+        m_discardedCalls += m_pendingChunks - m_pendingCalls.head().numberOfChunks + m_batchChunks.size();
+        m_pendingCalls.clear();
+        m_pendingChunks = 0;
+        m_batchChunks.clear();
+        m_blockCheckTimer.stop();
+
+        m_scriptIsBlocked = true;
+        terminateThread();
+        createThread(false);
+
+        emit scriptResultSignal(createBlockedString(isLog), isLog);
+    }
+}
+
+/**
+ * Clears all queued calls and the lag statistics.
+ */
+void CustomConsoleLogObject::clearPendingCalls(void)
+{
+    m_blockCheckTimer.stop();
+    m_pendingCalls.clear();
+    m_pendingChunks = 0;
+    m_batchChunks.clear();
+    m_maxPendingCalls = 0;
+    m_discardedCalls = 0;
+}
+
+/**
+ * Returns the age (ms) of the oldest queued call (the lag of the script).
+ */
+qint64 CustomConsoleLogObject::getLagMs(void)
+{
+    qint64 lag = 0;
+
+    if(!m_pendingCalls.isEmpty())
+    {
+        lag = m_elapsedTimer.elapsed() - m_pendingCalls.head().queueTimeMs;
+    }
+    else if(!m_batchChunks.isEmpty())
+    {
+        lag = m_elapsedTimer.elapsed() - m_batchQueueTimeMs;
+    }
+
+    return lag;
+}
+
+/**
+ * Returns a description of the current lag (an empty string if the script has no lag).
+ */
+QString CustomConsoleLogObject::lagToString(void)
+{
+    QString result;
+
+    quint32 abortedCalls = m_script ? m_script->getAbortedCallCount() : 0;
+
+    if((m_pendingChunks != 0) || (m_discardedCalls != 0) || (abortedCalls != 0))
+    {
+        result = QString("%1 pending (lag %2 ms, max. %3 pending)").arg(getPendingCalls())
+                .arg(getLagMs()).arg(m_maxPendingCalls);
+
+        if(m_discardedCalls != 0)
+        {
+            result += QString(", %1 discarded").arg(m_discardedCalls);
+        }
+
+        if(abortedCalls != 0)
+        {
+            result += QString(", %1 aborted").arg(abortedCalls);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Creates the result string for a blocked script.
+ * @param isLog
+ *      True if the string is for the custom log (false=custom console).
+ * @return
+ *      The created string.
+ */
+QString CustomConsoleLogObject::createBlockedString(bool isLog)
+{
+    QString result = isLog ? "\n" : "<br>";
+    result += m_scriptPath + " is blocked. The script has to be reloaded (uncheck and the check the correspondig check box)";
     return result;
 }
 
@@ -30,6 +30,11 @@
 #include <QFileInfo>
 #include <QScriptEngine>
 #include <QVector>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
 #include <mainwindow.h>
 #include "scriptsqldatabase.h"
 #include "scriptFile.h"
@@ -41,6 +46,61 @@
 class MainWindow;
 class CustomConsoleLogObject;
 
+///A queued (not yet finished) call of the script function 'createString' or 'createStringBatch'.
+typedef struct
+{
+    ///The sequence number of the call.
+    quint64 sequence;
+
+    ///The time at which the (first) chunk has been queued (ms, see CustomConsoleLogObject::m_elapsedTimer).
+    qint64 queueTimeMs;
+
+    ///The time at which the call has been sent to the script thread (ms).
+    qint64 sendTimeMs;
+
+    ///The number of chunks in this call.
+    quint32 numberOfChunks;
+
+    ///True if the call is for the custom log (false=custom console).
+    bool isLog;
+}CustomConsoleLogPendingCall;
+
+///One chunk of a 'createStringBatch' call.
+typedef struct
+{
+    ///The data.
+    QByteArray data;
+
+    ///The time stamp.
+    QString timeStamp;
+
+    ///True if the data has been sent.
+    bool isSend;
+
+    ///True if the data is a user message.
+    bool isUserMessage;
+
+    ///True if the data is from CAN.
+    bool isFromCan;
+}CustomConsoleLogChunk;
+Q_DECLARE_METATYPE(CustomConsoleLogChunk)
+
+///A call which is executed in the custom console/log script thread.
+typedef struct
+{
+    ///The sequence number of the call.
+    quint64 sequence;
+
+    ///The chunks of the call (one chunk for 'createString').
+    QVector<CustomConsoleLogChunk> chunks;
+
+    ///True if the call is for the custom log (false=custom console).
+    bool isLog;
+
+    ///True if 'createStringBatch' shall be called.
+    bool isBatch;
+}CustomConsoleLogScriptCall;
+
 ///Thrread which executes the custom console/log script.
 class CustomConsoleLogThread : public QThread
 {
@@ -49,10 +109,11 @@ class CustomConsoleLogThread : public QThread
 
 public:
     CustomConsoleLogThread(CustomConsoleLogObject* consoleLogObject, MainWindow* mainWindow,
-                           QString scriptPath, bool runsInDebugger) : QThread(0), m_createString(0),
+                           QString scriptPath, bool runsInDebugger) : QThread(0), m_createString(0), m_createStringBatch(0), m_hasBatchFunction(false),
     m_consoleLogObject(consoleLogObject), m_scriptEngine(0), m_scriptSql(0), m_scriptPath(scriptPath),
     m_blockTime(DEFAULT_BLOCK_TIME), m_scriptFileObject(0), m_mainWindow(mainWindow), m_runsInDebugger(runsInDebugger),
-    m_debugger(0), m_debugWindow(0)
+    m_debugger(0), m_debugWindow(0), m_watchdogTimer(0), m_callWasAborted(false), m_isExecuting(false),
+    m_scriptCalls(), m_abortedCalls(0), m_consecutiveAbortedCalls(0), m_cooldownTimer(), m_skippedCallWasReported(false)
     {
 
     }
@@ -67,6 +128,7 @@ public:
             }
 
             delete m_createString;
+            delete m_createStringBatch;
         }
         catch(...)
         {
@@ -163,11 +225,14 @@ public:
     ///Returns the current version of ScriptCommunicator.
     Q_INVOKABLE QString getCurrentVersion(void){return MainWindow::VERSION;}
 
-    ///Sets the script block time.
-    ///Note: After this execution time (createString and the script main function (all outside a function))
-    ///the script is regarded as blocked and will be terminated.
+    ///Sets the script block time (the time budget of one call).
+    ///Note: If createString (or the script main function (all outside a function)) exceeds this execution time,
+    ///the call is aborted.
     Q_INVOKABLE void setBlockTime(quint32 blockTime){m_blockTime = blockTime;}
 
+    ///Returns the number of aborted calls (calls which have exceeded the block time).
+    Q_INVOKABLE quint32 getAbortedCallCount(void){return m_abortedCalls.load();}
+
     ///Creates a XML reader.
     Q_INVOKABLE QScriptValue createXmlReader();
 
@@ -180,6 +245,16 @@ public:
     ///The default value for m_blockTime.
     static const quint32 DEFAULT_BLOCK_TIME= 10000;
 
+    ///The interval in which the script engine processes events while a script is executed (the watchdog
+    ///can only abort a call while the script engine processes events).
+    static const int WATCHDOG_PROCESS_EVENTS_INTERVAL = 50;
+
+    ///The number of consecutive aborted calls after which calls are skipped for COOLDOWN_TIME ms.
+    static const quint32 MAX_CONSECUTIVE_ABORTED_CALLS = 3;
+
+    ///The time (ms) in which calls are skipped after MAX_CONSECUTIVE_ABORTED_CALLS consecutive aborted calls.
+    static const qint64 COOLDOWN_TIME = 1000;
+
     ///Sets the script file path.
     void setScriptPath(QString scriptPath)
     {
@@ -187,6 +262,9 @@ public:
         m_scriptFileObject->setScriptFileName(m_scriptPath);
     }
 
+    ///Returns true if the script contains the function 'createStringBatch'.
+    bool hasBatchFunction(void){return m_hasBatchFunction;}
+
     ///Returns m_runsInDebugger.
     bool getRunsInDebugger(void){return m_runsInDebugger;}
 
@@ -214,11 +292,18 @@ signals:
     ///The main interface thread emits this signal to show a QMessageBox dialog in the main window.
     void showMessageBoxSignal(QMessageBox::Icon icon, QString title, QString text, QMessageBox::StandardButtons buttons);
 
+    ///Is emitted if the script function 'createString' has been executed.
+    ///This signal must not be used from script.
+    void scriptFunctionFinishedSignal(quint64 sequence, QString result);
+
 public slots:
 
-     ///Executes the script function 'createString'.
-    void executeScriptSlot(QByteArray* data, QString* timeStamp,
-                       bool isSend, bool isUserMessage, bool isFromCan, bool isLog, QString* result);
+     ///Executes the script function 'createString' (the result is emitted with scriptFunctionFinishedSignal).
+    void executeScriptSlot(quint64 sequence, QByteArray data, QString timeStamp,
+                       bool isSend, bool isUserMessage, bool isFromCan, bool isLog);
+
+     ///Executes the script function 'createStringBatch' (the result is emitted with scriptFunctionFinishedSignal).
+    void executeBatchScriptSlot(quint64 sequence, QVector<CustomConsoleLogChunk> chunks, bool isLog);
 
     ///Loads a custom console/log script.
     void loadCustomScriptSlot(QString scriptPath, bool* hasSucceeded);
@@ -234,25 +319,66 @@ public slots:
             m_debugWindow->activateWindow(); // for Windows
         }
     }
+private slots:
+
+    ///Is called if the current call has exceeded its time budget (aborts the call).
+    void watchdogTimeoutSlot(void);
+
 protected:
     ///The thread main function.
     void run()
     {
         m_createString = new QScriptValue(0);
+        m_createStringBatch = new QScriptValue(0);
         m_scriptSql = new ScriptSql();
         m_scriptFileObject = new ScriptFile(this, m_scriptPath);
         m_scriptFileObject->intSignals(m_mainWindow->getScriptWindow(), m_runsInDebugger);
 
         if(!m_runsInDebugger)
         {
+            m_watchdogTimer = new QTimer();
+            m_watchdogTimer->setSingleShot(true);
+            connect(m_watchdogTimer, SIGNAL(timeout()), this, SLOT(watchdogTimeoutSlot()), Qt::DirectConnection);
+
             exec();
+
+            delete m_watchdogTimer;
+            m_watchdogTimer = 0;
         }
     }
 
 private:
+
+    ///Executes all queued calls (m_scriptCalls).
+    void executeScriptCalls(void);
+
+    ///Executes the script function 'createString'.
+    QString callCreateString(const CustomConsoleLogChunk& chunk, bool isLog);
+
+    ///Executes the script function 'createStringBatch'.
+    QString callCreateStringBatch(const QVector<CustomConsoleLogChunk>& chunks, bool isLog);
+
+    ///Starts the watchdog for one call.
+    void armWatchdog(void);
+
+    ///Stops the watchdog and updates the budget accounting. Returns true if the call has been aborted.
+    bool disarmWatchdog(void);
+
+    ///Returns the type argument (for 'createString' and 'createStringBatch') of a chunk.
+    static quint32 chunkType(bool isSend, bool isUserMessage, bool isFromCan);
+
+    ///Creates the result string for an uncaught exception.
+    QString createExceptionString(bool isLog);
+
     ///The create string script function.
     QScriptValue* m_createString;
 
+    ///The create string batch script function.
+    QScriptValue* m_createStringBatch;
+
+    ///True if the script contains the function 'createStringBatch'.
+    bool m_hasBatchFunction;
+
     ///The custum console/log object.
     CustomConsoleLogObject* m_consoleLogObject;
 
@@ -283,6 +409,31 @@ private:
     ///The debug window.
     QMainWindow *m_debugWindow;
 
+    ///The watchdog timer (aborts calls which exceed m_blockTime).
+    QTimer* m_watchdogTimer;
+
+    ///True if the current call has been aborted by the watchdog.
+    bool m_callWasAborted;
+
+    ///True while a call is executed (the script engine processes events during a call, therefore
+    ///executeScriptSlot and executeBatchScriptSlot can be called recursively).
+    bool m_isExecuting;
+
+    ///The queued calls.
+    QQueue<CustomConsoleLogScriptCall> m_scriptCalls;
+
+    ///The number of aborted calls.
+    QAtomicInt m_abortedCalls;
+
+    ///The number of consecutive aborted calls.
+    quint32 m_consecutiveAbortedCalls;
+
+    ///Is started if MAX_CONSECUTIVE_ABORTED_CALLS consecutive calls have been aborted.
+    QElapsedTimer m_cooldownTimer;
+
+    ///True if the first skipped call of the current cooldown has been reported.
+    bool m_skippedCallWasReported;
+
 };
 
 ///Custom console and log object (the corresponding scripts are executed here).
@@ -302,8 +453,42 @@ public:
     ///Unloads the current script.
     void unloadCustomScript(void);
 
-    ///Calls the script function 'createString' in the script thread.
-    QString callScriptFunction(QByteArray *data, QString& timeStamp, bool isSend, bool isUserMessage, bool isFromCan, bool isLog);
+    ///Queues a call of the script function 'createString' in the script thread.
+    ///If the script contains the function 'createStringBatch', the chunk is collected and
+    ///all collected chunks are passed in one call (see flushBatch).
+    ///The results are emitted (in call order) with scriptResultSignal.
+    void queueScriptFunctionCall(const QByteArray& data, const QString& timeStamp, bool isSend, bool isUserMessage, bool isFromCan, bool isLog);
+
+    ///Passes all collected chunks to the script function 'createStringBatch'.
+    void flushBatch(void);
+
+    ///Returns the number of queued (not yet finished) chunks.
+    quint32 getPendingCalls(void){return m_pendingChunks + m_batchChunks.size();}
+
+    ///Returns the max. number of queued chunks (since the script has been loaded).
+    quint32 getMaxPendingCalls(void){return m_maxPendingCalls;}
+
+    ///Returns the number of discarded chunks (since the script has been loaded).
+    quint64 getDiscardedCalls(void){return m_discardedCalls;}
+
+    ///Returns the age (ms) of the oldest queued chunk (the lag of the script).
+    qint64 getLagMs(void);
+
+    ///Returns a description of the current lag (an empty string if the script has no lag).
+    QString lagToString(void);
+
+    ///The max. number of queued chunks (further chunks are discarded).
+    static const quint32 MAX_PENDING_CALLS = 10000;
+
+    ///The max. number of chunks in one 'createStringBatch' call.
+    static const quint32 MAX_BATCH_CHUNKS = 1000;
+
+    ///The interval of m_blockCheckTimer.
+    static const quint32 BLOCK_CHECK_INTERVAL = 100;
+
+    ///The time (ms, in addition to the block time) after which the script thread is terminated if the
+    ///watchdog could not abort a call (e.g. the script is blocked in a native function).
+    static const quint32 WATCHDOG_GRACE_TIME = 5000;
 
     ///Returns true if a script has been loaded successfully.
     bool scriptHasBeenLoaded();
@@ -325,15 +510,38 @@ public:
 signals:
 
     ///Signal for executing the script function 'createString'.
-    void executeScriptSignal(QByteArray* data, QString* timeStamp,
-                           bool isSend, bool isUserMessage, bool isFromCan, bool isLog,
-                           QString* result);
+    void executeScriptSignal(quint64 sequence, QByteArray data, QString timeStamp,
+                           bool isSend, bool isUserMessage, bool isFromCan, bool isLog);
+
+    ///Signal for executing the script function 'createStringBatch'.
+    void executeBatchScriptSignal(quint64 sequence, QVector<CustomConsoleLogChunk> chunks, bool isLog);
 
     ///Signal for loading a custom console/log script.
     void loadCustomScriptSignal(QString scriptPath, bool* hasSucceeded);
 
+    ///Is emitted if a queued call of the script function 'createString' has been finished
+    ///(the results are emitted in call order).
+    void scriptResultSignal(QString result, bool isLog);
+
+private slots:
+
+    ///Is called if the script thread has executed the script function 'createString'.
+    void scriptFunctionFinishedSlot(quint64 sequence, QString result);
+
+    ///Slot function for m_blockCheckTimer (checks if the script thread is blocked).
+    void blockCheckTimerSlot(void);
+
 private:
 
+    ///Clears all queued calls and the lag statistics.
+    void clearPendingCalls(void);
+
+    ///Adds a call to m_pendingCalls.
+    CustomConsoleLogPendingCall addPendingCall(qint64 queueTimeMs, quint32 numberOfChunks, bool isLog);
+
+    ///Creates the result string for a blocked script.
+    QString createBlockedString(bool isLog);
+
     ///Creates the script thread.
     void createThread(bool debug);
 
@@ -349,11 +557,53 @@ private:
     ///The script which executed the create string function.
     CustomConsoleLogThread* m_script;
 
-    ///True if the script function is finished.
-    bool m_scriptFunctionIsFinished;
+    ///1 if the script function loadCustomScriptSlot is finished (is protected by m_scriptFunctionMutex).
+    QAtomicInt m_scriptFunctionIsFinished;
+
+    ///Protects m_scriptFunctionIsFinished (for m_scriptFunctionFinishedCondition).
+    QMutex m_scriptFunctionMutex;
+
+    ///Is signaled by the script thread if loadCustomScriptSlot is finished.
+    QWaitCondition m_scriptFunctionFinishedCondition;
 
     ///True if ScriptCommunicator is blocked.
     bool m_scriptIsBlocked;
+
+    ///The queued (not yet finished) calls.
+    QQueue<CustomConsoleLogPendingCall> m_pendingCalls;
+
+    ///The sequence number of the next call.
+    quint64 m_nextSequence;
+
+    ///The number of chunks in m_pendingCalls.
+    quint32 m_pendingChunks;
+
+    ///The max. number of queued chunks.
+    quint32 m_maxPendingCalls;
+
+    ///The collected chunks for the next 'createStringBatch' call.
+    QVector<CustomConsoleLogChunk> m_batchChunks;
+
+    ///The time at which the first chunk in m_batchChunks has been queued (ms).
+    qint64 m_batchQueueTimeMs;
+
+    ///True if the chunks in m_batchChunks are for the custom log.
+    bool m_batchIsLog;
+
+    ///True if the loaded script contains the function 'createStringBatch'.
+    bool m_useBatch;
+
+    ///The number of discarded calls.
+    quint64 m_discardedCalls;
+
+    ///The time at which the last call has been finished (ms, see m_elapsedTimer).
+    qint64 m_lastFinishedTimeMs;
+
+    ///The time base for the lag calculation.
+    QElapsedTimer m_elapsedTimer;
+
+    ///Checks periodically (while calls are queued) if the script thread is blocked.
+    QTimer m_blockCheckTimer;
 };
 
 #endif // CUSTOMCONSOLELOGOBJECT_H
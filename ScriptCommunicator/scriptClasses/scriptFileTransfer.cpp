@@ -0,0 +1,1110 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptFileTransfer.h"
+#include "mainwindow.h"
+#include <QFileInfo>
+#include <QDir>
+
+/**
+ * Constructor.
+ * @param interfaceThread
+ *      The main interface thread.
+ */
+FileTransferWorker::FileTransferWorker(MainInterfaceThread* interfaceThread) :
+    QObject(0), m_interface(interfaceThread), m_sendId(MainInterfaceThread::getNextSendEngineId()),
+    m_mode(FILE_TRANSFER_MODE_RAW_SEND), m_state(FILE_TRANSFER_STATE_IDLE), m_file(), m_fileName(), m_directory(),
+    m_fileSize(0), m_transferredBytes(0), m_chunkSize(0), m_delayMs(0), m_block(), m_blockDataSize(0), m_blockNumber(0),
+    m_retries(0), m_useCrc(true), m_canCount(0), m_receivedData(), m_pendingData(), m_hasReceivedBlock(false),
+    m_isHeaderExpected(false), m_isEotReceived(false), m_timer(0), m_elapsedTimer(), m_lastProgressTime(0)
+{
+    //The timer is a child of the worker (it is moved with the worker into the main interface thread).
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(timerSlot()));
+
+    //The sending must be queued, else the next chunk would be sent recursively from sendingFinishedSlot.
+    connect(this, SIGNAL(sendDataSignal(QByteArray,uint)), m_interface, SLOT(sendDataSlot(QByteArray,uint)), Qt::QueuedConnection);
+    connect(m_interface, SIGNAL(sendingFinishedSignal(bool,uint)), this, SLOT(sendingFinishedSlot(bool,uint)), Qt::DirectConnection);
+    connect(m_interface, SIGNAL(dataReceivedSignal(QByteArray)), this, SLOT(dataReceivedSlot(QByteArray)), Qt::DirectConnection);
+}
+
+/**
+ * Destructor.
+ */
+FileTransferWorker::~FileTransferWorker()
+{
+    m_file.close();
+}
+
+/**
+ * Calculates the XMODEM CRC (CRC-16/XMODEM, polynomial 0x1021, initial value 0).
+ * @param data
+ *      The data.
+ * @return
+ *      The CRC.
+ */
+quint16 FileTransferWorker::calculateCrc(const QByteArray& data)
+{
+    static quint16 table[256];
+    static bool tableIsInitialized = false;
+
+    if(!tableIsInitialized)
+    {
+        for(int i = 0; i < 256; i++)
+        {
+            quint16 crc = (quint16)(i << 8);
+            for(int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc & 0x8000) ? (quint16)((crc << 1) ^ 0x1021) : (quint16)(crc << 1);
+            }
+            table[i] = crc;
+        }
+        tableIsInitialized = true;
+    }
+
+    quint16 crc = 0;
+    const quint8* bytes = (const quint8*)data.constData();
+    for(int i = 0; i < data.size(); i++)
+    {
+        crc = (quint16)((crc << 8) ^ table[((crc >> 8) ^ bytes[i]) & 0xff]);
+    }
+    return crc;
+}
+
+/**
+ * Starts a transfer.
+ * @param mode
+ *      The mode (FileTransferMode).
+ * @param path
+ *      The file (the directory for FILE_TRANSFER_MODE_YMODEM_RECEIVE).
+ * @param chunkSize
+ *      The raw chunk size (FILE_TRANSFER_MODE_RAW_SEND).
+ * @param delayMs
+ *      The delay between two raw chunks (FILE_TRANSFER_MODE_RAW_SEND).
+ * @param expectedSize
+ *      The expected file size (FILE_TRANSFER_MODE_RAW_RECEIVE, 0=unknown).
+ */
+void FileTransferWorker::startSlot(int mode, QString path, quint32 chunkSize, quint32 delayMs, quint64 expectedSize)
+{
+    if(m_state != FILE_TRANSFER_STATE_IDLE)
+    {
+        emit finishedSignal(false, "a transfer is already running");
+        return;
+    }
+
+    m_mode = (FileTransferMode)mode;
+    m_chunkSize = chunkSize;
+    m_delayMs = delayMs;
+    m_fileSize = 0;
+    m_transferredBytes = 0;
+    m_blockNumber = 0;
+    m_retries = 0;
+    m_useCrc = true;
+    m_canCount = 0;
+    m_receivedData.clear();
+    m_pendingData.clear();
+    m_hasReceivedBlock = false;
+    m_isHeaderExpected = false;
+    m_isEotReceived = false;
+    m_lastProgressTime = 0;
+    m_fileName = QFileInfo(path).fileName();
+    m_elapsedTimer.start();
+
+    if(m_interface->isConnectedWithCan())
+    {
+        emit finishedSignal(false, "file transfers are not supported with CAN interfaces");
+        return;
+    }
+
+    if((m_mode == FILE_TRANSFER_MODE_RAW_SEND) || (m_mode == FILE_TRANSFER_MODE_XMODEM_SEND) ||
+       (m_mode == FILE_TRANSFER_MODE_YMODEM_SEND))
+    {
+        m_file.setFileName(path);
+        if(!m_file.open(QIODevice::ReadOnly))
+        {
+            emit finishedSignal(false, "could not open file: " + path);
+            return;
+        }
+        m_fileSize = m_file.size();
+
+        if(m_mode == FILE_TRANSFER_MODE_RAW_SEND)
+        {
+            sendNextRawChunk();
+        }
+        else
+        {
+            m_state = FILE_TRANSFER_STATE_SEND_WAIT_START;
+            m_timer->start(START_TIMEOUT);
+        }
+    }
+    else if(m_mode == FILE_TRANSFER_MODE_YMODEM_RECEIVE)
+    {
+        m_directory = path;
+        m_fileName = "";
+        if(!QDir(m_directory).exists())
+        {
+            emit finishedSignal(false, "directory does not exist: " + path);
+            return;
+        }
+
+        m_isHeaderExpected = true;
+        m_state = FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK;
+        transmit(QByteArray(1, XMODEM_CRC_START));
+        m_timer->start(RECEIVE_START_INTERVAL);
+    }
+    else
+    {
+        m_file.setFileName(path);
+        if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            emit finishedSignal(false, "could not open file: " + path);
+            return;
+        }
+
+        if(m_mode == FILE_TRANSFER_MODE_RAW_RECEIVE)
+        {
+            m_fileSize = expectedSize;
+            m_state = FILE_TRANSFER_STATE_RAW_RECEIVE;
+        }
+        else
+        {
+            m_blockNumber = 1;
+            m_state = FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK;
+            transmit(QByteArray(1, XMODEM_CRC_START));
+            m_timer->start(RECEIVE_START_INTERVAL);
+        }
+    }
+    emitProgress(true);
+}
+
+/**
+ * Cancels the current transfer (a raw receive is finished successfully).
+ */
+void FileTransferWorker::cancelSlot(void)
+{
+    if(m_state == FILE_TRANSFER_STATE_IDLE)
+    {
+        return;
+    }
+
+    if(m_state == FILE_TRANSFER_STATE_RAW_RECEIVE)
+    {
+        finish(true, "receiving stopped");
+    }
+    else
+    {
+        if((m_mode != FILE_TRANSFER_MODE_RAW_SEND) && (m_mode != FILE_TRANSFER_MODE_RAW_RECEIVE))
+        {
+            sendCancel();
+        }
+        finish(false, "canceled");
+    }
+}
+
+/**
+ * Finishes the current transfer.
+ * @param success
+ *      True if the transfer was successful.
+ * @param message
+ *      The result message.
+ */
+void FileTransferWorker::finish(bool success, QString message)
+{
+    m_timer->stop();
+    m_file.close();
+    m_receivedData.clear();
+    m_pendingData.clear();
+    m_block.clear();
+
+    emitProgress(true);
+    m_state = FILE_TRANSFER_STATE_IDLE;
+    emit finishedSignal(success, message);
+}
+
+/**
+ * Emits progressSignal.
+ * @param force
+ *      If false, then the signal is emitted at most every PROGRESS_INTERVAL ms.
+ */
+void FileTransferWorker::emitProgress(bool force)
+{
+    qint64 elapsed = m_elapsedTimer.elapsed();
+
+    if(force || ((elapsed - m_lastProgressTime) >= PROGRESS_INTERVAL))
+    {
+        m_lastProgressTime = elapsed;
+        double bytesPerSecond = (elapsed > 0) ? ((double)m_transferredBytes * 1000.0) / (double)elapsed : 0.0;
+        emit progressSignal(m_fileName, m_transferredBytes, m_fileSize, bytesPerSecond);
+    }
+}
+
+/**
+ * Sends data with the main interface.
+ * @param data
+ *      The data.
+ */
+void FileTransferWorker::transmit(const QByteArray& data)
+{
+    emit sendDataSignal(data, m_sendId);
+}
+
+/**
+ * Sends the cancel sequence (XMODEM/YMODEM).
+ */
+void FileTransferWorker::sendCancel(void)
+{
+    transmit(QByteArray(3, XMODEM_CAN));
+}
+
+/**
+ * Is called if the main interface has sent data.
+ * @param success
+ *      True on success.
+ * @param id
+ *      The send id.
+ */
+void FileTransferWorker::sendingFinishedSlot(bool success, uint id)
+{
+    if((id != m_sendId) || (m_state == FILE_TRANSFER_STATE_IDLE))
+    {
+        return;
+    }
+
+    if(!success)
+    {
+        finish(false, "send error");
+        return;
+    }
+
+    if(m_state == FILE_TRANSFER_STATE_RAW_SEND_WAIT_FINISHED)
+    {
+        m_transferredBytes += m_blockDataSize;
+        emitProgress(false);
+
+        if(m_delayMs > 0)
+        {
+            m_state = FILE_TRANSFER_STATE_RAW_SEND_DELAY;
+            m_timer->start(m_delayMs);
+        }
+        else
+        {
+            sendNextRawChunk();
+        }
+    }
+}
+
+/**
+ * Reads the next raw chunk and sends it.
+ */
+void FileTransferWorker::sendNextRawChunk(void)
+{
+    if(m_file.atEnd())
+    {
+        finish(true, "file sent");
+        return;
+    }
+
+    QByteArray data = m_file.read(m_chunkSize);
+    if(data.isEmpty())
+    {
+        finish(false, "could not read file: " + m_file.errorString());
+        return;
+    }
+
+    m_blockDataSize = data.size();
+    m_state = FILE_TRANSFER_STATE_RAW_SEND_WAIT_FINISHED;
+    transmit(data);
+}
+
+/**
+ * Is called if m_timer has elapsed (timeout or raw send delay).
+ */
+void FileTransferWorker::timerSlot(void)
+{
+    switch(m_state)
+    {
+    case FILE_TRANSFER_STATE_RAW_SEND_DELAY:
+    {
+        sendNextRawChunk();
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_START:
+    case FILE_TRANSFER_STATE_SEND_WAIT_DATA_START:
+    case FILE_TRANSFER_STATE_SEND_WAIT_END_START:
+    {
+        sendCancel();
+        finish(false, "timeout (the receiver has not started the transfer)");
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_HEADER_ACK:
+    case FILE_TRANSFER_STATE_SEND_WAIT_BLOCK_ACK:
+    case FILE_TRANSFER_STATE_SEND_WAIT_EOT_ACK:
+    case FILE_TRANSFER_STATE_SEND_WAIT_END_ACK:
+    {
+        resendBlock();
+        break;
+    }
+    case FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK:
+    {
+        m_retries++;
+        if(m_retries > MAX_RETRIES)
+        {
+            sendCancel();
+            finish(false, "timeout (no data from the sender)");
+        }
+        else
+        {
+            //Before the first block the start character is repeated, else the current block is requested again.
+            m_receivedData.clear();
+            transmit(QByteArray(1, m_hasReceivedBlock ? (char)XMODEM_NAK : (char)XMODEM_CRC_START));
+            m_timer->start(m_hasReceivedBlock ? BLOCK_TIMEOUT : RECEIVE_START_INTERVAL);
+        }
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+}
+
+/**
+ * Is called if the main interface has received data.
+ * @param data
+ *      The received data.
+ */
+void FileTransferWorker::dataReceivedSlot(QByteArray data)
+{
+    if(m_state == FILE_TRANSFER_STATE_IDLE)
+    {
+        return;
+    }
+
+    if(m_state == FILE_TRANSFER_STATE_RAW_RECEIVE)
+    {
+        if(m_fileSize > 0)
+        {
+            quint64 remaining = m_fileSize - m_transferredBytes;
+            if((quint64)data.size() > remaining)
+            {
+                data.truncate((int)remaining);
+            }
+        }
+
+        if(writeToFile(data))
+        {
+            emitProgress(false);
+            if((m_fileSize > 0) && (m_transferredBytes >= m_fileSize))
+            {
+                finish(true, "file received");
+            }
+        }
+    }
+    else if(m_state == FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK)
+    {
+        m_receivedData.append(data);
+        processReceivedBlocks();
+    }
+    else
+    {
+        const quint8* bytes = (const quint8*)data.constData();
+        for(int i = 0; (i < data.size()) && (m_state != FILE_TRANSFER_STATE_IDLE); i++)
+        {
+            processSenderByte(bytes[i]);
+        }
+    }
+}
+
+/**
+ * Writes received data to the file.
+ * @param data
+ *      The data.
+ * @return
+ *      False on error (the transfer is finished).
+ */
+bool FileTransferWorker::writeToFile(const QByteArray& data)
+{
+    if(m_file.write(data) != data.size())
+    {
+        if((m_mode != FILE_TRANSFER_MODE_RAW_SEND) && (m_mode != FILE_TRANSFER_MODE_RAW_RECEIVE))
+        {
+            sendCancel();
+        }
+        finish(false, "could not write file: " + m_file.errorString());
+        return false;
+    }
+    m_transferredBytes += data.size();
+    return true;
+}
+
+/**
+ * Creates a XMODEM block.
+ * @param number
+ *      The block number.
+ * @param data
+ *      The block data (max. blockSize bytes).
+ * @param blockSize
+ *      The block size (XMODEM_BLOCK_SIZE or XMODEM_1K_BLOCK_SIZE).
+ * @param padding
+ *      The padding character.
+ * @return
+ *      The block.
+ */
+QByteArray FileTransferWorker::createBlock(quint8 number, const QByteArray& data, int blockSize, char padding)
+{
+    QByteArray blockData = data;
+    blockData.append(QByteArray(blockSize - data.size(), padding));
+
+    QByteArray block;
+    block.reserve(blockSize + 5);
+    block.append((blockSize == XMODEM_1K_BLOCK_SIZE) ? (char)XMODEM_STX : (char)XMODEM_SOH);
+    block.append((char)number);
+    block.append((char)(255 - number));
+    block.append(blockData);
+
+    if(m_useCrc)
+    {
+        quint16 crc = calculateCrc(blockData);
+        block.append((char)(crc >> 8));
+        block.append((char)(crc & 0xff));
+    }
+    else
+    {
+        quint8 checksum = 0;
+        for(auto el : blockData)
+        {
+            checksum += (quint8)el;
+        }
+        block.append((char)checksum);
+    }
+    return block;
+}
+
+/**
+ * Sends the YMODEM header block (block 0: file name and size).
+ */
+void FileTransferWorker::sendHeaderBlock(void)
+{
+    QByteArray data = m_fileName.toUtf8();
+    data.append('\0');
+    data.append(QByteArray::number(m_fileSize));
+
+    int blockSize = (data.size() <= XMODEM_BLOCK_SIZE) ? XMODEM_BLOCK_SIZE : XMODEM_1K_BLOCK_SIZE;
+    m_block = createBlock(0, data.left(XMODEM_1K_BLOCK_SIZE), blockSize, 0);
+    m_blockDataSize = 0;
+    m_retries = 0;
+    m_state = FILE_TRANSFER_STATE_SEND_WAIT_HEADER_ACK;
+    transmit(m_block);
+    m_timer->start(BLOCK_TIMEOUT);
+}
+
+/**
+ * Reads the next data block and sends it (sends the EOT at the end of the file).
+ */
+void FileTransferWorker::sendNextBlock(void)
+{
+    m_retries = 0;
+
+    if(m_file.atEnd())
+    {
+        m_block = QByteArray(1, XMODEM_EOT);
+        m_blockDataSize = 0;
+        m_state = FILE_TRANSFER_STATE_SEND_WAIT_EOT_ACK;
+    }
+    else
+    {
+        //Small rests are sent in a 128 byte block (less padding).
+        quint64 remaining = m_fileSize - m_file.pos();
+        int blockSize = (m_useCrc && (remaining > (quint64)XMODEM_BLOCK_SIZE)) ? XMODEM_1K_BLOCK_SIZE : XMODEM_BLOCK_SIZE;
+
+        QByteArray data = m_file.read(blockSize);
+        if(data.isEmpty())
+        {
+            sendCancel();
+            finish(false, "could not read file: " + m_file.errorString());
+            return;
+        }
+
+        m_blockNumber++;
+        m_block = createBlock(m_blockNumber, data, blockSize, XMODEM_PADDING);
+        m_blockDataSize = data.size();
+        m_state = FILE_TRANSFER_STATE_SEND_WAIT_BLOCK_ACK;
+    }
+
+    transmit(m_block);
+    m_timer->start(BLOCK_TIMEOUT);
+}
+
+/**
+ * Retransmits the current block.
+ */
+void FileTransferWorker::resendBlock(void)
+{
+    m_retries++;
+    if(m_retries > MAX_RETRIES)
+    {
+        sendCancel();
+        finish(false, "too many retries");
+        return;
+    }
+
+    transmit(m_block);
+    m_timer->start(BLOCK_TIMEOUT);
+}
+
+/**
+ * Processes one received byte (XMODEM/YMODEM send).
+ * @param byte
+ *      The received byte.
+ */
+void FileTransferWorker::processSenderByte(quint8 byte)
+{
+    if(byte == XMODEM_CAN)
+    {
+        m_canCount++;
+        if(m_canCount >= 2)
+        {
+            finish(false, "canceled by the receiver");
+        }
+        return;
+    }
+    m_canCount = 0;
+
+    switch(m_state)
+    {
+    case FILE_TRANSFER_STATE_SEND_WAIT_START:
+    {
+        if((byte == XMODEM_CRC_START) || (byte == XMODEM_NAK))
+        {
+            m_useCrc = (byte == XMODEM_CRC_START);
+            if(m_mode == FILE_TRANSFER_MODE_YMODEM_SEND)
+            {
+                sendHeaderBlock();
+            }
+            else
+            {
+                sendNextBlock();
+            }
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_HEADER_ACK:
+    {
+        if(byte == XMODEM_ACK)
+        {
+            m_state = FILE_TRANSFER_STATE_SEND_WAIT_DATA_START;
+            m_timer->start(BLOCK_TIMEOUT);
+        }
+        else if(byte == XMODEM_NAK)
+        {
+            resendBlock();
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_DATA_START:
+    {
+        if(byte == XMODEM_CRC_START)
+        {
+            sendNextBlock();
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_BLOCK_ACK:
+    {
+        if(byte == XMODEM_ACK)
+        {
+            m_transferredBytes += m_blockDataSize;
+            emitProgress(false);
+            sendNextBlock();
+        }
+        else if(byte == XMODEM_NAK)
+        {
+            resendBlock();
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_EOT_ACK:
+    {
+        if(byte == XMODEM_ACK)
+        {
+            if(m_mode == FILE_TRANSFER_MODE_YMODEM_SEND)
+            {
+                m_state = FILE_TRANSFER_STATE_SEND_WAIT_END_START;
+                m_timer->start(BLOCK_TIMEOUT);
+            }
+            else
+            {
+                finish(true, "file sent");
+            }
+        }
+        else if(byte == XMODEM_NAK)
+        {
+            resendBlock();
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_END_START:
+    {
+        if(byte == XMODEM_CRC_START)
+        {
+            //An empty header block ends the batch.
+            m_block = createBlock(0, QByteArray(), XMODEM_BLOCK_SIZE, 0);
+            m_retries = 0;
+            m_state = FILE_TRANSFER_STATE_SEND_WAIT_END_ACK;
+            transmit(m_block);
+            m_timer->start(BLOCK_TIMEOUT);
+        }
+        break;
+    }
+    case FILE_TRANSFER_STATE_SEND_WAIT_END_ACK:
+    {
+        if(byte == XMODEM_ACK)
+        {
+            finish(true, "file sent");
+        }
+        else if(byte == XMODEM_NAK)
+        {
+            resendBlock();
+        }
+        break;
+    }
+    default:
+    {
+        break;
+    }
+    }
+}
+
+/**
+ * Processes the received blocks (XMODEM/YMODEM receive).
+ */
+void FileTransferWorker::processReceivedBlocks(void)
+{
+    while(!m_receivedData.isEmpty() && (m_state == FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK))
+    {
+        quint8 header = (quint8)m_receivedData[0];
+
+        if(header == XMODEM_EOT)
+        {
+            m_receivedData.remove(0, 1);
+            handleEot();
+        }
+        else if(header == XMODEM_CAN)
+        {
+            if(m_receivedData.size() < 2)
+            {
+                break;
+            }
+            if((quint8)m_receivedData[1] == XMODEM_CAN)
+            {
+                finish(false, "canceled by the sender");
+            }
+            else
+            {
+                m_receivedData.remove(0, 1);
+            }
+        }
+        else if((header == XMODEM_SOH) || (header == XMODEM_STX))
+        {
+            int dataSize = (header == XMODEM_STX) ? XMODEM_1K_BLOCK_SIZE : XMODEM_BLOCK_SIZE;
+            int blockSize = 3 + dataSize + 2;
+            if(m_receivedData.size() < blockSize)
+            {
+                break;
+            }
+
+            QByteArray block = m_receivedData.left(blockSize);
+            m_receivedData.remove(0, blockSize);
+            handleReceivedBlock(block, dataSize);
+        }
+        else
+        {//Line noise.
+            m_receivedData.remove(0, 1);
+        }
+    }
+}
+
+/**
+ * Processes one received block (XMODEM/YMODEM receive).
+ * @param block
+ *      The block (header, block number, inverted block number, data and CRC).
+ * @param dataSize
+ *      The number of data bytes in the block.
+ */
+void FileTransferWorker::handleReceivedBlock(const QByteArray& block, int dataSize)
+{
+    quint8 number = (quint8)block[1];
+    quint8 invertedNumber = (quint8)block[2];
+    QByteArray data = block.mid(3, dataSize);
+    quint16 crc = (quint16)(((quint8)block[3 + dataSize] << 8) | (quint8)block[4 + dataSize]);
+
+    if(((quint8)(number + invertedNumber) != 255) || (calculateCrc(data) != crc))
+    {
+        m_receivedData.clear();
+        m_retries++;
+        if(m_retries > MAX_RETRIES)
+        {
+            sendCancel();
+            finish(false, "too many retries");
+        }
+        else
+        {
+            transmit(QByteArray(1, XMODEM_NAK));
+            m_timer->start(BLOCK_TIMEOUT);
+        }
+        return;
+    }
+
+    m_hasReceivedBlock = true;
+    m_retries = 0;
+
+    if(m_isHeaderExpected)
+    {
+        if(number == 0)
+        {
+            handleHeaderBlock(data);
+        }
+        else
+        {
+            sendCancel();
+            finish(false, "header block expected");
+        }
+        return;
+    }
+
+    if(number == (quint8)(m_blockNumber - 1))
+    {//The sender has not received the ACK of the last block.
+        transmit(QByteArray(1, XMODEM_ACK));
+        m_timer->start(BLOCK_TIMEOUT);
+        return;
+    }
+
+    if(number != m_blockNumber)
+    {
+        sendCancel();
+        finish(false, "block sequence error");
+        return;
+    }
+
+    if(m_mode == FILE_TRANSFER_MODE_XMODEM_RECEIVE)
+    {
+        if(!m_pendingData.isEmpty() && !writeToFile(m_pendingData))
+        {
+            return;
+        }
+        m_pendingData = data;
+    }
+    else
+    {
+        if(m_fileSize > 0)
+        {
+            quint64 remaining = m_fileSize - m_transferredBytes;
+            if((quint64)data.size() > remaining)
+            {
+                data.truncate((int)remaining);
+            }
+        }
+        if(!writeToFile(data))
+        {
+            return;
+        }
+    }
+
+    m_blockNumber++;
+    transmit(QByteArray(1, XMODEM_ACK));
+    m_timer->start(BLOCK_TIMEOUT);
+    emitProgress(false);
+}
+
+/**
+ * Processes a received YMODEM header block (file name and size, an empty file name ends the batch).
+ * @param data
+ *      The block data.
+ */
+void FileTransferWorker::handleHeaderBlock(const QByteArray& data)
+{
+    int nameEnd = data.indexOf('\0');
+    QString name = QString::fromUtf8(data.left(nameEnd));
+
+    if(name.isEmpty())
+    {
+        transmit(QByteArray(1, XMODEM_ACK));
+        finish(true, "file(s) received");
+        return;
+    }
+
+    //The size field is followed by optional fields (separated by spaces).
+    QByteArray sizeField = data.mid(nameEnd + 1);
+    sizeField = sizeField.left(sizeField.indexOf('\0'));
+    m_fileSize = sizeField.split(' ')[0].toULongLong();
+
+    //The path of the sender is not used.
+    m_fileName = QFileInfo(name).fileName();
+    m_file.setFileName(QDir(m_directory).filePath(m_fileName));
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        sendCancel();
+        finish(false, "could not open file: " + m_file.fileName());
+        return;
+    }
+
+    m_transferredBytes = 0;
+    m_elapsedTimer.start();
+    m_lastProgressTime = 0;
+    m_blockNumber = 1;
+    m_isHeaderExpected = false;
+    m_isEotReceived = false;
+
+    //ACK the header and start the data blocks.
+    QByteArray response;
+    response.append((char)XMODEM_ACK);
+    response.append((char)XMODEM_CRC_START);
+    transmit(response);
+    m_timer->start(BLOCK_TIMEOUT);
+    emitProgress(true);
+}
+
+/**
+ * Processes a received EOT (XMODEM/YMODEM receive).
+ */
+void FileTransferWorker::handleEot(void)
+{
+    if(m_mode == FILE_TRANSFER_MODE_XMODEM_RECEIVE)
+    {
+        //The padding of the last block is removed.
+        int size = m_pendingData.size();
+        while((size > 0) && ((quint8)m_pendingData[size - 1] == XMODEM_PADDING))
+        {
+            size--;
+        }
+        if(writeToFile(m_pendingData.left(size)))
+        {
+            transmit(QByteArray(1, XMODEM_ACK));
+            finish(true, "file received");
+        }
+    }
+    else if(m_isHeaderExpected)
+    {//The sender has not received the ACK of the last EOT.
+        transmit(QByteArray(1, XMODEM_ACK));
+    }
+    else if(!m_isEotReceived)
+    {//The first EOT is answered with a NAK (protection against line noise).
+        m_isEotReceived = true;
+        transmit(QByteArray(1, XMODEM_NAK));
+        m_timer->start(BLOCK_TIMEOUT);
+    }
+    else
+    {
+        m_file.close();
+        emitProgress(true);
+
+        //Request the next header block.
+        m_isHeaderExpected = true;
+        m_hasReceivedBlock = false;
+        m_retries = 0;
+        QByteArray response;
+        response.append((char)XMODEM_ACK);
+        response.append((char)XMODEM_CRC_START);
+        transmit(response);
+        m_timer->start(RECEIVE_START_INTERVAL);
+    }
+}
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ * @param interfaceThread
+ *      The main interface thread (executes the transfers).
+ * @param mainWindow
+ *      The main window (shows the progress).
+ */
+ScriptFileTransfer::ScriptFileTransfer(QObject *parent, MainInterfaceThread* interfaceThread, MainWindow* mainWindow) :
+    QObject(parent), m_worker(0), m_isRunning(false)
+{
+    m_worker = new FileTransferWorker(interfaceThread);
+    m_worker->moveToThread(interfaceThread);
+
+    connect(this, SIGNAL(startSignal(int,QString,quint32,quint32,quint64)),
+            m_worker, SLOT(startSlot(int,QString,quint32,quint32,quint64)), Qt::QueuedConnection);
+    connect(this, SIGNAL(cancelSignal()), m_worker, SLOT(cancelSlot()), Qt::QueuedConnection);
+
+    connect(m_worker, SIGNAL(progressSignal(QString,quint64,quint64,double)),
+            this, SIGNAL(progressSignal(QString,quint64,quint64,double)), Qt::QueuedConnection);
+    connect(m_worker, SIGNAL(finishedSignal(bool,QString)), this, SLOT(workerFinishedSlot(bool,QString)), Qt::QueuedConnection);
+
+    connect(m_worker, SIGNAL(progressSignal(QString,quint64,quint64,double)),
+            mainWindow, SLOT(fileTransferProgressSlot(QString,quint64,quint64,double)), Qt::QueuedConnection);
+    connect(m_worker, SIGNAL(finishedSignal(bool,QString)), mainWindow, SLOT(fileTransferFinishedSlot(bool,QString)), Qt::QueuedConnection);
+}
+
+/**
+ * Destructor.
+ */
+ScriptFileTransfer::~ScriptFileTransfer()
+{
+    //The worker lives in the main interface thread (cancelSlot is executed before the worker is deleted).
+    emit cancelSignal();
+    m_worker->deleteLater();
+}
+
+/**
+ * Starts a transfer in the worker.
+ * @param mode
+ *      The mode.
+ * @param path
+ *      The file (the directory for FILE_TRANSFER_MODE_YMODEM_RECEIVE).
+ * @param chunkSize
+ *      The raw chunk size.
+ * @param delayMs
+ *      The delay between two raw chunks.
+ * @param expectedSize
+ *      The expected file size (raw receive).
+ * @return
+ *      False if a transfer is running.
+ */
+bool ScriptFileTransfer::start(FileTransferMode mode, QString path, quint32 chunkSize, quint32 delayMs, quint64 expectedSize)
+{
+    if(m_isRunning)
+    {
+        return false;
+    }
+
+    m_isRunning = true;
+    emit startSignal(mode, path, chunkSize, delayMs, expectedSize);
+    return true;
+}
+
+/**
+ * Sends a file in chunks.
+ * @param path
+ *      The file.
+ * @param chunkSize
+ *      The chunk size (max. MAX_RAW_CHUNK_SIZE).
+ * @param delayMs
+ *      The delay between two chunks (ms).
+ * @return
+ *      False if a transfer is running or the file does not exist.
+ */
+bool ScriptFileTransfer::sendFileRaw(QString path, quint32 chunkSize, quint32 delayMs)
+{
+    if(!QFileInfo(path).isFile())
+    {
+        return false;
+    }
+
+    if(chunkSize == 0)
+    {
+        chunkSize = DEFAULT_RAW_CHUNK_SIZE;
+    }
+    else if(chunkSize > MAX_RAW_CHUNK_SIZE)
+    {
+        chunkSize = MAX_RAW_CHUNK_SIZE;
+    }
+    return start(FILE_TRANSFER_MODE_RAW_SEND, path, chunkSize, delayMs, 0);
+}
+
+/**
+ * Sends a file with XMODEM-1K.
+ * @param path
+ *      The file.
+ * @return
+ *      False if a transfer is running or the file does not exist.
+ */
+bool ScriptFileTransfer::sendFileXmodem(QString path)
+{
+    if(!QFileInfo(path).isFile())
+    {
+        return false;
+    }
+    return start(FILE_TRANSFER_MODE_XMODEM_SEND, path, 0, 0, 0);
+}
+
+/**
+ * Sends a file with YMODEM.
+ * @param path
+ *      The file.
+ * @return
+ *      False if a transfer is running or the file does not exist.
+ */
+bool ScriptFileTransfer::sendFileYmodem(QString path)
+{
+    if(!QFileInfo(path).isFile())
+    {
+        return false;
+    }
+    return start(FILE_TRANSFER_MODE_YMODEM_SEND, path, 0, 0, 0);
+}
+
+/**
+ * Writes all received data to a file.
+ * @param path
+ *      The file.
+ * @param expectedSize
+ *      The expected size (0=the transfer is finished with cancel).
+ * @return
+ *      False if a transfer is running.
+ */
+bool ScriptFileTransfer::receiveFileRaw(QString path, quint32 expectedSize)
+{
+    return start(FILE_TRANSFER_MODE_RAW_RECEIVE, path, 0, 0, expectedSize);
+}
+
+/**
+ * Receives a file with XMODEM/XMODEM-1K.
+ * @param path
+ *      The file.
+ * @return
+ *      False if a transfer is running.
+ */
+bool ScriptFileTransfer::receiveFileXmodem(QString path)
+{
+    return start(FILE_TRANSFER_MODE_XMODEM_RECEIVE, path, 0, 0, 0);
+}
+
+/**
+ * Receives a YMODEM batch.
+ * @param directory
+ *      The directory in which the files are stored.
+ * @return
+ *      False if a transfer is running.
+ */
+bool ScriptFileTransfer::receiveFileYmodem(QString directory)
+{
+    return start(FILE_TRANSFER_MODE_YMODEM_RECEIVE, directory, 0, 0, 0);
+}
+
+/**
+ * Is called if the worker has finished a transfer.
+ * @param success
+ *      True if the transfer was successful.
+ * @param message
+ *      The result message.
+ */
+void ScriptFileTransfer::workerFinishedSlot(bool success, QString message)
+{
+    m_isRunning = false;
+    emit transferFinishedSignal(success, message);
+}
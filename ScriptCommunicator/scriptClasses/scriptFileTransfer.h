@@ -0,0 +1,368 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTFILETRANSFER_H
+#define SCRIPTFILETRANSFER_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <mainInterfaceThread.h>
+
+class MainWindow;
+
+///The file transfer modes.
+typedef enum
+{
+    FILE_TRANSFER_MODE_RAW_SEND = 0,
+    FILE_TRANSFER_MODE_RAW_RECEIVE,
+    FILE_TRANSFER_MODE_XMODEM_SEND,
+    FILE_TRANSFER_MODE_XMODEM_RECEIVE,
+    FILE_TRANSFER_MODE_YMODEM_SEND,
+    FILE_TRANSFER_MODE_YMODEM_RECEIVE
+}FileTransferMode;
+
+///The states of a file transfer.
+typedef enum
+{
+    FILE_TRANSFER_STATE_IDLE = 0,
+
+    ///Raw send: a chunk has been passed to the main interface.
+    FILE_TRANSFER_STATE_RAW_SEND_WAIT_FINISHED,
+
+    ///Raw send: waiting before the next chunk is sent.
+    FILE_TRANSFER_STATE_RAW_SEND_DELAY,
+
+    ///Raw receive: all received data is written to the file.
+    FILE_TRANSFER_STATE_RAW_RECEIVE,
+
+    ///XMODEM/YMODEM send: waiting for the start character of the receiver ('C' or NAK).
+    FILE_TRANSFER_STATE_SEND_WAIT_START,
+
+    ///YMODEM send: waiting for the ACK of the header block (block 0).
+    FILE_TRANSFER_STATE_SEND_WAIT_HEADER_ACK,
+
+    ///YMODEM send: waiting for the 'C' which starts the data blocks.
+    FILE_TRANSFER_STATE_SEND_WAIT_DATA_START,
+
+    ///XMODEM/YMODEM send: waiting for the ACK of a data block.
+    FILE_TRANSFER_STATE_SEND_WAIT_BLOCK_ACK,
+
+    ///XMODEM/YMODEM send: waiting for the ACK of the EOT.
+    FILE_TRANSFER_STATE_SEND_WAIT_EOT_ACK,
+
+    ///YMODEM send: waiting for the 'C' which requests the (empty) batch end block.
+    FILE_TRANSFER_STATE_SEND_WAIT_END_START,
+
+    ///YMODEM send: waiting for the ACK of the batch end block.
+    FILE_TRANSFER_STATE_SEND_WAIT_END_ACK,
+
+    ///XMODEM/YMODEM receive: waiting for the next block.
+    FILE_TRANSFER_STATE_RECEIVE_WAIT_BLOCK
+}FileTransferState;
+
+///Executes a file transfer. The object lives in the main interface thread, the file is read/written
+///block by block (only the current block is hold in memory).
+class FileTransferWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    FileTransferWorker(MainInterfaceThread* interfaceThread);
+    ~FileTransferWorker();
+
+    ///XMODEM/YMODEM control characters.
+    static const quint8 XMODEM_SOH = 0x01;
+    static const quint8 XMODEM_STX = 0x02;
+    static const quint8 XMODEM_EOT = 0x04;
+    static const quint8 XMODEM_ACK = 0x06;
+    static const quint8 XMODEM_NAK = 0x15;
+    static const quint8 XMODEM_CAN = 0x18;
+    static const quint8 XMODEM_CRC_START = 'C';
+    static const quint8 XMODEM_PADDING = 0x1A;
+
+    ///The block sizes.
+    static const int XMODEM_BLOCK_SIZE = 128;
+    static const int XMODEM_1K_BLOCK_SIZE = 1024;
+
+    ///The time a sender waits for the receiver (ms).
+    static const int START_TIMEOUT = 60000;
+
+    ///The time after which a block is retransmitted (ms).
+    static const int BLOCK_TIMEOUT = 10000;
+
+    ///The interval in which the receiver sends the start character (ms).
+    static const int RECEIVE_START_INTERVAL = 3000;
+
+    ///The max. number of retries per block.
+    static const int MAX_RETRIES = 10;
+
+    ///The min. interval of the progress signal (ms).
+    static const int PROGRESS_INTERVAL = 100;
+
+public slots:
+
+    ///Starts a transfer.
+    void startSlot(int mode, QString path, quint32 chunkSize, quint32 delayMs, quint64 expectedSize);
+
+    ///Cancels the current transfer (a raw receive is finished successfully).
+    void cancelSlot(void);
+
+signals:
+
+    ///Is emitted periodically during a transfer.
+    void progressSignal(QString fileName, quint64 transferredBytes, quint64 totalBytes, double bytesPerSecond);
+
+    ///Is emitted if a transfer has finished.
+    void finishedSignal(bool success, QString message);
+
+    ///Is emitted if data shall be sent.
+    void sendDataSignal(const QByteArray data, uint id);
+
+private slots:
+
+    ///Is called if the main interface has received data.
+    void dataReceivedSlot(QByteArray data);
+
+    ///Is called if the main interface has sent data.
+    void sendingFinishedSlot(bool success, uint id);
+
+    ///Is called if m_timer has elapsed (timeout or raw send delay).
+    void timerSlot(void);
+
+private:
+
+    ///Finishes the current transfer.
+    void finish(bool success, QString message);
+
+    ///Emits progressSignal (at most every PROGRESS_INTERVAL ms if force is false).
+    void emitProgress(bool force);
+
+    ///Sends data with the main interface.
+    void transmit(const QByteArray& data);
+
+    ///Sends the cancel sequence (XMODEM/YMODEM).
+    void sendCancel(void);
+
+    ///Reads the next raw chunk and sends it.
+    void sendNextRawChunk(void);
+
+    ///Processes one received byte (XMODEM/YMODEM send).
+    void processSenderByte(quint8 byte);
+
+    ///Creates a XMODEM block.
+    QByteArray createBlock(quint8 number, const QByteArray& data, int blockSize, char padding);
+
+    ///Sends the YMODEM header block (block 0).
+    void sendHeaderBlock(void);
+
+    ///Reads the next data block and sends it (sends the EOT at the end of the file).
+    void sendNextBlock(void);
+
+    ///Retransmits the current block.
+    void resendBlock(void);
+
+    ///Processes the received blocks (XMODEM/YMODEM receive).
+    void processReceivedBlocks(void);
+
+    ///Processes one received block (XMODEM/YMODEM receive).
+    void handleReceivedBlock(const QByteArray& block, int dataSize);
+
+    ///Processes a received YMODEM header block.
+    void handleHeaderBlock(const QByteArray& data);
+
+    ///Processes a received EOT (XMODEM/YMODEM receive).
+    void handleEot(void);
+
+    ///Writes received data to the file.
+    bool writeToFile(const QByteArray& data);
+
+    ///Calculates the XMODEM CRC (CRC-16/XMODEM).
+    static quint16 calculateCrc(const QByteArray& data);
+
+    ///The main interface thread.
+    MainInterfaceThread* m_interface;
+
+    ///The send id of the worker.
+    quint32 m_sendId;
+
+    ///The current mode.
+    FileTransferMode m_mode;
+
+    ///The current state.
+    FileTransferState m_state;
+
+    ///The current file.
+    QFile m_file;
+
+    ///The name of the current file.
+    QString m_fileName;
+
+    ///The directory for received YMODEM files.
+    QString m_directory;
+
+    ///The size of the current file (0 if unknown).
+    quint64 m_fileSize;
+
+    ///The number of transferred bytes of the current file.
+    quint64 m_transferredBytes;
+
+    ///The raw chunk size.
+    quint32 m_chunkSize;
+
+    ///The delay between two raw chunks (ms).
+    quint32 m_delayMs;
+
+    ///The current (not acknowledged) block.
+    QByteArray m_block;
+
+    ///The number of file bytes in m_block.
+    int m_blockDataSize;
+
+    ///The current (send) or the next expected (receive) block number.
+    quint8 m_blockNumber;
+
+    ///The number of retries of the current block.
+    int m_retries;
+
+    ///True if the CRC is used (else the checksum).
+    bool m_useCrc;
+
+    ///The number of consecutive received CAN characters.
+    int m_canCount;
+
+    ///The received unprocessed data (XMODEM/YMODEM receive).
+    QByteArray m_receivedData;
+
+    ///The last received XMODEM block (written after the next block or the EOT, because the padding
+    ///of the last block is removed).
+    QByteArray m_pendingData;
+
+    ///True if a block has been received since the last start character.
+    bool m_hasReceivedBlock;
+
+    ///True if a YMODEM header block is expected.
+    bool m_isHeaderExpected;
+
+    ///True if the first EOT of a YMODEM file has been received.
+    bool m_isEotReceived;
+
+    ///Timeout/delay timer.
+    QTimer* m_timer;
+
+    ///Measures the transfer time of the current file.
+    QElapsedTimer m_elapsedTimer;
+
+    ///The time of the last progress signal (ms).
+    qint64 m_lastProgressTime;
+};
+
+///Native streaming file transfer for scripts (raw paced, XMODEM-1K and YMODEM).
+///The transfer is executed in the main interface thread (the script thread is not blocked)
+///and the progress is shown in the status bar of the main window.
+class ScriptFileTransfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptFileTransfer(QObject *parent, MainInterfaceThread* interfaceThread, MainWindow* mainWindow);
+    ~ScriptFileTransfer();
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptFileTransfer*>("ScriptFileTransfer*");
+    }
+
+    ///The default raw chunk size.
+    static const quint32 DEFAULT_RAW_CHUNK_SIZE = 1024;
+
+    ///The max. raw chunk size.
+    static const quint32 MAX_RAW_CHUNK_SIZE = 1024 * 1024;
+
+    ///Sends a file in chunks of chunkSize bytes with delayMs ms between two chunks.
+    ///Returns false if a transfer is running or the file does not exist.
+    Q_INVOKABLE bool sendFileRaw(QString path, quint32 chunkSize=DEFAULT_RAW_CHUNK_SIZE, quint32 delayMs=0);
+
+    ///Sends a file with XMODEM-1K (XMODEM with 128 byte blocks if the receiver requests the checksum mode).
+    ///Returns false if a transfer is running or the file does not exist.
+    Q_INVOKABLE bool sendFileXmodem(QString path);
+
+    ///Sends a file with YMODEM (batch with one file).
+    ///Returns false if a transfer is running or the file does not exist.
+    Q_INVOKABLE bool sendFileYmodem(QString path);
+
+    ///Writes all received data to a file. The transfer is finished after expectedSize bytes
+    ///(or with cancel if expectedSize is 0). Returns false if a transfer is running.
+    Q_INVOKABLE bool receiveFileRaw(QString path, quint32 expectedSize=0);
+
+    ///Receives a file with XMODEM/XMODEM-1K (CRC mode). Returns false if a transfer is running.
+    Q_INVOKABLE bool receiveFileXmodem(QString path);
+
+    ///Receives a YMODEM batch. The files are stored in directory. Returns false if a transfer is running.
+    Q_INVOKABLE bool receiveFileYmodem(QString directory);
+
+    ///Cancels the current transfer (a raw receive without expected size is finished successfully).
+    Q_INVOKABLE void cancel(void){emit cancelSignal();}
+
+    ///Returns true if a transfer is running.
+    Q_INVOKABLE bool isRunning(void){return m_isRunning;}
+
+signals:
+    ///Is emitted periodically during a transfer (totalBytes is 0 if the size is unknown).
+    ///Scripts can connect a function to this signal.
+    void progressSignal(QString fileName, quint64 transferredBytes, quint64 totalBytes, double bytesPerSecond);
+
+    ///Is emitted if a transfer has finished.
+    ///Scripts can connect a function to this signal.
+    void transferFinishedSignal(bool success, QString message);
+
+    ///Is emitted if a transfer shall be started.
+    ///This signal must not be used from script.
+    void startSignal(int mode, QString path, quint32 chunkSize, quint32 delayMs, quint64 expectedSize);
+
+    ///Is emitted if the current transfer shall be canceled.
+    ///This signal must not be used from script.
+    void cancelSignal(void);
+
+private slots:
+
+    ///Is called if the worker has finished a transfer.
+    void workerFinishedSlot(bool success, QString message);
+
+private:
+
+    ///Starts a transfer in the worker.
+    bool start(FileTransferMode mode, QString path, quint32 chunkSize, quint32 delayMs, quint64 expectedSize);
+
+    ///The worker (lives in the main interface thread).
+    FileTransferWorker* m_worker;
+
+    ///True if a transfer is running.
+    bool m_isRunning;
+};
+
+#endif // SCRIPTFILETRANSFER_H
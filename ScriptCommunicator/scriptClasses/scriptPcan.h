@@ -195,41 +195,28 @@ private slots:
      ///This slot function is called if can message are available for reading.
     void stub_readyReadSlot()
     {
-        QByteArray data = m_pcan.readLastMessage();
-        QVector<QByteArray> messages;
-        while(!data.isEmpty())
-        {
-            messages.append(data);
-            data = m_pcan.readLastMessage();
-        }
+        QVector<CanFrame> messages = m_pcan.readMessages();
 
         if(!messages.isEmpty())
         {
-            QVector<quint8> types;
-            QVector<quint32> messageIds;
-            QVector<quint32> timestamps;
-            QVector<QVector<unsigned char>> data;
+            QVector<quint8> types(messages.size());
+            QVector<quint32> messageIds(messages.size());
+            QVector<quint32> timestamps(messages.size());
+            QVector<QVector<unsigned char>> data(messages.size());
 
-            for(auto el : messages)
+            for(int i = 0; i < messages.size(); i++)
             {
-                QVector<unsigned char> dataVector;
+                const CanFrame& frame = messages.at(i);
+
+                types[i] = canFrameType(frame);
+                messageIds[i] = frame.id;
+                timestamps[i] = (quint32)(frame.timestamp / 1000);
 
-                for(auto val : el)
+                if(frame.length > 0)
                 {
-                    dataVector.push_back((unsigned char) val);
+                    data[i].resize(frame.length);
+                    memcpy(data[i].data(), frame.data, frame.length);
                 }
-                quint8 type = dataVector[0];
-
-                quint32 messageId = ((dataVector[1] << 24) & 0xff000000) + ((dataVector[2] << 16) & 0xff0000) +
-                        ((dataVector[3] << 8) & 0xff00) + (dataVector[4] & 0xff);
-                quint32 timeStamp = ((dataVector[5] << 24) & 0xff000000) + ((dataVector[6] << 16) & 0xff0000) +
-                        ((dataVector[7] << 8) & 0xff00) + (dataVector[8] & 0xff);
-
-                types.push_back(type);
-                messageIds.push_back(messageId);
-                timestamps.push_back(timeStamp);
-                data.push_back(dataVector.mid(9));
-
             }
 
             emit canMessagesReceivedSignal(types, messageIds, timestamps, data);
@@ -0,0 +1,555 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptProfiler.h"
+#include <QScriptEngine>
+#include <QScriptContext>
+#include <QScriptContextInfo>
+#include <QFileInfo>
+#include <QStringList>
+#include <algorithm>
+#include <string.h>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+const quint32 ScriptProfiler::HISTOGRAM_LIMITS_US[ScriptProfiler::HISTOGRAM_BIN_COUNT - 1] = {100, 1000, 10000, 100000, 1000000};
+
+/**
+ * Constructor.
+ */
+ScriptProfiler::ScriptProfiler() : m_mutex(), m_statistics(), m_handlers(), m_samples(), m_pendingEvents(0), m_maxPendingEvents(0),
+    m_elapsedTimer(), m_lastUpdateNs(-1), m_lastCpuTimeNs(0), m_cpuTimeOffsetNs(0), m_lastBytesIn(0), m_lastBytesOut(0)
+{
+    memset(&m_statistics, 0, sizeof(m_statistics));
+    m_elapsedTimer.start();
+}
+
+/**
+ * Returns the CPU time of the calling thread.
+ * @return
+ *      The CPU time (ns, 0 if the CPU time is not available).
+ */
+qint64 ScriptProfiler::currentThreadCpuTimeNs(void)
+{
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if(GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        quint64 kernel = ((quint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+        quint64 user = ((quint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+
+        //The thread times are in 100 ns units.
+        return (qint64)(kernel + user) * 100;
+    }
+    return 0;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec time;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+    {
+        return ((qint64)time.tv_sec * 1000000000) + time.tv_nsec;
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Must be called periodically (every UPDATE_INTERVAL ms) in the script thread.
+ * Updates the CPU time, the rates and the event loop latency.
+ */
+void ScriptProfiler::updateStatistics(void)
+{
+    qint64 nowNs = m_elapsedTimer.nsecsElapsed();
+    qint64 cpuTimeNs = currentThreadCpuTimeNs();
+
+    QMutexLocker locker(&m_mutex);
+
+    if(m_lastUpdateNs >= 0)
+    {
+        qint64 elapsedNs = nowNs - m_lastUpdateNs;
+        if(elapsedNs > 0)
+        {
+            m_statistics.cpuLoad = (100.0 * (double)(cpuTimeNs - m_lastCpuTimeNs)) / (double)elapsedNs;
+            m_statistics.bytesInPerSecond = ((double)(m_statistics.bytesIn - m_lastBytesIn) * 1000000000.0) / (double)elapsedNs;
+            m_statistics.bytesOutPerSecond = ((double)(m_statistics.bytesOut - m_lastBytesOut) * 1000000000.0) / (double)elapsedNs;
+        }
+
+        //The update timer is delayed if the event loop of the script thread is busy.
+        qint64 latencyNs = elapsedNs - ((qint64)UPDATE_INTERVAL * 1000000);
+        m_statistics.eventLoopLatencyMs = (latencyNs > 0) ? (double)latencyNs / 1000000.0 : 0.0;
+        if(m_statistics.eventLoopLatencyMs > m_statistics.maxEventLoopLatencyMs)
+        {
+            m_statistics.maxEventLoopLatencyMs = m_statistics.eventLoopLatencyMs;
+        }
+    }
+
+    m_statistics.cpuTimeMs = (double)(cpuTimeNs - m_cpuTimeOffsetNs) / 1000000.0;
+    m_lastUpdateNs = nowNs;
+    m_lastCpuTimeNs = cpuTimeNs;
+    m_lastBytesIn = m_statistics.bytesIn;
+    m_lastBytesOut = m_statistics.bytesOut;
+}
+
+/**
+ * Is called (from any thread) if a received data block has been queued for the script thread.
+ */
+void ScriptProfiler::dataQueued(void)
+{
+    int pending = m_pendingEvents.fetchAndAddRelaxed(1) + 1;
+    int maxPending = m_maxPendingEvents.load();
+    while((pending > maxPending) && !m_maxPendingEvents.testAndSetRelaxed(maxPending, pending))
+    {
+        maxPending = m_maxPendingEvents.load();
+    }
+}
+
+/**
+ * Is called in the script thread if a received data block has been processed.
+ * @param bytes
+ *      The number of received bytes.
+ */
+void ScriptProfiler::dataProcessed(quint32 bytes)
+{
+    if(m_pendingEvents.fetchAndAddRelaxed(-1) <= 0)
+    {//The data has been queued before the profiler has been connected.
+        m_pendingEvents.fetchAndAddRelaxed(1);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_statistics.bytesIn += bytes;
+}
+
+/**
+ * Is called in the script thread if data has been sent with the main interface.
+ * @param bytes
+ *      The number of sent bytes.
+ */
+void ScriptProfiler::dataSent(quint32 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics.bytesOut += bytes;
+}
+
+/**
+ * Is called in the script thread after a garbage collection.
+ * @param durationNs
+ *      The duration of the garbage collection.
+ */
+void ScriptProfiler::garbageCollected(qint64 durationNs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics.garbageCollections++;
+    m_statistics.garbageCollectionTimeMs += (double)durationNs / 1000000.0;
+}
+
+/**
+ * Adds one call of a signal handler.
+ * @param name
+ *      The handler name.
+ * @param durationNs
+ *      The duration of the call.
+ */
+void ScriptProfiler::addHandlerCall(const QString& name, qint64 durationNs)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QHash<QString, ScriptHandlerStatistics>::iterator iter = m_handlers.find(name);
+    if(iter == m_handlers.end())
+    {
+        ScriptHandlerStatistics handler;
+        handler.name = name;
+        handler.calls = 0;
+        handler.totalNs = 0;
+        handler.maxNs = 0;
+        handler.histogram.fill(0, HISTOGRAM_BIN_COUNT);
+        iter = m_handlers.insert(name, handler);
+    }
+
+    iter->calls++;
+    iter->totalNs += durationNs;
+    if(durationNs > iter->maxNs)
+    {
+        iter->maxNs = durationNs;
+    }
+
+    qint64 durationUs = durationNs / 1000;
+    int bin = 0;
+    while((bin < (HISTOGRAM_BIN_COUNT - 1)) && (durationUs > HISTOGRAM_LIMITS_US[bin]))
+    {
+        bin++;
+    }
+    iter->histogram[bin]++;
+}
+
+/**
+ * Adds a sample of the sampling profiler.
+ * @param stack
+ *      The folded stack (the functions are separated by ';').
+ * @param weight
+ *      The number of sampling intervals which are represented by this sample.
+ */
+void ScriptProfiler::addSample(const QString& stack, quint64 weight)
+{
+    QMutexLocker locker(&m_mutex);
+    m_samples[stack] += weight;
+    m_statistics.samples += weight;
+}
+
+/**
+ * Enables/disables the signal handler profiling (display only).
+ * @param enabled
+ *      True if profiling is enabled.
+ */
+void ScriptProfiler::setProfilingIsEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_statistics.profilingIsEnabled = enabled;
+}
+
+/**
+ * Returns the statistics.
+ * @return
+ *      The statistics.
+ */
+ScriptThreadStatistics ScriptProfiler::getStatistics(void)
+{
+    QMutexLocker locker(&m_mutex);
+    ScriptThreadStatistics statistics = m_statistics;
+    statistics.pendingEvents = m_pendingEvents.load();
+    statistics.maxPendingEvents = m_maxPendingEvents.load();
+    return statistics;
+}
+
+/**
+ * Returns the statistics of all signal handlers.
+ * @return
+ *      The statistics (sorted by the total time, descending).
+ */
+QVector<ScriptHandlerStatistics> ScriptProfiler::getHandlerStatistics(void)
+{
+    QVector<ScriptHandlerStatistics> result;
+    {
+        QMutexLocker locker(&m_mutex);
+        result.reserve(m_handlers.size());
+        for(auto el : m_handlers)
+        {
+            result.append(el);
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const ScriptHandlerStatistics& a, const ScriptHandlerStatistics& b)
+    {
+        return a.totalNs > b.totalNs;
+    });
+    return result;
+}
+
+/**
+ * Returns the samples of the sampling profiler in the folded stack format.
+ * @return
+ *      The samples (one line per stack: 'function1;function2;function3 count').
+ */
+QString ScriptProfiler::getFoldedStacks(void)
+{
+    QMutexLocker locker(&m_mutex);
+    QString result;
+
+    for(QHash<QString, quint64>::const_iterator iter = m_samples.constBegin(); iter != m_samples.constEnd(); ++iter)
+    {
+        result += iter.key() + " " + QString::number(iter.value()) + "\n";
+    }
+    return result;
+}
+
+/**
+ * Resets all statistics (must be called in the script thread).
+ */
+void ScriptProfiler::reset(void)
+{
+    qint64 cpuTimeNs = currentThreadCpuTimeNs();
+
+    QMutexLocker locker(&m_mutex);
+    bool profilingIsEnabled = m_statistics.profilingIsEnabled;
+    memset(&m_statistics, 0, sizeof(m_statistics));
+    m_statistics.profilingIsEnabled = profilingIsEnabled;
+
+    m_handlers.clear();
+    m_samples.clear();
+    m_maxPendingEvents.store(m_pendingEvents.load());
+    m_cpuTimeOffsetNs = cpuTimeNs;
+    m_lastCpuTimeNs = cpuTimeNs;
+    m_lastBytesIn = 0;
+    m_lastBytesOut = 0;
+}
+
+/**
+ * Converts statistics into a short text (for the script window).
+ * @param statistics
+ *      The statistics.
+ * @return
+ *      The text.
+ */
+QString ScriptProfiler::statisticsToShortString(const ScriptThreadStatistics& statistics)
+{
+    return QString("%1% in:%2kB/s out:%3kB/s queue:%4").arg(statistics.cpuLoad, 0, 'f', 1)
+            .arg(statistics.bytesInPerSecond / 1000.0, 0, 'f', 1).arg(statistics.bytesOutPerSecond / 1000.0, 0, 'f', 1)
+            .arg(statistics.pendingEvents);
+}
+
+/**
+ * Converts statistics into a detailed text (for the script window tool tip).
+ * @param statistics
+ *      The statistics.
+ * @param handlers
+ *      The signal handler statistics.
+ * @return
+ *      The text.
+ */
+QString ScriptProfiler::statisticsToString(const ScriptThreadStatistics& statistics, const QVector<ScriptHandlerStatistics>& handlers)
+{
+    QString result;
+    result += QString("CPU time: %1 ms, CPU load: %2%\n").arg(statistics.cpuTimeMs, 0, 'f', 1).arg(statistics.cpuLoad, 0, 'f', 1);
+    result += QString("received: %1 bytes (%2 bytes/s), sent: %3 bytes (%4 bytes/s)\n").arg(statistics.bytesIn)
+            .arg(statistics.bytesInPerSecond, 0, 'f', 0).arg(statistics.bytesOut).arg(statistics.bytesOutPerSecond, 0, 'f', 0);
+    result += QString("pending receive events: %1 (max. %2), event loop latency: %3 ms (max. %4 ms)\n").arg(statistics.pendingEvents)
+            .arg(statistics.maxPendingEvents).arg(statistics.eventLoopLatencyMs, 0, 'f', 1).arg(statistics.maxEventLoopLatencyMs, 0, 'f', 1);
+    result += QString("garbage collections: %1 (%2 ms)").arg(statistics.garbageCollections).arg(statistics.garbageCollectionTimeMs, 0, 'f', 1);
+
+    if(statistics.profilingIsEnabled)
+    {
+        result += QString("\nsamples: %1").arg(statistics.samples);
+    }
+
+    if(!handlers.isEmpty())
+    {
+        QStringList binNames;
+        for(int i = 0; i < HISTOGRAM_BIN_COUNT; i++)
+        {
+            quint32 limit = (i < (HISTOGRAM_BIN_COUNT - 1)) ? HISTOGRAM_LIMITS_US[i] : HISTOGRAM_LIMITS_US[HISTOGRAM_BIN_COUNT - 2];
+            QString limitString = (limit < 1000) ? QString("%1us").arg(limit) : QString("%1ms").arg(limit / 1000);
+            binNames << ((i < (HISTOGRAM_BIN_COUNT - 1)) ? "<=" : ">") + limitString;
+        }
+
+        result += "\n\nsignal handlers (" + binNames.join(", ") + "):";
+        for(auto el : handlers)
+        {
+            QStringList histogram;
+            for(auto bin : el.histogram)
+            {
+                histogram << QString::number(bin);
+            }
+            result += QString("\n%1: %2 calls, total %3 ms, max %4 ms [%5]").arg(el.name).arg(el.calls)
+                    .arg((double)el.totalNs / 1000000.0, 0, 'f', 1).arg((double)el.maxNs / 1000000.0, 0, 'f', 2)
+                    .arg(histogram.join(" "));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Constructor.
+ * @param engine
+ *      The script engine.
+ * @param profiler
+ *      The profiler which stores the results.
+ * @param samplingIntervalNs
+ *      The sampling interval (ns, 0=sampling disabled).
+ */
+ScriptProfilerAgent::ScriptProfilerAgent(QScriptEngine* engine, ScriptProfiler* profiler, qint64 samplingIntervalNs) :
+    QScriptEngineAgent(engine), m_profiler(profiler), m_samplingIntervalNs(samplingIntervalNs), m_nextSampleNs(0), m_stack(),
+    m_handlerStartNs(0), m_functionNames(), m_elapsedTimer()
+{
+    m_elapsedTimer.start();
+}
+
+/**
+ * Returns the depth of the current context.
+ * @return
+ *      The depth (number of parent contexts).
+ */
+int ScriptProfilerAgent::currentContextDepth(void)
+{
+    int depth = 0;
+    for(QScriptContext* context = engine()->currentContext(); context != 0; context = context->parentContext())
+    {
+        depth++;
+    }
+    return depth;
+}
+
+/**
+ * Returns the name of the function of the current context.
+ * @return
+ *      The name ('function (file:line)').
+ */
+QString ScriptProfilerAgent::currentFunctionName(void)
+{
+    QScriptContext* context = engine()->currentContext();
+    qint64 id = context->callee().objectId();
+
+    QHash<qint64, QString>::const_iterator iter = m_functionNames.constFind(id);
+    if(iter != m_functionNames.constEnd())
+    {
+        return iter.value();
+    }
+
+    QScriptContextInfo info(context);
+    QString name = info.functionName();
+    if(name.isEmpty())
+    {
+        name = (info.functionType() == QScriptContextInfo::ScriptFunction) ? "(anonymous)" : "(native)";
+    }
+    if(!info.fileName().isEmpty())
+    {
+        name += QString(" (%1:%2)").arg(QFileInfo(info.fileName()).fileName()).arg(info.functionStartLineNumber());
+    }
+
+    //';' separates the functions in the folded stack format.
+    name.replace(';', ',');
+
+    m_functionNames[id] = name;
+    return name;
+}
+
+/**
+ * Adds a sample if the sampling interval has elapsed.
+ */
+void ScriptProfilerAgent::checkSample(void)
+{
+    if((m_samplingIntervalNs > 0) && !m_stack.isEmpty())
+    {
+        qint64 nowNs = m_elapsedTimer.nsecsElapsed();
+        if(nowNs >= m_nextSampleNs)
+        {
+            //All elapsed intervals are attributed to the current stack.
+            quint64 weight = 1 + (quint64)((nowNs - m_nextSampleNs) / m_samplingIntervalNs);
+            m_nextSampleNs += (qint64)weight * m_samplingIntervalNs;
+
+            QString stack;
+            for(int i = 0; i < m_stack.size(); i++)
+            {
+                if(i != 0)
+                {
+                    stack += ";";
+                }
+                stack += m_stack[i].name;
+            }
+            m_profiler->addSample(stack, weight);
+        }
+    }
+}
+
+/**
+ * Removes all entries from the shadow call stack with a depth >= depth.
+ * Ends the current handler measurement if the stack becomes empty.
+ * @param depth
+ *      The depth.
+ */
+void ScriptProfilerAgent::unwindStack(int depth)
+{
+    if(!m_stack.isEmpty())
+    {
+        QString handlerName = m_stack[0].name;
+
+        while(!m_stack.isEmpty() && (m_stack.last().depth >= depth))
+        {
+            m_stack.removeLast();
+        }
+
+        if(m_stack.isEmpty())
+        {
+            m_profiler->addHandlerCall(handlerName, m_elapsedTimer.nsecsElapsed() - m_handlerStartNs);
+        }
+    }
+}
+
+/**
+ * Is called if a function is called.
+ * @param scriptId
+ *      The script id (-1 for native functions).
+ */
+void ScriptProfilerAgent::functionEntry(qint64 scriptId)
+{
+    (void)scriptId;
+
+    checkSample();
+
+    int depth = currentContextDepth();
+
+    //Remove the functions which have been left without functionExit (e.g. exceptions).
+    unwindStack(depth);
+
+    if(m_stack.isEmpty())
+    {//A handler (a script function which is called from C++) starts.
+        m_handlerStartNs = m_elapsedTimer.nsecsElapsed();
+
+        //The time between two handlers must not be attributed to a stack.
+        m_nextSampleNs = m_handlerStartNs + m_samplingIntervalNs;
+    }
+
+    ScriptProfilerStackEntry entry;
+    entry.depth = depth;
+    entry.name = currentFunctionName();
+    m_stack.append(entry);
+}
+
+/**
+ * Is called if a function returns.
+ * @param scriptId
+ *      The script id (-1 for native functions).
+ * @param returnValue
+ *      The return value.
+ */
+void ScriptProfilerAgent::functionExit(qint64 scriptId, const QScriptValue& returnValue)
+{
+    (void)scriptId;
+    (void)returnValue;
+
+    checkSample();
+    unwindStack(currentContextDepth());
+}
+
+/**
+ * Is called if the engine is about to execute a statement.
+ * @param scriptId
+ *      The script id.
+ * @param lineNumber
+ *      The line number.
+ * @param columnNumber
+ *      The column number.
+ */
+void ScriptProfilerAgent::positionChange(qint64 scriptId, int lineNumber, int columnNumber)
+{
+    (void)scriptId;
+    (void)lineNumber;
+    (void)columnNumber;
+
+    checkSample();
+}
@@ -0,0 +1,269 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTPROFILER_H
+#define SCRIPTPROFILER_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QScriptEngineAgent>
+
+class ScriptProfiler;
+
+///The statistics of one script thread.
+typedef struct
+{
+    ///The CPU time which has been used by the script thread (ms).
+    double cpuTimeMs;
+
+    ///The CPU load of the script thread during the last update interval (percent of one core).
+    double cpuLoad;
+
+    ///The number of bytes which have been received from the main interface.
+    quint64 bytesIn;
+
+    ///The number of bytes which have been sent with the main interface.
+    quint64 bytesOut;
+
+    ///The receive rate during the last update interval (bytes/s).
+    double bytesInPerSecond;
+
+    ///The send rate during the last update interval (bytes/s).
+    double bytesOutPerSecond;
+
+    ///The number of received data blocks (main interface) which have not been processed by the script thread yet.
+    quint32 pendingEvents;
+
+    ///The max. value of pendingEvents.
+    quint32 maxPendingEvents;
+
+    ///The delay of the event loop of the script thread during the last update interval (ms).
+    double eventLoopLatencyMs;
+
+    ///The max. value of eventLoopLatencyMs.
+    double maxEventLoopLatencyMs;
+
+    ///The number of garbage collections (scriptThread.collectGarbage).
+    quint32 garbageCollections;
+
+    ///The time which has been used by the garbage collections (ms).
+    double garbageCollectionTimeMs;
+
+    ///True if the signal handler profiling is enabled.
+    bool profilingIsEnabled;
+
+    ///The number of samples of the sampling profiler.
+    quint64 samples;
+}ScriptThreadStatistics;
+
+///The statistics of one signal handler (script function which is called from C++).
+typedef struct
+{
+    ///The name of the handler (function name, file and line).
+    QString name;
+
+    ///The number of calls.
+    quint64 calls;
+
+    ///The time which has been spent in the handler (ns).
+    qint64 totalNs;
+
+    ///The max. duration of one call (ns).
+    qint64 maxNs;
+
+    ///The duration histogram (see ScriptProfiler::HISTOGRAM_LIMITS_US).
+    QVector<quint64> histogram;
+}ScriptHandlerStatistics;
+
+///Collects the profiling statistics of one script thread. The statistics can be read from any thread.
+class ScriptProfiler
+{
+public:
+    ScriptProfiler();
+
+    ///Must be called periodically (every UPDATE_INTERVAL ms) in the script thread.
+    ///Updates the CPU time, the rates and the event loop latency.
+    void updateStatistics(void);
+
+    ///Is called (from any thread) if a received data block has been queued for the script thread.
+    void dataQueued(void);
+
+    ///Is called in the script thread if a received data block has been processed.
+    void dataProcessed(quint32 bytes);
+
+    ///Is called in the script thread if data has been sent with the main interface.
+    void dataSent(quint32 bytes);
+
+    ///Is called in the script thread after a garbage collection.
+    void garbageCollected(qint64 durationNs);
+
+    ///Adds one call of a signal handler.
+    void addHandlerCall(const QString& name, qint64 durationNs);
+
+    ///Adds a sample (folded stack, the functions are separated by ';') of the sampling profiler.
+    void addSample(const QString& stack, quint64 weight);
+
+    ///Enables/disables the signal handler profiling (display only).
+    void setProfilingIsEnabled(bool enabled);
+
+    ///Returns the statistics.
+    ScriptThreadStatistics getStatistics(void);
+
+    ///Returns the statistics of all signal handlers (sorted by the total time, descending).
+    QVector<ScriptHandlerStatistics> getHandlerStatistics(void);
+
+    ///Returns the samples of the sampling profiler in the folded stack format
+    ///(one line per stack: 'function1;function2;function3 count'), which is used by flame graph tools.
+    QString getFoldedStacks(void);
+
+    ///Resets all statistics.
+    void reset(void);
+
+    ///Returns the CPU time of the calling thread (ns).
+    static qint64 currentThreadCpuTimeNs(void);
+
+    ///Converts statistics into a short text (for the script window).
+    static QString statisticsToShortString(const ScriptThreadStatistics& statistics);
+
+    ///Converts statistics into a detailed text (for the script window tool tip).
+    static QString statisticsToString(const ScriptThreadStatistics& statistics, const QVector<ScriptHandlerStatistics>& handlers);
+
+    ///The update interval (ms).
+    static const int UPDATE_INTERVAL = 1000;
+
+    ///The number of histogram bins.
+    static const int HISTOGRAM_BIN_COUNT = 6;
+
+    ///The upper limits of the histogram bins (us). The last bin contains all greater values.
+    static const quint32 HISTOGRAM_LIMITS_US[];
+
+private:
+
+    ///Protects all members which are used by more than one thread.
+    QMutex m_mutex;
+
+    ///The statistics.
+    ScriptThreadStatistics m_statistics;
+
+    ///The statistics of all signal handlers.
+    QHash<QString, ScriptHandlerStatistics> m_handlers;
+
+    ///The samples of the sampling profiler (folded stack, weight).
+    QHash<QString, quint64> m_samples;
+
+    ///The number of queued and not processed data blocks.
+    QAtomicInt m_pendingEvents;
+
+    ///The max. value of m_pendingEvents.
+    QAtomicInt m_maxPendingEvents;
+
+    ///The time base.
+    QElapsedTimer m_elapsedTimer;
+
+    ///The time of the last updateStatistics call (ns, -1 if updateStatistics has not been called yet).
+    qint64 m_lastUpdateNs;
+
+    ///The CPU time of the script thread at the last updateStatistics call (ns).
+    qint64 m_lastCpuTimeNs;
+
+    ///The CPU time of the script thread before the last reset (ns).
+    qint64 m_cpuTimeOffsetNs;
+
+    ///The value of bytesIn at the last updateStatistics call.
+    quint64 m_lastBytesIn;
+
+    ///The value of bytesOut at the last updateStatistics call.
+    quint64 m_lastBytesOut;
+};
+
+///One entry of the shadow call stack of ScriptProfilerAgent.
+typedef struct
+{
+    ///The context depth of the function.
+    int depth;
+
+    ///The function name.
+    QString name;
+}ScriptProfilerStackEntry;
+
+///Script engine agent which measures the duration of all signal handlers (script functions which are called
+///from C++) and samples the call stack (sampling profiler).
+///Note: An agent slows down the script engine, therefore the agent is only installed if profiling is enabled.
+class ScriptProfilerAgent : public QScriptEngineAgent
+{
+public:
+    ///If samplingIntervalNs is 0 then the sampling profiler is disabled.
+    ScriptProfilerAgent(QScriptEngine* engine, ScriptProfiler* profiler, qint64 samplingIntervalNs);
+
+    ///Is called if a function is called.
+    void functionEntry(qint64 scriptId);
+
+    ///Is called if a function returns.
+    void functionExit(qint64 scriptId, const QScriptValue& returnValue);
+
+    ///Is called if the engine is about to execute a statement.
+    void positionChange(qint64 scriptId, int lineNumber, int columnNumber);
+
+private:
+
+    ///Returns the depth of the current context.
+    int currentContextDepth(void);
+
+    ///Returns the name of the function of the current context.
+    QString currentFunctionName(void);
+
+    ///Removes all entries from the shadow call stack with a depth >= depth.
+    ///Ends the current handler measurement if the stack becomes empty.
+    void unwindStack(int depth);
+
+    ///Adds a sample if the sampling interval has elapsed.
+    void checkSample(void);
+
+    ///The profiler which stores the results.
+    ScriptProfiler* m_profiler;
+
+    ///The sampling interval (ns, 0=sampling disabled).
+    qint64 m_samplingIntervalNs;
+
+    ///The time of the next sample (ns).
+    qint64 m_nextSampleNs;
+
+    ///The shadow call stack.
+    QVector<ScriptProfilerStackEntry> m_stack;
+
+    ///The start time of the current handler (ns).
+    qint64 m_handlerStartNs;
+
+    ///The cached function names (key: object id of the function).
+    QHash<qint64, QString> m_functionNames;
+
+    ///The time base.
+    QElapsedTimer m_elapsedTimer;
+};
+
+#endif // SCRIPTPROFILER_H
@@ -0,0 +1,1004 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptProtocolFramer.h"
+#include "scriptSerialPort.h"
+#include "scriptTcpClient.h"
+#include "scriptUdpSocket.h"
+#include "crc.h"
+#include <string.h>
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent (script thread).
+ * @param interfaceThread
+ *      Pointer to the main interface.
+ */
+ScriptProtocolFramer::ScriptProtocolFramer(QObject *parent, MainInterfaceThread* interfaceThread) :
+    QObject(parent), m_mainInterfaceThread(interfaceThread), m_interfaceIsPaused(false), m_framingMode(FRAMING_SLIP),
+    m_checksumType(CHECKSUM_NONE), m_checksumIsBigEndian(true), m_checksumStartOffset(0), m_removeChecksum(false),
+    m_startDelimiter(), m_endDelimiter(), m_useEscapeByte(false), m_escapeByte(0), m_escapeXorValue(0x20),
+    m_lengthFieldOffset(0), m_lengthFieldSize(1), m_lengthFieldIsBigEndian(true), m_lengthAdjustment(0),
+    m_maxFrameLength(DEFAULT_MAX_FRAME_LENGTH), m_receiveState(STATE_IN_FRAME), m_currentFrame(),
+    m_unescapedTailLength(0), m_receiveBuffer(), m_pendingFrames(), m_frameCount(0), m_checksumErrorCount(0),
+    m_framingErrorCount(0), m_resyncCount(0), m_discardedByteCount(0)
+{
+    connect(parent, SIGNAL(pauseAllCreatedInterfaces(bool)),this, SLOT(pauseInterfaceSlot(bool)));
+}
+
+/**
+ * Destructor.
+ */
+ScriptProtocolFramer::~ScriptProtocolFramer()
+{
+
+}
+
+/**
+ * Sets the framing mode.
+ * @param mode
+ *      The framing mode (SLIP, COBS, STX_ETX or LENGTH).
+ * @return
+ *      False if the mode is unknown.
+ */
+bool ScriptProtocolFramer::setFramingMode(QString mode)
+{
+    bool result = true;
+
+    if(mode == "SLIP")
+    {
+        m_framingMode = FRAMING_SLIP;
+    }
+    else if(mode == "COBS")
+    {
+        m_framingMode = FRAMING_COBS;
+    }
+    else if(mode == "STX_ETX")
+    {
+        m_framingMode = FRAMING_STX_ETX;
+    }
+    else if(mode == "LENGTH")
+    {
+        m_framingMode = FRAMING_LENGTH;
+    }
+    else
+    {
+        result = false;
+    }
+
+    reset();
+    return result;
+}
+
+/**
+ * Sets the start and end delimiter of a frame.
+ * @param start
+ *      The start delimiter (STX_ETX mode) or the sync pattern (LENGTH mode).
+ * @param end
+ *      The end delimiter (STX_ETX mode).
+ */
+void ScriptProtocolFramer::setDelimiters(QVector<unsigned char> start, QVector<unsigned char> end)
+{
+    m_startDelimiter = QByteArray((const char*)start.constData(), start.size());
+    m_endDelimiter = QByteArray((const char*)end.constData(), end.size());
+    reset();
+}
+
+/**
+ * Sets the escape byte (STX_ETX mode).
+ * @param escapeByte
+ *      The escape byte.
+ * @param xorValue
+ *      An escaped byte is XORed with this value.
+ */
+void ScriptProtocolFramer::setEscapeByte(quint8 escapeByte, quint8 xorValue)
+{
+    m_useEscapeByte = true;
+    m_escapeByte = escapeByte;
+    m_escapeXorValue = xorValue;
+}
+
+/**
+ * Sets the length field (LENGTH mode).
+ * @param offset
+ *      The offset of the length field.
+ * @param size
+ *      The size of the length field (1, 2 or 4).
+ * @param isBigEndian
+ *      True if the length field is big endian.
+ * @param adjustment
+ *      This value is added to the content of the length field.
+ * @return
+ *      False if size is invalid.
+ */
+bool ScriptProtocolFramer::setLengthField(quint32 offset, quint8 size, bool isBigEndian, qint32 adjustment)
+{
+    bool result = false;
+
+    if((size == 1) || (size == 2) || (size == 4))
+    {
+        m_lengthFieldOffset = offset;
+        m_lengthFieldSize = size;
+        m_lengthFieldIsBigEndian = isBigEndian;
+        m_lengthAdjustment = adjustment;
+        reset();
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * Sets the checksum which is appended to each frame.
+ * @param type
+ *      The checksum type (NONE, CRC8, CRC16, CRC32 or CRC64).
+ * @param isBigEndian
+ *      True if the checksum is stored big endian.
+ * @param startOffset
+ *      The checksum calculation starts at this offset.
+ * @return
+ *      False if the type is unknown.
+ */
+bool ScriptProtocolFramer::setChecksum(QString type, bool isBigEndian, quint32 startOffset)
+{
+    bool result = true;
+
+    if(type == "NONE")
+    {
+        m_checksumType = CHECKSUM_NONE;
+    }
+    else if(type == "CRC8")
+    {
+        m_checksumType = CHECKSUM_CRC8;
+    }
+    else if(type == "CRC16")
+    {
+        m_checksumType = CHECKSUM_CRC16;
+    }
+    else if(type == "CRC32")
+    {
+        m_checksumType = CHECKSUM_CRC32;
+    }
+    else if(type == "CRC64")
+    {
+        m_checksumType = CHECKSUM_CRC64;
+    }
+    else
+    {
+        result = false;
+    }
+
+    if(result)
+    {
+        m_checksumIsBigEndian = isBigEndian;
+        m_checksumStartOffset = startOffset;
+    }
+
+    return result;
+}
+
+/**
+ * Discards all partially received data.
+ */
+void ScriptProtocolFramer::reset(void)
+{
+    m_currentFrame.clear();
+    m_receiveBuffer.clear();
+    m_unescapedTailLength = 0;
+
+    //A STX_ETX frame must start with the start delimiter.
+    m_receiveState = ((m_framingMode == FRAMING_STX_ETX) && !m_startDelimiter.isEmpty()) ? STATE_HUNT : STATE_IN_FRAME;
+}
+
+/**
+ * Resets all statistic counters.
+ */
+void ScriptProtocolFramer::resetStatistics(void)
+{
+    m_frameCount = 0;
+    m_checksumErrorCount = 0;
+    m_framingErrorCount = 0;
+    m_resyncCount = 0;
+    m_discardedByteCount = 0;
+}
+
+/**
+ * All data received with the main interface is processed by this framer.
+ */
+void ScriptProtocolFramer::attachToMainInterface(void)
+{
+    connect(m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
+            this, SLOT(mainInterfaceReceivedSlot(QByteArray)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+}
+
+/**
+ * Stops the processing of main interface data.
+ */
+void ScriptProtocolFramer::detachFromMainInterface(void)
+{
+    disconnect(m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
+               this, SLOT(mainInterfaceReceivedSlot(QByteArray)));
+}
+
+/**
+ * All data received with interfaceObject is processed by this framer.
+ * @param interfaceObject
+ *      The interface (script serial port, TCP client or UDP socket).
+ * @return
+ *      False if interfaceObject is not supported.
+ */
+bool ScriptProtocolFramer::attachToInterface(QObject* interfaceObject)
+{
+    bool result = false;
+
+    if(qobject_cast<ScriptSerialPort*>(interfaceObject) || qobject_cast<ScriptTcpClient*>(interfaceObject)
+            || qobject_cast<ScriptUdpSocket*>(interfaceObject))
+    {
+        connect(interfaceObject, SIGNAL(readyReadSignal()), this, SLOT(interfaceReadyReadSlot()), Qt::UniqueConnection);
+        result = true;
+    }
+
+    return result;
+}
+
+/**
+ * Stops the processing of the data from interfaceObject.
+ * @param interfaceObject
+ *      The interface.
+ */
+void ScriptProtocolFramer::detachFromInterface(QObject* interfaceObject)
+{
+    if(interfaceObject)
+    {
+        disconnect(interfaceObject, SIGNAL(readyReadSignal()), this, SLOT(interfaceReadyReadSlot()));
+    }
+}
+
+/**
+ * Is called if the main interface has received data.
+ * @param data
+ *      The received data.
+ */
+void ScriptProtocolFramer::mainInterfaceReceivedSlot(QByteArray data)
+{
+    processBytes((const unsigned char*)data.constData(), data.size());
+}
+
+/**
+ * Is called if an attached interface has received data.
+ */
+void ScriptProtocolFramer::interfaceReadyReadSlot(void)
+{
+    QObject* source = sender();
+    QVector<unsigned char> data;
+
+    if(ScriptSerialPort* serialPort = qobject_cast<ScriptSerialPort*>(source))
+    {
+        data = serialPort->readAll();
+    }
+    else if(ScriptTcpClient* tcpClient = qobject_cast<ScriptTcpClient*>(source))
+    {
+        data = tcpClient->readAll();
+    }
+    else if(ScriptUdpSocket* udpSocket = qobject_cast<ScriptUdpSocket*>(source))
+    {
+        data = udpSocket->readAll();
+    }
+
+    processBytes(data.constData(), data.size());
+}
+
+/**
+ * Processes received data (called from a script).
+ * @param data
+ *      The received data.
+ */
+void ScriptProtocolFramer::processData(QVector<unsigned char> data)
+{
+    processBytes(data.constData(), data.size());
+}
+
+/**
+ * Processes received data.
+ * @param data
+ *      The received data.
+ * @param length
+ *      The number of bytes in data.
+ */
+void ScriptProtocolFramer::processBytes(const unsigned char* data, int length)
+{
+    if(m_interfaceIsPaused || (length <= 0))
+    {
+        return;
+    }
+
+    switch(m_framingMode)
+    {
+    case FRAMING_SLIP:
+        for(int i = 0; i < length; i++)
+        {
+            processSlipByte(data[i]);
+        }
+        break;
+
+    case FRAMING_COBS:
+        for(int i = 0; i < length; i++)
+        {
+            processCobsByte(data[i]);
+        }
+        break;
+
+    case FRAMING_STX_ETX:
+        for(int i = 0; i < length; i++)
+        {
+            processStxEtxByte(data[i]);
+        }
+        break;
+
+    case FRAMING_LENGTH:
+        m_receiveBuffer.append((const char*)data, length);
+        processLengthBuffer();
+        break;
+    }
+
+    emitPendingFrames();
+}
+
+/**
+ * Processes one byte (SLIP mode).
+ * @param byte
+ *      The byte.
+ */
+void ScriptProtocolFramer::processSlipByte(unsigned char byte)
+{
+    if(m_receiveState == STATE_HUNT)
+    {
+        if(byte == SLIP_END)
+        {
+            m_receiveState = STATE_IN_FRAME;
+        }
+        else
+        {
+            m_discardedByteCount++;
+        }
+    }
+    else if(m_receiveState == STATE_IN_FRAME)
+    {
+        if(byte == SLIP_END)
+        {
+            if(!m_currentFrame.isEmpty())
+            {
+                if(!finishFrame((const unsigned char*)m_currentFrame.constData(), m_currentFrame.size()))
+                {
+                    m_discardedByteCount += m_currentFrame.size();
+                }
+                m_currentFrame.clear();
+            }
+        }
+        else if(byte == SLIP_ESC)
+        {
+            m_receiveState = STATE_ESCAPE;
+        }
+        else
+        {
+            m_currentFrame.append((char)byte);
+        }
+    }
+    else
+    {//STATE_ESCAPE
+
+        if(byte == SLIP_ESC_END)
+        {
+            m_currentFrame.append((char)SLIP_END);
+            m_receiveState = STATE_IN_FRAME;
+        }
+        else if(byte == SLIP_ESC_ESC)
+        {
+            m_currentFrame.append((char)SLIP_ESC);
+            m_receiveState = STATE_IN_FRAME;
+        }
+        else
+        {
+            addFramingError("invalid SLIP escape sequence");
+            m_discardedByteCount += m_currentFrame.size() + 1;
+            m_currentFrame.clear();
+            m_resyncCount++;
+
+            //Discard everything up to the next end byte.
+            m_receiveState = (byte == SLIP_END) ? STATE_IN_FRAME : STATE_HUNT;
+        }
+    }
+
+    if((quint32)m_currentFrame.size() > m_maxFrameLength)
+    {
+        addFramingError("frame too long");
+        m_discardedByteCount += m_currentFrame.size();
+        m_currentFrame.clear();
+        m_resyncCount++;
+        m_receiveState = STATE_HUNT;
+    }
+}
+
+/**
+ * Processes one byte (COBS mode).
+ * @param byte
+ *      The byte.
+ */
+void ScriptProtocolFramer::processCobsByte(unsigned char byte)
+{
+    if(m_receiveState == STATE_HUNT)
+    {
+        if(byte == 0)
+        {
+            m_receiveState = STATE_IN_FRAME;
+        }
+        else
+        {
+            m_discardedByteCount++;
+        }
+        return;
+    }
+
+    if(byte != 0)
+    {
+        m_currentFrame.append((char)byte);
+
+        //COBS adds at most one byte per 254 data bytes.
+        if((quint32)m_currentFrame.size() > (m_maxFrameLength + (m_maxFrameLength / 254) + 1))
+        {
+            addFramingError("frame too long");
+            m_discardedByteCount += m_currentFrame.size();
+            m_currentFrame.clear();
+            m_resyncCount++;
+            m_receiveState = STATE_HUNT;
+        }
+        return;
+    }
+
+    if(m_currentFrame.isEmpty())
+    {//Empty frame (delimiter only).
+        return;
+    }
+
+    //Decode the frame in place (the decoded frame is never longer than the encoded one).
+    unsigned char* frame = (unsigned char*)m_currentFrame.data();
+    const int encodedSize = m_currentFrame.size();
+    int readIndex = 0;
+    int writeIndex = 0;
+    bool isValid = true;
+
+    while(readIndex < encodedSize)
+    {
+        const int code = frame[readIndex++];
+
+        if((readIndex + code - 1) > encodedSize)
+        {
+            isValid = false;
+            break;
+        }
+
+        for(int i = 1; i < code; i++)
+        {
+            frame[writeIndex++] = frame[readIndex++];
+        }
+
+        if((code < 0xFF) && (readIndex < encodedSize))
+        {
+            frame[writeIndex++] = 0;
+        }
+    }
+
+    if(isValid)
+    {
+        if(!finishFrame(frame, writeIndex))
+        {
+            m_discardedByteCount += encodedSize;
+        }
+    }
+    else
+    {
+        addFramingError("invalid COBS data");
+        m_discardedByteCount += encodedSize;
+        m_resyncCount++;
+    }
+
+    m_currentFrame.clear();
+}
+
+/**
+ * Processes one byte (STX_ETX mode).
+ * @param byte
+ *      The byte.
+ */
+void ScriptProtocolFramer::processStxEtxByte(unsigned char byte)
+{
+    if(m_receiveState == STATE_HUNT)
+    {
+        m_currentFrame.append((char)byte);
+
+        if(m_currentFrame.endsWith(m_startDelimiter))
+        {
+            m_discardedByteCount += m_currentFrame.size() - m_startDelimiter.size();
+            m_currentFrame.clear();
+            m_unescapedTailLength = 0;
+            m_receiveState = STATE_IN_FRAME;
+        }
+        else if(m_currentFrame.size() >= m_startDelimiter.size())
+        {
+            m_currentFrame.remove(0, 1);
+            m_discardedByteCount++;
+        }
+        return;
+    }
+
+    if(m_receiveState == STATE_ESCAPE)
+    {
+        m_currentFrame.append((char)(byte ^ m_escapeXorValue));
+        m_unescapedTailLength = 0;
+        m_receiveState = STATE_IN_FRAME;
+    }
+    else if(m_useEscapeByte && (byte == m_escapeByte))
+    {
+        m_receiveState = STATE_ESCAPE;
+        return;
+    }
+    else
+    {
+        m_currentFrame.append((char)byte);
+        m_unescapedTailLength++;
+
+        if(!m_endDelimiter.isEmpty() && (m_unescapedTailLength >= m_endDelimiter.size())
+                && m_currentFrame.endsWith(m_endDelimiter))
+        {
+            const int frameSize = m_currentFrame.size() - m_endDelimiter.size();
+            if(!finishFrame((const unsigned char*)m_currentFrame.constData(), frameSize))
+            {
+                m_discardedByteCount += frameSize;
+            }
+            m_currentFrame.clear();
+            m_unescapedTailLength = 0;
+            m_receiveState = m_startDelimiter.isEmpty() ? STATE_IN_FRAME : STATE_HUNT;
+            return;
+        }
+
+        if(!m_startDelimiter.isEmpty() && (m_unescapedTailLength >= m_startDelimiter.size())
+                && m_currentFrame.endsWith(m_startDelimiter))
+        {//A new frame has been started before the current frame has been finished.
+
+            addFramingError("start delimiter inside frame");
+            m_discardedByteCount += m_currentFrame.size() - m_startDelimiter.size();
+            m_currentFrame.clear();
+            m_unescapedTailLength = 0;
+            m_resyncCount++;
+            return;
+        }
+    }
+
+    if((quint32)m_currentFrame.size() > (m_maxFrameLength + m_endDelimiter.size()))
+    {
+        addFramingError("frame too long");
+        m_discardedByteCount += m_currentFrame.size();
+        m_currentFrame.clear();
+        m_unescapedTailLength = 0;
+        m_resyncCount++;
+        m_receiveState = m_startDelimiter.isEmpty() ? STATE_IN_FRAME : STATE_HUNT;
+    }
+}
+
+/**
+ * Processes the receive buffer (LENGTH mode).
+ */
+void ScriptProtocolFramer::processLengthBuffer(void)
+{
+    const unsigned char* buffer = (const unsigned char*)m_receiveBuffer.constData();
+    const int bufferSize = m_receiveBuffer.size();
+    const qint64 headerSize = (qint64)m_lengthFieldOffset + m_lengthFieldSize;
+    int position = 0;
+
+    while(position < bufferSize)
+    {
+        if(!m_startDelimiter.isEmpty())
+        {
+            int index = m_receiveBuffer.indexOf(m_startDelimiter, position);
+            if(index < 0)
+            {
+                //Keep the bytes which could be the beginning of the sync pattern.
+                int newPosition = qMax(position, bufferSize - (m_startDelimiter.size() - 1));
+                m_discardedByteCount += newPosition - position;
+                position = newPosition;
+                break;
+            }
+            m_discardedByteCount += index - position;
+            position = index;
+        }
+
+        if((bufferSize - position) < headerSize)
+        {
+            break;
+        }
+
+        quint64 value = readValue(&buffer[position + m_lengthFieldOffset], m_lengthFieldSize, m_lengthFieldIsBigEndian);
+        qint64 frameLength = headerSize + (qint64)value + m_lengthAdjustment;
+
+        if((frameLength < (headerSize + checksumSize())) || (frameLength < m_startDelimiter.size())
+                || (frameLength > (qint64)m_maxFrameLength))
+        {
+            addFramingError("invalid length field");
+            m_resyncCount++;
+            m_discardedByteCount++;
+            position++;
+            continue;
+        }
+
+        if((bufferSize - position) < frameLength)
+        {
+            break;
+        }
+
+        if(finishFrame(&buffer[position], (int)frameLength))
+        {
+            position += (int)frameLength;
+        }
+        else
+        {
+            m_resyncCount++;
+            m_discardedByteCount++;
+            position++;
+        }
+    }
+
+    m_receiveBuffer.remove(0, position);
+}
+
+/**
+ * Checks the checksum of a decoded frame and adds it to m_pendingFrames.
+ * @param frame
+ *      The decoded frame.
+ * @param length
+ *      The number of bytes in frame.
+ * @return
+ *      False if the checksum is invalid.
+ */
+bool ScriptProtocolFramer::finishFrame(const unsigned char* frame, int length)
+{
+    const int numberOfChecksumBytes = checksumSize();
+
+    if(numberOfChecksumBytes > 0)
+    {
+        if(length < ((qint64)m_checksumStartOffset + numberOfChecksumBytes))
+        {
+            m_checksumErrorCount++;
+            emit frameErrorSignal("frame too short for checksum");
+            return false;
+        }
+
+        quint64 expected = calculateChecksum(&frame[m_checksumStartOffset], length - numberOfChecksumBytes - m_checksumStartOffset);
+        quint64 received = readValue(&frame[length - numberOfChecksumBytes], numberOfChecksumBytes, m_checksumIsBigEndian);
+
+        if(expected != received)
+        {
+            m_checksumErrorCount++;
+            emit frameErrorSignal("invalid checksum");
+            return false;
+        }
+
+        if(m_removeChecksum)
+        {
+            length -= numberOfChecksumBytes;
+        }
+    }
+
+    QVector<unsigned char> result(length);
+    if(length > 0)
+    {
+        memcpy(result.data(), frame, length);
+    }
+    m_pendingFrames.append(result);
+    m_frameCount++;
+
+    return true;
+}
+
+/**
+ * Adds a framing error.
+ * @param error
+ *      The error description.
+ */
+void ScriptProtocolFramer::addFramingError(QString error)
+{
+    m_framingErrorCount++;
+    emit frameErrorSignal(error);
+}
+
+/**
+ * Emits all pending frames.
+ */
+void ScriptProtocolFramer::emitPendingFrames(void)
+{
+    if(!m_pendingFrames.isEmpty())
+    {
+        QVector<QVector<unsigned char>> frames;
+        frames.swap(m_pendingFrames);
+        emit framesReceivedSignal(frames);
+    }
+}
+
+/**
+ * Returns the number of checksum bytes.
+ * @return
+ *      The number of checksum bytes.
+ */
+int ScriptProtocolFramer::checksumSize(void)
+{
+    int result = 0;
+
+    switch(m_checksumType)
+    {
+    case CHECKSUM_NONE:
+        result = 0;
+        break;
+    case CHECKSUM_CRC8:
+        result = 1;
+        break;
+    case CHECKSUM_CRC16:
+        result = 2;
+        break;
+    case CHECKSUM_CRC32:
+        result = 4;
+        break;
+    case CHECKSUM_CRC64:
+        result = 8;
+        break;
+    }
+
+    return result;
+}
+
+/**
+ * Calculates the checksum.
+ * @param data
+ *      The data.
+ * @param length
+ *      The number of bytes in data.
+ * @return
+ *      The checksum.
+ */
+quint64 ScriptProtocolFramer::calculateChecksum(const unsigned char* data, int length)
+{
+    quint64 result = 0;
+
+    switch(m_checksumType)
+    {
+    case CHECKSUM_NONE:
+        result = 0;
+        break;
+    case CHECKSUM_CRC8:
+        result = CRC::calculateCrc8(data, length);
+        break;
+    case CHECKSUM_CRC16:
+        result = CRC::calculateCrc16(data, length);
+        break;
+    case CHECKSUM_CRC32:
+        result = CRC::calculateCrc32(data, length);
+        break;
+    case CHECKSUM_CRC64:
+        result = CRC::calculateCrc64(data, length);
+        break;
+    }
+
+    return result;
+}
+
+/**
+ * Reads an unsigned value.
+ * @param data
+ *      The data.
+ * @param size
+ *      The number of bytes.
+ * @param isBigEndian
+ *      True if the value is stored big endian.
+ * @return
+ *      The value.
+ */
+quint64 ScriptProtocolFramer::readValue(const unsigned char* data, int size, bool isBigEndian)
+{
+    quint64 result = 0;
+
+    for(int i = 0; i < size; i++)
+    {
+        const quint64 byte = isBigEndian ? data[i] : data[size - 1 - i];
+        result = (result << 8) | byte;
+    }
+
+    return result;
+}
+
+/**
+ * Writes an unsigned value.
+ * @param data
+ *      The destination.
+ * @param size
+ *      The number of bytes.
+ * @param isBigEndian
+ *      True if the value shall be stored big endian.
+ * @param value
+ *      The value.
+ */
+void ScriptProtocolFramer::writeValue(unsigned char* data, int size, bool isBigEndian, quint64 value)
+{
+    for(int i = 0; i < size; i++)
+    {
+        const unsigned char byte = (unsigned char)(value >> (8 * (size - 1 - i)));
+        data[isBigEndian ? i : (size - 1 - i)] = byte;
+    }
+}
+
+/**
+ * Appends one byte (escaped if necessary) to a frame (SLIP and STX_ETX mode).
+ * @param frame
+ *      The frame.
+ * @param byte
+ *      The byte.
+ */
+void ScriptProtocolFramer::appendEscaped(QVector<unsigned char>& frame, unsigned char byte)
+{
+    if(m_framingMode == FRAMING_SLIP)
+    {
+        if(byte == SLIP_END)
+        {
+            frame.append(SLIP_ESC);
+            frame.append(SLIP_ESC_END);
+        }
+        else if(byte == SLIP_ESC)
+        {
+            frame.append(SLIP_ESC);
+            frame.append(SLIP_ESC_ESC);
+        }
+        else
+        {
+            frame.append(byte);
+        }
+    }
+    else
+    {
+        bool escape = false;
+        if(m_useEscapeByte)
+        {
+            escape = (byte == m_escapeByte)
+                    || (!m_startDelimiter.isEmpty() && (byte == (unsigned char)m_startDelimiter[0]))
+                    || (!m_endDelimiter.isEmpty() && (byte == (unsigned char)m_endDelimiter[0]));
+        }
+
+        if(escape)
+        {
+            frame.append(m_escapeByte);
+            frame.append(byte ^ m_escapeXorValue);
+        }
+        else
+        {
+            frame.append(byte);
+        }
+    }
+}
+
+/**
+ * Creates a frame (adds the checksum, escapes the data and adds the delimiters/length field).
+ * @param data
+ *      The frame content.
+ * @return
+ *      The created frame.
+ */
+QVector<unsigned char> ScriptProtocolFramer::encodeFrame(QVector<unsigned char> data)
+{
+    QVector<unsigned char> frame = data;
+    QVector<unsigned char> result;
+    const int numberOfChecksumBytes = checksumSize();
+    const int headerSize = m_lengthFieldOffset + m_lengthFieldSize;
+
+    if((m_framingMode == FRAMING_LENGTH) && (frame.size() >= headerSize))
+    {
+        qint64 value = (qint64)frame.size() + numberOfChecksumBytes - headerSize - m_lengthAdjustment;
+        writeValue(&frame.data()[m_lengthFieldOffset], m_lengthFieldSize, m_lengthFieldIsBigEndian, (quint64)value);
+    }
+
+    if(numberOfChecksumBytes > 0)
+    {
+        const int startOffset = qMin((int)m_checksumStartOffset, frame.size());
+        quint64 checksum = calculateChecksum(&frame.constData()[startOffset], frame.size() - startOffset);
+        const int oldSize = frame.size();
+        frame.resize(oldSize + numberOfChecksumBytes);
+        writeValue(&frame.data()[oldSize], numberOfChecksumBytes, m_checksumIsBigEndian, checksum);
+    }
+
+    switch(m_framingMode)
+    {
+    case FRAMING_SLIP:
+    {
+        result.reserve((frame.size() * 2) + 2);
+        result.append(SLIP_END);
+        for(auto byte : frame)
+        {
+            appendEscaped(result, byte);
+        }
+        result.append(SLIP_END);
+        break;
+    }
+    case FRAMING_COBS:
+    {
+        result.reserve(frame.size() + (frame.size() / 254) + 2);
+        int codeIndex = 0;
+        unsigned char code = 1;
+        result.append(0);
+
+        for(auto byte : frame)
+        {
+            if(byte == 0)
+            {
+                result[codeIndex] = code;
+                codeIndex = result.size();
+                result.append(0);
+                code = 1;
+            }
+            else
+            {
+                result.append(byte);
+                code++;
+                if(code == 0xFF)
+                {
+                    result[codeIndex] = code;
+                    codeIndex = result.size();
+                    result.append(0);
+                    code = 1;
+                }
+            }
+        }
+        result[codeIndex] = code;
+        result.append(0);
+        break;
+    }
+    case FRAMING_STX_ETX:
+    {
+        result.reserve((frame.size() * 2) + m_startDelimiter.size() + m_endDelimiter.size());
+        for(auto byte : m_startDelimiter)
+        {
+            result.append((unsigned char)byte);
+        }
+        for(auto byte : frame)
+        {
+            appendEscaped(result, byte);
+        }
+        for(auto byte : m_endDelimiter)
+        {
+            result.append((unsigned char)byte);
+        }
+        break;
+    }
+    case FRAMING_LENGTH:
+        result = frame;
+        break;
+    }
+
+    return result;
+}
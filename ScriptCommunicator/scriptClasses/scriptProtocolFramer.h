@@ -0,0 +1,316 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTPROTOCOLFRAMER_H
+#define SCRIPTPROTOCOLFRAMER_H
+
+#include <QObject>
+#include <QVector>
+#include <QByteArray>
+#include <mainInterfaceThread.h>
+
+///This class splits a byte stream into frames (SLIP, COBS, STX/ETX or length prefixed).
+///The framing is done in C++; scripts only receive complete and validated frames.
+class ScriptProtocolFramer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptProtocolFramer(QObject *parent, MainInterfaceThread* interfaceThread);
+    virtual ~ScriptProtocolFramer();
+
+    ///The supported framing modes.
+    typedef enum
+    {
+        FRAMING_SLIP = 0,
+        FRAMING_COBS,
+        FRAMING_STX_ETX,
+        FRAMING_LENGTH
+    }FramingMode;
+
+    ///The supported checksum types (all are calculated with the CRC class).
+    typedef enum
+    {
+        CHECKSUM_NONE = 0,
+        CHECKSUM_CRC8,
+        CHECKSUM_CRC16,
+        CHECKSUM_CRC32,
+        CHECKSUM_CRC64
+    }ChecksumType;
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptProtocolFramer*>("ScriptProtocolFramer*");
+    }
+
+    ///Sets the framing mode. Possible values are:
+    ///- SLIP (RFC 1055, 0xC0 delimiter, 0xDB escape byte)
+    ///- COBS (consistent overhead byte stuffing, 0x00 delimiter)
+    ///- STX_ETX (start/end delimiters, see setDelimiters and setEscapeByte)
+    ///- LENGTH (length field, see setLengthField and setDelimiters)
+    ///Returns false if the mode is unknown.
+    ///Note: Changing the mode resets the receive state (but not the statistics).
+    Q_INVOKABLE bool setFramingMode(QString mode);
+
+    ///Sets the start and end delimiter of a frame (STX_ETX mode).
+    ///In LENGTH mode the start delimiter is used as sync pattern (an empty start delimiter
+    ///means every byte can be the start of a frame).
+    Q_INVOKABLE void setDelimiters(QVector<unsigned char> start, QVector<unsigned char> end);
+
+    ///Sets the escape byte (STX_ETX mode). An escaped byte is sent as escapeByte followed by
+    ///(byte XOR xorValue). A xorValue of 0 means the byte is sent unchanged after the escape byte.
+    Q_INVOKABLE void setEscapeByte(quint8 escapeByte, quint8 xorValue=0x20);
+
+    ///Disables the escape byte (STX_ETX mode).
+    Q_INVOKABLE void disableEscapeByte(void){m_useEscapeByte = false;}
+
+    ///Sets the length field (LENGTH mode). The total frame size is calculated as:
+    ///offset + size + value + adjustment (value is the content of the length field).
+    ///Possible values for size are 1, 2 and 4. Returns false if size is invalid.
+    Q_INVOKABLE bool setLengthField(quint32 offset, quint8 size, bool isBigEndian=true, qint32 adjustment=0);
+
+    ///Sets the checksum which is appended to each frame. Possible values for type are:
+    ///- NONE
+    ///- CRC8
+    ///- CRC16
+    ///- CRC32
+    ///- CRC64
+    ///The checksum is calculated from startOffset up to the checksum (in the decoded frame).
+    ///Returns false if the type is unknown.
+    Q_INVOKABLE bool setChecksum(QString type, bool isBigEndian=true, quint32 startOffset=0);
+
+    ///Sets the maximum size of a frame (decoded). Larger frames are discarded (framing error).
+    Q_INVOKABLE void setMaxFrameLength(quint32 maxLength){m_maxFrameLength = maxLength;}
+
+    ///If removeChecksum is true the checksum bytes are removed from the emitted frames.
+    Q_INVOKABLE void setRemoveChecksum(bool removeChecksum){m_removeChecksum = removeChecksum;}
+
+    ///Processes received data (all complete frames are emitted with framesReceivedSignal).
+    Q_INVOKABLE void processData(QVector<unsigned char> data);
+
+    ///Creates a frame (adds the checksum, escapes the data and adds the delimiters/length field).
+    ///In LENGTH mode data must contain the complete frame (header included) without checksum,
+    ///the length field is filled in by this function.
+    Q_INVOKABLE QVector<unsigned char> encodeFrame(QVector<unsigned char> data);
+
+    ///All data received with the main interface is processed by this framer.
+    Q_INVOKABLE void attachToMainInterface(void);
+
+    ///Stops the processing of main interface data.
+    Q_INVOKABLE void detachFromMainInterface(void);
+
+    ///All data received with interfaceObject is processed by this framer. interfaceObject must be a
+    ///script serial port, TCP client or UDP socket. Returns false if interfaceObject is not supported.
+    ///Note: The framer reads the data from interfaceObject (readAll must not be called by the script).
+    Q_INVOKABLE bool attachToInterface(QObject* interfaceObject);
+
+    ///Stops the processing of the data from interfaceObject.
+    Q_INVOKABLE void detachFromInterface(QObject* interfaceObject);
+
+    ///Discards all partially received data.
+    Q_INVOKABLE void reset(void);
+
+    ///Returns the number of received (valid) frames.
+    Q_INVOKABLE quint32 getFrameCount(void){return m_frameCount;}
+
+    ///Returns the number of frames with an invalid checksum.
+    Q_INVOKABLE quint32 getChecksumErrorCount(void){return m_checksumErrorCount;}
+
+    ///Returns the number of framing errors (invalid escape sequences, invalid COBS data,
+    ///invalid length fields and too long frames).
+    Q_INVOKABLE quint32 getFramingErrorCount(void){return m_framingErrorCount;}
+
+    ///Returns how often the framer had to resynchronize with the byte stream.
+    Q_INVOKABLE quint32 getResyncCount(void){return m_resyncCount;}
+
+    ///Returns the number of discarded bytes (bytes outside of a valid frame).
+    Q_INVOKABLE quint32 getDiscardedByteCount(void){return m_discardedByteCount;}
+
+    ///Resets all statistic counters.
+    Q_INVOKABLE void resetStatistics(void);
+
+signals:
+    ///This signal is emitted if complete and valid frames have been received.
+    ///All frames found in one block of received data are emitted with one signal.
+    ///Scripts can connect a function to this signal.
+    void framesReceivedSignal(QVector<QVector<unsigned char>> frames);
+
+    ///This signal is emitted if a frame has been discarded (checksum or framing error).
+    ///Scripts can connect a function to this signal.
+    void frameErrorSignal(QString error);
+
+private slots:
+
+    ///Is called if the main interface has received data.
+    void mainInterfaceReceivedSlot(QByteArray data);
+
+    ///Is called if an attached interface has received data.
+    void interfaceReadyReadSlot(void);
+
+    ///If pause is true, all received data is discarded.
+    void pauseInterfaceSlot(bool pause){m_interfaceIsPaused = pause;}
+
+private:
+
+    ///The state of the byte wise state machine (SLIP, COBS and STX_ETX).
+    typedef enum
+    {
+        STATE_HUNT = 0,
+        STATE_IN_FRAME,
+        STATE_ESCAPE
+    }ReceiveState;
+
+    ///Processes received data.
+    void processBytes(const unsigned char* data, int length);
+
+    ///Processes one byte (SLIP mode).
+    void processSlipByte(unsigned char byte);
+
+    ///Processes one byte (COBS mode).
+    void processCobsByte(unsigned char byte);
+
+    ///Processes one byte (STX_ETX mode).
+    void processStxEtxByte(unsigned char byte);
+
+    ///Processes the receive buffer (LENGTH mode).
+    void processLengthBuffer(void);
+
+    ///Checks the checksum of a decoded frame and adds it to m_pendingFrames.
+    ///Returns false if the checksum is invalid.
+    bool finishFrame(const unsigned char* frame, int length);
+
+    ///Adds a framing error.
+    void addFramingError(QString error);
+
+    ///Emits all pending frames.
+    void emitPendingFrames(void);
+
+    ///Returns the number of checksum bytes.
+    int checksumSize(void);
+
+    ///Calculates the checksum.
+    quint64 calculateChecksum(const unsigned char* data, int length);
+
+    ///Reads an unsigned value (size bytes) with the given endianess.
+    static quint64 readValue(const unsigned char* data, int size, bool isBigEndian);
+
+    ///Writes an unsigned value (size bytes) with the given endianess.
+    static void writeValue(unsigned char* data, int size, bool isBigEndian, quint64 value);
+
+    ///Appends one byte (escaped if necessary) to a frame (SLIP and STX_ETX mode).
+    void appendEscaped(QVector<unsigned char>& frame, unsigned char byte);
+
+    ///Pointer to the main interface.
+    MainInterfaceThread* m_mainInterfaceThread;
+
+    ///If m_interfaceIsPaused is true, all received data is dicarded.
+    bool m_interfaceIsPaused;
+
+    ///The current framing mode.
+    FramingMode m_framingMode;
+
+    ///The current checksum type.
+    ChecksumType m_checksumType;
+
+    ///True if the checksum is stored big endian.
+    bool m_checksumIsBigEndian;
+
+    ///The checksum calculation starts at this offset.
+    quint32 m_checksumStartOffset;
+
+    ///True if the checksum shall be removed from the emitted frames.
+    bool m_removeChecksum;
+
+    ///The start delimiter (STX_ETX mode) or the sync pattern (LENGTH mode).
+    QByteArray m_startDelimiter;
+
+    ///The end delimiter (STX_ETX mode).
+    QByteArray m_endDelimiter;
+
+    ///True if m_escapeByte is used.
+    bool m_useEscapeByte;
+
+    ///The escape byte (STX_ETX mode).
+    unsigned char m_escapeByte;
+
+    ///An escaped byte is XORed with this value.
+    unsigned char m_escapeXorValue;
+
+    ///The offset of the length field (LENGTH mode).
+    quint32 m_lengthFieldOffset;
+
+    ///The size of the length field (LENGTH mode).
+    quint8 m_lengthFieldSize;
+
+    ///True if the length field is big endian.
+    bool m_lengthFieldIsBigEndian;
+
+    ///This value is added to the length field.
+    qint32 m_lengthAdjustment;
+
+    ///The maximum size of a (decoded) frame.
+    quint32 m_maxFrameLength;
+
+    ///The current receive state (SLIP, COBS and STX_ETX).
+    ReceiveState m_receiveState;
+
+    ///The current (decoded) frame (SLIP and STX_ETX) or the undecoded COBS data.
+    QByteArray m_currentFrame;
+
+    ///Number of bytes at the end of m_currentFrame which have not been escaped (STX_ETX mode).
+    int m_unescapedTailLength;
+
+    ///The receive buffer (LENGTH mode).
+    QByteArray m_receiveBuffer;
+
+    ///All frames which have been found in the current block of data.
+    QVector<QVector<unsigned char>> m_pendingFrames;
+
+    ///Number of received (valid) frames.
+    quint32 m_frameCount;
+
+    ///Number of frames with an invalid checksum.
+    quint32 m_checksumErrorCount;
+
+    ///Number of framing errors.
+    quint32 m_framingErrorCount;
+
+    ///Number of resynchronisations.
+    quint32 m_resyncCount;
+
+    ///Number of discarded bytes.
+    quint32 m_discardedByteCount;
+
+    ///The SLIP special bytes.
+    static const unsigned char SLIP_END = 0xC0;
+    static const unsigned char SLIP_ESC = 0xDB;
+    static const unsigned char SLIP_ESC_END = 0xDC;
+    static const unsigned char SLIP_ESC_ESC = 0xDD;
+
+    ///The default maximum frame size.
+    static const quint32 DEFAULT_MAX_FRAME_LENGTH = 65536;
+};
+
+#endif // SCRIPTPROTOCOLFRAMER_H
@@ -0,0 +1,859 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptSequencePlaylist.h"
+#include "sendwindow.h"
+
+/**
+ * Constructor.
+ * @param sendId
+ *      The send id of the engine (identifies the sends of the engine in the main interface thread).
+ */
+SequencePlaylistEngine::SequencePlaylistEngine(quint32 sendId) : QThread(0), m_mutex(), m_waitCondition(), m_tracks(), m_trackStates(),
+    m_statistics(), m_pendingSends(), m_sendId(sendId), m_stop(true), m_failed(false), m_hasNewEvent(false), m_elapsedTimer()
+{
+}
+
+/**
+ * Destructor.
+ */
+SequencePlaylistEngine::~SequencePlaylistEngine()
+{
+    stopPlaylist();
+}
+
+/**
+ * Starts the playlist.
+ * @param tracks
+ *      The steps of all tracks.
+ */
+void SequencePlaylistEngine::startPlaylist(const QVector<QVector<PlaylistStep>>& tracks)
+{
+    stopPlaylist();
+
+    QMutexLocker locker(&m_mutex);
+    m_tracks = tracks;
+    m_trackStates.clear();
+    m_statistics.clear();
+
+    if(!m_pendingSends.isEmpty())
+    {//The main interface has not finished all sends of the previous run. The new run gets a new send id,
+     //so the late sending finished notifications of the previous run are ignored.
+        m_sendId = MainInterfaceThread::getNextSendEngineId();
+        m_pendingSends.clear();
+    }
+
+    for(auto el : m_tracks)
+    {
+        PlaylistTrackState state;
+        state.currentStep = 0;
+        state.timeNs = 0;
+        state.waitStartNs = 0;
+        state.isWaiting = false;
+        state.sendIsPending = false;
+        state.isFinished = false;
+        m_trackStates.append(state);
+
+        PlaylistStepStatistics statistics;
+        statistics.count = 0;
+        statistics.misses = 0;
+        statistics.minNs = 0;
+        statistics.maxNs = 0;
+        statistics.sumNs = 0;
+        statistics.lastNs = 0;
+        m_statistics.append(QVector<PlaylistStepStatistics>(el.size(), statistics));
+    }
+
+    m_stop = false;
+    m_failed = false;
+    m_hasNewEvent = false;
+
+    start(QThread::TimeCriticalPriority);
+}
+
+/**
+ * Stops the playlist and waits until the playlist thread has been finished.
+ */
+void SequencePlaylistEngine::stopPlaylist(void)
+{
+    m_mutex.lock();
+    m_stop = true;
+    m_waitCondition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/**
+ * Returns the statistics of all steps.
+ * @return
+ *      The statistics (one vector per track).
+ */
+QVector<QVector<PlaylistStepStatistics>> SequencePlaylistEngine::getStatistics(void)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+/**
+ * Must be called (direct connection) if the main interface has sent data.
+ * @param success
+ *      True on success.
+ * @param id
+ *      The send id.
+ */
+void SequencePlaylistEngine::sendingFinishedSlot(bool success, uint id)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(id == m_sendId)
+    {
+        if(!m_pendingSends.isEmpty())
+        {
+            PlaylistPendingSend pendingSend = m_pendingSends.dequeue();
+            if(pendingSend.track < m_trackStates.size())
+            {
+                PlaylistTrackState& track = m_trackStates[pendingSend.track];
+                track.sendIsPending = false;
+
+                if(success)
+                {
+                    qint64 latencyNs = m_elapsedTimer.nsecsElapsed() - pendingSend.deadlineNs;
+                    addLatency(pendingSend.track, pendingSend.step, latencyNs);
+                    emit stepExecutedSignal(pendingSend.track, pendingSend.step, (double)latencyNs / 1000000.0);
+                    track.currentStep++;
+                }
+            }
+        }
+
+        if(!success)
+        {
+            m_failed = true;
+            m_stop = true;
+        }
+        m_hasNewEvent = true;
+        m_waitCondition.wakeAll();
+    }
+}
+
+/**
+ * Must be called (direct connection) if the main interface has received data.
+ * @param data
+ *      The received data.
+ */
+void SequencePlaylistEngine::dataReceivedSlot(QByteArray data)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if(!m_stop)
+    {
+        for(auto& el : m_trackStates)
+        {
+            if(!el.isFinished)
+            {
+                el.receivedData.append(data);
+                if(el.receivedData.size() > MAX_RECEIVED_DATA_SIZE)
+                {
+                    el.receivedData.remove(0, el.receivedData.size() - MAX_RECEIVED_DATA_SIZE);
+                }
+            }
+        }
+        m_hasNewEvent = true;
+        m_waitCondition.wakeAll();
+    }
+}
+
+/**
+ * Adds a latency to the statistics of a step.
+ * @param trackIndex
+ *      The track index.
+ * @param stepIndex
+ *      The step index.
+ * @param latencyNs
+ *      The latency (ns).
+ */
+void SequencePlaylistEngine::addLatency(qint32 trackIndex, qint32 stepIndex, qint64 latencyNs)
+{
+    PlaylistStepStatistics& statistics = m_statistics[trackIndex][stepIndex];
+
+    if((statistics.count == 0) || (latencyNs < statistics.minNs))
+    {
+        statistics.minNs = latencyNs;
+    }
+    if((statistics.count == 0) || (latencyNs > statistics.maxNs))
+    {
+        statistics.maxNs = latencyNs;
+    }
+    statistics.count++;
+    statistics.sumNs += latencyNs;
+    statistics.lastNs = latencyNs;
+}
+
+/**
+ * Returns true if the current wait step of a track matches the received data.
+ * The received data up to the end of the match is removed (a following wait step waits for new data).
+ * @param step
+ *      The wait step.
+ * @param track
+ *      The track.
+ * @return
+ *      True if the received data matches.
+ */
+bool SequencePlaylistEngine::waitStepMatches(const PlaylistStep& step, PlaylistTrackState& track)
+{
+    int endIndex = -1;
+
+    if(step.type == PLAYLIST_STEP_WAIT_DATA)
+    {
+        int index = track.receivedData.indexOf(step.data);
+        if(index >= 0)
+        {
+            endIndex = index + step.data.size();
+        }
+    }
+    else
+    {
+        QRegularExpressionMatch match = step.regExp.match(QString::fromLatin1(track.receivedData));
+        if(match.hasMatch())
+        {
+            endIndex = match.capturedEnd();
+        }
+    }
+
+    if(endIndex >= 0)
+    {
+        track.receivedData.remove(0, endIndex);
+    }
+    return (endIndex >= 0);
+}
+
+/**
+ * Executes the ready steps of one track.
+ * @param trackIndex
+ *      The track index.
+ * @param nowNs
+ *      The current time (ns).
+ * @return
+ *      The time of the next event of this track (-1 = the track waits for the main interface,
+ *      received data without timeout or is finished).
+ */
+qint64 SequencePlaylistEngine::processTrack(qint32 trackIndex, qint64 nowNs)
+{
+    PlaylistTrackState& track = m_trackStates[trackIndex];
+    const QVector<PlaylistStep>& steps = m_tracks[trackIndex];
+
+    for(int i = 0; i < MAX_STEPS_PER_PASS; i++)
+    {
+        if(track.isFinished || track.sendIsPending || m_stop)
+        {
+            return -1;
+        }
+        if(track.currentStep >= steps.size())
+        {
+            track.isFinished = true;
+            return -1;
+        }
+
+        const PlaylistStep& step = steps[track.currentStep];
+
+        if(track.isWaiting)
+        {
+            if(waitStepMatches(step, track))
+            {
+                qint64 latencyNs = nowNs - track.waitStartNs;
+                addLatency(trackIndex, track.currentStep, latencyNs);
+                emit stepExecutedSignal(trackIndex, track.currentStep, (double)latencyNs / 1000000.0);
+
+                //The time line continues at the reception time.
+                track.isWaiting = false;
+                track.timeNs = nowNs;
+                track.currentStep++;
+                continue;
+            }
+
+            if(step.timeNs == 0)
+            {//No timeout.
+                return -1;
+            }
+
+            qint64 timeoutNs = track.waitStartNs + step.timeNs;
+            if(nowNs < timeoutNs)
+            {
+                return timeoutNs;
+            }
+
+            m_statistics[trackIndex][track.currentStep].misses++;
+            emit waitTimeoutSignal(trackIndex, track.currentStep);
+            track.isWaiting = false;
+
+            if(!step.continueOnTimeout)
+            {
+                m_failed = true;
+                m_stop = true;
+                return -1;
+            }
+            track.timeNs = nowNs;
+            track.currentStep++;
+            continue;
+        }
+
+        switch(step.type)
+        {
+        case PLAYLIST_STEP_SEND:
+        {
+            if(nowNs < track.timeNs)
+            {
+                return track.timeNs;
+            }
+
+            PlaylistPendingSend pendingSend;
+            pendingSend.track = trackIndex;
+            pendingSend.step = track.currentStep;
+            pendingSend.deadlineNs = track.timeNs;
+            m_pendingSends.enqueue(pendingSend);
+
+            //Wait steps only see the data which is received after this send step.
+            track.receivedData.clear();
+            track.sendIsPending = true;
+            emit sendDataSignal(step.data, m_sendId);
+            return -1;
+        }
+        case PLAYLIST_STEP_DELAY:
+        {
+            PlaylistStepStatistics& statistics = m_statistics[trackIndex][track.currentStep];
+            statistics.count++;
+
+            track.timeNs += step.timeNs;
+            if((nowNs - track.timeNs) > step.timeNs)
+            {//The track is more than one delay late, the time line is set to the current time (no burst).
+                track.timeNs = nowNs;
+                statistics.misses++;
+            }
+            track.currentStep++;
+            break;
+        }
+        case PLAYLIST_STEP_WAIT_DATA:
+        case PLAYLIST_STEP_WAIT_REGEXP:
+        {
+            if(nowNs < track.timeNs)
+            {
+                return track.timeNs;
+            }
+            track.isWaiting = true;
+            track.waitStartNs = nowNs;
+            break;
+        }
+        case PLAYLIST_STEP_LOOP_START:
+        {
+            m_statistics[trackIndex][track.currentStep].count++;
+            track.loopCounters.append(step.loopCount);
+            track.currentStep++;
+            break;
+        }
+        case PLAYLIST_STEP_LOOP_END:
+        {
+            m_statistics[trackIndex][track.currentStep].count++;
+            quint32& remainingIterations = track.loopCounters.last();
+
+            if(remainingIterations == 0)
+            {//Endless loop.
+                track.currentStep = step.loopPartner + 1;
+            }
+            else if(--remainingIterations > 0)
+            {
+                track.currentStep = step.loopPartner + 1;
+            }
+            else
+            {
+                track.loopCounters.removeLast();
+                track.currentStep++;
+            }
+            break;
+        }
+        }
+    }
+
+    //MAX_STEPS_PER_PASS has been reached, the track is processed again in the next pass.
+    return nowNs;
+}
+
+/**
+ * Executes all steps which are ready.
+ * @param nowNs
+ *      The current time (ns).
+ * @return
+ *      The time of the next event (ns, -1 if all tracks wait for data without timeout or for the main interface).
+ */
+qint64 SequencePlaylistEngine::processTracks(qint64 nowNs)
+{
+    qint64 nextEventNs = -1;
+
+    for(qint32 i = 0; i < m_trackStates.size(); i++)
+    {
+        qint64 trackEventNs = processTrack(i, nowNs);
+        if((trackEventNs >= 0) && ((nextEventNs < 0) || (trackEventNs < nextEventNs)))
+        {
+            nextEventNs = trackEventNs;
+        }
+    }
+    return nextEventNs;
+}
+
+/**
+ * The playlist loop. The playlist thread waits for the wait condition until the remaining time
+ * to the next event is smaller than FINE_WAIT_THRESHOLD_NS and sleeps in small steps afterwards.
+ */
+void SequencePlaylistEngine::run()
+{
+    bool allTracksFinished = false;
+
+    m_elapsedTimer.start();
+    m_mutex.lock();
+
+    while(!m_stop)
+    {
+        m_hasNewEvent = false;
+        qint64 nextEventNs = processTracks(m_elapsedTimer.nsecsElapsed());
+
+        allTracksFinished = true;
+        for(auto& el : m_trackStates)
+        {
+            if(!el.isFinished)
+            {
+                allTracksFinished = false;
+                break;
+            }
+        }
+        if(allTracksFinished || m_stop)
+        {
+            break;
+        }
+
+        if(nextEventNs < 0)
+        {//Wait for the main interface or for received data.
+            while(!m_hasNewEvent && !m_stop)
+            {
+                m_waitCondition.wait(&m_mutex);
+            }
+        }
+        else
+        {
+            qint64 remainingNs = nextEventNs - m_elapsedTimer.nsecsElapsed();
+            if(remainingNs > FINE_WAIT_THRESHOLD_NS)
+            {
+                if(!m_hasNewEvent)
+                {
+                    m_waitCondition.wait(&m_mutex, (unsigned long)((remainingNs - FINE_WAIT_THRESHOLD_NS) / 1000000) + 1);
+                }
+            }
+            else if(remainingNs > 0)
+            {
+                m_mutex.unlock();
+                while(remainingNs > 0)
+                {
+                    if(remainingNs > 200000)
+                    {
+                        QThread::usleep((unsigned long)(remainingNs / 2000));
+                    }
+                    else
+                    {
+                        QThread::yieldCurrentThread();
+                    }
+                    remainingNs = nextEventNs - m_elapsedTimer.nsecsElapsed();
+                }
+                m_mutex.lock();
+            }
+        }
+    }
+
+    bool success = allTracksFinished && !m_failed;
+    m_stop = true;
+    m_mutex.unlock();
+
+    emit playlistFinishedSignal(success);
+}
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ * @param interfaceThread
+ *      The main interface thread (sends the data and delivers the received data).
+ * @param sendWindow
+ *      The send window (contains the sequences).
+ * @param runsInDebugger
+ *      True if the script runs in the script debugger.
+ */
+ScriptSequencePlaylist::ScriptSequencePlaylist(QObject *parent, MainInterfaceThread* interfaceThread, SendWindow* sendWindow, bool runsInDebugger) :
+    QObject(parent), m_tracks(), m_openLoops(), m_startedTracks(), m_engine(MainInterfaceThread::getNextSendEngineId())
+{
+    Qt::ConnectionType directConnectionType = runsInDebugger ? Qt::DirectConnection : Qt::BlockingQueuedConnection;
+
+    connect(&m_engine, SIGNAL(sendDataSignal(QByteArray,uint)), interfaceThread, SLOT(sendDataSlot(QByteArray,uint)), Qt::QueuedConnection);
+
+    //The engine is called directly (in the main interface thread) to be independent of the script thread.
+    connect(interfaceThread, SIGNAL(sendingFinishedSignal(bool,uint)), &m_engine, SLOT(sendingFinishedSlot(bool,uint)), Qt::DirectConnection);
+    connect(interfaceThread, SIGNAL(dataReceivedSignal(QByteArray)), &m_engine, SLOT(dataReceivedSlot(QByteArray)), Qt::DirectConnection);
+
+    connect(&m_engine, SIGNAL(stepExecutedSignal(quint32,quint32,double)), this, SIGNAL(stepExecutedSignal(quint32,quint32,double)), Qt::QueuedConnection);
+    connect(&m_engine, SIGNAL(waitTimeoutSignal(quint32,quint32)), this, SIGNAL(waitTimeoutSignal(quint32,quint32)), Qt::QueuedConnection);
+    connect(&m_engine, SIGNAL(playlistFinishedSignal(bool)), this, SIGNAL(playlistFinishedSignal(bool)), Qt::QueuedConnection);
+
+    connect(this, SIGNAL(getSequenceDataSignal(QString,QByteArray*,bool*)), sendWindow, SLOT(getSequenceDataSlot(QString,QByteArray*,bool*)), directConnectionType);
+}
+
+/**
+ * Destructor.
+ */
+ScriptSequencePlaylist::~ScriptSequencePlaylist()
+{
+    m_engine.stopPlaylist();
+}
+
+/**
+ * Creates a step.
+ * @param type
+ *      The step type.
+ * @param name
+ *      The name of the step.
+ * @return
+ *      The created step.
+ */
+PlaylistStep ScriptSequencePlaylist::createStep(PlaylistStepType type, QString name)
+{
+    PlaylistStep step;
+    step.type = type;
+    step.name = name;
+    step.timeNs = 0;
+    step.loopCount = 0;
+    step.loopPartner = -1;
+    step.continueOnTimeout = false;
+    return step;
+}
+
+/**
+ * Returns the steps of a track (creates the track if necessary).
+ * @param index
+ *      The track index.
+ * @return
+ *      The steps of the track.
+ */
+QVector<PlaylistStep>& ScriptSequencePlaylist::trackSteps(quint32 index)
+{
+    while((quint32)m_tracks.size() <= index)
+    {
+        m_tracks.append(QVector<PlaylistStep>());
+        m_openLoops.append(QVector<qint32>());
+    }
+    return m_tracks[index];
+}
+
+/**
+ * Adds a send step with the data of a sequence of the send window (the sequence script is not executed).
+ * @param sequenceName
+ *      The name of the sequence.
+ * @param track
+ *      The track index.
+ * @return
+ *      False if the sequence does not exist.
+ */
+bool ScriptSequencePlaylist::addSequence(QString sequenceName, quint32 track)
+{
+    QByteArray data;
+    bool found = false;
+    emit getSequenceDataSignal(sequenceName, &data, &found);
+
+    if(found && !data.isEmpty())
+    {
+        PlaylistStep step = createStep(PLAYLIST_STEP_SEND, sequenceName);
+        step.data = data;
+        trackSteps(track).append(step);
+    }
+    return found && !data.isEmpty();
+}
+
+/**
+ * Adds a send step.
+ * @param data
+ *      The send data.
+ * @param track
+ *      The track index.
+ */
+void ScriptSequencePlaylist::addData(QVector<unsigned char> data, quint32 track)
+{
+    if(!data.isEmpty())
+    {
+        PlaylistStep step = createStep(PLAYLIST_STEP_SEND, "data");
+        step.data = QByteArray((const char*)data.constData(), data.size());
+        trackSteps(track).append(step);
+    }
+}
+
+/**
+ * Adds a delay step.
+ * @param delayMs
+ *      The delay (ms).
+ * @param track
+ *      The track index.
+ */
+void ScriptSequencePlaylist::addDelay(double delayMs, quint32 track)
+{
+    PlaylistStep step = createStep(PLAYLIST_STEP_DELAY, QString("delay %1 ms").arg(delayMs));
+    step.timeNs = (delayMs > 0.0) ? (qint64)(delayMs * 1000000.0) : 0;
+    trackSteps(track).append(step);
+}
+
+/**
+ * Adds a wait step which waits until the received data contains pattern.
+ * @param pattern
+ *      The pattern.
+ * @param timeoutMs
+ *      The timeout (ms, 0=no timeout).
+ * @param continueOnTimeout
+ *      True if the track shall continue if the step times out (else the playlist is stopped).
+ * @param track
+ *      The track index.
+ */
+void ScriptSequencePlaylist::addWaitForData(QVector<unsigned char> pattern, quint32 timeoutMs, bool continueOnTimeout, quint32 track)
+{
+    PlaylistStep step = createStep(PLAYLIST_STEP_WAIT_DATA, "wait for data");
+    step.data = QByteArray((const char*)pattern.constData(), pattern.size());
+    step.timeNs = (qint64)timeoutMs * 1000000;
+    step.continueOnTimeout = continueOnTimeout;
+    trackSteps(track).append(step);
+}
+
+/**
+ * Adds a wait step which waits until the received data (latin1 string) matches a regular expression.
+ * @param pattern
+ *      The regular expression.
+ * @param timeoutMs
+ *      The timeout (ms, 0=no timeout).
+ * @param continueOnTimeout
+ *      True if the track shall continue if the step times out (else the playlist is stopped).
+ * @param track
+ *      The track index.
+ * @return
+ *      False if the regular expression is invalid.
+ */
+bool ScriptSequencePlaylist::addWaitForRegExp(QString pattern, quint32 timeoutMs, bool continueOnTimeout, quint32 track)
+{
+    PlaylistStep step = createStep(PLAYLIST_STEP_WAIT_REGEXP, "wait for " + pattern);
+    step.regExp = QRegularExpression(pattern);
+    if(!step.regExp.isValid())
+    {
+        return false;
+    }
+    step.regExp.optimize();
+    step.timeNs = (qint64)timeoutMs * 1000000;
+    step.continueOnTimeout = continueOnTimeout;
+    trackSteps(track).append(step);
+    return true;
+}
+
+/**
+ * Starts a loop. All steps until the corresponding addLoopEnd are repeated.
+ * @param count
+ *      The number of iterations (0=endless).
+ * @param track
+ *      The track index.
+ */
+void ScriptSequencePlaylist::addLoopStart(quint32 count, quint32 track)
+{
+    PlaylistStep step = createStep(PLAYLIST_STEP_LOOP_START, (count == 0) ? QString("endless loop") : QString("loop %1").arg(count));
+    step.loopCount = count;
+    QVector<PlaylistStep>& steps = trackSteps(track);
+    m_openLoops[track].append(steps.size());
+    steps.append(step);
+}
+
+/**
+ * Ends the last started loop.
+ * @param track
+ *      The track index.
+ * @return
+ *      False if no loop is open.
+ */
+bool ScriptSequencePlaylist::addLoopEnd(quint32 track)
+{
+    QVector<PlaylistStep>& steps = trackSteps(track);
+    if(m_openLoops[track].isEmpty())
+    {
+        return false;
+    }
+
+    qint32 loopStart = m_openLoops[track].takeLast();
+    PlaylistStep step = createStep(PLAYLIST_STEP_LOOP_END, "loop end");
+    step.loopCount = steps[loopStart].loopCount;
+    step.loopPartner = loopStart;
+    steps[loopStart].loopPartner = steps.size();
+    steps.append(step);
+    return true;
+}
+
+/**
+ * Removes all steps (stops the playlist).
+ */
+void ScriptSequencePlaylist::clear(void)
+{
+    m_engine.stopPlaylist();
+    m_tracks.clear();
+    m_openLoops.clear();
+}
+
+/**
+ * Returns true if a track contains an endless loop which neither sends, waits for data nor delays
+ * (such a loop would occupy the playlist thread without pause).
+ * @param steps
+ *      The steps of the track.
+ * @return
+ *      True if the track contains such a loop.
+ */
+static bool containsZeroDurationEndlessLoop(const QVector<PlaylistStep>& steps)
+{
+    for(qint32 end = 0; end < steps.size(); end++)
+    {
+        if((steps[end].type != PLAYLIST_STEP_LOOP_END) || (steps[end].loopCount != 0))
+        {
+            continue;
+        }
+
+        bool takesTime = false;
+        for(qint32 i = steps[end].loopPartner + 1; (i < end) && !takesTime; i++)
+        {
+            takesTime = (steps[i].type == PLAYLIST_STEP_SEND) || (steps[i].type == PLAYLIST_STEP_WAIT_DATA) ||
+                    (steps[i].type == PLAYLIST_STEP_WAIT_REGEXP) || ((steps[i].type == PLAYLIST_STEP_DELAY) && (steps[i].timeNs > 0));
+        }
+        if(!takesTime)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Starts the playlist.
+ * @return
+ *      False if the playlist is empty, already running, contains an open loop or contains an endless
+ *      loop without send, wait or delay (> 0 ms) step.
+ */
+bool ScriptSequencePlaylist::start(void)
+{
+    bool hasSteps = false;
+
+    if(m_engine.isRunning())
+    {
+        return false;
+    }
+
+    for(qint32 i = 0; i < m_tracks.size(); i++)
+    {
+        if(!m_openLoops[i].isEmpty() || containsZeroDurationEndlessLoop(m_tracks[i]))
+        {
+            return false;
+        }
+        if(!m_tracks[i].isEmpty())
+        {
+            hasSteps = true;
+        }
+    }
+
+    if(!hasSteps)
+    {
+        return false;
+    }
+
+    m_startedTracks = m_tracks;
+    m_engine.startPlaylist(m_startedTracks);
+    return true;
+}
+
+/**
+ * Converts a step type into a string.
+ * @param type
+ *      The step type.
+ * @return
+ *      The string.
+ */
+QString ScriptSequencePlaylist::stepTypeToString(PlaylistStepType type)
+{
+    QString result;
+
+    switch(type)
+    {
+    case PLAYLIST_STEP_SEND:
+        result = "send";
+        break;
+    case PLAYLIST_STEP_DELAY:
+        result = "delay";
+        break;
+    case PLAYLIST_STEP_WAIT_DATA:
+    case PLAYLIST_STEP_WAIT_REGEXP:
+        result = "wait";
+        break;
+    case PLAYLIST_STEP_LOOP_START:
+        result = "loopStart";
+        break;
+    case PLAYLIST_STEP_LOOP_END:
+        result = "loopEnd";
+        break;
+    }
+    return result;
+}
+
+/**
+ * Returns the statistics of all steps.
+ * @return
+ *      One object per step (track, step, type, name, count, misses, minMs, meanMs, maxMs and lastMs).
+ */
+QVariantList ScriptSequencePlaylist::getStatistics(void)
+{
+    QVariantList result;
+    QVector<QVector<PlaylistStepStatistics>> statistics = m_engine.getStatistics();
+
+    for(qint32 i = 0; (i < statistics.size()) && (i < m_startedTracks.size()); i++)
+    {
+        for(qint32 j = 0; (j < statistics[i].size()) && (j < m_startedTracks[i].size()); j++)
+        {
+            const PlaylistStepStatistics& stepStatistics = statistics[i][j];
+            bool hasLatency = (m_startedTracks[i][j].type == PLAYLIST_STEP_SEND) || (m_startedTracks[i][j].type == PLAYLIST_STEP_WAIT_DATA) ||
+                    (m_startedTracks[i][j].type == PLAYLIST_STEP_WAIT_REGEXP);
+
+            QVariantMap map;
+            map["track"] = i;
+            map["step"] = j;
+            map["type"] = stepTypeToString(m_startedTracks[i][j].type);
+            map["name"] = m_startedTracks[i][j].name;
+            map["count"] = (double)stepStatistics.count;
+            map["misses"] = (double)stepStatistics.misses;
+            map["minMs"] = hasLatency ? (double)stepStatistics.minNs / 1000000.0 : 0.0;
+            map["meanMs"] = (hasLatency && (stepStatistics.count > 0)) ? ((double)stepStatistics.sumNs / (double)stepStatistics.count) / 1000000.0 : 0.0;
+            map["maxMs"] = hasLatency ? (double)stepStatistics.maxNs / 1000000.0 : 0.0;
+            map["lastMs"] = hasLatency ? (double)stepStatistics.lastNs / 1000000.0 : 0.0;
+            result.append(map);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,366 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTSEQUENCEPLAYLIST_H
+#define SCRIPTSEQUENCEPLAYLIST_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QVector>
+#include <QQueue>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QVariant>
+#include <mainInterfaceThread.h>
+
+class SendWindow;
+
+///The type of a playlist step.
+typedef enum
+{
+    PLAYLIST_STEP_SEND = 0,
+    PLAYLIST_STEP_DELAY,
+    PLAYLIST_STEP_WAIT_DATA,
+    PLAYLIST_STEP_WAIT_REGEXP,
+    PLAYLIST_STEP_LOOP_START,
+    PLAYLIST_STEP_LOOP_END
+}PlaylistStepType;
+
+///One step of a playlist track.
+typedef struct
+{
+    ///The step type.
+    PlaylistStepType type;
+
+    ///The name of the step (sequence name or description).
+    QString name;
+
+    ///The send data (PLAYLIST_STEP_SEND) or the pattern (PLAYLIST_STEP_WAIT_DATA).
+    QByteArray data;
+
+    ///The pattern of a PLAYLIST_STEP_WAIT_REGEXP step (is matched against the received data as latin1 string).
+    QRegularExpression regExp;
+
+    ///The delay (PLAYLIST_STEP_DELAY) or the timeout (wait steps, 0=no timeout) in ns.
+    qint64 timeNs;
+
+    ///The number of iterations of a loop (0=endless).
+    quint32 loopCount;
+
+    ///The index of the corresponding loop start/end step.
+    qint32 loopPartner;
+
+    ///True if the track shall continue if a wait step times out (else the playlist is stopped).
+    bool continueOnTimeout;
+}PlaylistStep;
+
+///The statistics of one playlist step.
+typedef struct
+{
+    ///The number of executions.
+    quint64 count;
+
+    ///The number of timeouts (wait steps) or late delays (delay steps).
+    quint64 misses;
+
+    ///The min. latency (ns).
+    qint64 minNs;
+
+    ///The max. latency (ns).
+    qint64 maxNs;
+
+    ///The sum of all latencies (ns).
+    qint64 sumNs;
+
+    ///The latency of the last execution (ns).
+    qint64 lastNs;
+}PlaylistStepStatistics;
+
+///The state of one playlist track.
+typedef struct
+{
+    ///The index of the current step.
+    qint32 currentStep;
+
+    ///The time line of the track (ns, relative to the start of the playlist).
+    ///Sends are executed at this time, delays advance it.
+    qint64 timeNs;
+
+    ///The start time of the current wait step (ns).
+    qint64 waitStartNs;
+
+    ///True if the track waits for data.
+    bool isWaiting;
+
+    ///True if the track waits until the main interface has sent the current send step.
+    bool sendIsPending;
+
+    ///True if all steps of the track have been executed.
+    bool isFinished;
+
+    ///The data which has been received since the last send step of this track (without the data
+    ///which has been matched by a wait step).
+    QByteArray receivedData;
+
+    ///The remaining iterations of the open loops.
+    QVector<quint32> loopCounters;
+}PlaylistTrackState;
+
+///A send step which has been passed to the main interface.
+typedef struct
+{
+    ///The track index.
+    qint32 track;
+
+    ///The step index.
+    qint32 step;
+
+    ///The deadline of the send step (ns).
+    qint64 deadlineNs;
+}PlaylistPendingSend;
+
+///Executes the tracks of a sequence playlist in an own thread. All tracks run in parallel
+///on one absolute time line (no drift). Sends are passed to the main interface thread and
+///the next step of a track is executed after the main interface has sent the data.
+class SequencePlaylistEngine : public QThread
+{
+    Q_OBJECT
+
+public:
+    SequencePlaylistEngine(quint32 sendId);
+    virtual ~SequencePlaylistEngine();
+
+    ///Starts the playlist.
+    void startPlaylist(const QVector<QVector<PlaylistStep>>& tracks);
+
+    ///Stops the playlist and waits until the playlist thread has been finished.
+    void stopPlaylist(void);
+
+    ///Returns the statistics of all steps (one vector per track).
+    QVector<QVector<PlaylistStepStatistics>> getStatistics(void);
+
+    ///Returns the send id of the engine.
+    quint32 getSendId(void){return m_sendId;}
+
+    ///If the remaining time to the next event is smaller than this value (ns),
+    ///the playlist thread sleeps in small steps instead of waiting for the wait condition.
+    static const qint64 FINE_WAIT_THRESHOLD_NS = 2000000;
+
+    ///The max. number of received bytes which are stored per track.
+    static const int MAX_RECEIVED_DATA_SIZE = 65536;
+
+    ///The max. number of steps which are executed per track without returning to the event loop
+    ///(prevents a loop without delay from blocking the other tracks).
+    static const int MAX_STEPS_PER_PASS = 1000;
+
+signals:
+    ///Is emitted for every payload which shall be sent.
+    void sendDataSignal(const QByteArray data, uint id);
+
+    ///Is emitted if a send or wait step has been executed.
+    void stepExecutedSignal(quint32 track, quint32 step, double latencyMs);
+
+    ///Is emitted if a wait step has timed out.
+    void waitTimeoutSignal(quint32 track, quint32 step);
+
+    ///Is emitted if the playlist has been finished (success is false if the playlist has been
+    ///stopped, a wait step has timed out or sending has failed).
+    void playlistFinishedSignal(bool success);
+
+public slots:
+
+    ///Must be called (direct connection) if the main interface has sent data.
+    void sendingFinishedSlot(bool success, uint id);
+
+    ///Must be called (direct connection) if the main interface has received data.
+    void dataReceivedSlot(QByteArray data);
+
+protected:
+    ///The playlist loop.
+    void run();
+
+private:
+
+    ///Executes all steps which are ready. Returns the time of the next event (ns, -1 if
+    ///all tracks wait for data without timeout or for the main interface).
+    qint64 processTracks(qint64 nowNs);
+
+    ///Executes the ready steps of one track. Returns the time of the next event of this track (-1 = none).
+    qint64 processTrack(qint32 trackIndex, qint64 nowNs);
+
+    ///Returns true if the current wait step of a track matches the received data (the matched data is removed).
+    bool waitStepMatches(const PlaylistStep& step, PlaylistTrackState& track);
+
+    ///Adds a latency to the statistics of a step.
+    void addLatency(qint32 trackIndex, qint32 stepIndex, qint64 latencyNs);
+
+    ///Protects all members which are used by more than one thread.
+    QMutex m_mutex;
+
+    ///Is used to wake the playlist thread (send finished, data received, stop).
+    QWaitCondition m_waitCondition;
+
+    ///The steps of all tracks.
+    QVector<QVector<PlaylistStep>> m_tracks;
+
+    ///The state of all tracks.
+    QVector<PlaylistTrackState> m_trackStates;
+
+    ///The statistics of all steps.
+    QVector<QVector<PlaylistStepStatistics>> m_statistics;
+
+    ///The send steps which have been passed to the main interface.
+    QQueue<PlaylistPendingSend> m_pendingSends;
+
+    ///The send id of the engine (changes if a run is started while sends of the previous run are pending).
+    quint32 m_sendId;
+
+    ///True if the playlist shall be stopped.
+    bool m_stop;
+
+    ///True if the playlist has failed (timeout, send error or stop).
+    bool m_failed;
+
+    ///True if an event (send finished, data received) has occurred since the last processTracks call.
+    bool m_hasNewEvent;
+
+    ///The time base of the playlist.
+    QElapsedTimer m_elapsedTimer;
+};
+
+///Script interface of the sequence playlist engine. A playlist consists of one or more tracks
+///(which run in parallel). Each track is an ordered list of steps (send a sequence or data,
+///delay, wait for received data, loops).
+class ScriptSequencePlaylist : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptSequencePlaylist(QObject *parent, MainInterfaceThread* interfaceThread, SendWindow* sendWindow, bool runsInDebugger);
+    virtual ~ScriptSequencePlaylist();
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptSequencePlaylist*>("ScriptSequencePlaylist*");
+        qRegisterMetaType<QByteArray*>("QByteArray*");
+        qRegisterMetaType<bool*>("bool*");
+    }
+
+    ///Adds a send step with the data of a sequence of the send window (the sequence script is not executed).
+    ///Returns false if the sequence does not exist.
+    Q_INVOKABLE bool addSequence(QString sequenceName, quint32 track=0);
+
+    ///Adds a send step.
+    Q_INVOKABLE void addData(QVector<unsigned char> data, quint32 track=0);
+
+    ///Adds a delay step. The delays of a track are added to an absolute time line (no drift).
+    Q_INVOKABLE void addDelay(double delayMs, quint32 track=0);
+
+    ///Adds a wait step which waits until the data received since the last send step of the track contains pattern.
+    ///The data up to the end of the match is consumed (a following wait step waits for new data).
+    ///timeoutMs=0 means no timeout. If continueOnTimeout is false, the playlist is stopped if the step times out.
+    Q_INVOKABLE void addWaitForData(QVector<unsigned char> pattern, quint32 timeoutMs, bool continueOnTimeout=false, quint32 track=0);
+
+    ///Adds a wait step which waits until the data received since the last send step of the track (latin1 string)
+    ///matches a regular expression. The data up to the end of the match is consumed.
+    ///Returns false if the regular expression is invalid.
+    Q_INVOKABLE bool addWaitForRegExp(QString pattern, quint32 timeoutMs, bool continueOnTimeout=false, quint32 track=0);
+
+    ///Starts a loop (count=0: endless loop). All steps until the corresponding addLoopEnd are repeated.
+    Q_INVOKABLE void addLoopStart(quint32 count, quint32 track=0);
+
+    ///Ends the last started loop. Returns false if no loop is open.
+    Q_INVOKABLE bool addLoopEnd(quint32 track=0);
+
+    ///Removes all steps (stops the playlist).
+    Q_INVOKABLE void clear(void);
+
+    ///Returns the number of tracks.
+    Q_INVOKABLE quint32 getTrackCount(void){return m_tracks.size();}
+
+    ///Returns the number of steps of a track.
+    Q_INVOKABLE quint32 getStepCount(quint32 track){return (track < (quint32)m_tracks.size()) ? m_tracks[track].size() : 0;}
+
+    ///Starts the playlist. Returns false if the playlist is empty, already running, contains an open loop
+    ///or contains an endless loop without send, wait or delay (> 0 ms) step.
+    Q_INVOKABLE bool start(void);
+
+    ///Stops the playlist.
+    Q_INVOKABLE void stop(void){m_engine.stopPlaylist();}
+
+    ///Returns true if the playlist is running.
+    Q_INVOKABLE bool isPlaying(void){return m_engine.isRunning();}
+
+    ///Returns the statistics of all steps. Each element is an object with the properties
+    ///track, step, type, name, count, misses, minMs, meanMs, maxMs and lastMs.
+    Q_INVOKABLE QVariantList getStatistics(void);
+
+signals:
+    ///Is emitted if a send or wait step has been executed. latencyMs is the time between the deadline
+    ///and the end of the sending (send steps) or the time until the data matched (wait steps).
+    ///Scripts can connect a function to this signal.
+    void stepExecutedSignal(quint32 track, quint32 step, double latencyMs);
+
+    ///Is emitted if a wait step has timed out.
+    ///Scripts can connect a function to this signal.
+    void waitTimeoutSignal(quint32 track, quint32 step);
+
+    ///Is emitted if the playlist has been finished (success is false if the playlist has been
+    ///stopped, a wait step has timed out or sending has failed).
+    ///Scripts can connect a function to this signal.
+    void playlistFinishedSignal(bool success);
+
+    ///Is emitted in addSequence to get the data of a sequence.
+    ///This signal must not be used from script.
+    void getSequenceDataSignal(QString name, QByteArray* data, bool* found);
+
+private:
+
+    ///Returns the steps of a track (creates the track if necessary).
+    QVector<PlaylistStep>& trackSteps(quint32 index);
+
+    ///Creates a step.
+    static PlaylistStep createStep(PlaylistStepType type, QString name);
+
+    ///Converts a step type into a string.
+    static QString stepTypeToString(PlaylistStepType type);
+
+    ///The steps of all tracks.
+    QVector<QVector<PlaylistStep>> m_tracks;
+
+    ///The indexes of the open loop start steps of all tracks.
+    QVector<QVector<qint32>> m_openLoops;
+
+    ///The steps of the running (or last) playlist (for getStatistics).
+    QVector<QVector<PlaylistStep>> m_startedTracks;
+
+    ///The playlist engine.
+    SequencePlaylistEngine m_engine;
+};
+
+#endif // SCRIPTSEQUENCEPLAYLIST_H
@@ -5,6 +5,8 @@
 #include <QMenu>
 #include <QFileDialog>
 #include <QBuffer>
+#include <QDialog>
+#include <QVBoxLayout>
 #include<QDomDocument>
 #include "plotwindow.h"
 #include "scriptComboBox.h"
@@ -853,3 +855,65 @@ void ScriptSlots::writeTextSlot(QTextEdit* textEdit, QString text, bool insertHt
 
     textEdit->setUpdatesEnabled(true);
 }
+
+/**
+ * Shows the statistics of a ScriptTransactionEngine in a (non-modal) dialog.
+ * If a dialog with the same title is already shown, then its content is updated.
+ * @param title
+ *      The title of the dialog.
+ * @param statistics
+ *      The statistics (ScriptTransactionEngine::getStatistics).
+ */
+void ScriptSlots::showTransactionStatisticsSlot(QString title, QVariantList statistics)
+{
+    static const char* columns[] = {"type", "requests", "responses", "timeouts", "sendErrors", "minMs",
+                                    "meanMs", "maxMs", "p50Ms", "p95Ms", "p99Ms"};
+    static const int columnCount = sizeof(columns) / sizeof(columns[0]);
+
+    QString objectName = "transactionStatistics_" + title;
+    QDialog* dialog = findChild<QDialog*>(objectName);
+    QTableWidget* table;
+
+    if(dialog == 0)
+    {
+        dialog = new QDialog(this);
+        dialog->setObjectName(objectName);
+        dialog->setWindowTitle(title);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+
+        table = new QTableWidget(dialog);
+        table->setColumnCount(columnCount);
+        QStringList headers;
+        for(int i = 0; i < columnCount; i++)
+        {
+            headers << columns[i];
+        }
+        table->setHorizontalHeaderLabels(headers);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
+        QVBoxLayout* layout = new QVBoxLayout(dialog);
+        layout->addWidget(table);
+        dialog->resize(900, 300);
+    }
+    else
+    {
+        table = dialog->findChild<QTableWidget*>();
+    }
+
+    table->setRowCount(statistics.size());
+    for(int row = 0; row < statistics.size(); row++)
+    {
+        QVariantMap map = statistics[row].toMap();
+        for(int column = 0; column < columnCount; column++)
+        {
+            QVariant value = map[columns[column]];
+            QString text = (column == 0) ? value.toString() :
+                           (column < 5) ? QString::number(value.toULongLong()) : QString::number(value.toDouble(), 'f', 3);
+            table->setItem(row, column, new QTableWidgetItem(text));
+        }
+    }
+    table->resizeColumnsToContents();
+
+    dialog->show();
+    dialog->raise();
+}
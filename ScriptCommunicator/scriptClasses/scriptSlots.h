@@ -349,6 +349,10 @@ public slots:
    ///Writes text to a text edit.
    void writeTextSlot(QTextEdit* textEdit, QString text, bool insertHtml, bool insertText, bool append, bool isLocked, quint32 maxChars, bool atTheEnd);
 
+   ///Shows the statistics of a ScriptTransactionEngine in a (non-modal) dialog.
+   ///If a dialog with the same title is already shown, then its content is updated.
+   void showTransactionStatisticsSlot(QString title, QVariantList statistics);
+
 };
 
 #endif // SCRIPTSLOTS_H
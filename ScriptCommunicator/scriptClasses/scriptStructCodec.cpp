@@ -0,0 +1,732 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptStructCodec.h"
+#include <QRegExp>
+#include <qnumeric.h>
+#include <math.h>
+#include <string.h>
+
+/**
+ * Sets the layout.
+ * @param layout
+ *      The layout description.
+ * @param isBigEndian
+ *      The default endianess of all fields.
+ * @return
+ *      False if the layout is invalid.
+ */
+bool ScriptStructCodec::setLayout(QString layout, bool isBigEndian)
+{
+    quint32 offset = 0;
+    int bitUnitIndex = -1;
+    quint8 usedBits = 0;
+
+    m_fields.clear();
+    m_size = 0;
+    m_lastError.clear();
+    m_nameHandles.clear();
+    m_nameHandlesEngine = 0;
+
+    QStringList fieldList = layout.split(QRegExp("[;\\n]"), QString::SkipEmptyParts);
+    for(auto el : fieldList)
+    {
+        QString fieldString = el.trimmed();
+        if(fieldString.isEmpty())
+        {
+            continue;
+        }
+
+        if(!parseField(fieldString, isBigEndian, &offset, &bitUnitIndex, &usedBits))
+        {
+            m_fields.clear();
+            return false;
+        }
+    }
+
+    m_size = offset;
+    return true;
+}
+
+/**
+ * Parses one field of the layout description.
+ * @param fieldString
+ *      The field description.
+ * @param isBigEndian
+ *      The default endianess.
+ * @param offset
+ *      The current offset (is incremented by the field size).
+ * @param bitUnitIndex
+ *      The index of the field which owns the current bit field storage unit (-1 if there is none).
+ * @param usedBits
+ *      The number of used bits in the current bit field storage unit.
+ * @return
+ *      False if the field is invalid.
+ */
+bool ScriptStructCodec::parseField(QString fieldString, bool isBigEndian, quint32* offset, int* bitUnitIndex, quint8* usedBits)
+{
+    QStringList tokens = fieldString.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    if(tokens.size() != 2)
+    {
+        m_lastError = "invalid field: " + fieldString;
+        return false;
+    }
+
+    QString typeString = tokens[0].toLower();
+    if(typeString == "skip")
+    {
+        bool isOk;
+        quint32 count = tokens[1].toUInt(&isOk);
+        if(!isOk)
+        {
+            m_lastError = "invalid skip count: " + fieldString;
+            return false;
+        }
+        *offset += count;
+        *bitUnitIndex = -1;
+        return true;
+    }
+
+    StructCodecField field;
+    field.isBigEndian = isBigEndian;
+    if(typeString.endsWith("le"))
+    {
+        field.isBigEndian = false;
+        typeString.chop(2);
+    }
+    else if(typeString.endsWith("be"))
+    {
+        field.isBigEndian = true;
+        typeString.chop(2);
+    }
+
+    if(typeString == "int8"){field.type = STRUCT_FIELD_SIGNED; field.size = 1;}
+    else if(typeString == "uint8"){field.type = STRUCT_FIELD_UNSIGNED; field.size = 1;}
+    else if(typeString == "int16"){field.type = STRUCT_FIELD_SIGNED; field.size = 2;}
+    else if(typeString == "uint16"){field.type = STRUCT_FIELD_UNSIGNED; field.size = 2;}
+    else if(typeString == "int32"){field.type = STRUCT_FIELD_SIGNED; field.size = 4;}
+    else if(typeString == "uint32"){field.type = STRUCT_FIELD_UNSIGNED; field.size = 4;}
+    else if(typeString == "int64"){field.type = STRUCT_FIELD_SIGNED; field.size = 8;}
+    else if(typeString == "uint64"){field.type = STRUCT_FIELD_UNSIGNED; field.size = 8;}
+    else if(typeString == "float32"){field.type = STRUCT_FIELD_FLOAT; field.size = 4;}
+    else if(typeString == "float64"){field.type = STRUCT_FIELD_FLOAT; field.size = 8;}
+    else if(typeString == "string"){field.type = STRUCT_FIELD_STRING; field.size = 1;}
+    else
+    {
+        m_lastError = "unknown type: " + fieldString;
+        return false;
+    }
+
+    QRegExp declarationRegExp("^([A-Za-z_][A-Za-z0-9_]*)(\\[(\\d+)\\]|:(\\d+))?$");
+    if(!declarationRegExp.exactMatch(tokens[1]))
+    {
+        m_lastError = "invalid field name: " + fieldString;
+        return false;
+    }
+
+    field.name = declarationRegExp.cap(1);
+    field.count = 1;
+    field.isArray = false;
+    field.bitOffset = 0;
+    field.bitCount = 0;
+
+    for(auto el : m_fields)
+    {
+        if(el.name == field.name)
+        {
+            m_lastError = "duplicate field name: " + fieldString;
+            return false;
+        }
+    }
+
+    if(!declarationRegExp.cap(3).isEmpty())
+    {
+        field.count = declarationRegExp.cap(3).toUInt();
+        if(field.count == 0)
+        {
+            m_lastError = "invalid array size: " + fieldString;
+            return false;
+        }
+        field.isArray = (field.type != STRUCT_FIELD_STRING);
+    }
+    else if(!declarationRegExp.cap(4).isEmpty())
+    {
+        quint32 bits = declarationRegExp.cap(4).toUInt();
+        if((field.type == STRUCT_FIELD_FLOAT) || (field.type == STRUCT_FIELD_STRING) || (bits == 0) || (bits > (field.size * 8)))
+        {
+            m_lastError = "invalid bit field: " + fieldString;
+            return false;
+        }
+        field.bitCount = bits;
+    }
+
+    if(field.bitCount != 0)
+    {
+        if(*bitUnitIndex >= 0)
+        {
+            const StructCodecField& unit = m_fields[*bitUnitIndex];
+            if((unit.size == field.size) && (unit.type == field.type) && (unit.isBigEndian == field.isBigEndian)
+                    && ((*usedBits + field.bitCount) <= (field.size * 8)))
+            {//The bit field fits into the current storage unit.
+
+                field.offset = unit.offset;
+                field.bitOffset = *usedBits;
+                *usedBits += field.bitCount;
+                m_fields.append(field);
+                return true;
+            }
+        }
+
+        //Start a new storage unit.
+        field.offset = *offset;
+        *usedBits = field.bitCount;
+        *bitUnitIndex = m_fields.size();
+        *offset += field.size;
+    }
+    else
+    {
+        *bitUnitIndex = -1;
+        field.offset = *offset;
+        *offset += field.size * field.count;
+    }
+
+    m_fields.append(field);
+    return true;
+}
+
+/**
+ * Returns the names of all fields.
+ * @return
+ *      The field names.
+ */
+QStringList ScriptStructCodec::getFieldNames(void)
+{
+    QStringList result;
+    for(auto el : m_fields)
+    {
+        result.append(el.name);
+    }
+    return result;
+}
+
+/**
+ * Creates the property name handles (faster property access) for scriptEngine.
+ * @param scriptEngine
+ *      The script engine.
+ */
+void ScriptStructCodec::createNameHandles(QScriptEngine* scriptEngine)
+{
+    if((scriptEngine != m_nameHandlesEngine) || (m_nameHandles.size() != m_fields.size()))
+    {
+        m_nameHandles.clear();
+        for(auto el : m_fields)
+        {
+            m_nameHandles.append(scriptEngine->toStringHandle(el.name));
+        }
+        m_nameHandlesEngine = scriptEngine;
+    }
+}
+
+/**
+ * Reads an unsigned value.
+ * @param data
+ *      The data.
+ * @param size
+ *      The number of bytes.
+ * @param isBigEndian
+ *      True if the value is stored big endian.
+ * @return
+ *      The value.
+ */
+quint64 ScriptStructCodec::readRaw(const unsigned char* data, quint32 size, bool isBigEndian)
+{
+    quint64 result = 0;
+
+    for(quint32 i = 0; i < size; i++)
+    {
+        const quint64 byte = isBigEndian ? data[i] : data[size - 1 - i];
+        result = (result << 8) | byte;
+    }
+
+    return result;
+}
+
+/**
+ * Writes an unsigned value.
+ * @param data
+ *      The destination.
+ * @param size
+ *      The number of bytes.
+ * @param isBigEndian
+ *      True if the value shall be stored big endian.
+ * @param value
+ *      The value.
+ */
+void ScriptStructCodec::writeRaw(unsigned char* data, quint32 size, bool isBigEndian, quint64 value)
+{
+    for(quint32 i = 0; i < size; i++)
+    {
+        const unsigned char byte = (unsigned char)(value >> (8 * (size - 1 - i)));
+        data[isBigEndian ? i : (size - 1 - i)] = byte;
+    }
+}
+
+/**
+ * Decodes one value of a field.
+ * @param field
+ *      The field.
+ * @param data
+ *      The value (the storage unit for bit fields).
+ * @return
+ *      The decoded value.
+ */
+QScriptValue ScriptStructCodec::decodeValue(const StructCodecField& field, const unsigned char* data)
+{
+    if(field.type == STRUCT_FIELD_STRING)
+    {
+        quint32 length = 0;
+        while((length < field.count) && (data[length] != 0))
+        {
+            length++;
+        }
+        return QScriptValue(QString::fromLatin1((const char*)data, length));
+    }
+
+    quint64 raw = readRaw(data, field.size, field.isBigEndian);
+    quint32 bits = field.size * 8;
+
+    if(field.bitCount != 0)
+    {
+        const quint64 mask = (field.bitCount >= 64) ? ~(quint64)0 : (((quint64)1 << field.bitCount) - 1);
+        raw = (raw >> field.bitOffset) & mask;
+        bits = field.bitCount;
+    }
+
+    QScriptValue result;
+    switch(field.type)
+    {
+    case STRUCT_FIELD_UNSIGNED:
+        result = (bits <= 32) ? QScriptValue((uint)raw) : QScriptValue((qsreal)raw);
+        break;
+
+    case STRUCT_FIELD_SIGNED:
+    {
+        if((bits < 64) && ((raw >> (bits - 1)) & 1))
+        {//Sign extension.
+            raw |= ~(quint64)0 << bits;
+        }
+        const qint64 value = (qint64)raw;
+        result = (bits <= 32) ? QScriptValue((int)value) : QScriptValue((qsreal)value);
+        break;
+    }
+
+    case STRUCT_FIELD_FLOAT:
+        if(field.size == 4)
+        {
+            quint32 tmp = (quint32)raw;
+            float value;
+            memcpy(&value, &tmp, sizeof(value));
+            result = QScriptValue((qsreal)value);
+        }
+        else
+        {
+            double value;
+            memcpy(&value, &raw, sizeof(value));
+            result = QScriptValue((qsreal)value);
+        }
+        break;
+
+    case STRUCT_FIELD_STRING:
+        break;
+    }
+
+    return result;
+}
+
+/**
+ * Decodes one struct into a JS object.
+ * @param scriptEngine
+ *      The script engine.
+ * @param data
+ *      The start of the struct.
+ * @return
+ *      The created object.
+ */
+QScriptValue ScriptStructCodec::decodeStruct(QScriptEngine* scriptEngine, const unsigned char* data)
+{
+    QScriptValue object = scriptEngine->newObject();
+
+    for(int i = 0; i < m_fields.size(); i++)
+    {
+        const StructCodecField& field = m_fields[i];
+
+        if(field.isArray)
+        {
+            QScriptValue array = scriptEngine->newArray(field.count);
+            for(quint32 j = 0; j < field.count; j++)
+            {
+                array.setProperty(j, decodeValue(field, &data[field.offset + (j * field.size)]));
+            }
+            object.setProperty(m_nameHandles[i], array);
+        }
+        else
+        {
+            object.setProperty(m_nameHandles[i], decodeValue(field, &data[field.offset]));
+        }
+    }
+
+    return object;
+}
+
+/**
+ * Decodes one struct into a JS object.
+ * @param data
+ *      The data.
+ * @param offset
+ *      The start of the struct in data.
+ * @return
+ *      The created object (undefined if data is too short).
+ */
+QScriptValue ScriptStructCodec::decode(QVector<unsigned char> data, quint32 offset)
+{
+    QScriptEngine* scriptEngine = engine();
+    if((scriptEngine == 0) || m_fields.isEmpty() || (((quint64)offset + m_size) > (quint64)data.size()))
+    {
+        return QScriptValue();
+    }
+
+    createNameHandles(scriptEngine);
+    return decodeStruct(scriptEngine, &data.constData()[offset]);
+}
+
+/**
+ * Decodes consecutive structs into an array of JS objects.
+ * @param data
+ *      The data.
+ * @return
+ *      The created array.
+ */
+QScriptValue ScriptStructCodec::decodeArray(QVector<unsigned char> data)
+{
+    QScriptEngine* scriptEngine = engine();
+    if(scriptEngine == 0)
+    {
+        return QScriptValue();
+    }
+
+    const quint32 numberOfStructs = (m_fields.isEmpty() || (m_size == 0)) ? 0 : (data.size() / m_size);
+    QScriptValue result = scriptEngine->newArray(numberOfStructs);
+
+    createNameHandles(scriptEngine);
+    for(quint32 i = 0; i < numberOfStructs; i++)
+    {
+        result.setProperty(i, decodeStruct(scriptEngine, &data.constData()[i * m_size]));
+    }
+
+    return result;
+}
+
+/**
+ * Decodes one struct from each frame into an array of JS objects.
+ * @param frames
+ *      The frames.
+ * @param offset
+ *      The start of the struct in each frame.
+ * @return
+ *      The created array.
+ */
+QScriptValue ScriptStructCodec::decodeFrames(QVector<QVector<unsigned char>> frames, quint32 offset)
+{
+    QScriptEngine* scriptEngine = engine();
+    if(scriptEngine == 0)
+    {
+        return QScriptValue();
+    }
+
+    QScriptValue result = scriptEngine->newArray(frames.size());
+
+    createNameHandles(scriptEngine);
+    for(int i = 0; i < frames.size(); i++)
+    {
+        const QVector<unsigned char>& frame = frames[i];
+        if(m_fields.isEmpty() || (((quint64)offset + m_size) > (quint64)frame.size()))
+        {
+            result.setProperty(i, QScriptValue(QScriptValue::NullValue));
+        }
+        else
+        {
+            result.setProperty(i, decodeStruct(scriptEngine, &frame.constData()[offset]));
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Decodes one struct from each frame into columns.
+ * @param frames
+ *      The frames.
+ * @param offset
+ *      The start of the struct in each frame.
+ * @return
+ *      An object which contains an array for each field.
+ */
+QScriptValue ScriptStructCodec::decodeColumns(QVector<QVector<unsigned char>> frames, quint32 offset)
+{
+    QScriptEngine* scriptEngine = engine();
+    if(scriptEngine == 0)
+    {
+        return QScriptValue();
+    }
+
+    createNameHandles(scriptEngine);
+
+    QVector<QScriptValue> columns;
+    for(int i = 0; i < m_fields.size(); i++)
+    {
+        columns.append(scriptEngine->newArray());
+    }
+
+    quint32 row = 0;
+    for(auto frame : frames)
+    {
+        if(m_fields.isEmpty() || (((quint64)offset + m_size) > (quint64)frame.size()))
+        {
+            continue;
+        }
+
+        const unsigned char* data = &frame.constData()[offset];
+        for(int i = 0; i < m_fields.size(); i++)
+        {
+            const StructCodecField& field = m_fields[i];
+
+            if(field.isArray)
+            {
+                QScriptValue array = scriptEngine->newArray(field.count);
+                for(quint32 j = 0; j < field.count; j++)
+                {
+                    array.setProperty(j, decodeValue(field, &data[field.offset + (j * field.size)]));
+                }
+                columns[i].setProperty(row, array);
+            }
+            else
+            {
+                columns[i].setProperty(row, decodeValue(field, &data[field.offset]));
+            }
+        }
+        row++;
+    }
+
+    QScriptValue result = scriptEngine->newObject();
+    for(int i = 0; i < m_fields.size(); i++)
+    {
+        result.setProperty(m_nameHandles[i], columns[i]);
+    }
+
+    return result;
+}
+
+/**
+ * Encodes one value of a field.
+ * @param field
+ *      The field.
+ * @param value
+ *      The value.
+ * @param data
+ *      The destination (the storage unit for bit fields).
+ */
+void ScriptStructCodec::encodeValue(const StructCodecField& field, QScriptValue value, unsigned char* data)
+{
+    if(!value.isValid() || value.isUndefined() || value.isNull())
+    {
+        return;
+    }
+
+    if(field.type == STRUCT_FIELD_STRING)
+    {
+        QByteArray string = value.toString().toLatin1();
+        memcpy(data, string.constData(), qMin((quint32)string.size(), field.count));
+        return;
+    }
+
+    quint64 raw = 0;
+    if(field.type == STRUCT_FIELD_FLOAT)
+    {
+        if(field.size == 4)
+        {
+            float tmp = (float)value.toNumber();
+            quint32 tmpRaw;
+            memcpy(&tmpRaw, &tmp, sizeof(tmpRaw));
+            raw = tmpRaw;
+        }
+        else
+        {
+            double tmp = (double)value.toNumber();
+            memcpy(&raw, &tmp, sizeof(raw));
+        }
+    }
+    else
+    {
+        raw = numberToRaw(field, value.toNumber());
+    }
+
+    if(field.bitCount != 0)
+    {
+        const quint64 mask = (field.bitCount >= 64) ? ~(quint64)0 : (((quint64)1 << field.bitCount) - 1);
+        quint64 storage = readRaw(data, field.size, field.isBigEndian);
+        storage &= ~(mask << field.bitOffset);
+        storage |= (raw & mask) << field.bitOffset;
+        raw = storage;
+    }
+
+    writeRaw(data, field.size, field.isBigEndian, raw);
+}
+
+/**
+ * Converts a number into the raw value of an integer field. NaN is encoded as 0,
+ * out of range values (and +/-Infinity) are clamped to the range of the field.
+ * @param field
+ *      The integer field.
+ * @param number
+ *      The number.
+ * @return
+ *      The raw value (two's complement for signed fields).
+ */
+quint64 ScriptStructCodec::numberToRaw(const StructCodecField& field, qsreal number)
+{
+    const quint32 bits = (field.bitCount != 0) ? field.bitCount : (field.size * 8);
+
+    if(qIsNaN(number))
+    {
+        return 0;
+    }
+
+    if(field.type == STRUCT_FIELD_SIGNED)
+    {
+        const qsreal limit = ldexp(1.0, bits - 1);
+        const qint64 maxValue = (qint64)(((quint64)1 << (bits - 1)) - 1);
+        if(number >= limit)
+        {
+            return (quint64)maxValue;
+        }
+        if(number <= -limit)
+        {
+            return (quint64)(-maxValue - 1);
+        }
+        return (quint64)(qint64)number;
+    }
+    else
+    {
+        if(number >= ldexp(1.0, bits))
+        {
+            return ~(quint64)0 >> (64 - bits);
+        }
+        if(number <= 0)
+        {
+            return 0;
+        }
+        return (quint64)number;
+    }
+}
+
+/**
+ * Encodes one JS object into a struct.
+ * @param values
+ *      The JS object.
+ * @param data
+ *      The destination (must be zero initialized).
+ */
+void ScriptStructCodec::encodeStruct(QScriptValue values, unsigned char* data)
+{
+    for(int i = 0; i < m_fields.size(); i++)
+    {
+        const StructCodecField& field = m_fields[i];
+        QScriptValue value = values.property(m_nameHandles[i]);
+
+        if(field.isArray)
+        {
+            if(value.isValid() && !value.isUndefined() && !value.isNull())
+            {
+                for(quint32 j = 0; j < field.count; j++)
+                {
+                    encodeValue(field, value.property(j), &data[field.offset + (j * field.size)]);
+                }
+            }
+        }
+        else
+        {
+            encodeValue(field, value, &data[field.offset]);
+        }
+    }
+}
+
+/**
+ * Encodes one JS object into a struct.
+ * @param values
+ *      The JS object.
+ * @return
+ *      The encoded struct.
+ */
+QVector<unsigned char> ScriptStructCodec::encode(QScriptValue values)
+{
+    QVector<unsigned char> result(m_size, 0);
+
+    if(values.isObject() && (values.engine() != 0))
+    {
+        createNameHandles(values.engine());
+        encodeStruct(values, result.data());
+    }
+
+    return result;
+}
+
+/**
+ * Encodes an array of JS objects into consecutive structs.
+ * @param valuesArray
+ *      The JS objects.
+ * @return
+ *      The encoded structs.
+ */
+QVector<unsigned char> ScriptStructCodec::encodeArray(QScriptValue valuesArray)
+{
+    QVector<unsigned char> result;
+
+    if(valuesArray.isArray() && (valuesArray.engine() != 0))
+    {
+        const quint32 numberOfStructs = valuesArray.property("length").toUInt32();
+        result.fill(0, numberOfStructs * m_size);
+
+        createNameHandles(valuesArray.engine());
+        for(quint32 i = 0; i < numberOfStructs; i++)
+        {
+            QScriptValue values = valuesArray.property(i);
+            if(values.isObject())
+            {
+                encodeStruct(values, &result.data()[i * m_size]);
+            }
+        }
+    }
+
+    return result;
+}
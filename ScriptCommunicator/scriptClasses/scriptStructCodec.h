@@ -0,0 +1,182 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTSTRUCTCODEC_H
+#define SCRIPTSTRUCTCODEC_H
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QScriptable>
+#include <QScriptEngine>
+#include <QScriptString>
+
+///The type of a struct layout field.
+typedef enum
+{
+    STRUCT_FIELD_SIGNED = 0,
+    STRUCT_FIELD_UNSIGNED,
+    STRUCT_FIELD_FLOAT,
+    STRUCT_FIELD_STRING
+}StructCodecFieldType;
+
+///One field of a struct layout.
+typedef struct
+{
+    ///The field name.
+    QString name;
+
+    ///The field type.
+    StructCodecFieldType type;
+
+    ///The byte offset of the field (of the storage unit for bit fields).
+    quint32 offset;
+
+    ///The size of one element (of the storage unit for bit fields).
+    quint32 size;
+
+    ///The number of elements (arrays) or the number of characters (strings).
+    quint32 count;
+
+    ///True if the field is an array.
+    bool isArray;
+
+    ///True if the field is stored big endian.
+    bool isBigEndian;
+
+    ///The first bit (LSB first) of a bit field.
+    quint8 bitOffset;
+
+    ///The number of bits of a bit field (0 if the field is no bit field).
+    quint8 bitCount;
+}StructCodecField;
+
+///This class decodes/encodes binary data (frames) with a declarative layout description.
+///A layout is configured once and then used for bulk decoding/encoding, which is much
+///faster than shifting bytes in a script.
+class ScriptStructCodec : public QObject, protected QScriptable
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptStructCodec(QObject *parent) : QObject(parent), m_fields(), m_size(0), m_lastError(),
+        m_nameHandles(), m_nameHandlesEngine(0)
+    {
+    }
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptStructCodec*>("ScriptStructCodec*");
+    }
+
+    ///Sets the layout. The fields are separated by ';' or new lines. Possible fields are:
+    ///- 'type name' (e.g. 'uint16 id')
+    ///- 'type name[count]' (array, e.g. 'float32le values[4]')
+    ///- 'type name:bits' (bit field, e.g. 'uint8 mode:3'; consecutive bit fields of the same type
+    ///   share one storage unit, the first bit field occupies the least significant bits)
+    ///- 'string name[count]' (fixed size latin1 string, a 0 ends the string)
+    ///- 'skip count' (count padding bytes)
+    ///Possible types are int8, uint8, int16, uint16, int32, uint32, int64, uint64, float32 and float64.
+    ///The suffix 'le' or 'be' (e.g. uint32le) overrides isBigEndian for one field.
+    ///Returns false if the layout is invalid (see getLastError).
+    ///Note: 64 bit values are converted into JS numbers (53 bit precision).
+    Q_INVOKABLE bool setLayout(QString layout, bool isBigEndian=true);
+
+    ///Returns the description of the last layout error.
+    Q_INVOKABLE QString getLastError(void){return m_lastError;}
+
+    ///Returns the size (in bytes) of one struct.
+    Q_INVOKABLE quint32 getSize(void){return m_size;}
+
+    ///Returns the names of all fields.
+    Q_INVOKABLE QStringList getFieldNames(void);
+
+    ///Decodes one struct (starting at offset) into a JS object. Returns undefined if data is too short.
+    Q_INVOKABLE QScriptValue decode(QVector<unsigned char> data, quint32 offset=0);
+
+    ///Decodes consecutive structs (data contains n * getSize() bytes) into an array of JS objects.
+    Q_INVOKABLE QScriptValue decodeArray(QVector<unsigned char> data);
+
+    ///Decodes one struct (starting at offset) from each frame into an array of JS objects.
+    ///The entry of a too short frame is null.
+    Q_INVOKABLE QScriptValue decodeFrames(QVector<QVector<unsigned char>> frames, quint32 offset=0);
+
+    ///Decodes one struct (starting at offset) from each frame into columns (one JS object which contains
+    ///an array for each field). Too short frames are skipped.
+    Q_INVOKABLE QScriptValue decodeColumns(QVector<QVector<unsigned char>> frames, quint32 offset=0);
+
+    ///Encodes one JS object into a struct (missing fields are 0).
+    ///Integer values are clamped to the range of their field (NaN is encoded as 0).
+    Q_INVOKABLE QVector<unsigned char> encode(QScriptValue values);
+
+    ///Encodes an array of JS objects into consecutive structs.
+    Q_INVOKABLE QVector<unsigned char> encodeArray(QScriptValue valuesArray);
+
+private:
+
+    ///Parses one field of the layout description.
+    bool parseField(QString fieldString, bool isBigEndian, quint32* offset, int* bitUnitIndex, quint8* usedBits);
+
+    ///Decodes one struct into a JS object.
+    QScriptValue decodeStruct(QScriptEngine* scriptEngine, const unsigned char* data);
+
+    ///Decodes one value of a field.
+    static QScriptValue decodeValue(const StructCodecField& field, const unsigned char* data);
+
+    ///Encodes one JS object into a struct.
+    void encodeStruct(QScriptValue values, unsigned char* data);
+
+    ///Encodes one value of a field.
+    static void encodeValue(const StructCodecField& field, QScriptValue value, unsigned char* data);
+
+    ///Converts a number into the raw value of an integer field (clamped to the field range).
+    static quint64 numberToRaw(const StructCodecField& field, qsreal number);
+
+    ///Reads an unsigned value (size bytes) with the given endianess.
+    static quint64 readRaw(const unsigned char* data, quint32 size, bool isBigEndian);
+
+    ///Writes an unsigned value (size bytes) with the given endianess.
+    static void writeRaw(unsigned char* data, quint32 size, bool isBigEndian, quint64 value);
+
+    ///Creates the property name handles (faster property access) for scriptEngine.
+    void createNameHandles(QScriptEngine* scriptEngine);
+
+    ///The fields of the current layout.
+    QVector<StructCodecField> m_fields;
+
+    ///The size of one struct.
+    quint32 m_size;
+
+    ///The description of the last layout error.
+    QString m_lastError;
+
+    ///The property name handles of all fields.
+    QVector<QScriptString> m_nameHandles;
+
+    ///The script engine for which m_nameHandles have been created.
+    QScriptEngine* m_nameHandlesEngine;
+};
+
+#endif // SCRIPTSTRUCTCODEC_H
@@ -58,6 +58,7 @@
 #include "scriptCheetahSpi.h"
 #include "scriptPcan.h"
 #include <QDateTime>
+#include <QElapsedTimer>
 #include "scriptSplitter.h"
 #include "scriptDoubleSpinBox.h"
 #include "scriptToolBox.h"
@@ -69,6 +70,12 @@
 #include "scriptUdpSocket.h"
 #include "scriptsqldatabase.h"
 #include "scriptXml.h"
+#include "scriptProtocolFramer.h"
+#include "scriptStructCodec.h"
+#include "scriptTimerWheel.h"
+#include "scriptSequencePlaylist.h"
+#include "scriptTransactionEngine.h"
+#include "scriptFileTransfer.h"
 #include <QScriptEngineDebugger>
 #include <QSerialPortInfo>
 
@@ -106,10 +113,11 @@ extern bool g_aThreadHasBeenTerminated;
  */
 ScriptThread::ScriptThread(ScriptWindow* scriptWindow, quint32 sendId, QString scriptName, QWidget *scriptUi,
                            SettingsDialog *settingsDialog, bool scriptRunsInDebugger) :
+    m_canDatabase(), m_canSignalSubscriptions(), m_subscribedCanSignalsCount(0), m_canSignalPlots(), m_periodicCanMessageFunctions(), m_hasStartedTriggerCapture(false), m_canReceiveFilter(),
     m_sendingSucceeded(false), m_shallExit(false), m_shallPause(false) ,m_scriptRunsInDebugger(scriptRunsInDebugger), m_state(INVALID),
     m_pauseTimer(0),m_scriptEngine(0), m_settingsDialog(settingsDialog), m_scriptSql(), m_blockTime(DEFAULT_BLOCK_TIME),
     m_standardDialogs(0), m_scriptFileObject(0), m_isSuspendedByDebuger(false), m_debugger(0), m_debugWindow(0), m_hasMainWindowGuiElements(false),
-    sendDataFromMainInterfaceFunction()
+    sendDataFromMainInterfaceFunction(), m_profiler(), m_profilerAgent(0), m_profilerTimer(0)
 {
     m_scriptWindow = scriptWindow;
 
@@ -316,11 +324,22 @@ void ScriptThread::run()
         connect(this, SIGNAL(appendTextToConsoleSignal(QString, bool)),
                 m_scriptWindow, SLOT(appendTextToConsoleSlot(QString, bool)), directConnectionType);
 
+        //Count the queued receive events (profiling statistics). Must be connected before the queued connections.
+        connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
+                this, SLOT(dataQueuedSlot(QByteArray)), Qt::DirectConnection);
+
+        //The can receive filter of the script is evaluated in the main interface thread.
+        connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(canMessagesReceivedSignal(QVector<CanFrame>)),
+                &m_canReceiveFilter, SLOT(framesReceivedSlot(QVector<CanFrame>)), Qt::DirectConnection);
+
+        connect(&m_canReceiveFilter, SIGNAL(framesAcceptedSignal(QVector<CanFrame>)),
+                this, SLOT(canMessagesQueuedSlot(QVector<CanFrame>)), Qt::DirectConnection);
+
         connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
                 this, SLOT(dataReceivedSlot(QByteArray)), Qt::QueuedConnection);
 
-        connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(canMessagesReceivedSignal(QVector<QByteArray>)),
-                this, SLOT(canMessagesReceivedSlot(QVector<QByteArray>)), Qt::QueuedConnection);
+        connect(&m_canReceiveFilter, SIGNAL(framesAcceptedSignal(QVector<CanFrame>)),
+                this, SLOT(canMessagesReceivedSlot(QVector<CanFrame>)), Qt::QueuedConnection);
 
 
         connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(sendDataWithWorkerScriptsSignal(QByteArray)),
@@ -335,6 +354,21 @@ void ScriptThread::run()
         connect(this, SIGNAL(sendDataSignal(const QByteArray, uint)),
                 m_scriptWindow->m_mainInterfaceThread, SLOT(sendDataSlot(const QByteArray, uint)), Qt::BlockingQueuedConnection);
 
+        connect(this, SIGNAL(sendCanFramesSignal(const QVector<CanFrame>, uint)),
+                m_scriptWindow->m_mainInterfaceThread, SLOT(sendCanFramesSlot(const QVector<CanFrame>, uint)), Qt::BlockingQueuedConnection);
+
+        connect(m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler(), SIGNAL(periodicMessagesSentSignal(QVector<CanFrame>)),
+                this, SLOT(periodicCanMessagesSentSlot(QVector<CanFrame>)), Qt::QueuedConnection);
+
+        connect(m_scriptWindow->m_mainInterfaceThread->getTriggerCapture(), SIGNAL(captureWrittenSignal(QString,bool,QString)),
+                this, SIGNAL(triggerCaptureWrittenSignal(QString,bool,QString)), Qt::QueuedConnection);
+
+        connect(m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine(), SIGNAL(messageReceivedSignal(quint32,quint8,quint32,QByteArray,bool,QString)),
+                this, SLOT(isoTpMessageReceivedSlot(quint32,quint8,quint32,QByteArray,bool,QString)), Qt::QueuedConnection);
+
+        connect(m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine(), SIGNAL(messageSentSignal(quint32,quint8,quint32,bool,QString)),
+                this, SLOT(isoTpMessageSentSlot(quint32,quint8,quint32,bool,QString)), Qt::QueuedConnection);
+
         connect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(sendingFinishedSignal(bool,uint)),
                 this, SLOT(sendingFinishedSlot(bool,uint)), Qt::DirectConnection);
 
@@ -371,6 +405,12 @@ void ScriptThread::run()
         connect(m_pauseTimer, SIGNAL(timeout()),this, SLOT(pauseTimerSlot()));
         m_pauseTimer->start();
 
+        //start the profiler timer
+        m_profilerTimer = new QTimer(this);
+        m_profilerTimer->setInterval(ScriptProfiler::UPDATE_INTERVAL);
+        connect(m_profilerTimer, SIGNAL(timeout()),this, SLOT(profilerTimerSlot()));
+        m_profilerTimer->start();
+
         //get the connection state of the main interface
         m_isConnected = m_scriptWindow->m_mainInterfaceThread->isConnected();
 
@@ -382,6 +422,12 @@ void ScriptThread::run()
         ScriptXmlReader::registerScriptMetaTypes(m_scriptEngine);
         ScriptXmlWriter::registerScriptMetaTypes(m_scriptEngine);
         ScriptTableCellPosition::registerType(m_scriptEngine);
+        ScriptProtocolFramer::registerScriptMetaTypes();
+        ScriptStructCodec::registerScriptMetaTypes();
+        ScriptTimerWheel::registerScriptMetaTypes();
+        ScriptSequencePlaylist::registerScriptMetaTypes();
+        ScriptTransactionEngine::registerScriptMetaTypes();
+        ScriptFileTransfer::registerScriptMetaTypes();
 
         qScriptRegisterSequenceMetaType<QVector<unsigned char> >(m_scriptEngine);
         qScriptRegisterSequenceMetaType<QVector<quint8> >(m_scriptEngine);
@@ -505,8 +551,28 @@ void ScriptThread::run()
 
         }//if (loadScript(m_scriptFileName))
 
+        disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
+                   this, SLOT(dataQueuedSlot(QByteArray)));
+        disconnect(&m_canReceiveFilter, SIGNAL(framesAcceptedSignal(QVector<CanFrame>)),
+                   this, SLOT(canMessagesQueuedSlot(QVector<CanFrame>)));
+
+        //Stop all periodic can messages of the script.
+        m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->removeAllMessages(m_sendId);
+        m_periodicCanMessageFunctions.clear();
+
+        m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine()->closeAllSessions(m_sendId);
+
+        if(m_hasStartedTriggerCapture)
+        {
+            m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->stop();
+        }
+
         delete m_pauseTimer;
+        delete m_profilerTimer;
+
+        //The profiler agent is deleted by the script engine.
         delete m_scriptEngine;
+        m_profilerAgent = 0;
         m_isSuspendedByDebuger = false;
 
 
@@ -565,6 +631,25 @@ QScriptValue ScriptThread::createTimer(void)
     return m_scriptEngine->newQObject(timer, QScriptEngine::ScriptOwnership);
 }
 
+/**
+ * Creates a timer wheel.
+ * @param resolutionUs
+ *      The resolution (tick duration) in us.
+ * @return
+ *      The created timer wheel.
+ */
+QScriptValue ScriptThread::createTimerWheel(quint32 resolutionUs)
+{
+    ScriptTimerWheel* timerWheel =  new ScriptTimerWheel(this, resolutionUs);
+
+    if(!m_scriptRunsInDebugger)
+    {
+        connect(timerWheel, SIGNAL(scriptExceptionSignal(QScriptValue)),
+                this, SLOT(scriptSignalHandlerSlot(QScriptValue)));
+    }
+    return m_scriptEngine->newQObject(timerWheel, QScriptEngine::ScriptOwnership);
+}
+
 /**
  * Creates a TCP socket.
  * @return
@@ -639,6 +724,62 @@ QScriptValue ScriptThread::createXmlWriter()
     return m_scriptEngine->newQObject(reader, QScriptEngine::ScriptOwnership);
 }
 
+/**
+ * Creates a protocol framer.
+ * @return
+ *      The created protocol framer.
+ */
+QScriptValue ScriptThread::createProtocolFramer(void)
+{
+    ScriptProtocolFramer* framer =  new ScriptProtocolFramer(this, m_scriptWindow->m_mainInterfaceThread);
+    return m_scriptEngine->newQObject(framer, QScriptEngine::ScriptOwnership);
+}
+
+/**
+ * Creates a struct codec.
+ * @return
+ *      The created struct codec.
+ */
+QScriptValue ScriptThread::createStructCodec(void)
+{
+    ScriptStructCodec* codec =  new ScriptStructCodec(this);
+    return m_scriptEngine->newQObject(codec, QScriptEngine::ScriptOwnership);
+}
+
+/**
+ * Creates a sequence playlist.
+ * @return
+ *      The created sequence playlist.
+ */
+QScriptValue ScriptThread::createSequencePlaylist(void)
+{
+    ScriptSequencePlaylist* playlist =  new ScriptSequencePlaylist(this, m_scriptWindow->m_mainInterfaceThread,
+                                                                    m_scriptWindow->getMainWindow()->getSendWindow(), m_scriptRunsInDebugger);
+    return m_scriptEngine->newQObject(playlist, QScriptEngine::ScriptOwnership);
+}
+
+/**
+ * Creates a transaction engine.
+ * @return
+ *      The created transaction engine.
+ */
+QScriptValue ScriptThread::createTransactionEngine(void)
+{
+    ScriptTransactionEngine* engine =  new ScriptTransactionEngine(this, m_scriptWindow->m_mainInterfaceThread, m_scriptWindow);
+    return m_scriptEngine->newQObject(engine, QScriptEngine::ScriptOwnership);
+}
+
+/**
+ * Creates a file transfer object.
+ * @return
+ *      The created file transfer object.
+ */
+QScriptValue ScriptThread::createFileTransfer(void)
+{
+    ScriptFileTransfer* transfer =  new ScriptFileTransfer(this, m_scriptWindow->m_mainInterfaceThread, m_scriptWindow->getMainWindow());
+    return m_scriptEngine->newQObject(transfer, QScriptEngine::ScriptOwnership);
+}
+
 /**
  * Deletes an object created by the script.
  * Note: This function must not used any more.
@@ -1188,7 +1329,7 @@ void ScriptThread::pauseTimerSlot()
         //Block the signals of all timer.
         for(auto child : children())
         {
-            if(QString(child->metaObject()->className()) == QString("QTimer"))
+            if((QString(child->metaObject()->className()) == QString("QTimer")) && (child != m_profilerTimer))
             {
                 static_cast<QTimer*>(child)->blockSignals(true);
             }
@@ -1231,7 +1372,7 @@ void ScriptThread::pauseTimerSlot()
         //Unblock the signals of all timer.
         for(auto child : children())
         {
-            if(QString(child->metaObject()->className()) == QString("QTimer"))
+            if((QString(child->metaObject()->className()) == QString("QTimer")) && (child != m_profilerTimer))
             {
                 static_cast<QTimer*>(child)->blockSignals(false);
             }
@@ -1288,44 +1429,47 @@ bool ScriptThread::loadScript(QString scriptPath, bool isRelativePath)
  * @param data
  *      The received data.
  */
-void ScriptThread::canMessagesReceivedSlot(QVector<QByteArray> messages)
+void ScriptThread::canMessagesReceivedSlot(QVector<CanFrame> messages)
 {
+    quint32 receivedBytes = 0;
+    for(const auto& el : messages)
+    {
+        receivedBytes += el.length;
+    }
+    m_profiler.dataProcessed(receivedBytes);
 
     if(!messages.isEmpty() &&  (m_state == RUNNING))
     {
         if(QObject::receivers(SIGNAL(canMessagesReceivedSignal(QVector<quint8>, QVector<quint32>, QVector<quint32>,
                                                                QVector<QVector<unsigned char>>))) > 0)
         {
-            QVector<quint8> types;
-            QVector<quint32> messageIds;
-            QVector<quint32> timestamps;
-            QVector<QVector<unsigned char>> data;
+            QVector<quint8> types(messages.size());
+            QVector<quint32> messageIds(messages.size());
+            QVector<quint32> timestamps(messages.size());
+            QVector<QVector<unsigned char>> data(messages.size());
 
-            for(auto el : messages)
+            for(int i = 0; i < messages.size(); i++)
             {
-                QVector<unsigned char> dataVector;
+                const CanFrame& frame = messages.at(i);
 
-                for(auto val : el)
+                types[i] = canFrameType(frame);
+                messageIds[i] = frame.id;
+                timestamps[i] = (quint32)(frame.timestamp / 1000);
+
+                if(frame.length > 0)
                 {
-                    dataVector.push_back((unsigned char) val);
+                    data[i].resize(frame.length);
+                    memcpy(data[i].data(), frame.data, frame.length);
                 }
-                quint8 type = dataVector[0];
-
-                quint32 messageId = (dataVector[1] << 24) + (dataVector[2] << 16) + (dataVector[3] << 8) + (dataVector[4] & 0xff);
-                quint32 timeStamp = (dataVector[5] << 24) + (dataVector[6] << 16) + (dataVector[7] << 8) + (dataVector[8] & 0xff);
-
-                types.push_back(type);
-                messageIds.push_back(messageId);
-                timestamps.push_back(timeStamp);
-
-                //Push the data bytes.
-                data.push_back(dataVector.mid(PCANBasicClass::BYTES_FOR_CAN_TYPE + PCANBasicClass::BYTES_FOR_CAN_ID
-                                              + PCANBasicClass::BYTES_FOR_CAN_TIMESTAMP));
-
             }
 
             emit canMessagesReceivedSignal(types, messageIds, timestamps, data);
         }
+
+        if(((m_subscribedCanSignalsCount > 0) || !m_canSignalPlots.isEmpty()) && !m_canDatabase.isEmpty())
+        {
+            decodeCanSignals(messages);
+        }
     }
 
 }
@@ -1339,6 +1483,8 @@ void ScriptThread::canMessagesReceivedSlot(QVector<QByteArray> messages)
  */
 void ScriptThread::dataReceivedSlot(QByteArray data)
 {
+    m_profiler.dataProcessed(data.size());
+
     if(m_state == RUNNING)
     {
         if(QObject::receivers(SIGNAL(dataReceivedSignal(QVector<unsigned char>))) > 0)
@@ -1393,6 +1539,12 @@ bool ScriptThread::sendByteArray(QByteArray byteArray, int repetitionCount, int
 
     bool hasSucceeded = false;
 
+    //The repetitions are paced with absolute deadlines (the send time does not add up).
+    QElapsedTimer paceTimer;
+    const qint64 pauseNs = (qint64)pause * 1000000;
+    qint64 nextDeadlineNs = 0;
+    paceTimer.start();
+
     for(qint32 i = 0; i <= repetitionCount; i++)
     {
         m_sendingSucceeded = false;
@@ -1410,6 +1562,7 @@ bool ScriptThread::sendByteArray(QByteArray byteArray, int repetitionCount, int
         {
             break;
         }
+        m_profiler.dataSent(byteArray.size());
 
         if(repetitionCount > 0)
         {
@@ -1418,7 +1571,17 @@ bool ScriptThread::sendByteArray(QByteArray byteArray, int repetitionCount, int
             {
                 pauseTimerSlot();
             }
-            msleep(pause);
+
+            nextDeadlineNs += pauseNs;
+            qint64 remainingNs = nextDeadlineNs - paceTimer.nsecsElapsed();
+            if(remainingNs > 0)
+            {
+                usleep(remainingNs / 1000);
+            }
+            else if(remainingNs < -pauseNs)
+            {//Too late (e.g. the script has been paused), do not send the missed repetitions as a burst.
+                nextDeadlineNs = paceTimer.nsecsElapsed();
+            }
         }
     }
 
@@ -1481,6 +1644,447 @@ bool ScriptThread::sendCanMessage(quint8 type, quint32 canId, QVector<unsigned c
     return sendByteArray(byteArray, repetitionCount, pause, addToMainWindowSendHistory);
 }
 
+/** Sends several can messages with one call (burst) with the main interface (in MainInterfaceThread).
+ *  @param types
+ *          The can message types (see sendCanMessage).
+ *  @param canIds
+ *          The can ids.
+ *  @param data
+ *          The can data (max. 8 bytes per message).
+ * @return
+ *      True for success.
+ */
+bool ScriptThread::sendCanMessages(QVector<quint8> types, QVector<quint32> canIds, QVector<QVector<unsigned char>> data)
+{
+    if(!m_isConnectedWithCan || m_shallExit || types.isEmpty() || (types.size() != canIds.size()) || (types.size() != data.size()))
+    {
+        return false;
+    }
+
+    QVector<CanFrame> frames(types.size());
+    quint32 sentBytes = 0;
+    for(int i = 0; i < types.size(); i++)
+    {
+        if(data[i].size() > PCANBasicClass::MAX_BYTES_PER_MESSAGE)
+        {
+            return false;
+        }
+        quint32 id = canIds[i] & ((types[i] & CAN_FRAME_FLAG_EXTENDED) ? 0x1fffffff : 0x7ff);
+        initCanFrame(&frames[i], types[i], id, data[i].constData(), data[i].size(), 0);
+        sentBytes += data[i].size();
+    }
+
+    m_sendingSucceeded = false;
+    emit sendCanFramesSignal(frames, m_sendId);
+
+    if(m_sendingSucceeded)
+    {
+        m_profiler.dataSent(sentBytes);
+    }
+    return m_sendingSucceeded;
+}
+
+/**
+ * Sends a can message periodically (with CanTransmitScheduler in the main interface thread).
+ * An existing periodic message with the same type and id is replaced.
+ * @param type
+ *      The can message type (see sendCanMessage).
+ * @param canId
+ *      The can id.
+ * @param data
+ *      The can data (max. 8 bytes).
+ * @param cycleTime
+ *      The cycle time in ms (min. 0.1 ms).
+ * @param updateFunction
+ *      If valid, then this function is called after every transmission with (type, canId, data). If it
+ *      returns an array, then the array is used as payload for the next transmissions.
+ * @return
+ *      True for success.
+ */
+bool ScriptThread::startPeriodicCanMessage(quint8 type, quint32 canId, QVector<unsigned char> data, double cycleTime,
+                                           QScriptValue updateFunction)
+{
+    if(!m_isConnectedWithCan || (data.size() > PCANBasicClass::MAX_BYTES_PER_MESSAGE))
+    {
+        return false;
+    }
+
+    quint32 key = CanTransmitScheduler::createKey(type, CanTransmitScheduler::maskId(type, canId));
+    bool hasFunction = updateFunction.isFunction();
+    if(hasFunction)
+    {
+        m_periodicCanMessageFunctions[key] = updateFunction;
+    }
+    else
+    {
+        m_periodicCanMessageFunctions.remove(key);
+    }
+
+    return m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->setMessage(m_sendId, type, canId,
+                                                                                        QByteArray(reinterpret_cast<const char*>(data.constData()), data.size()),
+                                                                                        cycleTime, hasFunction);
+}
+
+/**
+ * Sets the payload of a periodic can message (is used for the next transmission).
+ * @param type
+ *      The can message type.
+ * @param canId
+ *      The can id.
+ * @param data
+ *      The can data (max. 8 bytes).
+ * @return
+ *      False if the periodic message does not exist.
+ */
+bool ScriptThread::setPeriodicCanMessageData(quint8 type, quint32 canId, QVector<unsigned char> data)
+{
+    if(data.size() > PCANBasicClass::MAX_BYTES_PER_MESSAGE)
+    {
+        return false;
+    }
+    return m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->setPayload(type, canId,
+                                                                                        QByteArray(reinterpret_cast<const char*>(data.constData()), data.size()));
+}
+
+/**
+ * Stops a periodic can message.
+ * @param type
+ *      The can message type.
+ * @param canId
+ *      The can id.
+ */
+void ScriptThread::stopPeriodicCanMessage(quint8 type, quint32 canId)
+{
+    m_periodicCanMessageFunctions.remove(CanTransmitScheduler::createKey(type, CanTransmitScheduler::maskId(type, canId)));
+    m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->removeMessage(type, canId);
+}
+
+/**
+ * Returns the measured cycle accuracy of a periodic can message.
+ * @param type
+ *      The can message type.
+ * @param canId
+ *      The can id.
+ * @return
+ *      The statistics (all times in ms) or undefined if the periodic message does not exist.
+ */
+QScriptValue ScriptThread::getPeriodicCanMessageStatistics(quint8 type, quint32 canId)
+{
+    CanPeriodicMessageStatistics statistics;
+    if(!m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->getStatistics(type, canId, &statistics))
+    {
+        return QScriptValue();
+    }
+
+    QScriptValue result = m_scriptEngine->newObject();
+    result.setProperty("cycleTime", statistics.cycleTime);
+    result.setProperty("sentMessages", (double)statistics.sentFrames);
+    result.setProperty("missedCycles", (double)statistics.missedCycles);
+    result.setProperty("meanCycleTime", statistics.meanCycleTime);
+    result.setProperty("minCycleTime", statistics.minCycleTime);
+    result.setProperty("maxCycleTime", statistics.maxCycleTime);
+    result.setProperty("meanDelay", statistics.meanDelay);
+    result.setProperty("maxDelay", statistics.maxDelay);
+    return result;
+}
+
+/**
+ * Returns the can bus statistics of the main interface (rates of the last second, counters since connect).
+ * @return
+ *      The statistics (busLoad and maxBusLoad in %, -1 if the bit rate is unknown).
+ */
+QScriptValue ScriptThread::getCanBusStatistics(void)
+{
+    CanBusStatisticsSnapshot statistics = m_scriptWindow->m_mainInterfaceThread->getCanBusStatistics();
+
+    QScriptValue result = m_scriptEngine->newObject();
+    result.setProperty("bitrate", statistics.bitrate);
+    result.setProperty("receivedFrames", (double)statistics.receivedFrames);
+    result.setProperty("sentFrames", (double)statistics.sentFrames);
+    result.setProperty("errorFrames", (double)statistics.errorFrames);
+    result.setProperty("receivedFramesPerSecond", statistics.receivedFramesPerSecond);
+    result.setProperty("sentFramesPerSecond", statistics.sentFramesPerSecond);
+    result.setProperty("receivedBitsPerSecond", statistics.receivedBitsPerSecond);
+    result.setProperty("sentBitsPerSecond", statistics.sentBitsPerSecond);
+    result.setProperty("errorFramesPerSecond", statistics.errorFramesPerSecond);
+    result.setProperty("busLoad", statistics.busLoad);
+    result.setProperty("maxBusLoad", statistics.maxBusLoad);
+
+    QScriptValue idArray = m_scriptEngine->newArray(statistics.ids.size());
+    for(int i = 0; i < statistics.ids.size(); i++)
+    {
+        QScriptValue id = m_scriptEngine->newObject();
+        id.setProperty("type", statistics.ids[i].type);
+        id.setProperty("id", statistics.ids[i].id);
+        id.setProperty("receivedFrames", (double)statistics.ids[i].receivedFrames);
+        id.setProperty("sentFrames", (double)statistics.ids[i].sentFrames);
+        id.setProperty("receivedFramesPerSecond", statistics.ids[i].receivedFramesPerSecond);
+        id.setProperty("sentFramesPerSecond", statistics.ids[i].sentFramesPerSecond);
+        idArray.setProperty(i, id);
+    }
+    result.setProperty("ids", idArray);
+
+    return result;
+}
+
+/**
+ * Sets the filter for the can messages which are received by this script (canMessagesReceivedSignal
+ * and the CAN database signals). The filter is evaluated in the main interface thread.
+ * @param filter
+ *      Comma separated list of rules (hex): id, first-last or id:mask. A rule with a leading '!' excludes,
+ *      an id with 8 hex digits is an extended id. An empty filter receives all messages.
+ * @return
+ *      The error description (empty on success, the filter is not changed on error).
+ */
+QString ScriptThread::setCanReceiveFilter(QString filter)
+{
+    CanFilter canFilter;
+    QString errorString;
+    if(canFilter.compile(filter, &errorString))
+    {
+        m_canReceiveFilter.setFilter(canFilter);
+    }
+    return errorString;
+}
+
+/**
+ * Starts (arms) the trigger capture of the received data (can frames and bytes). If a trigger fires, then the data
+ * of preTriggerTime before and postTriggerTime after the trigger is written into a capture file.
+ * The capture is re-armed after every trigger and is stopped if the script exits.
+ * @param fileName
+ *      The file name (every capture is written into a new file: fileName with an appended index).
+ * @param preTriggerTime
+ *      The time (ms) before the trigger which is captured.
+ * @param postTriggerTime
+ *      The time (ms) after the trigger which is captured.
+ * @param maxMemory
+ *      The max. memory (MB) of the capture ring.
+ * @param isRelativePath
+ *      True if fileName is relative to the script.
+ * @return
+ *      False if fileName is empty or maxMemory is too small.
+ */
+bool ScriptThread::startTriggerCapture(QString fileName, quint32 preTriggerTime, quint32 postTriggerTime, double maxMemory, bool isRelativePath)
+{
+    fileName = isRelativePath ? createAbsolutePath(fileName) : fileName;
+    bool result = m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->start(fileName, preTriggerTime, postTriggerTime,
+                                                                                    (qint64)(maxMemory * 1024.0 * 1024.0));
+    if(result)
+    {
+        m_hasStartedTriggerCapture = true;
+    }
+    return result;
+}
+
+/**
+ * Stops the trigger capture (a running post-trigger time is discarded).
+ */
+void ScriptThread::stopTriggerCapture(void)
+{
+    m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->stop();
+    m_hasStartedTriggerCapture = false;
+}
+
+/**
+ * Adds a can trigger to the trigger capture.
+ * @param type
+ *      The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+ * @param canId
+ *      The can id.
+ * @param idMask
+ *      The id mask (only the set bits are compared).
+ * @param data
+ *      The data.
+ * @param dataMask
+ *      The data mask (only the set bits are compared, frames with less data bytes do not match).
+ * @return
+ *      False if data and dataMask have different sizes.
+ */
+bool ScriptThread::addCanCaptureTrigger(quint8 type, quint32 canId, quint32 idMask, QVector<unsigned char> data, QVector<unsigned char> dataMask)
+{
+    return m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->addCanTrigger(type, canId, idMask,
+                                    QByteArray(reinterpret_cast<const char*>(data.constData()), data.length()),
+                                    QByteArray(reinterpret_cast<const char*>(dataMask.constData()), dataMask.length()));
+}
+
+/**
+ * Adds a byte pattern trigger to the trigger capture (for the received bytes of the not can interfaces).
+ * @param pattern
+ *      The pattern.
+ * @return
+ *      False if the pattern is empty or too big.
+ */
+bool ScriptThread::addDataCaptureTrigger(QVector<unsigned char> pattern)
+{
+    return m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->addDataTrigger(
+                QByteArray(reinterpret_cast<const char*>(pattern.constData()), pattern.length()));
+}
+
+/**
+ * Removes all can and byte pattern triggers of the trigger capture.
+ */
+void ScriptThread::clearCaptureTriggers(void)
+{
+    m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->clearTriggers();
+}
+
+/**
+ * Fires the trigger of the trigger capture.
+ * @param description
+ *      The description of the trigger (is written into the capture file).
+ * @return
+ *      False if the capture is not armed (not started or a post-trigger time is running).
+ */
+bool ScriptThread::fireCaptureTrigger(QString description)
+{
+    return m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->fire(description);
+}
+
+/**
+ * Opens an ISO-TP session (normal addressing, classic can frames).
+ * @param type
+ *      The can type (0=standard, 2=extended).
+ * @param txId
+ *      The id of the sent frames.
+ * @param rxId
+ *      The id of the received frames.
+ * @param blockSize
+ *      The block size which is sent in the flow control frames (0=no further flow control frames).
+ * @param stMin
+ *      The separation time (ms) which is sent in the flow control frames.
+ * @param paddingByte
+ *      The padding byte (-1=no padding).
+ * @return
+ *      False if txId or rxId is used by another session.
+ */
+bool ScriptThread::openIsoTpSession(quint8 type, quint32 txId, quint32 rxId, quint8 blockSize, double stMin, int paddingByte)
+{
+    return m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine()->openSession(m_sendId, type, txId, rxId, blockSize,
+                                                                                IsoTpEngine::encodeSeparationTime(stMin),
+                                                                                (paddingByte < 0) ? -1 : (qint16)(paddingByte & 0xff));
+}
+
+/**
+ * Closes an ISO-TP session (a running transfer is aborted).
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ */
+void ScriptThread::closeIsoTpSession(quint8 type, quint32 txId)
+{
+    m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine()->closeSession(type, txId);
+}
+
+/**
+ * Sends a message with an ISO-TP session (the result is emitted with isoTpMessageSentSignal).
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ * @param data
+ *      The message.
+ * @return
+ *      False if the session does not exist, if the session is sending or if the size of data is invalid.
+ */
+bool ScriptThread::sendIsoTpMessage(quint8 type, quint32 txId, QVector<unsigned char> data)
+{
+    return m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine()->send(type, txId,
+                                    QByteArray(reinterpret_cast<const char*>(data.constData()), data.length()));
+}
+
+/**
+ * The slot is called if an ISO-TP message has been received.
+ * This slot is connected to the IsoTpEngine::messageReceivedSignal signal.
+ * @param ownerId
+ *      The id of the owner of the session.
+ * @param type
+ *      The can type.
+ * @param rxId
+ *      The id of the received frames.
+ * @param data
+ *      The message.
+ * @param success
+ *      False if the reception has failed.
+ * @param errorString
+ *      The error description.
+ */
+void ScriptThread::isoTpMessageReceivedSlot(quint32 ownerId, quint8 type, quint32 rxId, QByteArray data, bool success, QString errorString)
+{
+    if((m_state != RUNNING) || (ownerId != m_sendId))
+    {
+        return;
+    }
+
+    QVector<unsigned char> message(data.size());
+    if(data.size() > 0)
+    {
+        memcpy(message.data(), data.constData(), data.size());
+    }
+    emit isoTpMessageReceivedSignal(type, rxId, message, success, errorString);
+}
+
+/**
+ * The slot is called if an ISO-TP message has been sent.
+ * This slot is connected to the IsoTpEngine::messageSentSignal signal.
+ * @param ownerId
+ *      The id of the owner of the session.
+ * @param type
+ *      The can type.
+ * @param txId
+ *      The id of the sent frames.
+ * @param success
+ *      False if the sending has failed.
+ * @param errorString
+ *      The error description.
+ */
+void ScriptThread::isoTpMessageSentSlot(quint32 ownerId, quint8 type, quint32 txId, bool success, QString errorString)
+{
+    if((m_state != RUNNING) || (ownerId != m_sendId))
+    {
+        return;
+    }
+    emit isoTpMessageSentSignal(type, txId, success, errorString);
+}
+
+/**
+ * The slot is called if periodic can messages with an update function have been sent.
+ * This slot is connected to the CanTransmitScheduler::periodicMessagesSentSignal signal.
+ * @param frames
+ *      The sent frames.
+ */
+void ScriptThread::periodicCanMessagesSentSlot(QVector<CanFrame> frames)
+{
+    if(m_state != RUNNING)
+    {
+        return;
+    }
+
+    for(const auto& frame : frames)
+    {
+        QMap<quint32, QScriptValue>::iterator function = m_periodicCanMessageFunctions.find(CanTransmitScheduler::createKey(frame.flags, frame.id));
+        if(function == m_periodicCanMessageFunctions.end())
+        {//The message belongs to another script.
+            continue;
+        }
+
+        QVector<unsigned char> data(frame.length);
+        if(frame.length > 0)
+        {
+            memcpy(data.data(), frame.data, frame.length);
+        }
+
+        QScriptValueList arguments;
+        arguments << QScriptValue((int)canFrameType(frame)) << QScriptValue((uint)frame.id) << m_scriptEngine->toScriptValue(data);
+        QScriptValue result = function.value().call(QScriptValue(), arguments);
+
+        if(result.isArray())
+        {
+            setPeriodicCanMessageData(canFrameType(frame), frame.id, qscriptvalue_cast<QVector<unsigned char>>(result));
+        }
+    }
+}
+
 /**
  * Starts the script thread in a debugger;
  */
@@ -1516,12 +2120,26 @@ void ScriptThread::terminateScriptThread(void)
     //Disconnect all signals which are routed to the current script.
     QObject::disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)),
                     this, SLOT(dataReceivedSlot(QByteArray)));
-    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(canMessagesReceivedSignal(QVector<QByteArray>)),
-                    this, SLOT(canMessagesReceivedSlot(QVector<QByteArray>)));
+    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(canMessagesReceivedSignal(QVector<CanFrame>)),
+                    &m_canReceiveFilter, SLOT(framesReceivedSlot(QVector<CanFrame>)));
     QObject::disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(dataConnectionStatusSignal(bool, QString)),
                     this, SLOT(dataConnectionStatusSlot(bool, QString)));
     QObject::disconnect(m_scriptWindow->m_mainInterfaceThread, SIGNAL(sendingFinishedSignal(bool,uint)),
                     this, SLOT(sendingFinishedSlot(bool,uint)));
+    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler(), SIGNAL(periodicMessagesSentSignal(QVector<CanFrame>)),
+                    this, SLOT(periodicCanMessagesSentSlot(QVector<CanFrame>)));
+    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread->getTriggerCapture(), SIGNAL(captureWrittenSignal(QString,bool,QString)),
+                    this, SIGNAL(triggerCaptureWrittenSignal(QString,bool,QString)));
+    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine(), SIGNAL(messageReceivedSignal(quint32,quint8,quint32,QByteArray,bool,QString)),
+                    this, SLOT(isoTpMessageReceivedSlot(quint32,quint8,quint32,QByteArray,bool,QString)));
+    QObject::disconnect(m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine(), SIGNAL(messageSentSignal(quint32,quint8,quint32,bool,QString)),
+                    this, SLOT(isoTpMessageSentSlot(quint32,quint8,quint32,bool,QString)));
+    m_scriptWindow->m_mainInterfaceThread->getCanTransmitScheduler()->removeAllMessages(m_sendId);
+    m_scriptWindow->m_mainInterfaceThread->getIsoTpEngine()->closeAllSessions(m_sendId);
+    if(m_hasStartedTriggerCapture)
+    {
+        m_scriptWindow->m_mainInterfaceThread->getTriggerCapture()->stop();
+    }
 
     terminate();
 }
@@ -1662,6 +2280,197 @@ bool ScriptThread::connectPcan(quint8 channel, quint32 baudrate, quint32 connect
     return succeeded;
 }
 
+/**
+ * Connects the main interface (SocketCAN, Linux only).
+ * Note: A successful call will modify the corresponding settings in the settings dialog.
+ * @param interfaceName
+ *      The interface name (e.g. can0 or vcan0).
+ * @param connectTimeout
+ *      Connect timeout(ms)
+ * @param filters
+ *      Comma separated list of kernel filters (id:mask or id~mask (inverted), hex). An id with
+ *      8 hex digits is an extended id. An empty list receives all frames.
+ * @return
+ *      True on success.
+ */
+bool ScriptThread::connectSocketCan(QString interfaceName, quint32 connectTimeout, QString filters)
+{
+    bool succeeded = false;
+
+    m_settingsDialog->updateSettings();
+    Settings oldSettings = *m_settingsDialog->settings();
+
+    Settings newSettings = *m_settingsDialog->settings();
+    newSettings.connectionType = CONNECTION_TYPE_SOCKETCAN;
+    newSettings.socketCan.interfaceName = interfaceName;
+    newSettings.socketCan.filters = filters;
+    emit setAllSettingsSignal(newSettings, false);
+    emit connectDataConnectionSignal(newSettings, true);
+
+    waitForMainInterfaceToConnect(connectTimeout);
+
+    if(!m_isConnected)
+    {
+        emit setAllSettingsSignal(oldSettings, false);
+        emit connectDataConnectionSignal(oldSettings, false);
+    }
+
+    succeeded = m_isConnected;
+    return succeeded;
+}
+
+/**
+ * Loads a CAN database (dbc file) which is used to decode the received can messages.
+ * All signal subscriptions and plot connections are removed.
+ * @param fileName
+ *      The file name (an empty name removes the loaded database).
+ * @param isRelativePath
+ *      True if fileName is a relative path.
+ * @return
+ *      An empty string on success or the error description.
+ */
+QString ScriptThread::loadCanDatabase(QString fileName, bool isRelativePath)
+{
+    QString errorString;
+
+    m_canSignalSubscriptions.clear();
+    m_subscribedCanSignalsCount = 0;
+    m_canSignalPlots.clear();
+
+    if(fileName.isEmpty())
+    {
+        m_canDatabase.clear();
+    }
+    else
+    {
+        fileName = isRelativePath ? createAbsolutePath(fileName) : fileName;
+        if(!m_canDatabase.loadFile(fileName, &errorString))
+        {
+            m_canDatabase.clear();
+        }
+    }
+
+    m_canSignalSubscriptions.fill(false, m_canDatabase.signalCount());
+    return errorString;
+}
+
+/**
+ * Subscribes a CAN database signal. The values of all subscribed signals are emitted with canSignalsReceivedSignal.
+ * @param signalName
+ *      The signal name (name or message.signal).
+ * @return
+ *      False if the signal does not exist.
+ */
+bool ScriptThread::subscribeCanSignal(QString signalName)
+{
+    qint32 index = m_canDatabase.findSignal(signalName);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    if(!m_canSignalSubscriptions[index])
+    {
+        m_canSignalSubscriptions[index] = true;
+        m_subscribedCanSignalsCount++;
+    }
+    return true;
+}
+
+/**
+ * Unsubscribes a CAN database signal.
+ * @param signalName
+ *      The signal name (name or message.signal).
+ */
+void ScriptThread::unsubscribeCanSignal(QString signalName)
+{
+    qint32 index = m_canDatabase.findSignal(signalName);
+    if((index >= 0) && m_canSignalSubscriptions[index])
+    {
+        m_canSignalSubscriptions[index] = false;
+        m_subscribedCanSignalsCount--;
+    }
+}
+
+/**
+ * Adds every received value of a CAN database signal to a graph of a plot window/widget.
+ * @param signalName
+ *      The signal name (name or message.signal).
+ * @param plot
+ *      The plot window/widget.
+ * @param graphIndex
+ *      The graph index.
+ * @return
+ *      False if the signal does not exist or plot is not a plot object.
+ */
+bool ScriptThread::addCanSignalToPlot(QString signalName, QScriptValue plot, int graphIndex)
+{
+    qint32 index = m_canDatabase.findSignal(signalName);
+    QObject* plotObject = plot.toQObject();
+
+    if((index < 0) || (plotObject == 0) ||
+       (plotObject->metaObject()->indexOfMethod("addDataToGraph(int,double,double)") < 0))
+    {
+        return false;
+    }
+
+    CanSignalPlot signalPlot;
+    signalPlot.signalIndex = index;
+    signalPlot.plot = plotObject;
+    signalPlot.graphIndex = graphIndex;
+    m_canSignalPlots.append(signalPlot);
+    return true;
+}
+
+/**
+ * Decodes the subscribed/plotted CAN database signals of received can messages
+ * and emits canSignalsReceivedSignal.
+ * @param messages
+ *      The received can messages.
+ */
+void ScriptThread::decodeCanSignals(const QVector<CanFrame>& messages)
+{
+    QStringList names;
+    QList<double> values;
+    QVector<quint32> timestamps;
+    QVector<CanSignalValue> frameValues;
+
+    for(const auto& frame : messages)
+    {
+        frameValues.clear();
+        if(!m_canDatabase.decodeFrame(frame, &frameValues))
+        {
+            continue;
+        }
+
+        quint32 timestamp = (quint32)(frame.timestamp / 1000);
+        for(const auto& el : frameValues)
+        {
+            if(m_canSignalSubscriptions[el.signalIndex])
+            {
+                names.append(m_canDatabase.signalAt(el.signalIndex).fullName);
+                values.append(el.value);
+                timestamps.append(timestamp);
+            }
+
+            for(const auto& signalPlot : m_canSignalPlots)
+            {
+                if((signalPlot.signalIndex == el.signalIndex) && !signalPlot.plot.isNull())
+                {
+                    QMetaObject::invokeMethod(signalPlot.plot.data(), "addDataToGraph", Qt::DirectConnection,
+                                              Q_ARG(int, signalPlot.graphIndex), Q_ARG(double, (double)timestamp),
+                                              Q_ARG(double, el.value));
+                }
+            }
+        }
+    }
+
+    if(!names.isEmpty())
+    {
+        emit canSignalsReceivedSignal(names, values, timestamps);
+    }
+}
+
 /**
  * Sets the serial port (main interface) RTS and DTR pins
  * @param setRTS
@@ -2825,6 +3634,107 @@ QStringList ScriptThread::getAllObjectPropertiesAndFunctions(QScriptValue object
     return resultList;
 }
 
+/**
+ * Returns the profiling statistics of the script thread.
+ * @return
+ *      The statistics (the signal handler statistics are in the array 'handlers').
+ */
+QScriptValue ScriptThread::getProfilingStatistics(void)
+{
+    ScriptThreadStatistics statistics = m_profiler.getStatistics();
+    QVector<ScriptHandlerStatistics> handlers = m_profiler.getHandlerStatistics();
+
+    QScriptValue result = m_scriptEngine->newObject();
+    result.setProperty("cpuTimeMs", statistics.cpuTimeMs);
+    result.setProperty("cpuLoad", statistics.cpuLoad);
+    result.setProperty("bytesIn", (double)statistics.bytesIn);
+    result.setProperty("bytesOut", (double)statistics.bytesOut);
+    result.setProperty("bytesInPerSecond", statistics.bytesInPerSecond);
+    result.setProperty("bytesOutPerSecond", statistics.bytesOutPerSecond);
+    result.setProperty("pendingEvents", statistics.pendingEvents);
+    result.setProperty("maxPendingEvents", statistics.maxPendingEvents);
+    result.setProperty("eventLoopLatencyMs", statistics.eventLoopLatencyMs);
+    result.setProperty("maxEventLoopLatencyMs", statistics.maxEventLoopLatencyMs);
+    result.setProperty("garbageCollections", statistics.garbageCollections);
+    result.setProperty("garbageCollectionTimeMs", statistics.garbageCollectionTimeMs);
+    result.setProperty("profilingIsEnabled", statistics.profilingIsEnabled);
+    result.setProperty("samples", (double)statistics.samples);
+
+    QScriptValue handlerArray = m_scriptEngine->newArray(handlers.size());
+    for(int i = 0; i < handlers.size(); i++)
+    {
+        QScriptValue handler = m_scriptEngine->newObject();
+        handler.setProperty("name", handlers[i].name);
+        handler.setProperty("calls", (double)handlers[i].calls);
+        handler.setProperty("totalMs", (double)handlers[i].totalNs / 1000000.0);
+        handler.setProperty("maxMs", (double)handlers[i].maxNs / 1000000.0);
+        handler.setProperty("meanMs", (handlers[i].calls > 0) ? ((double)handlers[i].totalNs / (double)handlers[i].calls) / 1000000.0 : 0.0);
+
+        QScriptValue histogram = m_scriptEngine->newArray(handlers[i].histogram.size());
+        for(int bin = 0; bin < handlers[i].histogram.size(); bin++)
+        {
+            histogram.setProperty(bin, (double)handlers[i].histogram[bin]);
+        }
+        handler.setProperty("histogram", histogram);
+        handlerArray.setProperty(i, handler);
+    }
+    result.setProperty("handlers", handlerArray);
+
+    QScriptValue histogramLimits = m_scriptEngine->newArray(ScriptProfiler::HISTOGRAM_BIN_COUNT - 1);
+    for(int i = 0; i < (ScriptProfiler::HISTOGRAM_BIN_COUNT - 1); i++)
+    {
+        histogramLimits.setProperty(i, (double)ScriptProfiler::HISTOGRAM_LIMITS_US[i] / 1000.0);
+    }
+    result.setProperty("histogramLimitsMs", histogramLimits);
+
+    return result;
+}
+
+/**
+ * Enables/disables the profiling of all signal handlers (script functions which are called from C++).
+ * @param enable
+ *      True for enable.
+ * @param samplingIntervalMs
+ *      The sampling interval of the sampling profiler (0=sampling disabled).
+ * @return
+ *      False if the script runs in the debugger.
+ */
+bool ScriptThread::setProfilingEnabled(bool enable, double samplingIntervalMs)
+{
+    if(m_scriptRunsInDebugger)
+    {//The debugger uses its own agent.
+        return false;
+    }
+
+    if(m_profilerAgent)
+    {
+        m_scriptEngine->setAgent(0);
+        delete m_profilerAgent;
+        m_profilerAgent = 0;
+    }
+
+    if(enable)
+    {
+        qint64 samplingIntervalNs = (samplingIntervalMs > 0) ? (qint64)(samplingIntervalMs * 1000000.0) : 0;
+        m_profilerAgent = new ScriptProfilerAgent(m_scriptEngine, &m_profiler, samplingIntervalNs);
+        m_scriptEngine->setAgent(m_profilerAgent);
+    }
+    m_profiler.setProfilingIsEnabled(enable);
+
+    return true;
+}
+
+/**
+ * Runs the garbage collector of the script engine.
+ */
+void ScriptThread::collectGarbage(void)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_scriptEngine->collectGarbage();
+    m_profiler.garbageCollected(timer.nsecsElapsed());
+}
+
 /**
  * Checks if the version of ScriptCommunicator is equal/greater then the version in minVersion.
  * The format of minVersion is: 'major'.'minor' (e.g. 04.11).
@@ -41,6 +41,10 @@
 #include <scriptHelper.h>
 #include <QStandardPaths>
 #include <QToolBox>
+#include "scriptProfiler.h"
+#include "canDatabase.h"
+#include "canFilter.h"
+#include <QPointer>
 
 
 class ScriptWidget;
@@ -120,6 +124,9 @@ public:
     ///Creates a timer.
     Q_INVOKABLE QScriptValue createTimer(void);
 
+    ///Creates a timer wheel (many timers which are driven by one precise timer, resolution in us).
+    Q_INVOKABLE QScriptValue createTimerWheel(quint32 resolutionUs=1000);
+
     ///Creates a serial port.
     Q_INVOKABLE QScriptValue createSerialPort(void);
 
@@ -138,6 +145,24 @@ public:
     ///Creates a XML writer.
     Q_INVOKABLE QScriptValue createXmlWriter();
 
+    ///Creates a protocol framer (splits a byte stream into SLIP, COBS, STX/ETX or length prefixed frames).
+    Q_INVOKABLE QScriptValue createProtocolFramer(void);
+
+    ///Creates a struct codec (decodes/encodes binary data with a declarative layout description).
+    Q_INVOKABLE QScriptValue createStructCodec(void);
+
+    ///Creates a sequence playlist (sends sequences/data with delays, loops and waits for received data
+    ///in parallel tracks in an own thread).
+    Q_INVOKABLE QScriptValue createSequencePlaylist(void);
+
+    ///Creates a transaction engine (sends requests with the main interface, matches the responses
+    ///and collects the round trip times per command type).
+    Q_INVOKABLE QScriptValue createTransactionEngine(void);
+
+    ///Creates a file transfer object (sends/receives files with raw chunks, XMODEM-1K or YMODEM
+    ///in the main interface thread).
+    Q_INVOKABLE QScriptValue createFileTransfer(void);
+
     ///Deletes an object created by the script.
     ///Note: This function must not used any more.
     ///Objects are deleted automatically by the script engine garbage collector.
@@ -237,6 +262,81 @@ public:
     ///If more then 8 data bytes are given several can messages with the same can id will be sent.
     Q_INVOKABLE bool sendCanMessage(quint8 type, quint32 canId, QVector<unsigned char> data, int repetitionCount=0, int pause=0, bool addToMainWindowSendHistory=false);
 
+    ///Sends several can messages (max. 8 data bytes per message) with one call (burst).
+    ///types, canIds and data must have the same size.
+    Q_INVOKABLE bool sendCanMessages(QVector<quint8> types, QVector<quint32> canIds, QVector<QVector<unsigned char>> data);
+
+    ///Sends a can message periodically (max. 8 data bytes, cycleTime in ms, min. 0.1 ms). An existing periodic message with the same
+    ///type and id is replaced. If updateFunction is given, then it is called after every transmission with (type, canId, data);
+    ///if it returns an array, then the array is used as payload for the next transmissions.
+    ///The periodic messages of a script are removed if the script exits.
+    Q_INVOKABLE bool startPeriodicCanMessage(quint8 type, quint32 canId, QVector<unsigned char> data, double cycleTime,
+                                             QScriptValue updateFunction = QScriptValue());
+
+    ///Sets the payload of a periodic can message (is used for the next transmission).
+    Q_INVOKABLE bool setPeriodicCanMessageData(quint8 type, quint32 canId, QVector<unsigned char> data);
+
+    ///Stops a periodic can message.
+    Q_INVOKABLE void stopPeriodicCanMessage(quint8 type, quint32 canId);
+
+    ///Returns the measured cycle accuracy of a periodic can message (all times in ms):
+    ///cycleTime, sentMessages, missedCycles, meanCycleTime, minCycleTime, maxCycleTime, meanDelay, maxDelay.
+    ///Returns undefined if the periodic message does not exist.
+    Q_INVOKABLE QScriptValue getPeriodicCanMessageStatistics(quint8 type, quint32 canId);
+
+    ///Returns the can bus statistics of the main interface (rates of the last second, counters since connect):
+    ///bitrate, receivedFrames, sentFrames, errorFrames, receivedFramesPerSecond, sentFramesPerSecond,
+    ///receivedBitsPerSecond, sentBitsPerSecond, errorFramesPerSecond, busLoad, maxBusLoad (in %, -1 if the bit rate is unknown)
+    ///and ids (array with: type, id, receivedFrames, sentFrames, receivedFramesPerSecond, sentFramesPerSecond).
+    Q_INVOKABLE QScriptValue getCanBusStatistics(void);
+
+    ///Sets the filter for the can messages which are received by this script (canMessagesReceivedSignal and the
+    ///CAN database signals). filter is a comma separated list of rules (hex): id, first-last or id:mask; a rule with a
+    ///leading '!' excludes, an id with 8 hex digits is an extended id (e.g. "100-1ff, !123, 18fe0000:1fff0000").
+    ///An empty filter receives all messages. Returns an error description (empty on success).
+    Q_INVOKABLE QString setCanReceiveFilter(QString filter);
+
+    ///Returns the filter for the received can messages (see setCanReceiveFilter).
+    Q_INVOKABLE QString getCanReceiveFilter(void){return m_canReceiveFilter.filter().text();}
+
+    ///Starts (arms) the trigger capture of the received data (can frames and bytes). If a trigger fires, then the data of
+    ///preTriggerTime (ms) before and postTriggerTime (ms) after the trigger is written into a capture file (fileName with an
+    ///appended index). maxMemory (MB) limits the memory of the capture (including the captures which are being written).
+    ///The capture is re-armed after every trigger and is stopped if the script exits. triggerCaptureWrittenSignal is emitted
+    ///after a capture file has been written.
+    Q_INVOKABLE bool startTriggerCapture(QString fileName, quint32 preTriggerTime, quint32 postTriggerTime, double maxMemory = 64, bool isRelativePath = true);
+
+    ///Stops the trigger capture (a running post-trigger time is discarded).
+    Q_INVOKABLE void stopTriggerCapture(void);
+
+    ///Adds a can trigger to the trigger capture. The trigger fires if a received frame has the same type and
+    ///(frameId & idMask) == (canId & idMask) and (frameData[i] & dataMask[i]) == (data[i] & dataMask[i]) for every byte in dataMask.
+    Q_INVOKABLE bool addCanCaptureTrigger(quint8 type, quint32 canId, quint32 idMask, QVector<unsigned char> data, QVector<unsigned char> dataMask);
+
+    ///Adds a byte pattern trigger to the trigger capture (for the received bytes of the not can interfaces).
+    Q_INVOKABLE bool addDataCaptureTrigger(QVector<unsigned char> pattern);
+
+    ///Removes all can and byte pattern triggers of the trigger capture.
+    Q_INVOKABLE void clearCaptureTriggers(void);
+
+    ///Fires the trigger of the trigger capture. Returns false if the capture is not armed
+    ///(not started or a post-trigger time is running).
+    Q_INVOKABLE bool fireCaptureTrigger(QString description = "script");
+
+    ///Opens an ISO-TP session (normal addressing, classic can frames). The messages are sent with txId and received with rxId.
+    ///blockSize and stMin (ms, 0.1-0.9 ms are possible) are sent in the flow control frames, paddingByte (-1=no padding) is used
+    ///to fill the frames to 8 bytes. The received messages are emitted with isoTpMessageReceivedSignal.
+    ///Returns false if txId or rxId is used by another session. The sessions are closed if the script exits.
+    Q_INVOKABLE bool openIsoTpSession(quint8 type, quint32 txId, quint32 rxId, quint8 blockSize = 0, double stMin = 0, int paddingByte = 0xCC);
+
+    ///Closes an ISO-TP session (a running transfer is aborted).
+    Q_INVOKABLE void closeIsoTpSession(quint8 type, quint32 txId);
+
+    ///Sends a message with an ISO-TP session (the segmentation and the flow control are done in the main interface thread).
+    ///The result is emitted with isoTpMessageSentSignal. Returns false if the session does not exist, if the session
+    ///is sending or if the size of data is invalid (1 - 1048576 bytes).
+    Q_INVOKABLE bool sendIsoTpMessage(quint8 type, quint32 txId, QVector<unsigned char> data);
+
     ///Sends a string (QString) with the main interface (in MainInterfaceThread).
     Q_INVOKABLE bool sendString(QString string, int repetitionCount=0, int pause=0, bool addToMainWindowSendHistory=false);
 
@@ -254,6 +354,29 @@ public:
     Q_INVOKABLE bool connectPcan(quint8 channel, quint32 baudrate, quint32 connectTimeout = 2000, bool busOffAutoReset = true, bool powerSupply = false,
                                  bool filterExtended = true, quint32 filterFrom = 0, quint32 filterTo = 0x1fffffff);
 
+    ///Connects the main interface (SocketCAN, Linux only).
+    ///Note: A successful call will modify the corresponding settings in the settings dialog.
+    Q_INVOKABLE bool connectSocketCan(QString interfaceName, quint32 connectTimeout = 2000, QString filters = "");
+
+    ///Loads a CAN database (dbc file) which is used to decode the received can messages.
+    ///An empty file name removes the loaded database. All signal subscriptions and plot connections are removed.
+    ///Returns an empty string on success or the error description.
+    Q_INVOKABLE QString loadCanDatabase(QString fileName, bool isRelativePath = true);
+
+    ///Returns the names (message.signal) of all signals in the loaded CAN database.
+    Q_INVOKABLE QStringList getCanSignalNames(void){return m_canDatabase.signalNames();}
+
+    ///Subscribes a CAN database signal (name or message.signal). The values of all subscribed
+    ///signals are emitted with canSignalsReceivedSignal. Returns false if the signal does not exist.
+    Q_INVOKABLE bool subscribeCanSignal(QString signalName);
+
+    ///Unsubscribes a CAN database signal.
+    Q_INVOKABLE void unsubscribeCanSignal(QString signalName);
+
+    ///Adds every received value of a CAN database signal to a graph of a plot window/widget
+    ///(x = time stamp in ms). Returns false if the signal does not exist or plot is not a plot object.
+    Q_INVOKABLE bool addCanSignalToPlot(QString signalName, QScriptValue plot, int graphIndex);
+
     ///Sets the serial port (main interface) RTS and DTR pins.
     Q_INVOKABLE void setSerialPortPins(bool setRTS, bool setDTR);
 
@@ -509,6 +632,28 @@ public:
     ///Returns and prints (if printInScriptWindowConsole is true) all functions and properties of an object in the script window console.
     Q_INVOKABLE QStringList getAllObjectPropertiesAndFunctions(QScriptValue object, bool printInScriptWindowConsole=false);
 
+    ///Returns the profiling statistics of the script thread (CPU time/load, received/sent bytes, pending receive events,
+    ///event loop latency, garbage collections and the statistics of all signal handlers if profiling is enabled).
+    Q_INVOKABLE QScriptValue getProfilingStatistics(void);
+
+    ///Enables/disables the profiling of all signal handlers (script functions which are called from C++).
+    ///If samplingIntervalMs is greater than 0, the call stack is sampled (see getFlameGraphData).
+    ///Note: Profiling slows down the script and is not possible if the script runs in the debugger.
+    Q_INVOKABLE bool setProfilingEnabled(bool enable, double samplingIntervalMs=0);
+
+    ///Returns the samples of the sampling profiler in the folded stack format
+    ///(one line per stack: 'function1;function2;function3 count'), which can be used to create flame graphs.
+    Q_INVOKABLE QString getFlameGraphData(void){return m_profiler.getFoldedStacks();}
+
+    ///Resets all profiling statistics.
+    Q_INVOKABLE void resetProfilingStatistics(void){m_profiler.reset();}
+
+    ///Runs the garbage collector of the script engine.
+    Q_INVOKABLE void collectGarbage(void);
+
+    ///Returns the profiler of the script thread.
+    ScriptProfiler* getProfiler(void){return &m_profiler;}
+
     ///Returns the tread state.
     ThreadSate getThreadState(){return m_state;}
 
@@ -572,10 +717,32 @@ signals:
     void canMessagesReceivedSignal(QVector<quint8> types, QVector<quint32> messageIds, QVector<quint32> timestamps,
                                    QVector<QVector<unsigned char>>  data);
 
+    ///This signal is emitted if subscribed CAN database signals (see subscribeCanSignal) have been received.
+    ///names, values and timestamps (ms) contain one entry per received signal value.
+    ///Scripts can connect a function to this signal.
+    void canSignalsReceivedSignal(QStringList names, QList<double> values, QVector<quint32> timestamps);
+
+    ///This signal is emitted if a capture file of the trigger capture (see startTriggerCapture) has been written.
+    ///Scripts can connect a function to this signal.
+    void triggerCaptureWrittenSignal(QString fileName, bool success, QString errorString);
+
+    ///This signal is emitted if an ISO-TP message has been received (see openIsoTpSession). If success is false, then
+    ///data contains the bytes which have been received before the error.
+    ///Scripts can connect a function to this signal.
+    void isoTpMessageReceivedSignal(quint8 type, quint32 rxId, QVector<unsigned char> data, bool success, QString errorString);
+
+    ///This signal is emitted if an ISO-TP message has been sent (see sendIsoTpMessage) or if the sending has failed.
+    ///Scripts can connect a function to this signal.
+    void isoTpMessageSentSignal(quint8 type, quint32 txId, bool success, QString errorString);
+
     ///Is connected with MainInterfaceThread::sendData (sends data with the main interface).
     ///This signal must not be used from script.
     void sendDataSignal(const QByteArray data, uint id);
 
+    ///Is connected with MainInterfaceThread::sendCanFramesSlot (sends several can frames with the main interface).
+    ///This signal must not be used from script.
+    void sendCanFramesSignal(const QVector<CanFrame> frames, uint id);
+
     ///Is connected with ScriptWindow::appendTextToConsoleSlot (appends text to the console in the script window).
     ///This signal must not be used from script.
     void appendTextToConsoleSignal(QString text, bool newLine);
@@ -682,7 +849,19 @@ private slots:
 
     ///The slot is called if the main interface thread has received data.
     ///This slot is connected to the MainInterfaceThread::dataReceivedSignal signal.
-    void canMessagesReceivedSlot(QVector<QByteArray> messages);
+    void canMessagesReceivedSlot(QVector<CanFrame> messages);
+
+    ///The slot is called if periodic can messages with an update function have been sent.
+    ///This slot is connected to the CanTransmitScheduler::periodicMessagesSentSignal signal.
+    void periodicCanMessagesSentSlot(QVector<CanFrame> frames);
+
+    ///The slot is called if an ISO-TP message has been received.
+    ///This slot is connected to the IsoTpEngine::messageReceivedSignal signal.
+    void isoTpMessageReceivedSlot(quint32 ownerId, quint8 type, quint32 rxId, QByteArray data, bool success, QString errorString);
+
+    ///The slot is called if an ISO-TP message has been sent.
+    ///This slot is connected to the IsoTpEngine::messageSentSignal signal.
+    void isoTpMessageSentSlot(quint32 ownerId, quint8 type, quint32 txId, bool success, QString errorString);
 
     ///This slot is connected with MainInterfaceThread::dataConnectionStatusSignal.
     ///The connected status (main interface) is reported with this signal.
@@ -699,6 +878,15 @@ private slots:
     ///Sends the send data from the main interface.
     void sendDataFromMainInterfaceSlot(const QByteArray data);
 
+    ///Is called (direct connection) if the main interface thread has queued received data for this thread.
+    void dataQueuedSlot(QByteArray data){(void)data; m_profiler.dataQueued();}
+
+    ///Is called (direct connection) if the main interface thread has queued received can messages for this thread.
+    void canMessagesQueuedSlot(QVector<CanFrame> messages){(void)messages; m_profiler.dataQueued();}
+
+    ///This slot is called periodically by the timer m_profilerTimer.
+    void profilerTimerSlot(void){m_profiler.updateStatistics();}
+
 #ifdef Q_OS_MAC
     ///Debug timer slot (checks if the script is suspended by the debugger or is running).
     void debugTimerSlot(void);
@@ -715,6 +903,9 @@ private:
     ///Sends a byte array (QByteArray) with the main interface (in MainInterfaceThread).
     bool sendByteArray(QByteArray byteArray, int repetitionCount, int pause, bool addToMainWindowSendHistory);
 
+    ///Decodes the subscribed/plotted CAN database signals of received can messages.
+    void decodeCanSignals(const QVector<CanFrame>& messages);
+
     ///Pointer to the script window.
     ScriptWindow* m_scriptWindow;
 
@@ -724,6 +915,40 @@ private:
     ///True, if the main interface is a can interface (and is connected).
     bool m_isConnectedWithCan;
 
+    ///The CAN database which is used by the script.
+    CanDatabase m_canDatabase;
+
+    ///Contains one entry per signal in m_canDatabase (true if the signal is subscribed).
+    QVector<bool> m_canSignalSubscriptions;
+
+    ///The number of subscribed CAN database signals.
+    qint32 m_subscribedCanSignalsCount;
+
+    ///A CAN database signal which is added to a plot graph.
+    typedef struct
+    {
+        ///The index of the signal in m_canDatabase.
+        qint32 signalIndex;
+
+        ///The plot window/widget.
+        QPointer<QObject> plot;
+
+        ///The graph index.
+        int graphIndex;
+    }CanSignalPlot;
+
+    ///All CAN database signals which are added to a plot graph.
+    QVector<CanSignalPlot> m_canSignalPlots;
+
+    ///The update functions of the periodic can messages (key: CanTransmitScheduler::createKey).
+    QMap<quint32, QScriptValue> m_periodicCanMessageFunctions;
+
+    ///True if the trigger capture has been started by this script (it is stopped if the script exits).
+    bool m_hasStartedTriggerCapture;
+
+    ///Filters the received can messages of this script (is evaluated in the main interface thread).
+    CanFilterRelay m_canReceiveFilter;
+
     ///The send id, which is send to the send data during sending data.
     quint32 m_sendId;
 
@@ -790,6 +1015,15 @@ private:
     ///The script sendDataFromMainInterface function.
     QScriptValue sendDataFromMainInterfaceFunction;
 
+    ///The profiler (statistics) of the script thread.
+    ScriptProfiler m_profiler;
+
+    ///The script engine agent which is used if profiling is enabled.
+    ScriptProfilerAgent* m_profilerAgent;
+
+    ///The timer which periodically calls profilerTimerSlot.
+    QTimer* m_profilerTimer;
+
 #ifdef Q_OS_MAC
     ///The debug timer (checks if the script is suspended by the debugger or is running).
     QTimer m_debugTimer;
@@ -0,0 +1,559 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptTimerWheel.h"
+#include <QThread>
+#include <QScriptEngine>
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent (script thread).
+ * @param resolutionUs
+ *      The tick duration in us (50us - 1s).
+ */
+ScriptTimerWheel::ScriptTimerWheel(QObject *parent, quint32 resolutionUs) :
+    QObject(parent), m_timers(), m_freeIndexes(), m_idToIndex(), m_slotHeads(LEVEL0_SIZE + (3 * LEVEL_N_SIZE), -1),
+    m_expiredTimers(), m_nextId(1), m_currentTick(0), m_resolutionNs(0), m_activeCount(0), m_level0Count(0),
+    m_missedPeriodCount(0), m_isProcessing(false), m_isPaused(false), m_elapsedTimer(), m_driverTimer(this), m_driverTick(0)
+{
+    resolutionUs = qBound((quint32)50, resolutionUs, (quint32)1000000);
+    m_resolutionNs = (qint64)resolutionUs * 1000;
+
+    m_elapsedTimer.start();
+
+    m_driverTimer.setSingleShot(true);
+    m_driverTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_driverTimer, SIGNAL(timeout()), this, SLOT(driverTimerSlot()));
+
+    connect(parent, SIGNAL(pauseAllCreatedInterfaces(bool)),this, SLOT(pauseInterfaceSlot(bool)));
+}
+
+/**
+ * Creates and starts a timer.
+ * @param intervalMs
+ *      The interval in ms.
+ * @param callback
+ *      The function which is called if the timer expires (if this is no function timeoutSignal is emitted).
+ * @param isPeriodic
+ *      True if the timer is periodic.
+ * @return
+ *      The timer id.
+ */
+quint32 ScriptTimerWheel::start(double intervalMs, QScriptValue callback, bool isPeriodic)
+{
+    qint32 index;
+    if(!m_freeIndexes.isEmpty())
+    {
+        index = m_freeIndexes.takeLast();
+    }
+    else
+    {
+        index = m_timers.size();
+        m_timers.resize(m_timers.size() + 1);
+    }
+
+    TimerWheelEntry& entry = m_timers[index];
+    entry.id = m_nextId++;
+    entry.intervalNs = (intervalMs > 0) ? (qint64)(intervalMs * 1000000.0) : 0;
+    if(isPeriodic && (entry.intervalNs < m_resolutionNs))
+    {
+        entry.intervalNs = m_resolutionNs;
+    }
+    entry.isPeriodic = isPeriodic;
+    entry.callback = callback;
+    entry.slot = -1;
+    entry.previous = -1;
+    entry.next = -1;
+
+    m_idToIndex.insert(entry.id, index);
+
+    quint32 id = entry.id;
+    restart(id);
+    return id;
+}
+
+/**
+ * Restarts a timer.
+ * @param id
+ *      The timer id.
+ * @return
+ *      False if the id is unknown.
+ */
+bool ScriptTimerWheel::restart(quint32 id)
+{
+    qint32 index = indexOf(id);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    unlinkTimer(index);
+
+    TimerWheelEntry& entry = m_timers[index];
+    entry.expiryNs = m_elapsedTimer.nsecsElapsed() + entry.intervalNs;
+    insertTimer(index);
+
+    armDriver();
+    return true;
+}
+
+/**
+ * Sets the interval of a timer and restarts it.
+ * @param id
+ *      The timer id.
+ * @param intervalMs
+ *      The new interval in ms.
+ * @return
+ *      False if the id is unknown.
+ */
+bool ScriptTimerWheel::setInterval(quint32 id, double intervalMs)
+{
+    qint32 index = indexOf(id);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    TimerWheelEntry& entry = m_timers[index];
+    entry.intervalNs = (intervalMs > 0) ? (qint64)(intervalMs * 1000000.0) : 0;
+    if(entry.isPeriodic && (entry.intervalNs < m_resolutionNs))
+    {
+        entry.intervalNs = m_resolutionNs;
+    }
+
+    return restart(id);
+}
+
+/**
+ * Stops a timer.
+ * @param id
+ *      The timer id.
+ * @return
+ *      False if the id is unknown.
+ */
+bool ScriptTimerWheel::stop(quint32 id)
+{
+    qint32 index = indexOf(id);
+    if(index < 0)
+    {
+        return false;
+    }
+
+    unlinkTimer(index);
+    m_timers[index].slot = -1;
+    armDriver();
+    return true;
+}
+
+/**
+ * Stops and removes a timer.
+ * @param id
+ *      The timer id.
+ */
+void ScriptTimerWheel::remove(quint32 id)
+{
+    qint32 index = indexOf(id);
+    if(index >= 0)
+    {
+        unlinkTimer(index);
+        m_timers[index].slot = -1;
+        m_timers[index].callback = QScriptValue();
+        m_idToIndex.remove(id);
+        m_freeIndexes.append(index);
+        armDriver();
+    }
+}
+
+/**
+ * Stops and removes all timers.
+ */
+void ScriptTimerWheel::removeAll(void)
+{
+    m_timers.clear();
+    m_freeIndexes.clear();
+    m_idToIndex.clear();
+    m_expiredTimers.clear();
+    m_slotHeads.fill(-1);
+    m_activeCount = 0;
+    m_level0Count = 0;
+    m_driverTimer.stop();
+}
+
+/**
+ * Returns true if the timer is running.
+ * @param id
+ *      The timer id.
+ * @return
+ *      True if the timer is running.
+ */
+bool ScriptTimerWheel::isActive(quint32 id)
+{
+    qint32 index = indexOf(id);
+    return (index >= 0) && ((m_timers[index].slot >= 0) || (m_timers[index].slot == SLOT_EXPIRED));
+}
+
+/**
+ * Inserts a timer into the wheel.
+ * @param index
+ *      The index of the timer.
+ */
+void ScriptTimerWheel::insertTimer(qint32 index)
+{
+    TimerWheelEntry& entry = m_timers[index];
+
+    entry.expiryTick = nsToTick(entry.expiryNs);
+    if(entry.expiryTick <= m_currentTick)
+    {//The timer is already due, put it directly into the ready list (m_expiredTimers).
+        entry.slot = SLOT_EXPIRED;
+        entry.previous = -1;
+        entry.next = -1;
+        m_expiredTimers.append(entry.id);
+        return;
+    }
+
+    const quint64 delta = entry.expiryTick - m_currentTick;
+    qint32 slot;
+
+    if(delta < LEVEL0_SIZE)
+    {
+        slot = entry.expiryTick & (LEVEL0_SIZE - 1);
+        m_level0Count++;
+    }
+    else if(delta < ((quint64)1 << 14))
+    {
+        slot = LEVEL0_SIZE + ((entry.expiryTick >> 8) & (LEVEL_N_SIZE - 1));
+    }
+    else if(delta < ((quint64)1 << 20))
+    {
+        slot = LEVEL0_SIZE + LEVEL_N_SIZE + ((entry.expiryTick >> 14) & (LEVEL_N_SIZE - 1));
+    }
+    else
+    {
+        //Timers which are out of the range of the wheel are re-inserted during the cascade.
+        const quint64 tick = (delta < ((quint64)1 << 26)) ? entry.expiryTick : (m_currentTick + ((quint64)1 << 26) - 1);
+        slot = LEVEL0_SIZE + (2 * LEVEL_N_SIZE) + ((tick >> 20) & (LEVEL_N_SIZE - 1));
+    }
+
+    entry.slot = slot;
+    entry.previous = -1;
+    entry.next = m_slotHeads[slot];
+    if(entry.next >= 0)
+    {
+        m_timers[entry.next].previous = index;
+    }
+    m_slotHeads[slot] = index;
+    m_activeCount++;
+}
+
+/**
+ * Removes a timer from its slot.
+ * @param index
+ *      The index of the timer.
+ */
+void ScriptTimerWheel::unlinkTimer(qint32 index)
+{
+    TimerWheelEntry& entry = m_timers[index];
+    if(entry.slot < 0)
+    {//The timer is not running (or has already been expired).
+        entry.slot = -1;
+        return;
+    }
+
+    if(entry.previous >= 0)
+    {
+        m_timers[entry.previous].next = entry.next;
+    }
+    else
+    {
+        m_slotHeads[entry.slot] = entry.next;
+    }
+
+    if(entry.next >= 0)
+    {
+        m_timers[entry.next].previous = entry.previous;
+    }
+
+    if(entry.slot < (qint32)LEVEL0_SIZE)
+    {
+        m_level0Count--;
+    }
+    m_activeCount--;
+
+    entry.slot = -1;
+    entry.previous = -1;
+    entry.next = -1;
+}
+
+/**
+ * Moves all timers of a slot to lower levels.
+ * @param slot
+ *      The slot.
+ */
+void ScriptTimerWheel::cascade(qint32 slot)
+{
+    qint32 index = m_slotHeads[slot];
+    m_slotHeads[slot] = -1;
+
+    while(index >= 0)
+    {
+        qint32 next = m_timers[index].next;
+        m_timers[index].slot = -1;
+        m_activeCount--;
+        insertTimer(index);
+        index = next;
+    }
+}
+
+/**
+ * Advances the wheel up to targetTick and collects all expired timers in m_expiredTimers.
+ * @param targetTick
+ *      The target tick.
+ */
+void ScriptTimerWheel::advance(quint64 targetTick)
+{
+    while(m_currentTick < targetTick)
+    {
+        if(m_activeCount == 0)
+        {
+            m_currentTick = targetTick;
+            break;
+        }
+
+        if(m_level0Count == 0)
+        {//Nothing can expire before the next cascade.
+
+            const quint64 boundary = ((m_currentTick / LEVEL0_SIZE) + 1) * LEVEL0_SIZE;
+            if(boundary > targetTick)
+            {
+                m_currentTick = targetTick;
+                break;
+            }
+            m_currentTick = boundary - 1;
+        }
+
+        m_currentTick++;
+
+        if((m_currentTick & (LEVEL0_SIZE - 1)) == 0)
+        {
+            const qint32 index1 = (m_currentTick >> 8) & (LEVEL_N_SIZE - 1);
+            cascade(LEVEL0_SIZE + index1);
+            if(index1 == 0)
+            {
+                const qint32 index2 = (m_currentTick >> 14) & (LEVEL_N_SIZE - 1);
+                cascade(LEVEL0_SIZE + LEVEL_N_SIZE + index2);
+                if(index2 == 0)
+                {
+                    cascade(LEVEL0_SIZE + (2 * LEVEL_N_SIZE) + ((m_currentTick >> 20) & (LEVEL_N_SIZE - 1)));
+                }
+            }
+        }
+
+        const qint32 slot = m_currentTick & (LEVEL0_SIZE - 1);
+        qint32 index = m_slotHeads[slot];
+        m_slotHeads[slot] = -1;
+
+        while(index >= 0)
+        {
+            TimerWheelEntry& entry = m_timers[index];
+            qint32 next = entry.next;
+
+            entry.slot = SLOT_EXPIRED;
+            entry.previous = -1;
+            entry.next = -1;
+            m_activeCount--;
+            m_level0Count--;
+            m_expiredTimers.append(entry.id);
+
+            index = next;
+        }
+    }
+}
+
+/**
+ * Returns the next tick at which the wheel has to be processed.
+ * @return
+ *      The tick.
+ */
+quint64 ScriptTimerWheel::nextEventTick(void)
+{
+    const bool higherLevelsAreEmpty = (m_level0Count == m_activeCount);
+
+    for(quint64 i = 1; i <= LEVEL0_SIZE; i++)
+    {
+        const quint64 tick = m_currentTick + i;
+        const qint32 slot = tick & (LEVEL0_SIZE - 1);
+
+        if((slot == 0) && !higherLevelsAreEmpty)
+        {//Cascade.
+            return tick;
+        }
+        if(m_slotHeads[slot] >= 0)
+        {
+            return tick;
+        }
+    }
+
+    return m_currentTick + LEVEL0_SIZE;
+}
+
+/**
+ * Starts m_driverTimer for the next event.
+ */
+void ScriptTimerWheel::armDriver(void)
+{
+    if(m_isPaused || m_isProcessing)
+    {
+        return;
+    }
+
+    if(!m_expiredTimers.isEmpty())
+    {//Call the due timers as soon as possible.
+        m_driverTick = m_currentTick;
+        m_driverTimer.start(0);
+        return;
+    }
+
+    if(m_activeCount == 0)
+    {
+        m_driverTimer.stop();
+        return;
+    }
+
+    m_driverTick = nextEventTick();
+    const qint64 remainingNs = ((qint64)m_driverTick * m_resolutionNs) - m_elapsedTimer.nsecsElapsed();
+    m_driverTimer.start((remainingNs > 0) ? (int)(remainingNs / 1000000) : 0);
+}
+
+/**
+ * Is called by m_driverTimer.
+ */
+void ScriptTimerWheel::driverTimerSlot(void)
+{
+    if(m_isPaused)
+    {
+        return;
+    }
+
+    const qint64 remainingNs = ((qint64)m_driverTick * m_resolutionNs) - m_elapsedTimer.nsecsElapsed();
+    if(remainingNs > 0)
+    {
+        if(remainingNs < 2000000)
+        {//QTimer has only a ms resolution, wait the rest of the time.
+            QThread::usleep((unsigned long)(remainingNs / 1000));
+        }
+        else
+        {
+            armDriver();
+            return;
+        }
+    }
+
+    m_isProcessing = true;
+
+    qint64 nowNs = m_elapsedTimer.nsecsElapsed();
+    advance((quint64)(nowNs / m_resolutionNs));
+
+    QVector<quint32> expiredTimers;
+    expiredTimers.swap(m_expiredTimers);
+
+    for(auto id : expiredTimers)
+    {
+        qint32 index = indexOf(id);
+        if((index < 0) || (m_timers[index].slot != SLOT_EXPIRED))
+        {//The timer has been stopped or restarted by a previous callback.
+            continue;
+        }
+
+        TimerWheelEntry& entry = m_timers[index];
+        if(entry.isPeriodic)
+        {
+            //The next expiry time is based on the last expiry time (not on the current time).
+            qint64 nextExpiryNs = entry.expiryNs + entry.intervalNs;
+            if(nextExpiryNs <= nowNs)
+            {
+                const qint64 missedPeriods = ((nowNs - nextExpiryNs) / entry.intervalNs) + 1;
+                nextExpiryNs += missedPeriods * entry.intervalNs;
+                m_missedPeriodCount += (quint32)missedPeriods;
+            }
+            entry.expiryNs = nextExpiryNs;
+            entry.slot = -1;
+            insertTimer(index);
+        }
+        else
+        {
+            entry.slot = -1;
+        }
+
+        //Note: entry must not be used after the callback (m_timers may be changed).
+        QScriptValue callback = entry.callback;
+        if(callback.isFunction())
+        {
+            callback.call();
+
+            QScriptEngine* engine = callback.engine();
+            if(engine && engine->hasUncaughtException())
+            {
+                QScriptValue exception = engine->uncaughtException();
+                engine->clearExceptions();
+                emit scriptExceptionSignal(exception);
+            }
+        }
+        else
+        {
+            emit timeoutSignal(id);
+        }
+
+        if(m_isPaused)
+        {//The script has been paused by a callback, the remaining timers are called after the pause.
+
+            m_expiredTimers = expiredTimers.mid(expiredTimers.indexOf(id) + 1) + m_expiredTimers;
+            break;
+        }
+        nowNs = m_elapsedTimer.nsecsElapsed();
+    }
+
+    m_isProcessing = false;
+    armDriver();
+}
+
+/**
+ * If pause is true, no timer is called.
+ * @param pause
+ *      True for pause.
+ */
+void ScriptTimerWheel::pauseInterfaceSlot(bool pause)
+{
+    m_isPaused = pause;
+
+    if(pause)
+    {
+        m_driverTimer.stop();
+    }
+    else
+    {
+        //Calls the timers which have not been called because of the pause.
+        armDriver();
+    }
+}
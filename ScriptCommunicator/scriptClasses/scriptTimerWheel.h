@@ -0,0 +1,215 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTTIMERWHEEL_H
+#define SCRIPTTIMERWHEEL_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QScriptValue>
+
+///One timer of the timer wheel.
+typedef struct
+{
+    ///The id of the timer.
+    quint32 id;
+
+    ///The interval in ns.
+    qint64 intervalNs;
+
+    ///The absolute expiry time in ns (relative to the start of the timer wheel).
+    qint64 expiryNs;
+
+    ///The expiry tick.
+    quint64 expiryTick;
+
+    ///The previous timer in the same slot (-1 if there is none).
+    qint32 previous;
+
+    ///The next timer in the same slot (-1 if there is none).
+    qint32 next;
+
+    ///The slot in which the timer is stored (-1 if the timer is not running).
+    qint32 slot;
+
+    ///True if the timer is periodic.
+    bool isPeriodic;
+
+    ///The script function which is called if the timer expires.
+    QScriptValue callback;
+}TimerWheelEntry;
+
+///Hierarchical timer wheel (4 levels) for scripts which need many timers.
+///All timers of one wheel are driven by one precise QTimer. Starting, stopping and
+///restarting a timer are O(1) operations. Periodic timers are scheduled with absolute
+///deadlines (no drift).
+class ScriptTimerWheel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptTimerWheel(QObject *parent, quint32 resolutionUs);
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptTimerWheel*>("ScriptTimerWheel*");
+    }
+
+    ///Creates and starts a timer. If callback is a function, it is called if the timer expires,
+    ///else timeoutSignal is emitted. Returns the timer id.
+    Q_INVOKABLE quint32 start(double intervalMs, QScriptValue callback=QScriptValue(), bool isPeriodic=false);
+
+    ///Restarts a timer (the new expiry time is now + interval). Returns false if the id is unknown.
+    Q_INVOKABLE bool restart(quint32 id);
+
+    ///Sets the interval of a timer and restarts it. Returns false if the id is unknown.
+    Q_INVOKABLE bool setInterval(quint32 id, double intervalMs);
+
+    ///Stops a timer (it can be restarted with restart). Returns false if the id is unknown.
+    Q_INVOKABLE bool stop(quint32 id);
+
+    ///Stops and removes a timer (the id becomes invalid).
+    Q_INVOKABLE void remove(quint32 id);
+
+    ///Stops and removes all timers.
+    Q_INVOKABLE void removeAll(void);
+
+    ///Returns true if the timer is running (or has expired and its callback has not been called yet).
+    Q_INVOKABLE bool isActive(quint32 id);
+
+    ///Returns the number of running timers.
+    Q_INVOKABLE quint32 activeTimerCount(void){return m_activeCount;}
+
+    ///Returns the resolution of the timer wheel (ms).
+    Q_INVOKABLE double getResolutionMs(void){return (double)m_resolutionNs / 1000000.0;}
+
+    ///Returns the number of skipped periods (periodic timers which could not be called in time).
+    Q_INVOKABLE quint32 getMissedPeriodCount(void){return m_missedPeriodCount;}
+
+signals:
+    ///This signal is emitted if a timer without callback function expires.
+    ///Scripts can connect a function to this signal.
+    void timeoutSignal(quint32 id);
+
+    ///This signal is emitted if a callback function has thrown an exception.
+    ///This signal must not be used from script.
+    void scriptExceptionSignal(const QScriptValue& exception);
+
+private slots:
+
+    ///Is called by m_driverTimer.
+    void driverTimerSlot(void);
+
+    ///If pause is true, no timer is called.
+    void pauseInterfaceSlot(bool pause);
+
+private:
+
+    ///Inserts a timer into the wheel.
+    void insertTimer(qint32 index);
+
+    ///Removes a timer from its slot.
+    void unlinkTimer(qint32 index);
+
+    ///Moves all timers of a slot to lower levels.
+    void cascade(qint32 slot);
+
+    ///Advances the wheel up to targetTick and collects all expired timers in m_expiredTimers.
+    void advance(quint64 targetTick);
+
+    ///Returns the next tick at which the wheel has to be processed.
+    quint64 nextEventTick(void);
+
+    ///Starts m_driverTimer for the next event.
+    void armDriver(void);
+
+    ///Returns the first tick at or after timeNs.
+    quint64 nsToTick(qint64 timeNs){return (quint64)((timeNs + m_resolutionNs - 1) / m_resolutionNs);}
+
+    ///Returns the index of a timer (-1 if the id is unknown).
+    qint32 indexOf(quint32 id){return m_idToIndex.value(id, -1);}
+
+    ///Number of slots in level 0.
+    static const quint32 LEVEL0_SIZE = 256;
+
+    ///Number of slots in level 1 to 3.
+    static const quint32 LEVEL_N_SIZE = 64;
+
+    ///Slot marker for timers which have expired but have not been called yet.
+    static const qint32 SLOT_EXPIRED = -2;
+
+    ///All timers.
+    QVector<TimerWheelEntry> m_timers;
+
+    ///Indexes of unused entries in m_timers.
+    QVector<qint32> m_freeIndexes;
+
+    ///Maps a timer id to its index in m_timers.
+    QHash<quint32, qint32> m_idToIndex;
+
+    ///The first timer of each slot (-1 if the slot is empty).
+    QVector<qint32> m_slotHeads;
+
+    ///Ids of the expired timers (ready list, the callbacks of these timers are called by driverTimerSlot).
+    QVector<quint32> m_expiredTimers;
+
+    ///The next timer id.
+    quint32 m_nextId;
+
+    ///The last processed tick.
+    quint64 m_currentTick;
+
+    ///The tick duration.
+    qint64 m_resolutionNs;
+
+    ///Number of running timers.
+    quint32 m_activeCount;
+
+    ///Number of running timers in level 0.
+    quint32 m_level0Count;
+
+    ///Number of skipped periods.
+    quint32 m_missedPeriodCount;
+
+    ///True while the expired timers are processed.
+    bool m_isProcessing;
+
+    ///True if the script is paused.
+    bool m_isPaused;
+
+    ///The time base of the wheel.
+    QElapsedTimer m_elapsedTimer;
+
+    ///The timer which drives the wheel.
+    QTimer m_driverTimer;
+
+    ///The tick for which m_driverTimer has been started.
+    quint64 m_driverTick;
+};
+
+#endif // SCRIPTTIMERWHEEL_H
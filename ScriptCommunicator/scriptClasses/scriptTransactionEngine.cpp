@@ -0,0 +1,627 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "scriptTransactionEngine.h"
+#include "scriptSlots.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ * @param interfaceThread
+ *      The main interface thread (sends the requests and delivers the responses).
+ * @param scriptWindow
+ *      The script window (shows the statistics dialog).
+ */
+ScriptTransactionEngine::ScriptTransactionEngine(QObject *parent, MainInterfaceThread* interfaceThread, ScriptSlots* scriptWindow) :
+    QObject(parent), m_mainInterfaceThread(interfaceThread), m_sendId(MainInterfaceThread::getNextSendEngineId()), m_nextId(1),
+    m_maxOutstandingRequests(1), m_frameMode(false), m_queuedRequests(), m_sendingRequests(), m_outstandingRequests(),
+    m_receivedData(), m_receivedChunks(), m_statistics(), m_types(), m_timeoutTimer(), m_elapsedTimer()
+{
+    m_elapsedTimer.start();
+
+    connect(this, SIGNAL(sendDataSignal(QByteArray,uint)), m_mainInterfaceThread, SLOT(sendDataSlot(QByteArray,uint)), Qt::QueuedConnection);
+
+    //The times are taken directly in the main interface thread (independent of the load of the script thread).
+    connect(m_mainInterfaceThread, SIGNAL(sendingFinishedSignal(bool,uint)), this, SLOT(mainInterfaceSendingFinishedSlot(bool,uint)), Qt::DirectConnection);
+    connect(m_mainInterfaceThread, SIGNAL(dataReceivedSignal(QByteArray)), this, SLOT(mainInterfaceDataReceivedSlot(QByteArray)), Qt::DirectConnection);
+    connect(this, SIGNAL(sendingFinishedWithTimeSignal(bool,qint64)), this, SLOT(sendingFinishedWithTimeSlot(bool,qint64)), Qt::QueuedConnection);
+    connect(this, SIGNAL(dataReceivedWithTimeSignal(QByteArray,qint64)), this, SLOT(dataReceivedWithTimeSlot(QByteArray,qint64)), Qt::QueuedConnection);
+
+    connect(this, SIGNAL(showStatisticsDialogSignal(QString,QVariantList)), scriptWindow, SLOT(showTransactionStatisticsSlot(QString,QVariantList)), Qt::QueuedConnection);
+
+    connect(&m_timeoutTimer, SIGNAL(timeout()), this, SLOT(timeoutTimerSlot()));
+}
+
+/**
+ * Is called (direct connection, main interface thread) if the main interface has received data.
+ * @param data
+ *      The received data.
+ */
+void ScriptTransactionEngine::mainInterfaceDataReceivedSlot(QByteArray data)
+{
+    emit dataReceivedWithTimeSignal(data, m_elapsedTimer.nsecsElapsed());
+}
+
+/**
+ * Is called (direct connection, main interface thread) if the main interface has sent data.
+ * @param success
+ *      True on success.
+ * @param id
+ *      The send id.
+ */
+void ScriptTransactionEngine::mainInterfaceSendingFinishedSlot(bool success, uint id)
+{
+    if(id == m_sendId)
+    {
+        emit sendingFinishedWithTimeSignal(success, m_elapsedTimer.nsecsElapsed());
+    }
+}
+
+/**
+ * Returns the statistics of a command type (creates the statistics if necessary).
+ * @param type
+ *      The command type.
+ * @return
+ *      The statistics.
+ */
+TransactionStatistics& ScriptTransactionEngine::statistics(QString type)
+{
+    if(!m_statistics.contains(type))
+    {
+        TransactionStatistics statistics;
+        statistics.requests = 0;
+        statistics.responses = 0;
+        statistics.timeouts = 0;
+        statistics.sendErrors = 0;
+        statistics.minNs = 0;
+        statistics.maxNs = 0;
+        statistics.sumNs = 0;
+        statistics.nextSample = 0;
+        m_statistics[type] = statistics;
+        m_types.append(type);
+    }
+    return m_statistics[type];
+}
+
+/**
+ * Creates a transaction and sends it (or queues it).
+ * @param transaction
+ *      The transaction (the match parameters must be set).
+ * @param request
+ *      The request data.
+ * @param timeoutMs
+ *      The timeout (ms).
+ * @return
+ *      The transaction id.
+ */
+quint32 ScriptTransactionEngine::addTransaction(Transaction& transaction, QVector<unsigned char> request, quint32 timeoutMs)
+{
+    transaction.id = m_nextId++;
+    if(m_nextId == 0)
+    {//0 is not a valid id.
+        m_nextId = 1;
+    }
+    transaction.request = QByteArray((const char*)request.constData(), request.size());
+    transaction.timeoutNs = (qint64)timeoutMs * 1000000;
+    transaction.sendStartTimeNs = 0;
+    transaction.sendTimeNs = 0;
+    transaction.isCanceled = false;
+
+    m_queuedRequests.enqueue(transaction);
+    sendQueuedRequests();
+    return transaction.id;
+}
+
+/**
+ * Sends a request. The response must contain responsePattern.
+ * @param type
+ *      The command type (statistics key).
+ * @param request
+ *      The request data.
+ * @param responsePattern
+ *      The response pattern.
+ * @param timeoutMs
+ *      The timeout (ms).
+ * @return
+ *      The transaction id.
+ */
+quint32 ScriptTransactionEngine::sendRequest(QString type, QVector<unsigned char> request, QVector<unsigned char> responsePattern, quint32 timeoutMs)
+{
+    Transaction transaction;
+    transaction.type = type;
+    transaction.matchType = TRANSACTION_MATCH_PATTERN;
+    transaction.pattern = QByteArray((const char*)responsePattern.constData(), responsePattern.size());
+    transaction.fieldOffset = 0;
+    return addTransaction(transaction, request, timeoutMs);
+}
+
+/**
+ * Sends a request. The response (latin1 string) must match responseRegExp.
+ * @param type
+ *      The command type (statistics key).
+ * @param request
+ *      The request data.
+ * @param responseRegExp
+ *      The regular expression.
+ * @param timeoutMs
+ *      The timeout (ms).
+ * @return
+ *      The transaction id (0 if the regular expression is invalid).
+ */
+quint32 ScriptTransactionEngine::sendRequestRegExp(QString type, QVector<unsigned char> request, QString responseRegExp, quint32 timeoutMs)
+{
+    Transaction transaction;
+    transaction.type = type;
+    transaction.matchType = TRANSACTION_MATCH_REGEXP;
+    transaction.regExp = QRegularExpression(responseRegExp);
+    transaction.fieldOffset = 0;
+
+    if(!transaction.regExp.isValid())
+    {
+        return 0;
+    }
+    transaction.regExp.optimize();
+    return addTransaction(transaction, request, timeoutMs);
+}
+
+/**
+ * Sends a request. The response must contain fieldValue at fieldOffset.
+ * @param type
+ *      The command type (statistics key).
+ * @param request
+ *      The request data.
+ * @param fieldOffset
+ *      The field offset.
+ * @param fieldValue
+ *      The field value.
+ * @param timeoutMs
+ *      The timeout (ms).
+ * @return
+ *      The transaction id.
+ */
+quint32 ScriptTransactionEngine::sendRequestField(QString type, QVector<unsigned char> request, quint32 fieldOffset,
+                                                  QVector<unsigned char> fieldValue, quint32 timeoutMs)
+{
+    Transaction transaction;
+    transaction.type = type;
+    transaction.matchType = TRANSACTION_MATCH_FIELD;
+    transaction.pattern = QByteArray((const char*)fieldValue.constData(), fieldValue.size());
+    transaction.fieldOffset = fieldOffset;
+    return addTransaction(transaction, request, timeoutMs);
+}
+
+/**
+ * Sends queued requests until m_maxOutstandingRequests requests are outstanding.
+ */
+void ScriptTransactionEngine::sendQueuedRequests(void)
+{
+    while(!m_queuedRequests.isEmpty() && (getOutstandingRequestCount() < m_maxOutstandingRequests))
+    {
+        Transaction transaction = m_queuedRequests.dequeue();
+        if(m_outstandingRequests.isEmpty() && m_sendingRequests.isEmpty() && !m_frameMode)
+        {//The received data which is not a response to an outstanding request is discarded
+         //(before the request is sent, a fast response must not be discarded).
+            clearReceivedData();
+        }
+        statistics(transaction.type).requests++;
+        transaction.sendStartTimeNs = m_elapsedTimer.nsecsElapsed();
+        m_sendingRequests.enqueue(transaction);
+        emit sendDataSignal(transaction.request, m_sendId);
+    }
+}
+
+/**
+ * Is called if the main interface has sent a request.
+ * @param success
+ *      True on success.
+ * @param timeNs
+ *      The send time (ns).
+ */
+void ScriptTransactionEngine::sendingFinishedWithTimeSlot(bool success, qint64 timeNs)
+{
+    if(m_sendingRequests.isEmpty())
+    {
+        return;
+    }
+
+    Transaction transaction = m_sendingRequests.dequeue();
+    if(!transaction.isCanceled)
+    {
+        if(success)
+        {
+            transaction.sendTimeNs = timeNs;
+            m_outstandingRequests.append(transaction);
+            if(!m_timeoutTimer.isActive())
+            {
+                m_timeoutTimer.start(TIMEOUT_CHECK_INTERVAL);
+            }
+
+            if(!m_frameMode && !m_receivedData.isEmpty())
+            {//The response may have been received before the main interface has reported the end of the sending.
+                matchReceivedData();
+            }
+        }
+        else
+        {
+            statistics(transaction.type).sendErrors++;
+            emit requestFailedSignal(transaction.id, transaction.type, "send error");
+        }
+    }
+    sendQueuedRequests();
+}
+
+/**
+ * Returns the end index of the response of a transaction in data.
+ * @param transaction
+ *      The transaction.
+ * @param data
+ *      The received data (stream mode) or one frame (frame mode).
+ * @return
+ *      The end index of the response (-1 if the response does not match).
+ */
+int ScriptTransactionEngine::matchResponse(const Transaction& transaction, const QByteArray& data)
+{
+    int endIndex = -1;
+
+    if(transaction.matchType == TRANSACTION_MATCH_PATTERN)
+    {
+        int index = data.indexOf(transaction.pattern);
+        if(index >= 0)
+        {
+            endIndex = index + transaction.pattern.size();
+        }
+    }
+    else if(transaction.matchType == TRANSACTION_MATCH_REGEXP)
+    {
+        QRegularExpressionMatch match = transaction.regExp.match(QString::fromLatin1(data));
+        if(match.hasMatch())
+        {
+            endIndex = match.capturedEnd();
+        }
+    }
+    else
+    {
+        int fieldEnd = (int)transaction.fieldOffset + transaction.pattern.size();
+        if((data.size() >= fieldEnd) && (data.mid(transaction.fieldOffset, transaction.pattern.size()) == transaction.pattern))
+        {
+            endIndex = fieldEnd;
+        }
+    }
+
+    return endIndex;
+}
+
+/**
+ * Finishes an outstanding transaction with a response.
+ * @param index
+ *      The index of the transaction in m_outstandingRequests.
+ * @param response
+ *      The response.
+ * @param timeNs
+ *      The receive time (ns).
+ */
+void ScriptTransactionEngine::finishTransaction(int index, const QByteArray& response, qint64 timeNs)
+{
+    Transaction transaction = m_outstandingRequests.takeAt(index);
+    qint64 roundTripTimeNs = timeNs - transaction.sendTimeNs;
+    if(roundTripTimeNs < 0)
+    {//The response has been received before the main interface has finished the sending
+     //(e.g. during waitForBytesWritten), the round trip time starts with the start of the sending.
+        roundTripTimeNs = qMax(timeNs - transaction.sendStartTimeNs, (qint64)0);
+    }
+    TransactionStatistics& typeStatistics = statistics(transaction.type);
+
+    if((typeStatistics.responses == 0) || (roundTripTimeNs < typeStatistics.minNs))
+    {
+        typeStatistics.minNs = roundTripTimeNs;
+    }
+    if((typeStatistics.responses == 0) || (roundTripTimeNs > typeStatistics.maxNs))
+    {
+        typeStatistics.maxNs = roundTripTimeNs;
+    }
+    typeStatistics.responses++;
+    typeStatistics.sumNs += roundTripTimeNs;
+
+    if(typeStatistics.samples.size() < MAX_LATENCY_SAMPLES)
+    {
+        typeStatistics.samples.append(roundTripTimeNs);
+    }
+    else
+    {
+        typeStatistics.samples[typeStatistics.nextSample] = roundTripTimeNs;
+        typeStatistics.nextSample = (typeStatistics.nextSample + 1) % MAX_LATENCY_SAMPLES;
+    }
+
+    QVector<unsigned char> responseVector(response.size());
+    memcpy(responseVector.data(), response.constData(), response.size());
+    emit responseReceivedSignal(transaction.id, transaction.type, responseVector, (double)roundTripTimeNs / 1000000.0);
+}
+
+/**
+ * Is called if the main interface has received data (stream mode).
+ * @param data
+ *      The received data.
+ * @param timeNs
+ *      The receive time (ns).
+ */
+void ScriptTransactionEngine::dataReceivedWithTimeSlot(QByteArray data, qint64 timeNs)
+{
+    if(m_frameMode || (m_outstandingRequests.isEmpty() && m_sendingRequests.isEmpty()))
+    {
+        return;
+    }
+
+    m_receivedData.append(data);
+    TransactionReceivedChunk chunk;
+    chunk.endIndex = m_receivedData.size();
+    chunk.timeNs = timeNs;
+    m_receivedChunks.append(chunk);
+
+    matchReceivedData();
+    sendQueuedRequests();
+}
+
+/**
+ * Matches the unprocessed received data (stream mode) against the outstanding requests. If the data
+ * contains the responses of several outstanding requests, the response which ends first is processed first.
+ * The receive time of a response is the receive time of the chunk which has completed the response.
+ */
+void ScriptTransactionEngine::matchReceivedData(void)
+{
+    bool responseFound = true;
+    while(responseFound && !m_outstandingRequests.isEmpty())
+    {
+        int bestIndex = -1;
+        int bestEnd = -1;
+        for(int i = 0; i < m_outstandingRequests.size(); i++)
+        {
+            int endIndex = matchResponse(m_outstandingRequests[i], m_receivedData);
+            if((endIndex >= 0) && ((bestEnd < 0) || (endIndex < bestEnd)))
+            {
+                bestIndex = i;
+                bestEnd = endIndex;
+            }
+        }
+
+        responseFound = (bestIndex >= 0);
+        if(responseFound)
+        {
+            qint64 timeNs = m_receivedChunks.last().timeNs;
+            for(const auto& el : m_receivedChunks)
+            {
+                if(el.endIndex >= bestEnd)
+                {
+                    timeNs = el.timeNs;
+                    break;
+                }
+            }
+
+            QByteArray response = m_receivedData.left(bestEnd);
+            removeReceivedData(bestEnd);
+            finishTransaction(bestIndex, response, timeNs);
+        }
+    }
+
+    if(m_receivedData.size() > MAX_RECEIVED_DATA_SIZE)
+    {
+        removeReceivedData(m_receivedData.size() - MAX_RECEIVED_DATA_SIZE);
+    }
+}
+
+/**
+ * Removes bytes from the beginning of the unprocessed received data (stream mode).
+ * @param size
+ *      The number of bytes.
+ */
+void ScriptTransactionEngine::removeReceivedData(int size)
+{
+    m_receivedData.remove(0, size);
+
+    int removedChunks = 0;
+    while((removedChunks < m_receivedChunks.size()) && (m_receivedChunks[removedChunks].endIndex <= size))
+    {
+        removedChunks++;
+    }
+    m_receivedChunks.remove(0, removedChunks);
+
+    for(auto& el : m_receivedChunks)
+    {
+        el.endIndex -= size;
+    }
+}
+
+/**
+ * Clears the unprocessed received data (stream mode).
+ */
+void ScriptTransactionEngine::clearReceivedData(void)
+{
+    m_receivedData.clear();
+    m_receivedChunks.clear();
+}
+
+/**
+ * If enabled, the data received by the main interface is ignored and the responses must be passed
+ * frame by frame with processFrame/processFrames.
+ * @param enable
+ *      True for frame mode.
+ */
+void ScriptTransactionEngine::setFrameMode(bool enable)
+{
+    m_frameMode = enable;
+    clearReceivedData();
+}
+
+/**
+ * Matches one received frame (frame mode). The frame is the response of the oldest
+ * outstanding request which matches.
+ * @param frame
+ *      The frame.
+ */
+void ScriptTransactionEngine::processFrame(QVector<unsigned char> frame)
+{
+    if(m_frameMode)
+    {
+        qint64 timeNs = m_elapsedTimer.nsecsElapsed();
+        QByteArray data((const char*)frame.constData(), frame.size());
+
+        for(int i = 0; i < m_outstandingRequests.size(); i++)
+        {
+            if(matchResponse(m_outstandingRequests[i], data) >= 0)
+            {
+                finishTransaction(i, data, timeNs);
+                sendQueuedRequests();
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Matches received frames (frame mode).
+ * @param frames
+ *      The frames.
+ */
+void ScriptTransactionEngine::processFrames(QVector<QVector<unsigned char>> frames)
+{
+    for(auto el : frames)
+    {
+        processFrame(el);
+    }
+}
+
+/**
+ * Checks the timeouts of the outstanding requests.
+ */
+void ScriptTransactionEngine::timeoutTimerSlot(void)
+{
+    qint64 nowNs = m_elapsedTimer.nsecsElapsed();
+
+    for(int i = 0; i < m_outstandingRequests.size();)
+    {
+        const Transaction& transaction = m_outstandingRequests[i];
+        if((transaction.timeoutNs > 0) && ((nowNs - transaction.sendTimeNs) > transaction.timeoutNs))
+        {
+            Transaction timedOut = m_outstandingRequests.takeAt(i);
+            statistics(timedOut.type).timeouts++;
+            emit requestFailedSignal(timedOut.id, timedOut.type, "timeout");
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    if(m_outstandingRequests.isEmpty())
+    {
+        m_timeoutTimer.stop();
+    }
+    sendQueuedRequests();
+}
+
+/**
+ * Cancels all queued and outstanding requests (requestFailedSignal is not emitted).
+ */
+void ScriptTransactionEngine::cancelAll(void)
+{
+    m_queuedRequests.clear();
+    m_outstandingRequests.clear();
+    clearReceivedData();
+    m_timeoutTimer.stop();
+
+    //The main interface still reports the end of the sending of these requests.
+    for(auto& el : m_sendingRequests)
+    {
+        el.isCanceled = true;
+    }
+}
+
+/**
+ * Returns a percentile (nearest rank) of sorted samples.
+ * @param sortedSamples
+ *      The sorted samples (ns).
+ * @param percent
+ *      The percentile (0-100).
+ * @return
+ *      The percentile (ns).
+ */
+qint64 ScriptTransactionEngine::percentile(const QVector<qint64>& sortedSamples, double percent)
+{
+    if(sortedSamples.isEmpty())
+    {
+        return 0;
+    }
+
+    int rank = (int)std::ceil((percent / 100.0) * (double)sortedSamples.size());
+    if(rank < 1)
+    {
+        rank = 1;
+    }
+    return sortedSamples[rank - 1];
+}
+
+/**
+ * Returns the statistics of all command types.
+ * @return
+ *      One object per command type (type, requests, responses, timeouts, sendErrors, minMs, meanMs, maxMs,
+ *      p50Ms, p95Ms and p99Ms).
+ */
+QVariantList ScriptTransactionEngine::getStatistics(void)
+{
+    QVariantList result;
+
+    for(auto type : m_types)
+    {
+        const TransactionStatistics& typeStatistics = m_statistics[type];
+        QVector<qint64> sortedSamples = typeStatistics.samples;
+        std::sort(sortedSamples.begin(), sortedSamples.end());
+
+        QVariantMap map;
+        map["type"] = type;
+        map["requests"] = (double)typeStatistics.requests;
+        map["responses"] = (double)typeStatistics.responses;
+        map["timeouts"] = (double)typeStatistics.timeouts;
+        map["sendErrors"] = (double)typeStatistics.sendErrors;
+        map["minMs"] = (double)typeStatistics.minNs / 1000000.0;
+        map["meanMs"] = (typeStatistics.responses > 0) ? ((double)typeStatistics.sumNs / (double)typeStatistics.responses) / 1000000.0 : 0.0;
+        map["maxMs"] = (double)typeStatistics.maxNs / 1000000.0;
+        map["p50Ms"] = (double)percentile(sortedSamples, 50.0) / 1000000.0;
+        map["p95Ms"] = (double)percentile(sortedSamples, 95.0) / 1000000.0;
+        map["p99Ms"] = (double)percentile(sortedSamples, 99.0) / 1000000.0;
+        result.append(map);
+    }
+    return result;
+}
+
+/**
+ * Shows the statistics in a dialog (the dialog is updated if it is already shown).
+ * @param title
+ *      The title of the dialog.
+ */
+void ScriptTransactionEngine::showStatisticsDialog(QString title)
+{
+    emit showStatisticsDialogSignal(title, getStatistics());
+}
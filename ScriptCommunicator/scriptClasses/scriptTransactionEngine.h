@@ -0,0 +1,314 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SCRIPTTRANSACTIONENGINE_H
+#define SCRIPTTRANSACTIONENGINE_H
+
+#include <QObject>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QQueue>
+#include <QTimer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QVariant>
+#include <mainInterfaceThread.h>
+
+class ScriptSlots;
+
+///The match type of a transaction.
+typedef enum
+{
+    TRANSACTION_MATCH_PATTERN = 0,
+    TRANSACTION_MATCH_REGEXP,
+    TRANSACTION_MATCH_FIELD
+}TransactionMatchType;
+
+///One request/response transaction.
+typedef struct
+{
+    ///The transaction id.
+    quint32 id;
+
+    ///The command type (statistics key).
+    QString type;
+
+    ///The request data.
+    QByteArray request;
+
+    ///The match type.
+    TransactionMatchType matchType;
+
+    ///The response pattern (TRANSACTION_MATCH_PATTERN) or the field value (TRANSACTION_MATCH_FIELD).
+    QByteArray pattern;
+
+    ///The response regular expression (TRANSACTION_MATCH_REGEXP).
+    QRegularExpression regExp;
+
+    ///The field offset (TRANSACTION_MATCH_FIELD).
+    quint32 fieldOffset;
+
+    ///The timeout (ns).
+    qint64 timeoutNs;
+
+    ///The time at which the request has been passed to the main interface (ns).
+    qint64 sendStartTimeNs;
+
+    ///The time at which the main interface has sent the request (ns).
+    qint64 sendTimeNs;
+
+    ///True if the transaction has been canceled while the main interface was sending it.
+    bool isCanceled;
+}Transaction;
+
+///A chunk of the unprocessed received data (stream mode).
+typedef struct
+{
+    ///The end index of the chunk in the unprocessed received data.
+    int endIndex;
+
+    ///The receive time of the chunk (ns).
+    qint64 timeNs;
+}TransactionReceivedChunk;
+
+///The statistics of one command type.
+typedef struct
+{
+    ///The number of sent requests.
+    quint64 requests;
+
+    ///The number of received responses.
+    quint64 responses;
+
+    ///The number of timeouts.
+    quint64 timeouts;
+
+    ///The number of requests which could not be sent.
+    quint64 sendErrors;
+
+    ///The min. round trip time (ns).
+    qint64 minNs;
+
+    ///The max. round trip time (ns).
+    qint64 maxNs;
+
+    ///The sum of all round trip times (ns).
+    qint64 sumNs;
+
+    ///The last round trip times (max. MAX_LATENCY_SAMPLES, used for the percentiles).
+    QVector<qint64> samples;
+
+    ///The index of the next sample in samples (if samples is full).
+    int nextSample;
+}TransactionStatistics;
+
+///Request/response engine for scripts. A request is sent with the main interface and the response
+///is matched (byte pattern, regular expression or frame field) with a timeout. Several requests
+///can be outstanding at the same time (pipelining). The round trip times are collected per
+///command type (min, mean, max, p50, p95, p99).
+///The send and receive times are taken in the main interface thread.
+class ScriptTransactionEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    ScriptTransactionEngine(QObject *parent, MainInterfaceThread* interfaceThread, ScriptSlots* scriptWindow);
+
+    ///Registers all (for this class) necessary meta types.
+    static void registerScriptMetaTypes(void)
+    {
+        qRegisterMetaType<ScriptTransactionEngine*>("ScriptTransactionEngine*");
+    }
+
+    ///Sends a request. The response must contain responsePattern. Returns the transaction id.
+    Q_INVOKABLE quint32 sendRequest(QString type, QVector<unsigned char> request, QVector<unsigned char> responsePattern, quint32 timeoutMs);
+
+    ///Sends a request. The response (latin1 string) must match responseRegExp.
+    ///Returns the transaction id (0 if the regular expression is invalid).
+    Q_INVOKABLE quint32 sendRequestRegExp(QString type, QVector<unsigned char> request, QString responseRegExp, quint32 timeoutMs);
+
+    ///Sends a request. The response must contain fieldValue at fieldOffset (relative to the start of the
+    ///frame in frame mode, else relative to the first unprocessed received byte). Returns the transaction id.
+    Q_INVOKABLE quint32 sendRequestField(QString type, QVector<unsigned char> request, quint32 fieldOffset,
+                                         QVector<unsigned char> fieldValue, quint32 timeoutMs);
+
+    ///Sets the max. number of outstanding requests (default 1). Further requests are queued.
+    Q_INVOKABLE void setMaxOutstandingRequests(quint32 count){m_maxOutstandingRequests = (count == 0) ? 1 : count; sendQueuedRequests();}
+
+    ///Returns the number of sent requests which wait for a response.
+    Q_INVOKABLE quint32 getOutstandingRequestCount(void){return m_sendingRequests.size() + m_outstandingRequests.size();}
+
+    ///Returns the number of queued (not sent) requests.
+    Q_INVOKABLE quint32 getQueuedRequestCount(void){return m_queuedRequests.size();}
+
+    ///If enabled, the data received by the main interface is ignored and the responses must be passed
+    ///frame by frame with processFrame/processFrames (e.g. from a ScriptProtocolFramer).
+    Q_INVOKABLE void setFrameMode(bool enable);
+
+    ///Matches one received frame (frame mode).
+    Q_INVOKABLE void processFrame(QVector<unsigned char> frame);
+
+    ///Matches received frames (frame mode, e.g. connected to ScriptProtocolFramer::framesReceivedSignal).
+    Q_INVOKABLE void processFrames(QVector<QVector<unsigned char>> frames);
+
+    ///Cancels all queued and outstanding requests (requestFailedSignal is not emitted).
+    Q_INVOKABLE void cancelAll(void);
+
+    ///Returns the statistics of all command types. Each element is an object with the properties
+    ///type, requests, responses, timeouts, sendErrors, minMs, meanMs, maxMs, p50Ms, p95Ms and p99Ms.
+    Q_INVOKABLE QVariantList getStatistics(void);
+
+    ///Resets the statistics.
+    Q_INVOKABLE void resetStatistics(void){m_statistics.clear(); m_types.clear();}
+
+    ///Shows the statistics in a dialog (the dialog is updated if it is already shown).
+    Q_INVOKABLE void showStatisticsDialog(QString title="transaction statistics");
+
+    ///The max. number of round trip times which are stored per command type (for the percentiles).
+    static const int MAX_LATENCY_SAMPLES = 10000;
+
+    ///The max. number of unprocessed received bytes (stream mode).
+    static const int MAX_RECEIVED_DATA_SIZE = 65536;
+
+    ///The interval of the timeout check (ms).
+    static const int TIMEOUT_CHECK_INTERVAL = 5;
+
+signals:
+    ///Is emitted if the response of a request has been received.
+    ///Scripts can connect a function to this signal.
+    void responseReceivedSignal(quint32 id, QString type, QVector<unsigned char> response, double roundTripTimeMs);
+
+    ///Is emitted if a request has failed (reason: 'timeout' or 'send error').
+    ///Scripts can connect a function to this signal.
+    void requestFailedSignal(quint32 id, QString type, QString reason);
+
+    ///Is emitted for every request which shall be sent.
+    ///This signal must not be used from script.
+    void sendDataSignal(const QByteArray data, uint id);
+
+    ///Is emitted (in the main interface thread) if the main interface has received data.
+    ///This signal must not be used from script.
+    void dataReceivedWithTimeSignal(QByteArray data, qint64 timeNs);
+
+    ///Is emitted (in the main interface thread) if the main interface has sent a request.
+    ///This signal must not be used from script.
+    void sendingFinishedWithTimeSignal(bool success, qint64 timeNs);
+
+    ///Is emitted in showStatisticsDialog.
+    ///This signal must not be used from script.
+    void showStatisticsDialogSignal(QString title, QVariantList statistics);
+
+private slots:
+
+    ///Is called (direct connection, main interface thread) if the main interface has received data.
+    void mainInterfaceDataReceivedSlot(QByteArray data);
+
+    ///Is called (direct connection, main interface thread) if the main interface has sent data.
+    void mainInterfaceSendingFinishedSlot(bool success, uint id);
+
+    ///Matches the received data (stream mode).
+    void dataReceivedWithTimeSlot(QByteArray data, qint64 timeNs);
+
+    ///Is called if the main interface has sent a request.
+    void sendingFinishedWithTimeSlot(bool success, qint64 timeNs);
+
+    ///Checks the timeouts of the outstanding requests.
+    void timeoutTimerSlot(void);
+
+private:
+
+    ///Creates a transaction and sends it (or queues it).
+    quint32 addTransaction(Transaction& transaction, QVector<unsigned char> request, quint32 timeoutMs);
+
+    ///Sends queued requests until m_maxOutstandingRequests requests are outstanding.
+    void sendQueuedRequests(void);
+
+    ///Returns the end index of the response of a transaction in data (-1 if the response does not match).
+    ///In frame mode the whole frame must match.
+    static int matchResponse(const Transaction& transaction, const QByteArray& data);
+
+    ///Matches the unprocessed received data (stream mode) against the outstanding requests.
+    void matchReceivedData(void);
+
+    ///Removes size bytes from the beginning of the unprocessed received data (stream mode).
+    void removeReceivedData(int size);
+
+    ///Clears the unprocessed received data (stream mode).
+    void clearReceivedData(void);
+
+    ///Finishes an outstanding transaction with a response.
+    void finishTransaction(int index, const QByteArray& response, qint64 timeNs);
+
+    ///Returns the statistics of a command type (creates the statistics if necessary).
+    TransactionStatistics& statistics(QString type);
+
+    ///Returns a percentile (nearest rank) of sorted samples (ns).
+    static qint64 percentile(const QVector<qint64>& sortedSamples, double percent);
+
+    ///The main interface thread.
+    MainInterfaceThread* m_mainInterfaceThread;
+
+    ///The send id of the engine.
+    quint32 m_sendId;
+
+    ///The next transaction id.
+    quint32 m_nextId;
+
+    ///The max. number of outstanding requests.
+    quint32 m_maxOutstandingRequests;
+
+    ///True if the frame mode is enabled.
+    bool m_frameMode;
+
+    ///The requests which have not been sent yet.
+    QQueue<Transaction> m_queuedRequests;
+
+    ///The requests which have been passed to the main interface (in send order).
+    QQueue<Transaction> m_sendingRequests;
+
+    ///The requests which have been sent and wait for a response (in send order).
+    QList<Transaction> m_outstandingRequests;
+
+    ///The unprocessed received data (stream mode).
+    QByteArray m_receivedData;
+
+    ///The chunks of m_receivedData (receive time of each received block).
+    QVector<TransactionReceivedChunk> m_receivedChunks;
+
+    ///The statistics of all command types.
+    QHash<QString, TransactionStatistics> m_statistics;
+
+    ///The command types in the order of their first use.
+    QStringList m_types;
+
+    ///Checks the timeouts.
+    QTimer m_timeoutTimer;
+
+    ///The time base (used in the main interface thread and in the script thread).
+    QElapsedTimer m_elapsedTimer;
+};
+
+#endif // SCRIPTTRANSACTIONENGINE_H
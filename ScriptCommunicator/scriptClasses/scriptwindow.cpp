@@ -132,7 +132,7 @@ Qt::DropActions DragDropTableWidget::supportedDropActions () const
  */
 ScriptWindow::ScriptWindow(MainWindow* mainWindow, MainInterfaceThread *thread, QStringList scripts) : ScriptSlots(),
     m_userInterface(new Ui::ScriptWindow), m_mainWindow(mainWindow), m_sendIdCounter(MainInterfaceThread::SEND_ID_SCRIPTS_START), m_mainInterfaceThread(thread),
-    m_commandLineScripts(scripts), m_createSceFileDialog(0)
+    m_commandLineScripts(scripts), m_createSceFileDialog(0), m_profilerDisplayTimer()
 {
     m_userInterface->setupUi(this);
 
@@ -168,7 +168,10 @@ ScriptWindow::ScriptWindow(MainWindow* mainWindow, MainInterfaceThread *thread,
     connect(m_userInterface->tableWidget, SIGNAL(dropEventSignal(int,int,QStringList)), this, SLOT(tableDropEventSlot(int,int,QStringList)));
     connect(m_userInterface->tableWidget, SIGNAL(itemSelectionChanged()), this, SLOT(itemSelectionChangedSlot()));
 
-    m_userInterface->tableWidget->setHorizontalHeaderLabels({"name", "status", "worker script path", "user interface"});
+    m_userInterface->tableWidget->setHorizontalHeaderLabels({"name", "status", "load", "worker script path", "user interface"});
+
+    connect(&m_profilerDisplayTimer, SIGNAL(timeout()), this, SLOT(updateScriptLoadColumnSlot()));
+    m_profilerDisplayTimer.start(ScriptProfiler::UPDATE_INTERVAL);
     m_currentScriptConfigFileString = tableToString();
 
     if(!m_commandLineScripts.isEmpty())
@@ -384,10 +387,11 @@ void ScriptWindow::cellEnteredSlot(int row, int column)
 void ScriptWindow::resizeTableColumnsSlot(void)
 {
     m_userInterface->tableWidget->resizeColumnToContents(COLUMN_SCRIPT_THREAD_STATUS);
-
+    m_userInterface->tableWidget->resizeColumnToContents(COLUMN_SCRIPT_LOAD);
 
     m_userInterface->tableWidget->setColumnWidth(COLUMN_UI_PATH, m_userInterface->tableWidget->width() -
                                                  (m_userInterface->tableWidget->columnWidth(COLUMN_NAME) + m_userInterface->tableWidget->columnWidth(COLUMN_SCRIPT_THREAD_STATUS)
+                                                  + m_userInterface->tableWidget->columnWidth(COLUMN_SCRIPT_LOAD)
                                                   + m_userInterface->tableWidget->columnWidth(COLUMN_SCRIPT_PATH)
                                                   + 2 *m_userInterface->tableWidget->frameWidth()
                                                   + m_userInterface->tableWidget->verticalHeader()->width()
@@ -417,6 +421,10 @@ void ScriptWindow::createNewTableRow()
     item->setFlags(item->flags() ^ Qt::ItemIsEditable);
     m_userInterface->tableWidget->setItem(0, 3, item);
 
+    item = new QTableWidgetItem();
+    item->setFlags(item->flags() ^ Qt::ItemIsEditable);
+    m_userInterface->tableWidget->setItem(0, 4, item);
+
     QStringList list;
 
     for(int i = 0; i <  m_userInterface->tableWidget->rowCount(); i++)
@@ -479,7 +487,7 @@ void ScriptWindow::loadTableData(void)
                 if(width != 0) m_userInterface->tableWidget->setColumnWidth(1, width);
 
                 width = nodeItem.attributes().namedItem("width2").nodeValue().toUInt();
-                if(width != 0) m_userInterface->tableWidget->setColumnWidth(2, width);
+                if(width != 0) m_userInterface->tableWidget->setColumnWidth(COLUMN_SCRIPT_PATH, width);
 
                 QDomNodeList nodeList = docElem.elementsByTagName("script");
                 blockSignals(true);
@@ -983,7 +991,7 @@ QString ScriptWindow::tableToString(void)
         xmlWriter.writeStartElement("columnWidth");
         xmlWriter.writeAttribute("width0", QString("%1").arg(m_userInterface->tableWidget->columnWidth(0)));
         xmlWriter.writeAttribute("width1", QString("%1").arg(m_userInterface->tableWidget->columnWidth(1)));
-        xmlWriter.writeAttribute("width2", QString("%1").arg(m_userInterface->tableWidget->columnWidth(2)));
+        xmlWriter.writeAttribute("width2", QString("%1").arg(m_userInterface->tableWidget->columnWidth(COLUMN_SCRIPT_PATH)));
         xmlWriter.writeEndElement();//"columnWidth"
 
         for( int r = 0; r < m_userInterface->tableWidget->rowCount(); ++r )
@@ -1178,6 +1186,42 @@ QStringList ScriptWindow::getAllScriptNamesAndStates(void)
     return scripts;
 }
 
+/**
+ * Updates the script load column (profiling statistics of all running scripts).
+ * Is called periodically by m_profilerDisplayTimer.
+ */
+void ScriptWindow::updateScriptLoadColumnSlot(void)
+{
+    if(!isVisible())
+    {
+        return;
+    }
+
+    bool threadFound = false;
+    for (int32_t i = 0; i < m_userInterface->tableWidget->rowCount(); i++)
+    {
+        ScriptThread* thread = (ScriptThread*)m_userInterface->
+                tableWidget->item(i, COLUMN_SCRIPT_THREAD_POINTER)->data(USER_ROLE_SCRIPT_THREAD_IN_TABLE).toULongLong();
+        QTableWidgetItem* item = m_userInterface->tableWidget->item(i, COLUMN_SCRIPT_LOAD);
+
+        if((thread != 0) && (item != 0))
+        {
+            ScriptThreadStatistics statistics = thread->getProfiler()->getStatistics();
+
+            m_userInterface->tableWidget->blockSignals(true);
+            item->setText(ScriptProfiler::statisticsToShortString(statistics));
+            item->setToolTip(ScriptProfiler::statisticsToString(statistics, thread->getProfiler()->getHandlerStatistics()));
+            m_userInterface->tableWidget->blockSignals(false);
+            threadFound = true;
+        }
+    }
+
+    if(threadFound)
+    {
+        resizeTableColumnsSlot();
+    }
+}
+
 /**
  * Checks if ScriptCommunicatormust exit.
  */
@@ -1249,6 +1293,8 @@ void ScriptWindow::threadStateChangedSlot(ThreadSate state, ScriptThread* thread
                 if(threadIsInTable)
                 {
                     m_userInterface->tableWidget->item(row, COLUMN_SCRIPT_THREAD_POINTER)->setData(USER_ROLE_SCRIPT_THREAD_IN_TABLE, (quint64)0);
+                    m_userInterface->tableWidget->item(row, COLUMN_SCRIPT_LOAD)->setText("");
+                    m_userInterface->tableWidget->item(row, COLUMN_SCRIPT_LOAD)->setToolTip("");
                 }
 
                 delete thread;
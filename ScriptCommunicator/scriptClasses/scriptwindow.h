@@ -153,11 +153,14 @@ public:
     ///The script thread status column (in the script table)
     static const int COLUMN_SCRIPT_THREAD_STATUS = 1;
 
+    ///The script load column (profiling statistics, in the script table)
+    static const int COLUMN_SCRIPT_LOAD = 2;
+
     ///The script path column (in the script table)
-    static const int COLUMN_SCRIPT_PATH = 2;
+    static const int COLUMN_SCRIPT_PATH = 3;
 
     ///The ui file path column (in the script table)
-    static const int COLUMN_UI_PATH = 3;
+    static const int COLUMN_UI_PATH = 4;
 
     ///The column (in the script table) in which the script thread pointer a inserted.
     static const int COLUMN_SCRIPT_THREAD_POINTER = 1;
@@ -278,6 +281,9 @@ private slots:
     ///Slot function for the move down menu.
     void moveTableEntryDownSlot(void);
 
+    ///Updates the script load column (profiling statistics of all running scripts).
+    ///Is called periodically by m_profilerDisplayTimer.
+    void updateScriptLoadColumnSlot(void);
 
 private:
 
@@ -330,6 +336,9 @@ private:
     ///The create sce file dialog.
     CreateSceFile* m_createSceFileDialog;
 
+    ///Periodically updates the script load column.
+    QTimer m_profilerDisplayTimer;
+
 
 };
 
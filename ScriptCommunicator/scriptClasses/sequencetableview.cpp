@@ -281,6 +281,93 @@ void SequenceScriptThread::closeDebugger(void)
  *      The script wrapper. If 0 then the script wrapper will be create and written to this argument.
  */
 void SequenceScriptThread::executeScriptSlot(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper **scriptEngineWrapper)
+{
+    callSendDataFunction(sendScript, sendData, scriptEngineWrapper);
+    m_numberOfFinishedCalls.ref();
+    m_scriptFunctionIsFinished = true;
+}
+
+/**
+ * Executes a script up to count times (each call gets sendData) and appends the results to results.
+ * Stops at the first call which returns no data.
+ *
+ * @param sendScript
+ *  The script name.
+ * @param sendData
+ *      The send data.
+ * @param scriptEngineWrapper
+ *      The script wrapper. If 0 then the script wrapper will be create and written to this argument.
+ * @param count
+ *      The maximum number of script calls.
+ * @param results
+ *      The created payloads.
+ */
+void SequenceScriptThread::executeScriptBatchSlot(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper,
+                                                  quint32 count, QVector<QByteArray>* results)
+{
+    results->reserve(results->size() + count);
+    for(quint32 i = 0; i < count; i++)
+    {
+        QByteArray payload = *sendData;
+        callSendDataFunction(sendScript, &payload, scriptEngineWrapper);
+        m_numberOfFinishedCalls.ref();
+
+        if(payload.isEmpty())
+        {//The script has ended the sending.
+            break;
+        }
+        results->append(payload);
+    }
+
+    m_scriptFunctionIsFinished = true;
+}
+
+/**
+ * Converts the result of a send function into a byte array.
+ * A string is interpreted as binary string (each character is one byte), an array
+ * as byte array. All other values result in an empty byte array.
+ *
+ * @param result
+ *      The result of the send function.
+ * @param sendData
+ *      The created byte array.
+ */
+void SequenceScriptThread::scriptResultToByteArray(const QScriptValue& result, QByteArray* sendData)
+{
+    if(result.isString())
+    {
+        *sendData = result.toString().toLatin1();
+    }
+    else if(result.isArray())
+    {
+        quint32 length = result.property("length").toUInt32();
+        sendData->resize(length);
+        char* data = sendData->data();
+        for(quint32 i = 0; i < length; i++)
+        {
+            data[i] = (char)result.property(i).toUInt32();
+        }
+    }
+    else
+    {
+        sendData->clear();
+    }
+}
+
+/**
+ * Calls the send function of a script (loads the script if necessary).
+ * If the script contains the function sendDataBuffer, this function is used (the data is passed as
+ * binary string, which avoids the creation of one script value per byte), else the function sendData
+ * is called with a byte array.
+ *
+ * @param sendScript
+ *  The script name.
+ * @param sendData
+ *      The send data. (contains the modified data)
+ * @param scriptEngineWrapper
+ *      The script wrapper. If 0 then the script wrapper will be create and written to this argument.
+ */
+void SequenceScriptThread::callSendDataFunction(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper)
 {
     bool debugWindowHasBeenClosed = false;
 
@@ -301,40 +388,52 @@ void SequenceScriptThread::executeScriptSlot(QString* sendScript, QByteArray* se
         //Script has been loaded.
         if (*scriptEngineWrapper)
         {
+            QScriptEngine* scriptEngine = (*scriptEngineWrapper)->scriptEngine;
 
             if((*scriptEngineWrapper)->sendDataFunction == 0)
             {
-                (*scriptEngineWrapper)->sendDataFunction = new QScriptValue((*scriptEngineWrapper)->scriptEngine->evaluate("sendData"));
+                QScriptValue bufferFunction = scriptEngine->globalObject().property("sendDataBuffer");
+                if(bufferFunction.isFunction())
+                {
+                    (*scriptEngineWrapper)->sendDataFunction = new QScriptValue(bufferFunction);
+                    (*scriptEngineWrapper)->sendDataIsBufferFunction = true;
+                }
+                else
+                {
+                    (*scriptEngineWrapper)->sendDataFunction = new QScriptValue(scriptEngine->evaluate("sendData"));
+                }
             }
 
             if (!(*scriptEngineWrapper)->sendDataFunction->isError())
             {
-                QScriptValue scriptArray = (*scriptEngineWrapper)->scriptEngine->newArray(sendData->size());
-                for(int i = 0; i < sendData->size(); i++)
+                QScriptValue argument;
+                if((*scriptEngineWrapper)->sendDataIsBufferFunction)
                 {
-                    scriptArray.setProperty(i, QScriptValue((*scriptEngineWrapper)->scriptEngine, (unsigned char)(sendData->at(i))));
+                    argument = QScriptValue(scriptEngine, QString::fromLatin1(*sendData));
                 }
-
-                //call the sendData function
-                QScriptValue val = (*scriptEngineWrapper)->sendDataFunction->call(QScriptValue(), QScriptValueList() << scriptArray);
-                QList<QVariant> resultVariant = val.toVariant().toList();
-
-
-                sendData->clear();
-                for(auto el : resultVariant)
+                else
                 {
-                    sendData->append((char)el.toUInt());
-
+                    argument = scriptEngine->newArray(sendData->size());
+                    const char* data = sendData->constData();
+                    for(int i = 0; i < sendData->size(); i++)
+                    {
+                        argument.setProperty(i, QScriptValue(scriptEngine, (unsigned char)data[i]));
+                    }
                 }
+
+                //call the send function
+                QScriptValue val = (*scriptEngineWrapper)->sendDataFunction->call(QScriptValue(), QScriptValueList() << argument);
+                scriptResultToByteArray(val, sendData);
             }
             else
             {
                 sendData->clear();
             }
 
-            if((*scriptEngineWrapper)->scriptEngine->hasUncaughtException())
+            if(scriptEngine->hasUncaughtException())
             {
-                QScriptValue exception = (*scriptEngineWrapper)->scriptEngine->uncaughtException();
+                QScriptValue exception = scriptEngine->uncaughtException();
+                sendData->clear();
                 m_dialogIsShown = true;
                 QWidget *parent = (m_sendWindow->isVisible()) ? static_cast<QWidget *>(m_sendWindow) : static_cast<QWidget *>(m_mainWindow);
                 m_scriptFileObject->showExceptionInMessageBox(exception, *sendScript, SCRIPT_TYPE_SEQUENCE, parent);
@@ -352,8 +451,6 @@ void SequenceScriptThread::executeScriptSlot(QString* sendScript, QByteArray* se
     {
         sendData->clear();
     }
-
-    m_scriptFunctionIsFinished = true;
 }
 
 
@@ -374,6 +471,7 @@ void SequenceTableView::createThread(bool isSingle, bool debug)
     qRegisterMetaType<QMessageBox::Icon>("QMessageBox::Icon");
     qRegisterMetaType<QMessageBox::StandardButtons>("QMessageBox::StandardButtons");
     qRegisterMetaType<QList<QVariant>*>("QList<QVariant>*");
+    qRegisterMetaType<QVector<QByteArray>*>("QVector<QByteArray>*");
 
 
 
@@ -396,6 +494,8 @@ void SequenceTableView::createThread(bool isSingle, bool debug)
         {
             connect(this, SIGNAL(executeScriptCyclic(QString*,QByteArray*,SequenceScriptEngineWrapper**)),
                     (*thread), SLOT(executeScriptSlot(QString*,QByteArray*,SequenceScriptEngineWrapper**)), Qt::QueuedConnection);
+            connect(this, SIGNAL(executeScriptCyclicBatch(QString*,QByteArray*,SequenceScriptEngineWrapper**,quint32,QVector<QByteArray>*)),
+                    (*thread), SLOT(executeScriptBatchSlot(QString*,QByteArray*,SequenceScriptEngineWrapper**,quint32,QVector<QByteArray>*)), Qt::QueuedConnection);
         }
 
         (*thread)->start(QThread::HighPriority);
@@ -422,6 +522,8 @@ void SequenceTableView::terminateThread(bool isSingle)
      {
          disconnect(this, SIGNAL(executeScriptCyclic(QString*,QByteArray*,SequenceScriptEngineWrapper**)),
                  (*thread), SLOT(executeScriptSlot(QString*,QByteArray*,SequenceScriptEngineWrapper**)));
+         disconnect(this, SIGNAL(executeScriptCyclicBatch(QString*,QByteArray*,SequenceScriptEngineWrapper**,quint32,QVector<QByteArray>*)),
+                 (*thread), SLOT(executeScriptBatchSlot(QString*,QByteArray*,SequenceScriptEngineWrapper**,quint32,QVector<QByteArray>*)));
      }
 
     QApplication::removePostedEvents((*thread));
@@ -509,6 +611,62 @@ QByteArray SequenceTableView::executeScript(QString sendScript, QByteArray sendD
     return (sendData.isEmpty()) ? QByteArray() : sendData;
 }
 
+/**
+ * Executes a cyclic sequence script up to count times and returns the created payloads
+ * (one thread round trip for all calls).
+ *
+ * @param sendScript
+ *  The script name.
+ * @param sendData
+ *      The send data (passed to each script call).
+ * @param scriptEngineWrapper
+ *      The script wrapper. If 0 then the script wrapper will be create and written to this argument.
+ * @param count
+ *      The maximum number of script calls.
+ * @return
+ *      The created payloads (less than count if the script has returned no data).
+ */
+QVector<QByteArray> SequenceTableView::executeScriptBatch(QString sendScript, QByteArray sendData, SequenceScriptEngineWrapper **scriptEngineWrapper,
+                                                          quint32 count)
+{
+    QVector<QByteArray> results;
+
+    if(m_scriptCyclic == 0)
+    {
+        createThread(false);
+    }
+
+    m_scriptCyclic->m_scriptFunctionIsFinished = false;
+    int numberOfFinishedCalls = m_scriptCyclic->m_numberOfFinishedCalls.load();
+    QDateTime callTime = QDateTime::currentDateTime();
+
+    emit executeScriptCyclicBatch(&sendScript, &sendData, scriptEngineWrapper, count, &results);
+
+    while(!m_scriptCyclic->m_scriptFunctionIsFinished)
+    {
+        QCoreApplication::processEvents();
+
+        int currentNumberOfFinishedCalls = m_scriptCyclic->m_numberOfFinishedCalls.load();
+        if(m_scriptCyclic->m_dialogIsShown || (currentNumberOfFinishedCalls != numberOfFinishedCalls))
+        {//The block time is valid for each script call.
+            numberOfFinishedCalls = currentNumberOfFinishedCalls;
+            callTime = QDateTime::currentDateTime();
+        }
+
+        if(callTime.msecsTo(QDateTime::currentDateTime()) > m_scriptCyclic->m_blockTime)
+        {//Thread is blocked.
+
+            terminateThread(false);
+            createThread(false);
+            results.clear();
+            QMessageBox::critical(this, "error", sendScript + " is blocked");
+            break;
+        }
+    }
+
+    return results;
+}
+
 /**
  * Closes the debugger.
  * @param isSingle
@@ -542,17 +700,15 @@ void SequenceTableView::closeDebugger(bool isSingle)
 void SequenceTableView::sendSequence(int row, bool debug, QWidget* callerWidget)
 {
 
-    m_sendWindow->checkTextEditCell(row);
-    const Settings* settings = m_mainWindow->getSettingsDialog()->settings();
-
     SequenceTableComboBox* box = static_cast<SequenceTableComboBox*>(m_sendWindow->m_userInterface->tableWidget->cellWidget(row, SendWindow::COLUMN_FORMAT));
     SequenceTablePlainTextEdit* lineEdit = static_cast<SequenceTablePlainTextEdit*>(m_sendWindow->m_userInterface->tableWidget->cellWidget(row, SendWindow::COLUMN_VALUE));
     SequenceTablePlainTextEdit* scriptLineEdit = static_cast<SequenceTablePlainTextEdit*>(m_sendWindow->m_userInterface->tableWidget->cellWidget(row, SendWindow::COLUMN_SCRIPT));
 
+    //The payload is parsed only once (until the row is edited).
+    QByteArray sendData = m_sendWindow->getSequencePayload(row);
+
     if(!lineEdit->toPlainText().isEmpty())
     {
-        QByteArray sendData = m_sendWindow->textToByteArray(box->currentText(), lineEdit->toPlainText(),
-                                                            m_sendWindow->formatToDecimalType(box->currentText()), settings->targetEndianess);
 
         if(box->currentText() == "ascii")
         {
@@ -29,6 +29,7 @@
 #include <QWidget>
 #include <QThread>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QTableWidget>
 #include<QFile>
 #include "QScriptEngine"
@@ -55,7 +56,7 @@ class SequenceScriptEngineWrapper : public QObject
 
 public:
 
-    SequenceScriptEngineWrapper() : QObject(0), scriptEngine(0), sendDataFunction(0), runsInDebugger(false){}
+    SequenceScriptEngineWrapper() : QObject(0), scriptEngine(0), sendDataFunction(0), sendDataIsBufferFunction(false), runsInDebugger(false){}
     virtual ~SequenceScriptEngineWrapper()
     {
 
@@ -73,9 +74,12 @@ public:
     ///Pointer to the script engine.
     QScriptEngine* scriptEngine;
 
-    ///Pointer to the send data script function.
+    ///Pointer to the send data script function (sendDataBuffer or sendData).
     QScriptValue* sendDataFunction;
 
+    ///True if sendDataFunction is the script function sendDataBuffer (the data is passed as binary string).
+    bool sendDataIsBufferFunction;
+
     ///True if the scripts runs in a script debugger.
     bool runsInDebugger;
 
@@ -89,7 +93,7 @@ class SequenceScriptThread : public QThread
 public:
     SequenceScriptThread( SendWindow* sendWindow, MainWindow* mainWindow,  SequenceTableView* sequencteTable, bool runsInDebugger) : QThread(0), m_sendWindow(sendWindow),
     m_mainWindow(mainWindow), m_sequencteTable(sequencteTable), m_blockTime(DEFAULT_BLOCK_TIME), m_dialogIsShown(false),
-    m_scriptFunctionIsFinished(true), m_standardDialogs(0), m_runsInDebugger(runsInDebugger), m_debugger(0), m_debugWindow(0){}
+    m_scriptFunctionIsFinished(true), m_numberOfFinishedCalls(0), m_payloadLookahead(0), m_standardDialogs(0), m_runsInDebugger(runsInDebugger), m_debugger(0), m_debugWindow(0){}
     virtual ~SequenceScriptThread(){}
 
     ///Converts a byte array which contains ascii characters into a ascii string (QString).
@@ -185,12 +189,24 @@ public:
     ///the script is regarded as blocked and will be stopped.
     Q_INVOKABLE void setBlockTime(quint32 blockTime){m_blockTime = blockTime;}
 
+    ///Sets the number of payloads which are created in advance during a cyclic sending (max. MAX_PAYLOAD_LOOKAHEAD).
+    ///If count is greater than 1, the send function is called for the next count payloads at once and the
+    ///payloads are sent from this queue (the script is not called between two sends).
+    ///Note: 0 and 1 disable the lookahead (default).
+    Q_INVOKABLE void setPayloadLookahead(quint32 count){m_payloadLookahead = (count > MAX_PAYLOAD_LOOKAHEAD) ? MAX_PAYLOAD_LOOKAHEAD : count;}
+
+    ///Returns the number of payloads which are created in advance during a cyclic sending.
+    Q_INVOKABLE quint32 getPayloadLookahead(void){return m_payloadLookahead;}
+
     ///Returns all functions and properties of an object.
     Q_INVOKABLE QStringList getAllObjectPropertiesAndFunctions(QScriptValue object);
 
     ///The default value for m_blockTime.
     static const quint32 DEFAULT_BLOCK_TIME= 10000;
 
+    ///The maximum value for m_payloadLookahead.
+    static const quint32 MAX_PAYLOAD_LOOKAHEAD = 1000;
+
     ///Returns m_runsInDebugger.
     bool getRunsInDebugger(void){return m_runsInDebugger;}
 
@@ -203,6 +219,11 @@ public slots:
     ///Executes a script before sending the data.
     void executeScriptSlot(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper);
 
+    ///Executes a script up to count times (each call gets sendData) and appends the results to results.
+    ///Stops at the first call which returns no data.
+    void executeScriptBatchSlot(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper,
+                                quint32 count, QVector<QByteArray>* results);
+
     ///Brings the debug window to foreground.
     ///Note: This is an internal function and must not be used by a script.
     void bringWindowsToFrontSlot(void)
@@ -238,6 +259,12 @@ private:
     ///Loads one script.
     SequenceScriptEngineWrapper *loadScript(QString scriptPath);
 
+    ///Calls the send function of a script (loads the script if necessary).
+    void callSendDataFunction(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper);
+
+    ///Converts the result of a send function into a byte array.
+    static void scriptResultToByteArray(const QScriptValue& result, QByteArray* sendData);
+
     ///Pointer to the main window.
     SendWindow* m_sendWindow;
 
@@ -256,6 +283,12 @@ private:
     ///True if the script function is finished.
     bool m_scriptFunctionIsFinished;
 
+    ///The number of finished send function calls (used by SequenceTableView::executeScriptBatch to detect a blocked script).
+    QAtomicInt m_numberOfFinishedCalls;
+
+    ///The number of payloads which are created in advance during a cyclic sending.
+    quint32 m_payloadLookahead;
+
     ///The script standard dialogs.
     ScriptStandardDialogs* m_standardDialogs;
 
@@ -298,6 +331,13 @@ public:
     QByteArray executeScript(QString sendScript, QByteArray sendData, SequenceScriptEngineWrapper** scriptEngineWrapper,
                              bool isSingle, bool debug=false, bool firstCyclicSend=false);
 
+    ///Executes a cyclic sequence script up to count times and returns the created payloads.
+    ///The returned vector contains less than count payloads if the script has returned no data.
+    QVector<QByteArray> executeScriptBatch(QString sendScript, QByteArray sendData, SequenceScriptEngineWrapper** scriptEngineWrapper, quint32 count);
+
+    ///Returns the payload lookahead of the cyclic sequence script (see SequenceScriptThread::setPayloadLookahead).
+    quint32 getCyclicPayloadLookahead(void){return m_scriptCyclic ? m_scriptCyclic->getPayloadLookahead() : 0;}
+
     ///Closes the debugger.
     void closeDebugger(bool isSingle);
 
@@ -309,6 +349,8 @@ public:
 signals:
     void executeScriptSingle(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper);
     void executeScriptCyclic(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper);
+    void executeScriptCyclicBatch(QString* sendScript, QByteArray* sendData, SequenceScriptEngineWrapper** scriptEngineWrapper,
+                                  quint32 count, QVector<QByteArray>* results);
 
 private:
 
@@ -0,0 +1,333 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#include "sendHistory.h"
+#include "mainwindow.h"
+#include "sendwindow.h"
+#include <QFile>
+
+/**
+ * Constructor.
+ * @param maxEntries
+ *      The max. number of entries.
+ * @param maxBytes
+ *      The max. number of bytes in all entries.
+ */
+SendHistoryStore::SendHistoryStore(qint32 maxEntries, qint64 maxBytes) :
+    m_ring(), m_head(0), m_count(0), m_totalBytes(0), m_maxBytes(maxBytes), m_nextSequence(0)
+{
+    m_ring.resize((maxEntries > 0) ? maxEntries : 1);
+}
+
+/**
+ * Creates the search index of data.
+ * @param data
+ *      The data.
+ * @return
+ *      The search index (bit (byte % 64) is set for every byte in data).
+ */
+quint64 SendHistoryStore::createByteMask(const QByteArray& data)
+{
+    quint64 mask = 0;
+    for(auto el : data)
+    {
+        mask |= (quint64)1 << ((quint8)el % 64);
+    }
+    return mask;
+}
+
+/**
+ * Adds an entry (becomes index 0). The oldest entries are removed if necessary.
+ * @param data
+ *      The data.
+ */
+void SendHistoryStore::append(const QByteArray& data)
+{
+    while((m_count > 0) && ((m_count >= m_ring.size()) || ((m_totalBytes + data.size()) > m_maxBytes)))
+    {
+        SendHistoryEntry& oldest = m_ring[ringPosition(m_count - 1)];
+        m_totalBytes -= oldest.data.size();
+        oldest.data.clear();
+        m_count--;
+    }
+
+    SendHistoryEntry& entry = m_ring[m_head];
+    entry.data = data;
+    entry.byteMask = createByteMask(data);
+
+    m_head = (m_head + 1) % m_ring.size();
+    m_count++;
+    m_totalBytes += data.size();
+    m_nextSequence++;
+}
+
+/**
+ * Removes all entries.
+ */
+void SendHistoryStore::clear(void)
+{
+    for(auto& el : m_ring)
+    {
+        el.data.clear();
+    }
+    m_head = 0;
+    m_count = 0;
+    m_totalBytes = 0;
+}
+
+/**
+ * Returns an entry by its sequence number.
+ * @param sequence
+ *      The sequence number.
+ * @return
+ *      The entry (0 if the entry has been removed).
+ */
+const QByteArray* SendHistoryStore::bySequence(quint64 sequence) const
+{
+    if((sequence >= m_nextSequence) || ((m_nextSequence - sequence) > (quint64)m_count))
+    {
+        return 0;
+    }
+    return &at((qint32)(m_nextSequence - 1 - sequence));
+}
+
+/**
+ * Searches pattern in the entries.
+ * @param pattern
+ *      The pattern.
+ * @param startIndex
+ *      The first index which is searched.
+ * @param towardsOlder
+ *      True if the older entries (bigger indexes) shall be searched.
+ * @return
+ *      The index of the first matching entry (-1 if no entry matches).
+ */
+qint32 SendHistoryStore::search(const QByteArray& pattern, qint32 startIndex, bool towardsOlder) const
+{
+    if(pattern.isEmpty())
+    {
+        return -1;
+    }
+
+    quint64 patternMask = createByteMask(pattern);
+    qint32 step = towardsOlder ? 1 : -1;
+
+    for(qint32 index = startIndex; (index >= 0) && (index < m_count); index += step)
+    {
+        const SendHistoryEntry& entry = m_ring[ringPosition(index)];
+
+        //Entries which do not contain all bytes of the pattern are skipped without a search.
+        if(((entry.byteMask & patternMask) == patternMask) && entry.data.contains(pattern))
+        {
+            return index;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Writes all entries (oldest first, one hex line per entry) into a file.
+ * @param fileName
+ *      The file name.
+ * @param errorString
+ *      The error description.
+ * @return
+ *      True on success.
+ */
+bool SendHistoryStore::exportToFile(QString fileName, QString* errorString) const
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        *errorString = file.errorString();
+        return false;
+    }
+
+    for(qint32 index = m_count - 1; index >= 0; index--)
+    {
+        if(file.write(at(index).toHex() + "\n") < 0)
+        {
+            *errorString = file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Appends all entries of a file created with exportToFile.
+ * @param fileName
+ *      The file name.
+ * @param errorString
+ *      The error description.
+ * @return
+ *      The number of imported entries (-1 on error).
+ */
+qint32 SendHistoryStore::importFromFile(QString fileName, QString* errorString)
+{
+    QFile file(fileName);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        *errorString = file.errorString();
+        return -1;
+    }
+
+    qint32 count = 0;
+    while(!file.atEnd())
+    {
+        QByteArray line = file.readLine().trimmed();
+        if(!line.isEmpty())
+        {
+            append(QByteArray::fromHex(line));
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Constructor.
+ * @param store
+ *      The history store.
+ * @param parent
+ *      The parent.
+ */
+SendHistoryModel::SendHistoryModel(SendHistoryStore* store, QObject* parent) :
+    QAbstractListModel(parent), m_store(store), m_rowCount(0), m_nextSequence(store->nextSequence()),
+    m_format("hex"), m_endianess(LITTLE_ENDIAN_TARGET)
+{
+}
+
+/**
+ * Returns the number of rows.
+ * @param parent
+ *      The parent index.
+ * @return
+ *      The number of rows.
+ */
+int SendHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rowCount;
+}
+
+/**
+ * Returns the data of a row (the data is formatted on demand).
+ * @param index
+ *      The model index.
+ * @param role
+ *      The role.
+ * @return
+ *      The data.
+ */
+QVariant SendHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || (index.row() >= m_store->size()) || (role != Qt::DisplayRole))
+    {
+        return QVariant();
+    }
+
+    const QByteArray& entry = m_store->at(index.row());
+    QByteArray displayedData = entry.left(MAX_DISPLAYED_BYTES);
+    QString text = QString("index: %1   ").arg(index.row());
+
+    if(m_format == "ascii")
+    {
+        for(auto el : displayedData)
+        {
+            if((el == '\n') || (el == '\r'))
+            {
+                continue;
+            }
+            text += ((el < 32) || (el > 126)) ? QChar(255) : QChar::fromLatin1(el);
+        }
+    }
+    else
+    {
+        text += MainWindow::byteArrayToNumberString(displayedData, (m_format == "bin"), (m_format == "hex"), false, true, true,
+                                                    SendWindow::formatToDecimalType(m_format), m_endianess);
+    }
+
+    if(entry.size() > MAX_DISPLAYED_BYTES)
+    {
+        text += QString(" ... (%1 bytes)").arg(entry.size());
+    }
+    return text;
+}
+
+/**
+ * Sets the display format.
+ * @param format
+ *      The format (bin, hex, ascii, uint8...).
+ * @param endianess
+ *      The endianess (decimal formats).
+ */
+void SendHistoryModel::setFormat(QString format, Endianess endianess)
+{
+    if((format != m_format) || (endianess != m_endianess))
+    {
+        m_format = format;
+        m_endianess = endianess;
+        if(m_rowCount > 0)
+        {
+            emit dataChanged(index(0), index(m_rowCount - 1));
+        }
+    }
+}
+
+/**
+ * Updates the rows after the store has been changed. Removed (oldest) entries are
+ * removed at the end and added entries are inserted at the beginning, so that the
+ * view keeps its scroll position and selection.
+ */
+void SendHistoryModel::update(void)
+{
+    qint32 storeSize = m_store->size();
+    quint64 added = m_store->nextSequence() - m_nextSequence;
+    qint32 addedRows = (added > (quint64)storeSize) ? storeSize : (qint32)added;
+    qint32 removedRows = m_rowCount + addedRows - storeSize;
+
+    m_nextSequence = m_store->nextSequence();
+
+    if((removedRows < 0) || (removedRows > m_rowCount))
+    {
+        beginResetModel();
+        m_rowCount = storeSize;
+        endResetModel();
+        return;
+    }
+
+    if(removedRows > 0)
+    {
+        beginRemoveRows(QModelIndex(), m_rowCount - removedRows, m_rowCount - 1);
+        m_rowCount -= removedRows;
+        endRemoveRows();
+    }
+
+    if(addedRows > 0)
+    {
+        beginInsertRows(QModelIndex(), 0, addedRows - 1);
+        m_rowCount += addedRows;
+        endInsertRows();
+    }
+}
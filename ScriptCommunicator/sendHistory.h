@@ -0,0 +1,160 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+#ifndef SENDHISTORY_H
+#define SENDHISTORY_H
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QVector>
+#include "settingsdialog.h"
+
+///One entry in the send history.
+typedef struct
+{
+    ///The sent data.
+    QByteArray data;
+
+    ///Search index: bit (byte % 64) is set for every byte in data.
+    quint64 byteMask;
+}SendHistoryEntry;
+
+///Ring store for the send history. Index 0 is the newest entry. If the max. number of entries or
+///the max. number of bytes is reached, then the oldest entries are removed.
+///Every entry has an unique sequence number (the indexes change if entries are added).
+class SendHistoryStore
+{
+public:
+    SendHistoryStore(qint32 maxEntries = DEFAULT_MAX_ENTRIES, qint64 maxBytes = DEFAULT_MAX_BYTES);
+
+    ///The default max. number of entries.
+    static const qint32 DEFAULT_MAX_ENTRIES = 100000;
+
+    ///The default max. number of bytes in all entries.
+    static const qint64 DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+    ///Adds an entry (becomes index 0).
+    void append(const QByteArray& data);
+
+    ///Removes all entries.
+    void clear(void);
+
+    ///Returns the number of entries.
+    qint32 size(void) const {return m_count;}
+
+    ///Returns the number of bytes in all entries.
+    qint64 totalBytes(void) const {return m_totalBytes;}
+
+    ///Returns an entry (0 = newest).
+    const QByteArray& at(qint32 index) const {return m_ring[ringPosition(index)].data;}
+
+    ///Returns the sequence number of an entry.
+    quint64 sequenceOf(qint32 index) const {return m_nextSequence - 1 - index;}
+
+    ///Returns the sequence number of the next added entry.
+    quint64 nextSequence(void) const {return m_nextSequence;}
+
+    ///Returns an entry by its sequence number (0 if the entry has been removed).
+    const QByteArray* bySequence(quint64 sequence) const;
+
+    ///Searches pattern starting at startIndex (towards the older entries if towardsOlder is true).
+    ///Returns the index of the first matching entry or -1.
+    qint32 search(const QByteArray& pattern, qint32 startIndex, bool towardsOlder) const;
+
+    ///Writes all entries (oldest first, one hex line per entry) into a file.
+    bool exportToFile(QString fileName, QString* errorString) const;
+
+    ///Appends all entries of a file created with exportToFile.
+    ///Returns the number of imported entries (-1 on error).
+    qint32 importFromFile(QString fileName, QString* errorString);
+
+private:
+
+    ///Returns the ring position of an index.
+    qint32 ringPosition(qint32 index) const {return (m_head - 1 - index + m_ring.size()) % m_ring.size();}
+
+    ///Creates the search index of data.
+    static quint64 createByteMask(const QByteArray& data);
+
+    ///The ring buffer.
+    QVector<SendHistoryEntry> m_ring;
+
+    ///The ring position of the next added entry.
+    qint32 m_head;
+
+    ///The number of entries.
+    qint32 m_count;
+
+    ///The number of bytes in all entries.
+    qint64 m_totalBytes;
+
+    ///The max. number of bytes in all entries.
+    qint64 m_maxBytes;
+
+    ///The sequence number of the next added entry.
+    quint64 m_nextSequence;
+};
+
+///Model for the send history view. Only the visible rows are formatted (the view is virtualized).
+class SendHistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    SendHistoryModel(SendHistoryStore* store, QObject* parent);
+
+    ///The max. number of bytes which are shown per row.
+    static const qint32 MAX_DISPLAYED_BYTES = 512;
+
+    ///Returns the number of rows.
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+
+    ///Returns the data of a row.
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    ///Sets the display format (bin, hex, ascii, uint8...).
+    void setFormat(QString format, Endianess endianess);
+
+    ///Updates the rows after the store has been changed (added, removed or cleared entries).
+    void update(void);
+
+private:
+
+    ///The history store.
+    SendHistoryStore* m_store;
+
+    ///The number of rows.
+    qint32 m_rowCount;
+
+    ///The next sequence number of the store at the last update.
+    quint64 m_nextSequence;
+
+    ///The display format.
+    QString m_format;
+
+    ///The endianess (decimal formats).
+    Endianess m_endianess;
+};
+
+#endif // SENDHISTORY_H
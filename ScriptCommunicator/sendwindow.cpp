@@ -45,6 +45,7 @@
 #include <QInputDialog>
 #include <QStringList>
 #include <QMimeData>
+#include <limits>
 
 
 
@@ -153,7 +154,8 @@ SendWindow::SendWindow(SettingsDialog *settingsDialog, MainWindow *mainWindow) :
     QMainWindow(0),
     m_userInterface(new Ui::SendWindow), m_settingsDialog(settingsDialog), m_cyclicSendingIsInProgress(false), m_programIsClosing(false), m_isConnected(false), m_currentSendData(),
     m_currentSendRepetitionCount(0), m_currentSendNumberOfSends(0), m_currentSendPause(0), m_currentSendTimer(0), m_currentScriptEngineWrapper(0),
-    m_mainWindow(mainWindow)
+    m_cyclicSendEngine(), m_cyclicSendUsesEngine(false), m_cyclicPayloads(), m_cyclicCreatedPayloads(0), m_cyclicStatisticsTimer(),
+    m_lookaheadPayloads(), m_cyclicScriptHasEnded(false), m_mainWindow(mainWindow)
 {
     m_userInterface->setupUi(this);
 
@@ -191,6 +193,8 @@ SendWindow::SendWindow(SettingsDialog *settingsDialog, MainWindow *mainWindow) :
     connect(m_userInterface->tableWidget, SIGNAL(itemSelectionChanged()), this, SLOT(itemSelectionChangedSlot()));
 
     connect(&m_currentSendTimer, SIGNAL(timeout()), this, SLOT(sendTimerElapsedSlot()));
+    connect(&m_cyclicStatisticsTimer, SIGNAL(timeout()), this, SLOT(cyclicStatisticsTimerSlot()));
+    connect(&m_cyclicSendEngine, SIGNAL(payloadsNeededSignal()), this, SLOT(cyclicPayloadsNeededSlot()), Qt::QueuedConnection);
 
     m_userInterface->SendProgressBar->setValue(0);
     m_userInterface->CyclicSendRepetition->setText("0");
@@ -470,6 +474,7 @@ void SendWindow::textEditCellChangedSlot()
     SequenceTablePlainTextEdit* textEdit = static_cast<SequenceTablePlainTextEdit*>(sender());
     SequenceTableComboBox* box = static_cast<SequenceTableComboBox*>(m_userInterface->tableWidget->cellWidget(textEdit->row(),COLUMN_FORMAT));
 
+    invalidateSequencePayload(textEdit->row());
     textEditChanged(textEdit, box->currentText(), formatToDecimalType(box->currentText()));
 }
 
@@ -641,6 +646,7 @@ void SendWindow::comboBoxCellChangedSlot(QString text)
 
     QString newText = formatComboBoxChanged(textEdit, format, oldFormat);
 
+    invalidateSequencePayload(box->row());
     textEdit->blockSignals(true);
     textEdit->setPlainText(newText);
     textEdit->blockSignals(false);
@@ -959,6 +965,37 @@ QStringList SendWindow::getAllSequences(void)
     return sequences;
 }
 
+/**
+ * Returns the send data of a sequence (the sequence script is not executed).
+ * Is called by ScriptSequencePlaylist.
+ * @param name
+ *      The name of the sequence.
+ * @param data
+ *      The send data.
+ * @param found
+ *      True if the sequence has been found.
+ */
+void SendWindow::getSequenceDataSlot(QString name, QByteArray* data, bool* found)
+{
+    *found = false;
+
+    for( int r = 0; r < m_userInterface->tableWidget->rowCount(); ++r )
+    {
+        if(m_userInterface->tableWidget->item(r,COLUMN_NAME)->text() == name)
+        {
+            SequenceTableComboBox* box = static_cast<SequenceTableComboBox*>(m_userInterface->tableWidget->cellWidget(r, COLUMN_FORMAT));
+
+            *data = getSequencePayload(r);
+            if(box->currentText() == "ascii")
+            {
+                data->replace("\n", m_settingsDialog->settings()->consoleSendOnEnter.toLocal8Bit());
+            }
+            *found = true;
+            break;
+        }
+    }
+}
+
 /**
  * Loads a saved sequence table.
  */
@@ -1521,85 +1558,58 @@ void SendWindow::setProgressbarValue(int value)
 QByteArray SendWindow::textToByteArray(QString formatString, QString text, DecimalType decimalType, Endianess endianess)
 {
     QByteArray dataArray;
-    QStringList strList = text.split(" ");
 
     if(formatString != "ascii")
     {
-        uint format = 10;
+        bool isHexOrBin = false;
+        quint32 base = 10;
 
         if(formatString == "hex")
         {
-            format = 16;
+            base = 16;
+            isHexOrBin = true;
         }
         else if(formatString == "bin")
         {
-            format = 2;
+            base = 2;
+            isHexOrBin = true;
         }
 
-        for(auto var : strList)
+        qint32 bytesPerNumber = 1;
+        bool isSigned = true;
+        if((decimalType == DECIMAL_TYPE_UINT16) || (decimalType == DECIMAL_TYPE_INT16))
+        {
+            bytesPerNumber = 2;
+        }
+        else if((decimalType == DECIMAL_TYPE_UINT32) || (decimalType == DECIMAL_TYPE_INT32))
         {
-            bool isOk = false;
+            bytesPerNumber = 4;
+        }
+        if((decimalType == DECIMAL_TYPE_UINT8) || (decimalType == DECIMAL_TYPE_UINT16) || (decimalType == DECIMAL_TYPE_UINT32))
+        {
+            isSigned = false;
+        }
+
+        dataArray.reserve(isHexOrBin ? (text.size() / 2) + 1 : ((text.size() / 2) + 1) * bytesPerNumber);
 
-            if((formatString == "hex") || (formatString == "bin"))
+        //The numbers are separated by spaces (every space separates 2 numbers).
+        const QChar* numberBegin = text.constData();
+        const QChar* textEnd = numberBegin + text.size();
+        while(true)
+        {
+            const QChar* numberEnd = numberBegin;
+            while((numberEnd != textEnd) && (*numberEnd != QLatin1Char(' ')))
             {
-                quint32 value = var.toUInt(&isOk,format);
-                if(value > 255 || !isOk)
-                {
-                    QString valueSum = "";
-                    for(auto number : var)
-                    {
+                numberEnd++;
+            }
 
-                        if((valueSum + number).toUInt(&isOk,format) > 255)
-                        {
-                            dataArray.append(valueSum.toUInt(&isOk,format));
-                            valueSum = number;
-                        }
-                        else
-                        {
-                            valueSum += number;
-                        }
-                    }
-                    dataArray.append(valueSum.toUInt(&isOk,format));
-                }
-                else
-                {
-                    dataArray.append((qint8)value);
-                }
+            if(isHexOrBin)
+            {
+                appendHexOrBinNumber(numberBegin, numberEnd, base, dataArray);
             }
             else
             {
-                qint32 bytesPerNumber = 1;
-                quint32 value = 0;
-
-                if(decimalType == DECIMAL_TYPE_UINT16)
-                {
-                    bytesPerNumber = 2;
-                    value = (quint32)var.toULongLong(&isOk,format);
-                }
-                else if(decimalType == DECIMAL_TYPE_INT16)
-                {
-                    bytesPerNumber = 2;
-                    value = (quint32)var.toLongLong(&isOk,format);
-                }
-                else if(decimalType == DECIMAL_TYPE_UINT32)
-                {
-                    bytesPerNumber = 4;
-                    value = (quint32)var.toULongLong(&isOk,format);
-                }
-                else if(decimalType == DECIMAL_TYPE_INT32)
-                {
-                    bytesPerNumber = 4;
-                    value = (quint32)var.toLongLong(&isOk,format);
-                }
-                else if(decimalType == DECIMAL_TYPE_UINT8)
-                {
-                    bytesPerNumber = 1;
-                    value = (quint32)var.toULongLong(&isOk,format);
-                }
-                else
-                {
-                    value = (quint32)var.toLongLong(&isOk,format);
-                }
+                quint32 value = decimalNumberToValue(numberBegin, numberEnd, isSigned);
 
                 for(int k = 0; k < bytesPerNumber; k++)
                 {
@@ -1612,9 +1622,13 @@ QByteArray SendWindow::textToByteArray(QString formatString, QString text, Decim
                         dataArray.append((quint8)(value >> (8 * (bytesPerNumber - (k + 1)))));
                     }
                 }
-
             }
 
+            if(numberEnd == textEnd)
+            {
+                break;
+            }
+            numberBegin = numberEnd + 1;
         }
     }
     else
@@ -1627,6 +1641,186 @@ QByteArray SendWindow::textToByteArray(QString formatString, QString text, Decim
 
 }
 
+/**
+ * Appends the bytes of one hex/binary number to dataArray.
+ * Numbers which are greater than 255 are split into several bytes (the digits are
+ * collected as long as the value is smaller than 256). Other whitespace characters are ignored,
+ * invalid characters result in a 0 byte. An empty number results in a 0 byte.
+ * @param begin
+ *      The first character of the number.
+ * @param end
+ *      The character after the number.
+ * @param base
+ *      The base (16 or 2).
+ * @param dataArray
+ *      The byte array.
+ */
+void SendWindow::appendHexOrBinNumber(const QChar* begin, const QChar* end, quint32 base, QByteArray& dataArray)
+{
+    quint32 value = 0;
+    bool hasDigits = false;
+    bool isValid = true;
+
+    for(const QChar* current = begin; current != end; current++)
+    {
+        ushort character = current->unicode();
+        quint32 digit;
+
+        if((character >= '0') && (character <= '9'))
+        {
+            digit = character - '0';
+        }
+        else if((character >= 'a') && (character <= 'f'))
+        {
+            digit = character - 'a' + 10;
+        }
+        else if((character >= 'A') && (character <= 'F'))
+        {
+            digit = character - 'A' + 10;
+        }
+        else if(current->isSpace())
+        {
+            continue;
+        }
+        else
+        {
+            digit = base;
+        }
+
+        if(digit >= base)
+        {//Invalid character.
+            isValid = false;
+            hasDigits = true;
+            continue;
+        }
+
+        if(isValid && hasDigits && (((value * base) + digit) > 255))
+        {
+            dataArray.append((char)value);
+            value = digit;
+        }
+        else
+        {
+            value = (value * base) + digit;
+            hasDigits = true;
+        }
+    }
+
+    dataArray.append(isValid ? (char)value : (char)0);
+}
+
+/**
+ * Converts one decimal number (a leading '+' or '-' is allowed, '-' only for signed numbers).
+ * @param begin
+ *      The first character of the number.
+ * @param end
+ *      The character after the number.
+ * @param isSigned
+ *      True if the number is signed.
+ * @return
+ *      The value (0 if the number is invalid).
+ */
+quint32 SendWindow::decimalNumberToValue(const QChar* begin, const QChar* end, bool isSigned)
+{
+    quint64 value = 0;
+    bool isNegative = false;
+    bool hasSign = false;
+    bool hasDigits = false;
+
+    for(const QChar* current = begin; current != end; current++)
+    {
+        ushort character = current->unicode();
+
+        if((character >= '0') && (character <= '9'))
+        {
+            quint64 newValue = (value * 10) + (character - '0');
+            if((newValue / 10) != value)
+            {//Overflow.
+                return 0;
+            }
+            value = newValue;
+            hasDigits = true;
+        }
+        else if(((character == '-') || (character == '+')) && !hasSign && !hasDigits)
+        {
+            isNegative = (character == '-') ? true : false;
+            hasSign = true;
+        }
+        else if(!current->isSpace())
+        {//Invalid character.
+            return 0;
+        }
+    }
+
+    if(!hasDigits || (isNegative && !isSigned))
+    {
+        return 0;
+    }
+
+    if(isSigned)
+    {
+        quint64 maxValue = (quint64)std::numeric_limits<qint64>::max();
+        if(value > (isNegative ? maxValue + 1 : maxValue))
+        {
+            return 0;
+        }
+        return isNegative ? (quint32)(0 - value) : (quint32)value;
+    }
+    return (quint32)value;
+}
+
+/**
+ * Returns the payload of a sequence table row.
+ * The payload is cached (in the value item of the row) and the cache is invalidated if the
+ * value or the format of the row is changed (see invalidateSequencePayload).
+ * @param row
+ *      The row.
+ * @return
+ *      The payload.
+ */
+QByteArray SendWindow::getSequencePayload(int row)
+{
+    const Settings* settings = m_settingsDialog->settings();
+    QTableWidgetItem* item = m_userInterface->tableWidget->item(row, COLUMN_VALUE);
+    QVariant cachedEndianess = item->data(ROLE_CACHED_PAYLOAD_ENDIANESS);
+
+    if(!cachedEndianess.isValid() || (cachedEndianess.toInt() != (int)settings->targetEndianess))
+    {
+        checkTextEditCell(row);
+
+        SequenceTableComboBox* box = static_cast<SequenceTableComboBox*>(m_userInterface->tableWidget->cellWidget(row, COLUMN_FORMAT));
+        SequenceTablePlainTextEdit* textEdit = static_cast<SequenceTablePlainTextEdit*>(m_userInterface->tableWidget->cellWidget(row, COLUMN_VALUE));
+        QString text = textEdit->toPlainText();
+        QByteArray payload;
+
+        if(!text.isEmpty())
+        {
+            payload = textToByteArray(box->currentText(), text, formatToDecimalType(box->currentText()), settings->targetEndianess);
+        }
+
+        item->setData(ROLE_CACHED_PAYLOAD, payload);
+        item->setData(ROLE_CACHED_PAYLOAD_ENDIANESS, (int)settings->targetEndianess);
+        return payload;
+    }
+
+    return item->data(ROLE_CACHED_PAYLOAD).toByteArray();
+}
+
+/**
+ * Invalidates the cached payload of a sequence table row.
+ * @param row
+ *      The row.
+ */
+void SendWindow::invalidateSequencePayload(int row)
+{
+    QTableWidgetItem* item = m_userInterface->tableWidget->item(row, COLUMN_VALUE);
+    if(item)
+    {
+        item->setData(ROLE_CACHED_PAYLOAD_ENDIANESS, QVariant());
+        item->setData(ROLE_CACHED_PAYLOAD, QVariant());
+    }
+}
+
 /**
  * Returns the current send string (from to gui).
  * @return
@@ -1751,6 +1945,24 @@ void SendWindow::setAddToHistoryCheckBox(bool add)
     m_userInterface->addToHistoryCheckBox->setChecked(add);
 }
 
+/**
+ * Returns true if the cyclic sequence script shall be executed before the sending starts.
+ */
+bool SendWindow::getPrecomputeScriptCheckBox(void)
+{
+    return m_userInterface->precomputeScriptCheckBox->isChecked();
+}
+
+/**
+ * True if the cyclic sequence script shall be executed before the sending starts.
+ * @param precompute
+ *      True for precompute.
+ */
+void SendWindow::setPrecomputeScriptCheckBox(bool precompute)
+{
+    m_userInterface->precomputeScriptCheckBox->setChecked(precompute);
+}
+
 /**
  * Slot function for the send button.
  */
@@ -1831,6 +2043,10 @@ void SendWindow::cyclicSendErrorReceived(void)
     if(m_cyclicSendingIsInProgress)
     {
         m_currentSendTimer.stop();
+        m_cyclicSendEngine.stopSending();
+        cyclicStatisticsTimerSlot();
+        m_cyclicStatisticsTimer.stop();
+        m_cyclicSendUsesEngine = false;
 
         m_cyclicSendingIsInProgress = false;
 
@@ -1853,6 +2069,10 @@ void SendWindow::cyclicSendErrorReceived(void)
 void SendWindow::currentCyclicSendFinished(void)
 {
     m_currentSendTimer.stop();
+    m_cyclicSendEngine.stopSending();
+    cyclicStatisticsTimerSlot();
+    m_cyclicStatisticsTimer.stop();
+    m_cyclicSendUsesEngine = false;
 
     m_cyclicSendingIsInProgress = false;
     enableWindowForCyclicSend(true);
@@ -1877,6 +2097,16 @@ void SendWindow::dataHasBeenSendSlot(bool success, uint id)
 
                 if(!m_programIsClosing)
                 {
+                    if(m_cyclicSendUsesEngine && !m_cyclicPayloads.isEmpty())
+                    {
+                        //The engine sends the payloads in order (one at a time).
+                        QByteArray payload = m_currentSendScript.isEmpty() ? m_cyclicPayloads.head() : m_cyclicPayloads.dequeue();
+                        if(m_userInterface->addToHistoryCheckBox->isChecked())
+                        {
+                            m_mainWindow->getHandleDataObject()->addDataToSendHistory(&payload);
+                        }
+                    }
+
                     m_currentSendNumberOfSends++;
 
                     int currentProgress = 0;
@@ -1899,8 +2129,8 @@ void SendWindow::dataHasBeenSendSlot(bool success, uint id)
                         m_userInterface->tableWidget->closeDebugger(false);
                         currentCyclicSendFinished();
                     }
-                    else
-                    {
+                    else if(!m_cyclicSendUsesEngine)
+                    {//The next send is triggered by m_cyclicSendEngine if it is used.
                         if(m_currentSendPause == 0)
                         {
                             sendTimerElapsedSlot();
@@ -1915,6 +2145,9 @@ void SendWindow::dataHasBeenSendSlot(bool success, uint id)
                 {
                     m_userInterface->tableWidget->closeDebugger(false);
                     m_currentSendTimer.stop();
+                    m_cyclicSendEngine.stopSending();
+                    m_cyclicStatisticsTimer.stop();
+                    m_cyclicSendUsesEngine = false;
                     m_cyclicSendingIsInProgress = false;
                 }
             }
@@ -1997,6 +2230,8 @@ void SendWindow::sendDataWithTheMainInterface(const QByteArray &data, QWidget* c
                 m_currentSendPause = pause;
                 m_currentSendNumberOfSends = 0;
                 m_currentSendScript = scriptName;
+                m_lookaheadPayloads.clear();
+                m_cyclicScriptHasEnded = false;
 
                 if(m_currentScriptEngineWrapper != 0)
                 {
@@ -2004,10 +2239,18 @@ void SendWindow::sendDataWithTheMainInterface(const QByteArray &data, QWidget* c
                 }
                 m_currentScriptEngineWrapper = scriptEngineWrapper;
 
-                emit sendDataWithTheMainInterfaceSignal(sendData, MainInterfaceThread::SEND_ID_SEND_WINDOW_CYCLIC);
-                if(m_userInterface->addToHistoryCheckBox->isChecked())
+                m_userInterface->CyclicSendStatisticsLabel->clear();
+                if(scriptName.isEmpty() || (m_userInterface->precomputeScriptCheckBox->isChecked() && !debug))
                 {
-                    m_mainWindow->getHandleDataObject()->addDataToSendHistory(&sendData);
+                    startCyclicSendEngine(sendData);
+                }
+                else
+                {
+                    emit sendDataWithTheMainInterfaceSignal(sendData, MainInterfaceThread::SEND_ID_SEND_WINDOW_CYCLIC);
+                    if(m_userInterface->addToHistoryCheckBox->isChecked())
+                    {
+                        m_mainWindow->getHandleDataObject()->addDataToSendHistory(&sendData);
+                    }
                 }
             }
             else if(!isCyclicSend)
@@ -2040,6 +2283,98 @@ void SendWindow::sendDataWithTheMainInterface(const QByteArray &data, QWidget* c
     }
 }
 
+/**
+ * Starts the cyclic send engine (m_cyclicSendEngine) for the current cyclic send process.
+ * If the cyclic sequence has a script, the first PRECOMPUTE_BATCH_SIZE payloads are created before
+ * the sending starts and the following payloads are created while the engine is sending (cyclicPayloadsNeededSlot).
+ * @param firstPayload
+ *      The first payload (the result of the first script call or the send data).
+ */
+void SendWindow::startCyclicSendEngine(const QByteArray& firstPayload)
+{
+    QVector<QByteArray> payloads;
+    payloads.append(firstPayload);
+    m_cyclicCreatedPayloads = 1;
+
+    m_cyclicPayloads.clear();
+    m_cyclicPayloads.enqueue(firstPayload);
+    m_cyclicSendUsesEngine = true;
+
+    if(!m_currentSendScript.isEmpty())
+    {
+        payloads += createCyclicPayloads();
+        for(qint32 i = 1; i < payloads.size(); i++)
+        {
+            m_cyclicPayloads.enqueue(payloads[i]);
+        }
+    }
+
+    m_cyclicSendEngine.startSending(payloads, (quint64)m_currentSendRepetitionCount + 1, m_currentSendPause, m_currentSendScript.isEmpty());
+    m_cyclicStatisticsTimer.start(CYCLIC_STATISTICS_UPDATE_INTERVAL);
+}
+
+/**
+ * Creates the next payloads (max. PRECOMPUTE_BATCH_SIZE) of the current cyclic send process with the cyclic send script.
+ * If the script returns no data, then the cyclic sending ends after the last created payload (m_currentSendRepetitionCount
+ * is adjusted).
+ * @return
+ *      The created payloads.
+ */
+QVector<QByteArray> SendWindow::createCyclicPayloads(void)
+{
+    quint64 numberOfPayloads = (quint64)m_currentSendRepetitionCount + 1;
+    if(m_cyclicCreatedPayloads >= numberOfPayloads)
+    {
+        return QVector<QByteArray>();
+    }
+
+    quint32 count = (quint32)qMin(numberOfPayloads - m_cyclicCreatedPayloads, (quint64)PRECOMPUTE_BATCH_SIZE);
+    QVector<QByteArray> payloads = m_userInterface->tableWidget->executeScriptBatch(m_currentSendScript, m_currentSendData,
+                                                                                    &m_currentScriptEngineWrapper, count);
+    m_cyclicCreatedPayloads += payloads.size();
+    if((quint32)payloads.size() < count)
+    {//The script has ended the cyclic sending.
+        m_currentSendRepetitionCount = (int)(m_cyclicCreatedPayloads - 1);
+    }
+    return payloads;
+}
+
+/**
+ * Is connected with CyclicSendEngine::payloadsNeededSignal. Creates the next payloads with the cyclic send script
+ * (the engine continues sending the already created payloads).
+ */
+void SendWindow::cyclicPayloadsNeededSlot(void)
+{
+    if(!m_cyclicSendingIsInProgress || !m_cyclicSendUsesEngine || m_currentSendScript.isEmpty())
+    {
+        return;
+    }
+
+    QVector<QByteArray> payloads = createCyclicPayloads();
+    for(const auto& el : payloads)
+    {
+        m_cyclicPayloads.enqueue(el);
+    }
+    m_cyclicSendEngine.appendPayloads(payloads, m_cyclicCreatedPayloads >= ((quint64)m_currentSendRepetitionCount + 1));
+
+    if(m_currentSendNumberOfSends > m_currentSendRepetitionCount)
+    {//The script has ended the cyclic sending and all created payloads have already been sent.
+        m_userInterface->tableWidget->closeDebugger(false);
+        currentCyclicSendFinished();
+    }
+}
+
+/**
+ * This slot function is called by m_cyclicStatisticsTimer.
+ */
+void SendWindow::cyclicStatisticsTimerSlot(void)
+{
+    if(m_cyclicSendUsesEngine)
+    {
+        m_userInterface->CyclicSendStatisticsLabel->setText(CyclicSendEngine::statisticsToString(m_cyclicSendEngine.getStatistics()));
+    }
+}
+
 /**
  * Enables or disable the send window for cyclic sending.
  * @param enable
@@ -2068,6 +2403,7 @@ void SendWindow::enableWindowForCyclicSend(bool enable)
         m_userInterface->CyclicSendPause->setPalette(tmpPalette);
 
         m_userInterface->CyclicSendFormat->setEnabled(true);
+        m_userInterface->precomputeScriptCheckBox->setEnabled(true);
         m_userInterface->actionAddCyclicScript->setEnabled(true);
 
         cyclicScriptTextEditChangedSlot();
@@ -2093,6 +2429,7 @@ void SendWindow::enableWindowForCyclicSend(bool enable)
         m_userInterface->CyclicSendPause->setPalette(tmpPalette);
 
         m_userInterface->CyclicSendFormat->setEnabled(false);
+        m_userInterface->precomputeScriptCheckBox->setEnabled(false);
         m_userInterface->actionEditCyclicScript->setEnabled(false);
         m_userInterface->actionAddCyclicScript->setEnabled(false);
 
@@ -2104,6 +2441,36 @@ void SendWindow::enableWindowForCyclicSend(bool enable)
     itemSelectionChangedSlot();
 }
 
+/**
+ * Creates the next payloads of the current cyclic send process in advance (see SequenceScriptThread::setPayloadLookahead).
+ * Not more payloads than the remaining repetitions are created.
+ * @param numberOfPendingSends
+ *      The number of payloads which are being sent (not counted in m_currentSendNumberOfSends yet).
+ */
+void SendWindow::fillLookaheadPayloads(quint32 numberOfPendingSends)
+{
+    if(!m_cyclicScriptHasEnded)
+    {
+        qint64 numberOfSends = (qint64)m_currentSendNumberOfSends + m_lookaheadPayloads.size() + numberOfPendingSends;
+        qint64 remaining = (qint64)m_currentSendRepetitionCount + 1 - numberOfSends;
+        quint32 count = (quint32)qMax((qint64)0, qMin(remaining, (qint64)m_userInterface->tableWidget->getCyclicPayloadLookahead()));
+
+        if(count > 0)
+        {
+            QVector<QByteArray> payloads = m_userInterface->tableWidget->executeScriptBatch(m_currentSendScript, m_currentSendData,
+                                                                                            &m_currentScriptEngineWrapper, count);
+            for(auto el : payloads)
+            {
+                m_lookaheadPayloads.enqueue(el);
+            }
+            if((quint32)payloads.size() < count)
+            {//The script has ended the cyclic sending.
+                m_cyclicScriptHasEnded = true;
+            }
+        }
+    }
+}
+
 /**
  * This slot function is called by m_currentSendTimer.
  */
@@ -2117,8 +2484,26 @@ void SendWindow::sendTimerElapsedSlot(void)
     if(!m_currentSendScript.isEmpty())
     {//The sequence has a script.
 
-        QByteArray sendData = m_userInterface->tableWidget->executeScript(m_currentSendScript, m_currentSendData,
-                                                                          &m_currentScriptEngineWrapper, false, m_currentScriptEngineWrapper->runsInDebugger);
+        QByteArray sendData;
+        bool useLookahead = !m_currentScriptEngineWrapper->runsInDebugger && (m_userInterface->tableWidget->getCyclicPayloadLookahead() > 1);
+
+        if(useLookahead)
+        {
+            if(m_lookaheadPayloads.isEmpty())
+            {
+                fillLookaheadPayloads(0);
+            }
+            if(!m_lookaheadPayloads.isEmpty())
+            {
+                sendData = m_lookaheadPayloads.dequeue();
+            }
+        }
+        else
+        {
+            sendData = m_userInterface->tableWidget->executeScript(m_currentSendScript, m_currentSendData,
+                                                                   &m_currentScriptEngineWrapper, false, m_currentScriptEngineWrapper->runsInDebugger);
+        }
+
         if(!sendData.isEmpty())
         {
             emit sendDataWithTheMainInterfaceSignal(sendData, MainInterfaceThread::SEND_ID_SEND_WINDOW_CYCLIC);
@@ -2126,9 +2511,15 @@ void SendWindow::sendTimerElapsedSlot(void)
             {
                 m_mainWindow->getHandleDataObject()->addDataToSendHistory(&sendData);
             }
+
+            if(useLookahead && m_lookaheadPayloads.isEmpty())
+            {//Create the next payloads while the current payload is being sent.
+                fillLookaheadPayloads(1);
+            }
         }
         else
         {
+            m_lookaheadPayloads.clear();
             m_currentSendTimer.stop();
             m_cyclicSendingIsInProgress = false;
             enableWindowForCyclicSend(true);
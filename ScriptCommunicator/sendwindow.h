@@ -36,10 +36,12 @@
 #include "QPlainTextEdit"
 #include "QComboBox"
 #include <QTimer>
+#include <QQueue>
 #include <QSplitter>
 #include <mainwindow.h>
 
 #include "settingsdialog.h"
+#include "cyclicSendEngine.h"
 
 namespace Ui {
 class SendWindow;
@@ -310,12 +312,24 @@ public:
     ///Returns true if the cyclic data should be added to the send history.
     bool getAddToHistoryCheckBox(void);
 
+    ///True if the cyclic sequence script shall be executed before the sending starts.
+    void setPrecomputeScriptCheckBox(bool precompute);
+
+    ///Returns true if the cyclic sequence script shall be executed before the sending starts.
+    bool getPrecomputeScriptCheckBox(void);
+
+    ///Returns the cyclic send engine.
+    CyclicSendEngine* getCyclicSendEngine(void){return &m_cyclicSendEngine;}
+
     ///Converts a string into a bytes array.
     static QByteArray textToByteArray(QString formatString, QString text, DecimalType decimalType, Endianess endianess);
 
     ///Checks if the text has the correct format.
     void checkTextEditCell(int row);
 
+    ///Returns the payload of a sequence table row (the payload is cached until the row is edited).
+    QByteArray getSequencePayload(int row);
+
     ///The name column (in the sequence table)
     static const int COLUMN_NAME = 0;
 
@@ -328,6 +342,13 @@ public:
     ///The script column (in the sequence table)
     static const int COLUMN_SCRIPT = 3;
 
+    ///The item data role (value column) of the cached payload.
+    static const int ROLE_CACHED_PAYLOAD = Qt::UserRole + 2;
+
+    ///The item data role (value column) of the endianess with which the cached payload has been created
+    ///(invalid if there is no cached payload).
+    static const int ROLE_CACHED_PAYLOAD_ENDIANESS = Qt::UserRole + 3;
+
     ///Sends a sequence.
     void sendSequence(quint32 sequenceIndex, bool debug, QWidget* callerWidget);
 
@@ -367,6 +388,10 @@ public slots:
     ///The slot function is called if the the current transmission (sending of data) has been finished.
     void dataHasBeenSendSlot(bool success, uint id);
 
+    ///Returns the send data of a sequence (the sequence script is not executed).
+    ///Is called by ScriptSequencePlaylist.
+    void getSequenceDataSlot(QString name, QByteArray* data, bool* found);
+
     ///This slot function is called if a combobox (all comboboxes inside sequence table) value has been changed.
     void comboBoxCellChangedSlot(QString text);
 
@@ -451,6 +476,12 @@ private slots:
     ///This slot function is called by m_currentSendTimer.
     void sendTimerElapsedSlot(void);
 
+    ///This slot function is called by m_cyclicStatisticsTimer.
+    void cyclicStatisticsTimerSlot(void);
+
+    ///Is connected with CyclicSendEngine::payloadsNeededSignal (creates the next payloads with the cyclic send script).
+    void cyclicPayloadsNeededSlot(void);
+
     ///Copies the content of a sequence table entry to the cyclic send area.
     void copyFromSequenceTableSlot(void);
 
@@ -468,6 +499,15 @@ private:
     ///Swaps the position of 2 table rows.
     void swapTableRowPositions(int row1, int row2);
 
+    ///Invalidates the cached payload of a sequence table row.
+    void invalidateSequencePayload(int row);
+
+    ///Appends the bytes of one hex/binary number to dataArray.
+    static void appendHexOrBinNumber(const QChar* begin, const QChar* end, quint32 base, QByteArray& dataArray);
+
+    ///Converts one decimal number.
+    static quint32 decimalNumberToValue(const QChar* begin, const QChar* end, bool isSigned);
+
     ///Enables or disable the send window for cyclic sending.
     void enableWindowForCyclicSend(bool enable);
 
@@ -477,6 +517,22 @@ private:
     ///Maximum value for the pause.
     static const int MAX_PAUSE = 100000;
 
+    ///Update interval of the cyclic send statistics (ms).
+    static const int CYCLIC_STATISTICS_UPDATE_INTERVAL = 500;
+
+    ///Number of payloads which are created with one call of SequenceTableView::executeScriptBatch
+    ///(in startCyclicSendEngine and cyclicPayloadsNeededSlot).
+    static const quint32 PRECOMPUTE_BATCH_SIZE = 1000;
+
+    ///Creates the next payloads of the current cyclic send process in advance (see SequenceScriptThread::setPayloadLookahead).
+    void fillLookaheadPayloads(quint32 numberOfPendingSends);
+
+    ///Starts the cyclic send engine (m_cyclicSendEngine) for the current cyclic send process.
+    void startCyclicSendEngine(const QByteArray& firstPayload);
+
+    ///Creates the next payloads (max. PRECOMPUTE_BATCH_SIZE) of the current cyclic send process with the cyclic send script.
+    QVector<QByteArray> createCyclicPayloads(void);
+
     ///Sets the value of the progress bar.
     void setProgressbarValue(int value);
 
@@ -538,6 +594,29 @@ private:
     ///The cyclic send script engine wrapper.
     SequenceScriptEngineWrapper* m_currentScriptEngineWrapper;
 
+    ///Sends the cyclic data with precise timing (if the cyclic sequence has no script or
+    ///the script has been executed before the sending starts).
+    CyclicSendEngine m_cyclicSendEngine;
+
+    ///True if the current cyclic send process uses m_cyclicSendEngine.
+    bool m_cyclicSendUsesEngine;
+
+    ///The payloads which have been passed to m_cyclicSendEngine and have not been sent yet
+    ///(contains only the send data if the cyclic sequence has no script).
+    QQueue<QByteArray> m_cyclicPayloads;
+
+    ///The number of payloads which have been created for m_cyclicSendEngine.
+    quint64 m_cyclicCreatedPayloads;
+
+    ///Updates the cyclic send statistics while m_cyclicSendEngine is sending.
+    QTimer m_cyclicStatisticsTimer;
+
+    ///The payloads which have been created in advance by the cyclic send script.
+    QQueue<QByteArray> m_lookaheadPayloads;
+
+    ///True if the cyclic send script has returned no data while creating m_lookaheadPayloads.
+    bool m_cyclicScriptHasEnded;
+
     ///Pointer to the main window.
     MainWindow* m_mainWindow;
 
@@ -250,6 +250,12 @@ SettingsDialog::SettingsDialog(QAction *actionLockScrolling) :
     connect(m_userInterface->pcanBaudratecomboBox, SIGNAL(currentTextChanged(QString)),
             this, SLOT(textFromGuiElementChangedSlot(QString)));
 
+    connect(m_userInterface->socketCanInterfaceLineEdit, SIGNAL(textChanged(QString)),
+            this, SLOT(textFromGuiElementChangedSlot(QString)));
+
+    connect(m_userInterface->socketCanFiltersLineEdit, SIGNAL(textChanged(QString)),
+            this, SLOT(textFromGuiElementChangedSlot(QString)));
+
     connect(m_userInterface->consoleDecimalsType, SIGNAL(currentTextChanged(QString)),
             this, SLOT(textFromGuiElementChangedSlot(QString)));
 
@@ -920,6 +926,10 @@ void SettingsDialog::setAllSettingsSlot(Settings& settings, bool setTabIndex)
     {
         m_userInterface->connectionTypeComboBox->setCurrentText("pcan");
     }
+    else if(settings.connectionType == CONNECTION_TYPE_SOCKETCAN)
+    {
+        m_userInterface->connectionTypeComboBox->setCurrentText("socketcan");
+    }
     else
     {
         m_userInterface->connectionTypeComboBox->setCurrentText("socket");
@@ -975,6 +985,14 @@ void SettingsDialog::setAllSettingsSlot(Settings& settings, bool setTabIndex)
     m_userInterface->pcanFilterFromLineEdit->blockSignals(false);
     m_userInterface->pcanFilterToLineEdit->blockSignals(false);
 
+    //SocketCAN settings
+    m_userInterface->socketCanInterfaceLineEdit->blockSignals(true);
+    m_userInterface->socketCanFiltersLineEdit->blockSignals(true);
+    if(!settings.socketCan.interfaceName.isEmpty()){m_userInterface->socketCanInterfaceLineEdit->setText(settings.socketCan.interfaceName);}
+    m_userInterface->socketCanFiltersLineEdit->setText(settings.socketCan.filters);
+    m_userInterface->socketCanInterfaceLineEdit->blockSignals(false);
+    m_userInterface->socketCanFiltersLineEdit->blockSignals(false);
+
     if(settings.targetEndianess == LITTLE_ENDIAN_TARGET)
     {
         m_userInterface->endianessComboBox->setCurrentIndex(0);
@@ -1397,6 +1415,9 @@ void SettingsDialog::initializeInterfaceTabs(void)
         m_userInterface->pcanFilterFromLineEdit->setEnabled(true);
         m_userInterface->pcanFilterToLineEdit->setEnabled(true);
 
+        m_userInterface->socketCanInterfaceLineEdit->setEnabled(true);
+        m_userInterface->socketCanFiltersLineEdit->setEnabled(true);
+
         if(m_userInterface->socketsTypeComboBox->currentText() == "TCP client")
         {
             m_userInterface->socketOwnPortLineEdit->setEnabled(false);
@@ -1469,6 +1490,8 @@ void SettingsDialog::initializeInterfaceTabs(void)
         m_userInterface->pcanStandardRadioButton->setEnabled(false);
         m_userInterface->pcanFilterFromLineEdit->setEnabled(false);
         m_userInterface->pcanFilterToLineEdit->setEnabled(false);
+        m_userInterface->socketCanInterfaceLineEdit->setEnabled(false);
+        m_userInterface->socketCanFiltersLineEdit->setEnabled(false);
 
         if(m_userInterface->connectionTypeComboBox->currentText() == "spi master")
         {
@@ -1962,6 +1985,10 @@ void SettingsDialog::updateSettings()
     {
         m_currentSettings.connectionType = CONNECTION_TYPE_PCAN;
     }
+    else if(m_userInterface->connectionTypeComboBox->currentText() == "socketcan")
+    {
+        m_currentSettings.connectionType = CONNECTION_TYPE_SOCKETCAN;
+    }
     else
     {
         m_currentSettings.connectionType = CONNECTION_TYPE_CHEETAH_SPI_MASTER;
@@ -2007,6 +2034,10 @@ void SettingsDialog::updateSettings()
     m_currentSettings.pcanInterface.filterFrom = m_userInterface->pcanFilterFromLineEdit->text();
     m_currentSettings.pcanInterface.filterTo = m_userInterface->pcanFilterToLineEdit->text();
 
+    //SocketCAN settings
+    m_currentSettings.socketCan.interfaceName = m_userInterface->socketCanInterfaceLineEdit->text().trimmed();
+    m_currentSettings.socketCan.filters = m_userInterface->socketCanFiltersLineEdit->text().trimmed();
+
 
 
     m_currentSettings.targetEndianess = (m_userInterface->endianessComboBox->currentIndex() == 0) ? LITTLE_ENDIAN_TARGET : BIG_ENDIAN_TARGET;
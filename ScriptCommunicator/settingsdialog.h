@@ -53,7 +53,8 @@ typedef enum
     CONNECTION_TYPE_TCP_SERVER,
     CONNECTION_TYPE_UDP_SOCKET,
     CONNECTION_TYPE_CHEETAH_SPI_MASTER,
-    CONNECTION_TYPE_PCAN
+    CONNECTION_TYPE_PCAN,
+    CONNECTION_TYPE_SOCKETCAN
 
 }ConnectionType;
 
@@ -132,6 +133,16 @@ typedef struct
     QString filterTo;
 }PcanSettings;
 
+///Settings for a SocketCAN interface.
+typedef struct
+{
+    ///The interface name (e.g. can0 or vcan0).
+    QString interfaceName;
+
+    ///Comma separated list of kernel filters (id:mask or id~mask, hex).
+    QString filters;
+}SocketCanSettings;
+
 ///Struct which holds all settings from the settings window.
 struct Settings
 {
@@ -153,6 +164,9 @@ struct Settings
     ///Settings for the pcan interface.
     PcanSettings pcanInterface;
 
+    ///Settings for the SocketCAN interface.
+    SocketCanSettings socketCan;
+
     ///The target endianess of the target.
     Endianess targetEndianess;
 
@@ -0,0 +1,554 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "socketCan.h"
+#include <QElapsedTimer>
+#include <QStringList>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <sys/uio.h>
+#include <net/if.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/can/error.h>
+#include <linux/can/netlink.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ */
+SocketCan::SocketCan(QObject *parent) : QObject(parent), m_socket(-1), m_readNotifier(0), m_errorString(),
+    m_timeStampFirstReceivedFrame(0), m_firstFrameReceived(false), m_droppedFrames(0),
+    m_errorFrames(0), m_bitrate(0)
+{
+}
+
+/**
+ * Destructor.
+ */
+SocketCan::~SocketCan()
+{
+    close();
+}
+
+/**
+ * Returns true if SocketCAN is supported on this platform.
+ * @return
+ *      True if supported.
+ */
+bool SocketCan::isSupported(void)
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Opens a SocketCAN interface.
+ * @param interfaceName
+ *      The name of the interface (e.g. can0 or vcan0).
+ * @param filters
+ *      Comma separated list of kernel filters (id:mask or id~mask (inverted), hex). An id with
+ *      8 hex digits is an extended id. An empty list receives all frames.
+ * @return
+ *      True on success (see getErrorString on failure).
+ */
+bool SocketCan::open(QString interfaceName, QString filters)
+{
+    close();
+    m_errorString.clear();
+    m_firstFrameReceived = false;
+    m_droppedFrames = 0;
+    m_errorFrames = 0;
+    m_bitrate = 0;
+
+#ifdef Q_OS_LINUX
+    QByteArray name = interfaceName.trimmed().toLocal8Bit();
+    if(name.isEmpty() || (name.size() >= IFNAMSIZ))
+    {
+        m_errorString = QString("invalid interface name: %1").arg(interfaceName);
+        return false;
+    }
+
+    m_socket = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if(m_socket < 0)
+    {
+        m_errorString = QString("could not create a can socket: %1").arg(strerror(errno));
+        return false;
+    }
+
+    //The following options are optional (older kernels do not support CAN FD frames).
+    int enable = 1;
+    int receiveBufferSize = RECEIVE_BUFFER_SIZE;
+    (void)setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    (void)setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
+    (void)setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize));
+    (void)setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable));
+
+    //Receive all error frames (they are counted for the bus statistics).
+    can_err_mask_t errorMask = CAN_ERR_MASK;
+    (void)setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errorMask, sizeof(errorMask));
+
+    struct sockaddr_can address;
+    memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = if_nametoindex(name.constData());
+
+    bool success = false;
+    if(address.can_ifindex == 0)
+    {
+        m_errorString = QString("unknown interface: %1").arg(interfaceName);
+    }
+    else if(!setFilters(filters))
+    {
+        //m_errorString has been set by setFilters.
+    }
+    else if(bind(m_socket, (struct sockaddr*)&address, sizeof(address)) < 0)
+    {
+        m_errorString = QString("could not bind to %1: %2").arg(interfaceName).arg(strerror(errno));
+    }
+    else
+    {
+        success = true;
+    }
+
+    if(!success)
+    {
+        close();
+        return false;
+    }
+
+    m_bitrate = readBitrate(address.can_ifindex);
+
+    m_readNotifier = new QSocketNotifier(m_socket, QSocketNotifier::Read, this);
+    connect(m_readNotifier, SIGNAL(activated(int)), this, SLOT(socketActivatedSlot(int)));
+    return true;
+#else
+    (void)interfaceName;
+    (void)filters;
+    m_errorString = "SocketCAN is only supported on Linux";
+    return false;
+#endif
+}
+
+/**
+ * Reads the bit rate of an interface with a netlink request (RTM_GETLINK, IFLA_CAN_BITTIMING).
+ * @param interfaceIndex
+ *      The interface index.
+ * @return
+ *      The bit rate (bit/s, 0 if unknown, e.g. for virtual interfaces).
+ */
+quint32 SocketCan::readBitrate(int interfaceIndex)
+{
+    quint32 bitrate = 0;
+
+#ifdef Q_OS_LINUX
+    int netlinkSocket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if(netlinkSocket < 0)
+    {
+        return 0;
+    }
+
+    struct
+    {
+        struct nlmsghdr header;
+        struct ifinfomsg info;
+    }request;
+    memset(&request, 0, sizeof(request));
+    request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct ifinfomsg));
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST;
+    request.info.ifi_family = AF_UNSPEC;
+    request.info.ifi_index = interfaceIndex;
+
+    //The receive timeout prevents a blocked connect if the kernel does not answer.
+    struct timeval timeout = {1, 0};
+    (void)setsockopt(netlinkSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char buffer[16384];
+    int length = -1;
+    if(send(netlinkSocket, &request, request.header.nlmsg_len, 0) >= 0)
+    {
+        length = recv(netlinkSocket, buffer, sizeof(buffer), 0);
+    }
+
+    for(struct nlmsghdr* header = (struct nlmsghdr*)buffer; (length > 0) && NLMSG_OK(header, (unsigned int)length);
+        header = NLMSG_NEXT(header, length))
+    {
+        if(header->nlmsg_type != RTM_NEWLINK)
+        {
+            continue;
+        }
+
+        struct ifinfomsg* info = (struct ifinfomsg*)NLMSG_DATA(header);
+        int attributesLength = IFLA_PAYLOAD(header);
+        for(struct rtattr* attribute = IFLA_RTA(info); RTA_OK(attribute, attributesLength);
+            attribute = RTA_NEXT(attribute, attributesLength))
+        {
+            if(attribute->rta_type != IFLA_LINKINFO)
+            {
+                continue;
+            }
+
+            int linkInfoLength = RTA_PAYLOAD(attribute);
+            for(struct rtattr* linkInfo = (struct rtattr*)RTA_DATA(attribute); RTA_OK(linkInfo, linkInfoLength);
+                linkInfo = RTA_NEXT(linkInfo, linkInfoLength))
+            {
+                if(linkInfo->rta_type != IFLA_INFO_DATA)
+                {
+                    continue;
+                }
+
+                int dataLength = RTA_PAYLOAD(linkInfo);
+                for(struct rtattr* data = (struct rtattr*)RTA_DATA(linkInfo); RTA_OK(data, dataLength);
+                    data = RTA_NEXT(data, dataLength))
+                {
+                    if((data->rta_type == IFLA_CAN_BITTIMING) && (RTA_PAYLOAD(data) >= sizeof(struct can_bittiming)))
+                    {
+                        bitrate = ((struct can_bittiming*)RTA_DATA(data))->bitrate;
+                    }
+                }
+            }
+        }
+    }
+
+    ::close(netlinkSocket);
+#else
+    (void)interfaceIndex;
+#endif
+
+    return bitrate;
+}
+
+/**
+ * Configures the kernel filters (must be called before the socket is bound).
+ * @param filters
+ *      The filter list (see open).
+ * @return
+ *      True on success.
+ */
+bool SocketCan::setFilters(QString filters)
+{
+#ifdef Q_OS_LINUX
+    QVector<struct can_filter> kernelFilters;
+
+    for(auto el : filters.split(",", QString::SkipEmptyParts))
+    {
+        QString filter = el.trimmed();
+        bool isInverted = filter.contains('~');
+        QStringList parts = filter.split(isInverted ? '~' : ':');
+        bool idIsOk = false;
+        bool maskIsOk = false;
+        quint32 id = 0;
+        quint32 mask = 0;
+
+        if(parts.size() == 2)
+        {
+            id = parts[0].trimmed().toUInt(&idIsOk, 16);
+            mask = parts[1].trimmed().toUInt(&maskIsOk, 16);
+        }
+        if(!idIsOk || !maskIsOk)
+        {
+            m_errorString = QString("invalid can filter: %1").arg(filter);
+            return false;
+        }
+
+        //The frame format (standard/extended) is always part of the filter.
+        bool isExtended = (parts[0].trimmed().length() == 8);
+        struct can_filter kernelFilter;
+        kernelFilter.can_id = isExtended ? ((id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (id & CAN_SFF_MASK);
+        kernelFilter.can_mask = (mask & (isExtended ? CAN_EFF_MASK : CAN_SFF_MASK)) | CAN_EFF_FLAG;
+        if(isInverted)
+        {
+            kernelFilter.can_id |= CAN_INV_FILTER;
+        }
+        kernelFilters.append(kernelFilter);
+    }
+
+    if(!kernelFilters.isEmpty())
+    {
+        if(setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FILTER, kernelFilters.constData(),
+                      kernelFilters.size() * sizeof(struct can_filter)) < 0)
+        {
+            m_errorString = QString("could not set the can filters: %1").arg(strerror(errno));
+            return false;
+        }
+    }
+    return true;
+#else
+    (void)filters;
+    return false;
+#endif
+}
+
+/**
+ * Closes the interface.
+ */
+void SocketCan::close(void)
+{
+    if(m_readNotifier != 0)
+    {
+        m_readNotifier->setEnabled(false);
+        m_readNotifier->deleteLater();
+        m_readNotifier = 0;
+    }
+
+#ifdef Q_OS_LINUX
+    if(m_socket >= 0)
+    {
+        ::close(m_socket);
+    }
+#endif
+    m_socket = -1;
+}
+
+/**
+ * Is called by m_readNotifier if the socket is readable.
+ * @param socket
+ *      The socket.
+ */
+void SocketCan::socketActivatedSlot(int socket)
+{
+    (void)socket;
+    emit readyRead();
+}
+
+/**
+ * Returns the received frames. All frames of a batch are read with one system call (recvmmsg).
+ * @return
+ *      The received frames (max. MAX_FRAMES_PER_READ).
+ */
+QVector<CanFrame> SocketCan::readMessages(void)
+{
+    QVector<CanFrame> frames;
+
+#ifdef Q_OS_LINUX
+    if(m_socket < 0)
+    {
+        return frames;
+    }
+
+    struct canfd_frame buffers[BATCH_SIZE];
+    struct iovec vectors[BATCH_SIZE];
+    struct mmsghdr messages[BATCH_SIZE];
+    char controlBuffers[BATCH_SIZE][CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(quint32))];
+
+    while(frames.size() < MAX_FRAMES_PER_READ)
+    {
+        for(int i = 0; i < BATCH_SIZE; i++)
+        {
+            vectors[i].iov_base = &buffers[i];
+            vectors[i].iov_len = sizeof(buffers[i]);
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controlBuffers[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(controlBuffers[i]);
+        }
+
+        int received = recvmmsg(m_socket, messages, BATCH_SIZE, MSG_DONTWAIT, 0);
+        if(received <= 0)
+        {//No more frames (EAGAIN) or error.
+            break;
+        }
+
+        for(int i = 0; i < received; i++)
+        {
+            const struct canfd_frame& kernelFrame = buffers[i];
+            struct timespec time;
+            bool hasTimestamp = false;
+
+            for(struct cmsghdr* control = CMSG_FIRSTHDR(&messages[i].msg_hdr); control != 0;
+                control = CMSG_NXTHDR(&messages[i].msg_hdr, control))
+            {
+                if((control->cmsg_level == SOL_SOCKET) && (control->cmsg_type == SO_TIMESTAMPNS))
+                {
+                    memcpy(&time, CMSG_DATA(control), sizeof(time));
+                    hasTimestamp = true;
+                }
+                else if((control->cmsg_level == SOL_SOCKET) && (control->cmsg_type == SO_RXQ_OVFL))
+                {
+                    memcpy(&m_droppedFrames, CMSG_DATA(control), sizeof(m_droppedFrames));
+                }
+            }
+
+            if(kernelFrame.can_id & CAN_ERR_FLAG)
+            {
+                m_errorFrames++;
+                continue;
+            }
+            if(messages[i].msg_len < CAN_MTU)
+            {
+                continue;
+            }
+
+            if(!hasTimestamp)
+            {
+                clock_gettime(CLOCK_REALTIME, &time);
+            }
+            quint64 timestamp = ((quint64)time.tv_sec * 1000000) + (time.tv_nsec / 1000);
+            if(!m_firstFrameReceived)
+            {
+                m_firstFrameReceived = true;
+                m_timeStampFirstReceivedFrame = timestamp;
+            }
+
+            quint8 type = 0;
+            if(kernelFrame.can_id & CAN_EFF_FLAG){type |= CAN_FRAME_FLAG_EXTENDED;}
+            if(kernelFrame.can_id & CAN_RTR_FLAG){type |= CAN_FRAME_FLAG_RTR;}
+            quint32 id = kernelFrame.can_id & ((type & CAN_FRAME_FLAG_EXTENDED) ? CAN_EFF_MASK : CAN_SFF_MASK);
+
+            CanFrame frame;
+            initCanFrame(&frame, type, id, kernelFrame.data, (type & CAN_FRAME_FLAG_RTR) ? 0 : kernelFrame.len,
+                         (timestamp > m_timeStampFirstReceivedFrame) ? (timestamp - m_timeStampFirstReceivedFrame) : 0);
+
+            if(messages[i].msg_len == CANFD_MTU)
+            {
+                frame.flags |= CAN_FRAME_FLAG_FD;
+                if(kernelFrame.flags & CANFD_BRS){frame.flags |= CAN_FRAME_FLAG_BRS;}
+                if(kernelFrame.flags & CANFD_ESI){frame.flags |= CAN_FRAME_FLAG_ESI;}
+            }
+            frames.append(frame);
+        }
+
+        if(received < BATCH_SIZE)
+        {
+            break;
+        }
+    }
+#endif
+
+    return frames;
+}
+
+/**
+ * Sends the can frames of data. All frames of a batch are sent with one system call (sendmmsg).
+ * @param data
+ *      The data (byte 0=type, byte 1-4=id, byte 5-n=data, one frame for every 8 data bytes).
+ * @return
+ *      True on success.
+ */
+bool SocketCan::sendData(const QByteArray &data)
+{
+    QVector<CanFrame> frames;
+    canFramesFromSendData(data, MAX_BYTES_PER_MESSAGE, &frames);
+    return sendFrames(frames);
+}
+
+/**
+ * Sends several can frames. All frames of a batch are sent with one system call (sendmmsg).
+ * @param frames
+ *      The frames (max. 8 data bytes per frame).
+ * @return
+ *      True on success.
+ */
+bool SocketCan::sendFrames(const QVector<CanFrame>& frames)
+{
+#ifdef Q_OS_LINUX
+    if((m_socket < 0) || frames.isEmpty())
+    {
+        return false;
+    }
+
+    struct can_frame buffers[BATCH_SIZE];
+    struct iovec vectors[BATCH_SIZE];
+    struct mmsghdr messages[BATCH_SIZE];
+    int sentFrames = 0;
+    QElapsedTimer queueFullTimer;
+
+    while(sentFrames < frames.size())
+    {
+        int count = frames.size() - sentFrames;
+        if(count > BATCH_SIZE)
+        {
+            count = BATCH_SIZE;
+        }
+
+        for(int i = 0; i < count; i++)
+        {
+            const CanFrame& frame = frames[sentFrames + i];
+            memset(&buffers[i], 0, sizeof(buffers[i]));
+            buffers[i].can_id = frame.id;
+            if(frame.flags & CAN_FRAME_FLAG_EXTENDED){buffers[i].can_id |= CAN_EFF_FLAG;}
+            if(frame.flags & CAN_FRAME_FLAG_RTR){buffers[i].can_id |= CAN_RTR_FLAG;}
+            buffers[i].can_dlc = (frame.length > MAX_BYTES_PER_MESSAGE) ? MAX_BYTES_PER_MESSAGE : frame.length;
+            memcpy(buffers[i].data, frame.data, buffers[i].can_dlc);
+
+            vectors[i].iov_base = &buffers[i];
+            vectors[i].iov_len = sizeof(buffers[i]);
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = sendmmsg(m_socket, messages, count, MSG_DONTWAIT);
+        if(sent > 0)
+        {
+            sentFrames += sent;
+            queueFullTimer.invalidate();
+        }
+        else if((errno == ENOBUFS) || (errno == EAGAIN))
+        {//The transmit queue is full, wait until the socket is writable (max. SEND_QUEUE_TIMEOUT_MS).
+
+            if(!queueFullTimer.isValid())
+            {
+                queueFullTimer.start();
+            }
+
+            const int remainingMs = SEND_QUEUE_TIMEOUT_MS - (int)queueFullTimer.elapsed();
+            struct pollfd pollDescriptor;
+            pollDescriptor.fd = m_socket;
+            pollDescriptor.events = POLLOUT;
+            pollDescriptor.revents = 0;
+            if((remainingMs <= 0) || (poll(&pollDescriptor, 1, remainingMs) <= 0))
+            {
+                m_errorString = QString("could not send can frames: transmit queue is full");
+                return false;
+            }
+        }
+        else
+        {
+            m_errorString = QString("could not send can frames: %1").arg(strerror(errno));
+            return false;
+        }
+    }
+    return true;
+#else
+    (void)frames;
+    return false;
+#endif
+}
@@ -0,0 +1,137 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef SOCKETCAN_H
+#define SOCKETCAN_H
+
+#include <QObject>
+#include <QVector>
+#include <QSocketNotifier>
+#include "canFrame.h"
+
+///Class which represents a SocketCAN interface (Linux only, e.g. can0 or vcan0).
+///The frames are received and sent in batches (recvmmsg/sendmmsg), the receive timestamps
+///are created by the kernel and the id filters are applied in the kernel (CAN_RAW_FILTER).
+class SocketCan : public QObject
+{
+    Q_OBJECT
+
+public:
+    SocketCan(QObject *parent);
+    ~SocketCan();
+
+    ///Opens a SocketCAN interface.
+    ///filters is a comma separated list of kernel filters (id:mask or id~mask (inverted), hex).
+    ///An id with 8 hex digits is an extended id. An empty list receives all frames.
+    bool open(QString interfaceName, QString filters);
+
+    ///Closes the interface.
+    void close(void);
+
+    ///Returns true if the interface is open.
+    bool isConnected(void){return m_socket >= 0;}
+
+    ///Sends the can frames of data (byte 0=type, byte 1-4=id, byte 5-n=data, one frame for every 8 data bytes).
+    bool sendData(const QByteArray &data);
+
+    ///Sends several can frames (max. 8 data bytes per frame) with as few system calls as possible.
+    bool sendFrames(const QVector<CanFrame>& frames);
+
+    ///Returns the received frames (max. MAX_FRAMES_PER_READ).
+    QVector<CanFrame> readMessages(void);
+
+    ///Returns the number of frames which have been dropped by the kernel (socket receive buffer full).
+    quint32 getDroppedFrames(void){return m_droppedFrames;}
+
+    ///Returns the number of received error frames since the interface has been opened.
+    quint32 getErrorFrames(void){return m_errorFrames;}
+
+    ///Returns the bit rate of the interface (bit/s, 0 if unknown, e.g. for virtual interfaces).
+    quint32 getBitrate(void){return m_bitrate;}
+
+    ///Returns the description of the last error.
+    QString getErrorString(void){return m_errorString;}
+
+    ///Returns true if SocketCAN is supported on this platform.
+    static bool isSupported(void);
+
+    ///The max. number of data bytes in a sent frame.
+    static const qint32 MAX_BYTES_PER_MESSAGE = 8;
+
+    ///The number of frames which are received/sent with one system call.
+    static const qint32 BATCH_SIZE = 64;
+
+    ///The max. number of frames which are returned by readMessages (the remaining frames are
+    ///returned by the next call, readyRead is emitted again).
+    static const qint32 MAX_FRAMES_PER_READ = 4096;
+
+    ///The size of the socket receive buffer (bytes).
+    static const qint32 RECEIVE_BUFFER_SIZE = 1024 * 1024;
+
+    ///The max. time (ms) sendFrames waits for space in the full transmit queue.
+    static const int SEND_QUEUE_TIMEOUT_MS = 20;
+
+signals:
+    ///Is emitted if frames have been received.
+    void readyRead(void);
+
+private slots:
+    ///Is called by m_readNotifier if the socket is readable.
+    void socketActivatedSlot(int socket);
+
+private:
+
+    ///Configures the kernel filters.
+    bool setFilters(QString filters);
+
+    ///Reads the bit rate of an interface with a netlink request (0 if unknown).
+    static quint32 readBitrate(int interfaceIndex);
+
+    ///The socket (-1 if the interface is not open).
+    int m_socket;
+
+    ///The read notifier of m_socket.
+    QSocketNotifier* m_readNotifier;
+
+    ///The description of the last error.
+    QString m_errorString;
+
+    ///The kernel timestamp of the first received frame (us).
+    quint64 m_timeStampFirstReceivedFrame;
+
+    ///True if a first frame has been received.
+    bool m_firstFrameReceived;
+
+    ///The number of frames which have been dropped by the kernel.
+    quint32 m_droppedFrames;
+
+    ///The number of received error frames.
+    quint32 m_errorFrames;
+
+    ///The bit rate of the interface (bit/s, 0 if unknown).
+    quint32 m_bitrate;
+};
+
+#endif // SOCKETCAN_H
@@ -0,0 +1,650 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#include "triggerCapture.h"
+#include <QMutexLocker>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+/**
+ * Writes a capture into its capture file.
+ * Format: one line per entry (time in ms relative to the trigger):
+ * "time CAN type id(hex) length data(hex)" or "time DATA data(hex)".
+ * @param capture
+ *      The capture.
+ */
+void TriggerCaptureWriter::writeCaptureSlot(TriggerCaptureData capture)
+{
+    QVector<TriggerCaptureEntry>& ring = *capture.ring;
+    QFile file(capture.fileName);
+    bool success = file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text);
+    QString errorString = success ? QString() : file.errorString();
+
+    QByteArray text;
+    text += "# trigger: " + capture.triggerDescription.toUtf8() + "\n";
+    text += "# trigger time: " + capture.triggerDateTime.toString("yyyy-MM-dd hh:mm:ss.zzz").toUtf8() + "\n";
+    text += QString("# pre-trigger time: %1 ms, post-trigger time: %2 ms%3\n").arg(capture.preTriggerTime)
+            .arg(capture.postTriggerTime).arg(capture.truncated ? " (truncated, the capture memory was full)" : "").toUtf8();
+    text += "# time (ms, relative to the trigger) CAN type id(hex) length data(hex) | DATA data(hex)\n";
+
+    bool triggerWritten = false;
+    for(qint32 i = 0; i < capture.count; i++)
+    {
+        //The received bytes are released after writing (also if the file could not be written).
+        TriggerCaptureEntry& entry = ring[(capture.first + i) % ring.size()];
+        if(!success)
+        {
+            entry.data.clear();
+            continue;
+        }
+
+        if(!triggerWritten && (entry.time > capture.triggerTime))
+        {
+            text += "0.000 TRIGGER " + capture.triggerDescription.toUtf8() + "\n";
+            triggerWritten = true;
+        }
+
+        text += QByteArray::number((double)(entry.time - capture.triggerTime) / 1000.0, 'f', 3);
+        if(entry.isCanFrame)
+        {
+            text += " CAN " + QByteArray::number(canFrameType(entry.frame)) + " " + QByteArray::number(entry.frame.id, 16) + " "
+                    + QByteArray::number(entry.frame.length) + " " + QByteArray((const char*)entry.frame.data, entry.frame.length).toHex() + "\n";
+        }
+        else
+        {
+            text += " DATA " + entry.data.toHex() + "\n";
+            entry.data.clear();
+        }
+
+        //Write in blocks (the capture can be very large).
+        if(text.size() > 1024 * 1024)
+        {
+            success = (file.write(text) == text.size());
+            text.clear();
+        }
+    }
+
+    if(!triggerWritten)
+    {
+        text += "0.000 TRIGGER " + capture.triggerDescription.toUtf8() + "\n";
+    }
+    if(success)
+    {
+        success = (file.write(text) == text.size());
+    }
+    if(!success && errorString.isEmpty())
+    {
+        errorString = file.errorString();
+    }
+
+    emit ringWrittenSignal(capture.ringIndex);
+    emit captureWrittenSignal(capture.fileName, success, errorString);
+}
+
+/**
+ * Constructor.
+ * @param parent
+ *      The parent.
+ */
+TriggerCapture::TriggerCapture(QObject *parent) : QObject(parent), m_mutex(), m_isRunning(0), m_state(STATE_STOPPED), m_rings(),
+    m_activeRing(0), m_ringSize(0),
+    m_head(0), m_count(0), m_dataBytes(0), m_maxMemory(DEFAULT_MAX_MEMORY), m_preTriggerTime(0), m_postTriggerTime(0), m_fileName(),
+    m_numberOfCaptures(0), m_triggerDescription(), m_triggerDateTime(), m_triggerTime(0), m_canTriggers(), m_dataTriggers(),
+    m_dataTail(), m_clock(), m_postTriggerTimer(0), m_writerThread(), m_writer(0)
+{
+    qRegisterMetaType<TriggerCaptureData>("TriggerCaptureData");
+
+    for(qint32 i = 0; i < NUMBER_OF_RINGS; i++)
+    {
+        m_ringIsWritten[i] = false;
+    }
+
+    m_postTriggerTimer = new QTimer(this);
+    m_postTriggerTimer->setSingleShot(true);
+    connect(m_postTriggerTimer, SIGNAL(timeout()), this, SLOT(postTriggerTimerSlot()));
+
+    m_writer = new TriggerCaptureWriter();
+    m_writer->moveToThread(&m_writerThread);
+    connect(this, SIGNAL(writeCaptureSignal(TriggerCaptureData)), m_writer, SLOT(writeCaptureSlot(TriggerCaptureData)), Qt::QueuedConnection);
+    connect(m_writer, SIGNAL(captureWrittenSignal(QString,bool,QString)), this, SIGNAL(captureWrittenSignal(QString,bool,QString)));
+    connect(m_writer, SIGNAL(ringWrittenSignal(qint32)), this, SLOT(ringWrittenSlot(qint32)), Qt::QueuedConnection);
+    m_writerThread.start(QThread::LowPriority);
+
+    m_clock.start();
+}
+
+/**
+ * Destructor (the pending captures are written before).
+ */
+TriggerCapture::~TriggerCapture()
+{
+    QMetaObject::invokeMethod(m_writer, "quitThreadSlot", Qt::QueuedConnection);
+    m_writerThread.wait();
+    delete m_writer;
+}
+
+/**
+ * Starts (arms) the capture. Every capture is written into a new file: fileName with an appended
+ * index (e.g. capture_1.txt, capture_2.txt).
+ * @param fileName
+ *      The file name.
+ * @param preTriggerTime
+ *      The time (ms) before the trigger which is captured.
+ * @param postTriggerTime
+ *      The time (ms) after the trigger which is captured.
+ * @param maxMemory
+ *      The max. memory of both rings (bytes, includes the captures which are being written). Every ring
+ *      uses one quarter for the entries and one quarter for the received bytes. If the ring is full,
+ *      then the oldest entries are discarded (pre-trigger time) or the post-trigger time is cut short.
+ * @return
+ *      False if fileName is empty or maxMemory is too small.
+ */
+bool TriggerCapture::start(QString fileName, quint32 preTriggerTime, quint32 postTriggerTime, qint64 maxMemory)
+{
+    qint64 ringSize = (maxMemory / (2 * NUMBER_OF_RINGS)) / (qint64)sizeof(TriggerCaptureEntry);
+    if(fileName.isEmpty() || (ringSize < 1))
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_ringSize = (qint32)qMin(ringSize, (qint64)0x7fffffff);
+
+    //The rings which are being written are resized when the writer returns them (ringWrittenSlot).
+    m_activeRing = -1;
+    for(qint32 i = 0; i < NUMBER_OF_RINGS; i++)
+    {
+        if(!m_ringIsWritten[i])
+        {
+            m_rings[i].clear();
+            m_rings[i].resize(m_ringSize);
+            if(m_activeRing < 0)
+            {
+                m_activeRing = i;
+            }
+        }
+    }
+    m_head = 0;
+    m_count = 0;
+    m_dataBytes = 0;
+    m_maxMemory = maxMemory;
+    m_preTriggerTime = preTriggerTime;
+    m_postTriggerTime = postTriggerTime;
+    m_fileName = fileName;
+    m_numberOfCaptures = 0;
+    m_dataTail.clear();
+    m_state = (m_activeRing >= 0) ? STATE_ARMED : STATE_WAIT_FOR_RING;
+    m_activeRing = qMax(m_activeRing, 0);
+    m_isRunning.storeRelease(1);
+    return true;
+}
+
+/**
+ * Stops the capture (a running post-trigger time is discarded).
+ */
+void TriggerCapture::stop(void)
+{
+    QMutexLocker locker(&m_mutex);
+    m_isRunning.storeRelease(0);
+    m_state = STATE_STOPPED;
+    for(qint32 i = 0; i < NUMBER_OF_RINGS; i++)
+    {
+        if(!m_ringIsWritten[i])
+        {
+            m_rings[i].clear();
+            m_rings[i].squeeze();
+        }
+    }
+    m_head = 0;
+    m_count = 0;
+    m_dataBytes = 0;
+}
+
+/**
+ * Adds a can trigger.
+ * @param type
+ *      The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+ * @param id
+ *      The can id.
+ * @param idMask
+ *      The id mask (only the set bits are compared).
+ * @param data
+ *      The data.
+ * @param dataMask
+ *      The data mask (only the set bits are compared, frames with less data bytes do not match).
+ * @return
+ *      False if data and dataMask have different sizes.
+ */
+bool TriggerCapture::addCanTrigger(quint8 type, quint32 id, quint32 idMask, const QByteArray& data, const QByteArray& dataMask)
+{
+    if((data.size() != dataMask.size()) || (data.size() > CAN_FRAME_MAX_DATA))
+    {
+        return false;
+    }
+
+    CanCaptureTrigger trigger;
+    trigger.type = type & CAN_FRAME_TYPE_MASK;
+    trigger.id = id;
+    trigger.idMask = idMask;
+    trigger.data = data;
+    trigger.dataMask = dataMask;
+
+    QMutexLocker locker(&m_mutex);
+    m_canTriggers.append(trigger);
+    return true;
+}
+
+/**
+ * Adds a byte pattern trigger (for the received bytes of the not can interfaces).
+ * The pattern is also found if it is split over several received chunks.
+ * @param pattern
+ *      The pattern.
+ * @return
+ *      False if the pattern is empty or bigger than MAX_PATTERN_SIZE.
+ */
+bool TriggerCapture::addDataTrigger(const QByteArray& pattern)
+{
+    if(pattern.isEmpty() || (pattern.size() > MAX_PATTERN_SIZE))
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_dataTriggers.append(pattern);
+    return true;
+}
+
+/**
+ * Removes all can and byte pattern triggers.
+ */
+void TriggerCapture::clearTriggers(void)
+{
+    QMutexLocker locker(&m_mutex);
+    m_canTriggers.clear();
+    m_dataTriggers.clear();
+    m_dataTail.clear();
+}
+
+/**
+ * Fires the trigger.
+ * @param description
+ *      The description of the trigger (is written into the capture file).
+ * @return
+ *      False if the capture is not armed (stopped or in the post-trigger time).
+ */
+bool TriggerCapture::fire(QString description)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_state != STATE_ARMED)
+    {
+        return false;
+    }
+
+    //The trigger time is taken now (fireSlot is called later in the thread of the trigger capture).
+    QMetaObject::invokeMethod(this, "fireSlot", Qt::QueuedConnection, Q_ARG(QString, description), Q_ARG(qint64, now()));
+    return true;
+}
+
+/**
+ * Fires the trigger (is called in the thread of the trigger capture).
+ * @param description
+ *      The description of the trigger.
+ * @param time
+ *      The time of the trigger (us).
+ */
+void TriggerCapture::fireSlot(QString description, qint64 time)
+{
+    QMutexLocker locker(&m_mutex);
+    trigger(description, time);
+}
+
+/**
+ * Is called if the post-trigger time has elapsed (the timer is not stopped if a capture is finished
+ * early, so the remaining post-trigger time is checked here).
+ */
+void TriggerCapture::postTriggerTimerSlot(void)
+{
+    QMutexLocker locker(&m_mutex);
+    if(m_state != STATE_POST_TRIGGER)
+    {
+        return;
+    }
+
+    qint64 remaining = m_triggerTime + ((qint64)m_postTriggerTime * 1000) - now();
+    if(remaining > 0)
+    {
+        m_postTriggerTimer->start((int)(remaining / 1000) + 1);
+    }
+    else
+    {
+        finishCapture(false);
+    }
+}
+
+/**
+ * Is called if the writer has written a capture (is connected with TriggerCaptureWriter::ringWrittenSignal).
+ * The ring can be used again. If the capture waits for a ring, then it is re-armed with this ring.
+ * @param ringIndex
+ *      The index of the written ring.
+ */
+void TriggerCapture::ringWrittenSlot(qint32 ringIndex)
+{
+    QMutexLocker locker(&m_mutex);
+    m_ringIsWritten[ringIndex] = false;
+
+    if(m_state == STATE_STOPPED)
+    {
+        m_rings[ringIndex].clear();
+        m_rings[ringIndex].squeeze();
+    }
+    else if(m_rings[ringIndex].size() != m_ringSize)
+    {//The capture has been restarted with another size.
+        m_rings[ringIndex].clear();
+        m_rings[ringIndex].resize(m_ringSize);
+    }
+
+    if(m_state == STATE_WAIT_FOR_RING)
+    {
+        m_activeRing = ringIndex;
+        m_head = 0;
+        m_count = 0;
+        m_dataBytes = 0;
+        m_state = STATE_ARMED;
+    }
+}
+
+/**
+ * Adds received can frames.
+ * @param frames
+ *      The frames.
+ */
+void TriggerCapture::addCanFrames(const QVector<CanFrame>& frames)
+{
+    if(m_isRunning.loadAcquire() == 0)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if((m_state == STATE_STOPPED) || (m_state == STATE_WAIT_FOR_RING))
+    {
+        return;
+    }
+
+    TriggerCaptureEntry entry;
+    entry.time = now();
+    entry.isCanFrame = true;
+
+    if((m_state == STATE_POST_TRIGGER) && (entry.time >= (m_triggerTime + ((qint64)m_postTriggerTime * 1000))))
+    {
+        finishCapture(false);
+    }
+
+    for(const auto& el : frames)
+    {
+        if(m_state == STATE_WAIT_FOR_RING)
+        {//The capture has been finished and both rings are being written.
+            break;
+        }
+        entry.frame = el;
+        append(entry);
+
+        QString description;
+        if((m_state == STATE_ARMED) && !m_canTriggers.isEmpty() && canTriggerMatches(el, &description))
+        {
+            trigger(description, entry.time);
+        }
+    }
+}
+
+/**
+ * Adds received bytes.
+ * @param data
+ *      The data.
+ */
+void TriggerCapture::addData(const QByteArray& data)
+{
+    if(m_isRunning.loadAcquire() == 0)
+    {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if((m_state == STATE_STOPPED) || (m_state == STATE_WAIT_FOR_RING))
+    {
+        return;
+    }
+
+    TriggerCaptureEntry entry;
+    entry.time = now();
+    entry.isCanFrame = false;
+    entry.data = data;
+
+    if((m_state == STATE_POST_TRIGGER) && (entry.time >= (m_triggerTime + ((qint64)m_postTriggerTime * 1000))))
+    {
+        finishCapture(false);
+    }
+    if(m_state == STATE_WAIT_FOR_RING)
+    {
+        return;
+    }
+    append(entry);
+
+    if((m_state == STATE_ARMED) && !m_dataTriggers.isEmpty())
+    {
+        QByteArray searched = m_dataTail + data;
+        qint32 maxPatternSize = 0;
+        for(const auto& el : m_dataTriggers)
+        {
+            maxPatternSize = qMax(maxPatternSize, el.size());
+            if(searched.contains(el))
+            {
+                trigger("byte pattern " + QString(el.toHex()), entry.time);
+                return;
+            }
+        }
+        m_dataTail = searched.right(maxPatternSize - 1);
+    }
+}
+
+/**
+ * Appends an entry to the ring (m_mutex must be locked).
+ * In the armed state the oldest entries are removed if the ring is full or if they are older than the
+ * pre-trigger time. In the post-trigger time the capture is finished if the ring is full.
+ * @param entry
+ *      The entry.
+ */
+void TriggerCapture::append(const TriggerCaptureEntry& entry)
+{
+    qint64 maxDataBytes = m_maxMemory / (2 * NUMBER_OF_RINGS);
+    if(entry.data.size() > maxDataBytes)
+    {
+        return;
+    }
+
+    bool isFull = (m_count == m_ringSize) || ((m_dataBytes + entry.data.size()) > maxDataBytes);
+    if(isFull && (m_state == STATE_POST_TRIGGER))
+    {
+        finishCapture(true);
+        if(m_state == STATE_WAIT_FOR_RING)
+        {
+            return;
+        }
+    }
+
+    while((m_count > 0) && ((m_count == m_ringSize) || ((m_dataBytes + entry.data.size()) > maxDataBytes)))
+    {
+        removeOldest();
+    }
+
+    QVector<TriggerCaptureEntry>& ring = activeRing();
+    ring[m_head] = entry;
+    m_head = (m_head + 1) % m_ringSize;
+    m_count++;
+    m_dataBytes += entry.data.size();
+
+    if(m_state == STATE_ARMED)
+    {
+        qint64 oldestTime = entry.time - ((qint64)m_preTriggerTime * 1000);
+        while((m_count > 0) && (ring[(m_head - m_count + m_ringSize) % m_ringSize].time < oldestTime))
+        {
+            removeOldest();
+        }
+    }
+}
+
+/**
+ * Removes the oldest entry (m_mutex must be locked).
+ */
+void TriggerCapture::removeOldest(void)
+{
+    TriggerCaptureEntry& oldest = activeRing()[(m_head - m_count + m_ringSize) % m_ringSize];
+    m_dataBytes -= oldest.data.size();
+    oldest.data.clear();
+    m_count--;
+}
+
+/**
+ * Returns true if a can trigger matches frame (m_mutex must be locked).
+ * @param frame
+ *      The frame.
+ * @param description
+ *      The description of the matching trigger.
+ * @return
+ *      True if a trigger matches.
+ */
+bool TriggerCapture::canTriggerMatches(const CanFrame& frame, QString* description)
+{
+    for(const auto& el : m_canTriggers)
+    {
+        if((canFrameType(frame) != el.type) || (((frame.id ^ el.id) & el.idMask) != 0) || (el.dataMask.size() > frame.length))
+        {
+            continue;
+        }
+
+        bool matches = true;
+        for(qint32 i = 0; (i < el.dataMask.size()) && matches; i++)
+        {
+            matches = ((frame.data[i] ^ (quint8)el.data[i]) & (quint8)el.dataMask[i]) == 0;
+        }
+
+        if(matches)
+        {
+            *description = QString("can type %1 id 0x%2").arg(canFrameType(frame)).arg(frame.id, 0, 16);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Starts the post-trigger time (m_mutex must be locked). Does nothing if the capture is not armed.
+ * @param description
+ *      The description of the trigger.
+ * @param time
+ *      The time of the trigger (us).
+ */
+void TriggerCapture::trigger(QString description, qint64 time)
+{
+    if(m_state != STATE_ARMED)
+    {
+        return;
+    }
+
+    m_state = STATE_POST_TRIGGER;
+    m_triggerDescription = description;
+    m_triggerDateTime = QDateTime::currentDateTime();
+    m_triggerTime = time;
+    m_dataTail.clear();
+
+    if(m_postTriggerTime == 0)
+    {
+        finishCapture(false);
+    }
+    else
+    {
+        //trigger can be called in a script thread (the timer must be started in the thread of the trigger capture).
+        QMetaObject::invokeMethod(m_postTriggerTimer, "start", Qt::AutoConnection, Q_ARG(int, (int)m_postTriggerTime));
+    }
+}
+
+/**
+ * Finishes the current capture and hands it over to the writer (m_mutex must be locked).
+ * The ring is handed over (not copied). The capture is re-armed with the other ring or waits
+ * until the writer has returned a ring (no memory is allocated here).
+ * @param truncated
+ *      True if the post-trigger time has been cut short.
+ */
+void TriggerCapture::finishCapture(bool truncated)
+{
+    TriggerCaptureData capture;
+    capture.fileName = nextFileName();
+    capture.triggerDescription = m_triggerDescription;
+    capture.triggerDateTime = m_triggerDateTime;
+    capture.triggerTime = m_triggerTime;
+    capture.preTriggerTime = m_preTriggerTime;
+    capture.postTriggerTime = m_postTriggerTime;
+    capture.first = (m_head - m_count + m_ringSize) % m_ringSize;
+    capture.count = m_count;
+    capture.truncated = truncated;
+    capture.ring = &activeRing();
+    capture.ringIndex = m_activeRing;
+
+    m_ringIsWritten[m_activeRing] = true;
+    m_head = 0;
+    m_count = 0;
+    m_dataBytes = 0;
+    m_numberOfCaptures++;
+
+    m_state = STATE_WAIT_FOR_RING;
+    for(qint32 i = 0; i < NUMBER_OF_RINGS; i++)
+    {
+        if(!m_ringIsWritten[i])
+        {
+            m_activeRing = i;
+            m_state = STATE_ARMED;
+            break;
+        }
+    }
+
+    emit writeCaptureSignal(capture);
+}
+
+/**
+ * Creates the file name of the next capture (the index is appended to the base name).
+ * @return
+ *      The file name.
+ */
+QString TriggerCapture::nextFileName(void)
+{
+    QFileInfo info(m_fileName);
+    QString name = info.completeBaseName() + QString("_%1").arg(m_numberOfCaptures + 1);
+    if(!info.suffix().isEmpty())
+    {
+        name += "." + info.suffix();
+    }
+    return QDir(info.path()).filePath(name);
+}
@@ -0,0 +1,322 @@
+/***************************************************************************
+**                                                                        **
+**  ScriptCommunicator, is a tool for sending/receiving data with several **
+**  interfaces.                                                           **
+**  Copyright (C) 2014 Stefan Zieker                                      **
+**                                                                        **
+**  This program is free software: you can redistribute it and/or modify  **
+**  it under the terms of the GNU General Public License as published by  **
+**  the Free Software Foundation, either version 3 of the License, or     **
+**  (at your option) any later version.                                   **
+**                                                                        **
+**  This program is distributed in the hope that it will be useful,       **
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of        **
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         **
+**  GNU General Public License for more details.                          **
+**                                                                        **
+**  You should have received a copy of the GNU General Public License     **
+**  along with this program.  If not, see http://www.gnu.org/licenses/.   **
+**                                                                        **
+****************************************************************************
+**           Author: Stefan Zieker                                        **
+**  Website/Contact: http://sourceforge.net/projects/scriptcommunicator/  **
+****************************************************************************/
+
+
+#ifndef TRIGGERCAPTURE_H
+#define TRIGGERCAPTURE_H
+
+#include <QObject>
+#include <QVector>
+#include <QMutex>
+#include <QTimer>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include "canFrame.h"
+
+///One entry in the trigger capture ring (a received can frame or a chunk of received bytes).
+typedef struct
+{
+    ///The receive time (us since the creation of the trigger capture).
+    qint64 time;
+
+    ///True if the entry is a can frame (frame), false if it is a chunk of received bytes (data).
+    bool isCanFrame;
+
+    ///The can frame.
+    CanFrame frame;
+
+    ///The received bytes.
+    QByteArray data;
+}TriggerCaptureEntry;
+
+///A can trigger. The trigger fires if (frameId & idMask) == (id & idMask) and
+///(frameData[i] & dataMask[i]) == (data[i] & dataMask[i]) for every byte in dataMask.
+typedef struct
+{
+    ///The can type (0=standard, 1=standard rtr, 2=extended, 3=extended rtr).
+    quint8 type;
+
+    ///The can id.
+    quint32 id;
+
+    ///The id mask.
+    quint32 idMask;
+
+    ///The data.
+    QByteArray data;
+
+    ///The data mask (has the same size as data).
+    QByteArray dataMask;
+}CanCaptureTrigger;
+
+///A finished capture (is written by TriggerCaptureWriter). The entries are stored in one of the two
+///rings of the trigger capture (the ring is not copied and not used by the trigger capture until the
+///writer has returned it with ringWrittenSignal).
+typedef struct
+{
+    ///The capture file.
+    QString fileName;
+
+    ///The description of the trigger.
+    QString triggerDescription;
+
+    ///The (wall clock) time of the trigger.
+    QDateTime triggerDateTime;
+
+    ///The time of the trigger (us, same time base as TriggerCaptureEntry::time).
+    qint64 triggerTime;
+
+    ///The pre-trigger time (ms).
+    quint32 preTriggerTime;
+
+    ///The post-trigger time (ms).
+    quint32 postTriggerTime;
+
+    ///The ring (is owned by the trigger capture).
+    QVector<TriggerCaptureEntry>* ring;
+
+    ///The index of the ring in the trigger capture.
+    qint32 ringIndex;
+
+    ///The ring position of the oldest entry.
+    qint32 first;
+
+    ///The number of entries.
+    qint32 count;
+
+    ///True if the post-trigger time has been cut short (the ring was full).
+    bool truncated;
+}TriggerCaptureData;
+
+Q_DECLARE_METATYPE(TriggerCaptureData)
+
+///Writes the finished captures into the capture files (lives in its own thread, so that
+///the reception is not stalled by the file operations).
+class TriggerCaptureWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    TriggerCaptureWriter(QObject *parent = 0) : QObject(parent){}
+
+signals:
+    ///Is emitted after a capture file has been written.
+    void captureWrittenSignal(QString fileName, bool success, QString errorString);
+
+    ///Is emitted after a capture has been written (the ring can be used again by the trigger capture).
+    void ringWrittenSignal(qint32 ringIndex);
+
+public slots:
+    ///Writes a capture into its capture file (the received bytes in the ring are released).
+    void writeCaptureSlot(TriggerCaptureData capture);
+
+    ///Quits the thread of the writer (is queued behind the pending captures).
+    void quitThreadSlot(void){thread()->quit();}
+};
+
+///Memory-bounded pre-trigger ring for the received data of the main interface (can frames and bytes).
+///If a trigger fires (can trigger, byte pattern or fire()), then the entries of the pre-trigger time
+///and of the post-trigger time are written into a capture file. Two rings are allocated at start: the
+///capture is re-armed with the second ring while the first one is written and waits (discards the received
+///data) if both rings are being written.
+///All public functions are thread safe (received data is also added by the script threads,
+///see ScriptThread::sendReceivedDataToMainInterface).
+class TriggerCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    TriggerCapture(QObject *parent = 0);
+    ~TriggerCapture();
+
+    ///The default max. memory of the ring (bytes).
+    static const qint64 DEFAULT_MAX_MEMORY = 64 * 1024 * 1024;
+
+    ///The max. size of a byte pattern trigger.
+    static const qint32 MAX_PATTERN_SIZE = 256;
+
+    ///Starts (arms) the capture. Every capture is written into a new file (fileName with an
+    ///appended index).
+    bool start(QString fileName, quint32 preTriggerTime, quint32 postTriggerTime, qint64 maxMemory = DEFAULT_MAX_MEMORY);
+
+    ///Stops the capture (a running post-trigger time is discarded).
+    void stop(void);
+
+    ///Returns true if the capture is running.
+    bool isRunning(void){return m_isRunning.loadAcquire() != 0;}
+
+    ///Adds a can trigger.
+    bool addCanTrigger(quint8 type, quint32 id, quint32 idMask, const QByteArray& data, const QByteArray& dataMask);
+
+    ///Adds a byte pattern trigger (for the received bytes of the not can interfaces).
+    bool addDataTrigger(const QByteArray& pattern);
+
+    ///Removes all can and byte pattern triggers.
+    void clearTriggers(void);
+
+    ///Fires the trigger (false if the capture is not armed).
+    bool fire(QString description);
+
+    ///Adds received can frames.
+    void addCanFrames(const QVector<CanFrame>& frames);
+
+    ///Adds received bytes.
+    void addData(const QByteArray& data);
+
+signals:
+    ///Is emitted after a capture file has been written.
+    void captureWrittenSignal(QString fileName, bool success, QString errorString);
+
+    ///Is connected with TriggerCaptureWriter::writeCaptureSlot.
+    void writeCaptureSignal(TriggerCaptureData capture);
+
+private slots:
+    ///Fires the trigger (is called in the thread of the trigger capture).
+    void fireSlot(QString description, qint64 time);
+
+    ///Is called if the post-trigger time has elapsed.
+    void postTriggerTimerSlot(void);
+
+    ///Is called if the writer has written a capture (is connected with TriggerCaptureWriter::ringWrittenSignal).
+    void ringWrittenSlot(qint32 ringIndex);
+
+private:
+
+    ///The states of the capture.
+    typedef enum
+    {
+        STATE_STOPPED,
+        STATE_ARMED,
+        STATE_POST_TRIGGER,
+
+        ///Both rings are being written (the received data is discarded).
+        STATE_WAIT_FOR_RING
+    }CaptureState;
+
+    ///The number of rings.
+    static const qint32 NUMBER_OF_RINGS = 2;
+
+    ///Returns the current time (us).
+    qint64 now(void){return m_clock.nsecsElapsed() / 1000;}
+
+    ///Returns the ring which is currently filled (m_mutex must be locked).
+    QVector<TriggerCaptureEntry>& activeRing(void){return m_rings[m_activeRing];}
+
+    ///Appends an entry to the ring (m_mutex must be locked).
+    void append(const TriggerCaptureEntry& entry);
+
+    ///Removes the oldest entry (m_mutex must be locked).
+    void removeOldest(void);
+
+    ///Returns true if a can trigger matches frame (m_mutex must be locked).
+    bool canTriggerMatches(const CanFrame& frame, QString* description);
+
+    ///Starts the post-trigger time (m_mutex must be locked).
+    void trigger(QString description, qint64 time);
+
+    ///Finishes the current capture and hands it over to the writer (m_mutex must be locked).
+    void finishCapture(bool truncated);
+
+    ///Creates the file name of the next capture.
+    QString nextFileName(void);
+
+    ///Protects all members below.
+    QMutex m_mutex;
+
+    ///1 if the capture is running (is read without m_mutex in the receive functions).
+    QAtomicInt m_isRunning;
+
+    ///The state of the capture.
+    CaptureState m_state;
+
+    ///The rings (one half of m_maxMemory per ring: one half for the entries and one half for the received bytes).
+    QVector<TriggerCaptureEntry> m_rings[NUMBER_OF_RINGS];
+
+    ///True if a ring is being written by the writer.
+    bool m_ringIsWritten[NUMBER_OF_RINGS];
+
+    ///The index of the ring which is currently filled.
+    qint32 m_activeRing;
+
+    ///The number of entries per ring.
+    qint32 m_ringSize;
+
+    ///The ring position of the next added entry.
+    qint32 m_head;
+
+    ///The number of entries.
+    qint32 m_count;
+
+    ///The number of bytes in all byte chunk entries.
+    qint64 m_dataBytes;
+
+    ///The max. memory of the ring (bytes).
+    qint64 m_maxMemory;
+
+    ///The pre-trigger time (ms).
+    quint32 m_preTriggerTime;
+
+    ///The post-trigger time (ms).
+    quint32 m_postTriggerTime;
+
+    ///The base file name of the captures.
+    QString m_fileName;
+
+    ///The number of captures since start.
+    quint32 m_numberOfCaptures;
+
+    ///The description of the current trigger.
+    QString m_triggerDescription;
+
+    ///The (wall clock) time of the current trigger.
+    QDateTime m_triggerDateTime;
+
+    ///The time of the current trigger (us).
+    qint64 m_triggerTime;
+
+    ///The can triggers.
+    QVector<CanCaptureTrigger> m_canTriggers;
+
+    ///The byte pattern triggers.
+    QVector<QByteArray> m_dataTriggers;
+
+    ///The last received bytes (size of the longest pattern - 1, for patterns which are split over several chunks).
+    QByteArray m_dataTail;
+
+    ///The time base of all entries.
+    QElapsedTimer m_clock;
+
+    ///Ends the post-trigger time if no data is received.
+    QTimer* m_postTriggerTimer;
+
+    ///The writer thread.
+    QThread m_writerThread;
+
+    ///The writer (lives in m_writerThread).
+    TriggerCaptureWriter* m_writer;
+};
+
+#endif // TRIGGERCAPTURE_H